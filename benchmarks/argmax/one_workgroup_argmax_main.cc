@@ -13,24 +13,28 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <chrono>
 #include <memory>
 #include <numeric>
+#include <utility>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "benchmark/benchmark.h"
+#include "uvkc/benchmark/autotuner.h"
+#include "uvkc/benchmark/compute_benchmark.h"
 #include "uvkc/benchmark/data_type_util.h"
-#include "uvkc/benchmark/main.h"
 #include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
 #include "uvkc/benchmark/vulkan_buffer_util.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include "uvkc/vulkan/device.h"
 #include "uvkc/vulkan/pipeline.h"
 
-using ::uvkc::benchmark::LatencyMeasureMode;
 using ::uvkc::vulkan::Pipeline;
 
+namespace {
+
 static const char kBenchmarkName[] = "one_workgroup_argmax";
 
 static const uint32_t kLoopShader[] = {
@@ -56,28 +60,8 @@ ShaderCode kShaders[] = {
 static void Argmax(::benchmark::State &state, ::uvkc::vulkan::Device *device,
                    const ::uvkc::benchmark::LatencyMeasure *latency_measure,
                    const uint32_t *code, size_t code_num_words,
-                   size_t total_elements, int workgroup_size) {
-  //===-------------------------------------------------------------------===/
-  // Create shader module, pipeline, and descriptor sets
-  //===-------------------------------------------------------------------===/
-
-  BM_CHECK_OK_AND_ASSIGN(auto shader_module,
-                         device->CreateShaderModule(code, code_num_words));
-  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
-                         device->CreateDescriptorPool(*shader_module));
-  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
-                         descriptor_pool->AllocateDescriptorSets(
-                             shader_module->descriptor_set_layouts()));
-
-  Pipeline::SpecConstant spec_constants[] = {
-      {/*id=*/0, Pipeline::SpecConstant::Type::u32,
-       static_cast<int32_t>(total_elements)},
-      {/*id=*/1, Pipeline::SpecConstant::Type::u32, workgroup_size},
-  };
-  BM_CHECK_OK_AND_ASSIGN(
-      auto pipeline, device->CreatePipeline(*shader_module, "main",
-                                            absl::MakeSpan(spec_constants, 2)));
-
+                   size_t total_elements, int workgroup_size,
+                   Pipeline::SubgroupSizeControl subgroup_size_control) {
   //===-------------------------------------------------------------------===/
   // Create buffers
   //===-------------------------------------------------------------------===/
@@ -126,30 +110,29 @@ static void Argmax(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   // Dispatch
   //===-------------------------------------------------------------------===/
 
-  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers = {
+  ::uvkc::benchmark::ComputeBenchmark::Options options;
+  options.code = absl::MakeConstSpan(code, code_num_words);
+  options.buffers = {
       {src_buffer.get(), /*set=*/0, /*binding=*/0},
       {dst_buffer.get(), /*set=*/0, /*binding=*/1},
   };
-  BM_CHECK_OK(device->AttachBufferToDescriptor(
-      *shader_module, layout_set_map,
-      {bound_buffers.data(), bound_buffers.size()}));
-
-  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
-      << "unexpected number of descriptor sets";
-  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
-
-  std::vector<::uvkc::vulkan::CommandBuffer::BoundDescriptorSet>
-      bound_descriptor_sets(1);
-  bound_descriptor_sets[0].index = 0;
-  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
-  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
-
-  BM_CHECK_OK(dispatch_cmdbuf->Begin());
-  dispatch_cmdbuf->BindPipelineAndDescriptorSets(
-      *pipeline, {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-  dispatch_cmdbuf->Dispatch(1, 1, 1);
-  BM_CHECK_OK(dispatch_cmdbuf->End());
-  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+  options.subgroup_size_control = subgroup_size_control;
+
+  ::uvkc::benchmark::ComputeBenchmark::Dispatch dispatch;
+  dispatch.spec_constants = {
+      {/*id=*/0, Pipeline::SpecConstant::Type::u32,
+       static_cast<int32_t>(total_elements)},
+      {/*id=*/1, Pipeline::SpecConstant::Type::u32, workgroup_size},
+  };
+  options.dispatches.push_back(std::move(dispatch));
+
+  options.num_operations = total_elements;
+  options.bytes_processed = src_buffer_size;
+
+  BM_CHECK_OK_AND_ASSIGN(auto compute,
+                         ::uvkc::benchmark::ComputeBenchmark::Create(
+                             device, std::move(options)));
+  BM_CHECK_OK(compute->DispatchOnce());
 
   //===-------------------------------------------------------------------===/
   // Verify destination buffer data
@@ -178,105 +161,78 @@ static void Argmax(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   // Benchmarking
   //===-------------------------------------------------------------------===/
 
-  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
-  bool use_timestamp =
-      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
-  if (use_timestamp) {
-    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(2));
-  }
-
-  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
-  for (auto _ : state) {
-    BM_CHECK_OK(cmdbuf->Begin());
-    if (use_timestamp) cmdbuf->ResetQueryPool(*query_pool);
-
-    cmdbuf->BindPipelineAndDescriptorSets(
-        *pipeline,
-        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
-    }
-
-    cmdbuf->Dispatch(1, 1, 1);
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                             1);
-    }
-
-    BM_CHECK_OK(cmdbuf->End());
-
-    auto start_time = std::chrono::high_resolution_clock::now();
-    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto elapsed_seconds =
-        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
-                                                                  start_time);
-
-    switch (latency_measure->mode) {
-      case LatencyMeasureMode::kSystemDispatch: {
-        state.SetIterationTime(elapsed_seconds.count() -
-                               latency_measure->overhead_seconds);
-      } break;
-      case LatencyMeasureMode::kSystemSubmit: {
-        state.SetIterationTime(elapsed_seconds.count());
-      } break;
-      case LatencyMeasureMode::kGpuTimestamp: {
-        BM_CHECK_OK_AND_ASSIGN(
-            double timestamp_seconds,
-            query_pool->CalculateElapsedSecondsBetween(0, 1));
-        state.SetIterationTime(timestamp_seconds);
-      } break;
-    }
-
-    BM_CHECK_OK(cmdbuf->Reset());
-  }
-
-  state.SetBytesProcessed(state.iterations() * src_buffer_size);
-  state.counters["FLOps"] =
-      ::benchmark::Counter(total_elements,
-                           ::benchmark::Counter::kIsIterationInvariant |
-                               ::benchmark::Counter::kIsRate,
-                           ::benchmark::Counter::kIs1000);
-
-  // Reset the command pool to release all command buffers in the benchmarking
-  // loop to avoid draining GPU resources.
-  BM_CHECK_OK(device->ResetCommandPool());
+  compute->Measure(state, *latency_measure);
 }
 
+}  // namespace
+
 namespace uvkc {
 namespace benchmark {
-
-absl::StatusOr<std::unique_ptr<VulkanContext>> CreateVulkanContext() {
-  return CreateDefaultVulkanContext(kBenchmarkName);
-}
+namespace {
 
 bool RegisterVulkanOverheadBenchmark(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, double *overhead_seconds) {
+    LazyDevice *device, double *overhead_seconds) {
   return false;
 }
 
 void RegisterVulkanBenchmarks(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, const LatencyMeasure *latency_measure) {
-  const char *gpu_name = physical_device.v10_properties.deviceName;
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
+  const std::vector<uint32_t> subgroup_sizes =
+      device->GetRequirableSubgroupSizes();
+  const bool full_subgroups =
+      device->optional_features().compute_full_subgroups;
 
   for (const auto &shader : kShaders) {
     for (size_t total_elements : {1 << 10, 1 << 12, 1 << 14, 1 << 16}) {
       std::string test_name = absl::StrCat(
           gpu_name, "/#elements=", total_elements,
           "/workgroup_size=", shader.workgroup_size, "/", shader.name);
-      ::benchmark::RegisterBenchmark(test_name.c_str(), Argmax, device,
-                                     latency_measure, shader.code,
-                                     shader.code_num_bytes / sizeof(uint32_t),
-                                     total_elements, shader.workgroup_size)
+      TuningCandidate candidate = {GetTuningDevice(physical_device), "argmax",
+                                   absl::StrCat(total_elements), "fp32",
+                                   shader.name};
+      RegisterTuningCandidate(
+          std::move(candidate), test_name, Argmax, device, latency_measure,
+          shader.code, shader.code_num_bytes / sizeof(uint32_t),
+          total_elements, shader.workgroup_size,
+          Pipeline::SubgroupSizeControl{/*required_size=*/0,
+                                        /*require_full_subgroups=*/false})
+          ->UseManualTime()
+          ->Unit(::benchmark::kMicrosecond);
+    }
+  }
+
+  // Sweep all subgroup sizes the device allows for the subgroup shader, with
+  // one subgroup per workgroup.
+  const ShaderCode &subgroup_shader = kShaders[1];
+  for (uint32_t subgroup_size : subgroup_sizes) {
+    for (size_t total_elements : {1 << 10, 1 << 12, 1 << 14, 1 << 16}) {
+      std::string test_name = absl::StrCat(
+          gpu_name, "/#elements=", total_elements,
+          "/workgroup_size=", subgroup_size, "/", subgroup_shader.name,
+          "/subgroup_size=", subgroup_size);
+      TuningCandidate candidate = {
+          GetTuningDevice(physical_device), "argmax",
+          absl::StrCat(total_elements), "fp32",
+          absl::StrCat(subgroup_shader.name, "/subgroup_size=", subgroup_size)};
+      RegisterTuningCandidate(
+          std::move(candidate), test_name, Argmax, device, latency_measure,
+          subgroup_shader.code,
+          subgroup_shader.code_num_bytes / sizeof(uint32_t), total_elements,
+          static_cast<int>(subgroup_size),
+          Pipeline::SubgroupSizeControl{subgroup_size, full_subgroups})
           ->UseManualTime()
           ->Unit(::benchmark::kMicrosecond);
     }
   }
 }
 
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
 }  // namespace benchmark
 }  // namespace uvkc
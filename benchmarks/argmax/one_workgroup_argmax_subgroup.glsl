@@ -3,7 +3,7 @@
 #extension GL_KHR_shader_subgroup_arithmetic : enable
 #extension GL_KHR_shader_subgroup_ballot : enable
 
-layout(local_size_x = 32, local_size_y = 1, local_size_z = 1) in;
+layout(local_size_x_id = 1, local_size_y = 1, local_size_z = 1) in;
 
 layout(set=0, binding=0) buffer InputBuffer { float data[]; } Input;
 layout(set=0, binding=1) buffer OutputBuffer { uint data; } Output;
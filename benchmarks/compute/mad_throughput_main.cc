@@ -12,24 +12,26 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <chrono>
 #include <memory>
 #include <numeric>
 
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "benchmark/benchmark.h"
+#include "uvkc/benchmark/compute_benchmark.h"
 #include "uvkc/benchmark/data_type_util.h"
-#include "uvkc/benchmark/main.h"
+#include "uvkc/benchmark/device_benchmark.h"
 #include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
 #include "uvkc/benchmark/vulkan_buffer_util.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include "uvkc/vulkan/device.h"
 #include "uvkc/vulkan/pipeline.h"
 
-using ::uvkc::benchmark::LatencyMeasureMode;
 using namespace uvkc::benchmark;
 
+namespace {
+
 static const char kBenchmarkName[] = "mad_throughput";
 
 #include "mad_throughput_shader_spirv_permutation.inc"
@@ -52,26 +54,6 @@ static void Throughput(::benchmark::State &state,
                        const uint32_t *code, size_t code_num_words,
                        size_t num_element, int loop_count, DataType data_type) {
   //===-------------------------------------------------------------------===/
-  // Create shader module, pipeline, and descriptor sets
-  //===-------------------------------------------------------------------===/
-
-  BM_CHECK_OK_AND_ASSIGN(auto shader_module,
-                         device->CreateShaderModule(code, code_num_words));
-  ::uvkc::vulkan::Pipeline::SpecConstant spec_constant = {};
-  spec_constant.id = 0;
-  spec_constant.type = ::uvkc::vulkan::Pipeline::SpecConstant::Type::s32;
-  spec_constant.value.s32 = loop_count;
-  BM_CHECK_OK_AND_ASSIGN(
-      auto pipeline, device->CreatePipeline(*shader_module, "main",
-                                            absl::MakeSpan(&spec_constant, 1)));
-
-  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
-                         device->CreateDescriptorPool(*shader_module));
-  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
-                         descriptor_pool->AllocateDescriptorSets(
-                             shader_module->descriptor_set_layouts()));
-
-  //===-------------------------------------------------------------------===/
   // Create buffers
   //===-------------------------------------------------------------------===/
   const size_t src0_size = num_element * GetSize(data_type);
@@ -142,31 +124,30 @@ static void Throughput(::benchmark::State &state,
   // Dispatch
   //===-------------------------------------------------------------------===/
 
-  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers = {
+  ::uvkc::benchmark::ComputeBenchmark::Options options;
+  options.code = absl::MakeConstSpan(code, code_num_words);
+  options.buffers = {
       {src0_buffer.get(), /*set=*/0, /*binding=*/0},
       {src1_buffer.get(), /*set=*/0, /*binding=*/1},
       {dst_buffer.get(), /*set=*/0, /*binding=*/2},
   };
-  BM_CHECK_OK(device->AttachBufferToDescriptor(
-      *shader_module, layout_set_map,
-      {bound_buffers.data(), bound_buffers.size()}));
 
-  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
-      << "unexpected number of descriptor sets";
-  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
+  ::uvkc::benchmark::ComputeBenchmark::Dispatch dispatch;
+  dispatch.spec_constants = {
+      {/*id=*/0, ::uvkc::vulkan::Pipeline::SpecConstant::Type::s32,
+       loop_count},
+  };
+  dispatch.group_count_x = num_element / (4 * 16);
+  options.dispatches.push_back(std::move(dispatch));
 
-  std::vector<::uvkc::vulkan::CommandBuffer::BoundDescriptorSet>
-      bound_descriptor_sets(1);
-  bound_descriptor_sets[0].index = 0;
-  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
-  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
+  options.num_operations = double(num_element) * 2. /*fma*/ *
+                           10. /*10 elements per loop iteration*/ *
+                           double(loop_count);
 
-  BM_CHECK_OK(dispatch_cmdbuf->Begin());
-  dispatch_cmdbuf->BindPipelineAndDescriptorSets(
-      *pipeline, {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-  dispatch_cmdbuf->Dispatch(num_element / (4 * 16), 1, 1);
-  BM_CHECK_OK(dispatch_cmdbuf->End());
-  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+  BM_CHECK_OK_AND_ASSIGN(auto compute,
+                         ::uvkc::benchmark::ComputeBenchmark::Create(
+                             device, std::move(options)));
+  BM_CHECK_OK(compute->DispatchOnce());
 
   //===-------------------------------------------------------------------===/
   // Verify destination buffer data
@@ -202,92 +183,25 @@ static void Throughput(::benchmark::State &state,
   // Benchmarking
   //===-------------------------------------------------------------------===/
 
-  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
-  bool use_timestamp =
-      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
-  if (use_timestamp) {
-    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(2));
-  }
-
-  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
-  for (auto _ : state) {
-    BM_CHECK_OK(cmdbuf->Begin());
-    if (use_timestamp) cmdbuf->ResetQueryPool(*query_pool);
-
-    cmdbuf->BindPipelineAndDescriptorSets(
-        *pipeline,
-        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
-    }
-
-    cmdbuf->Dispatch(num_element / (4 * 16), 1, 1);
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                             1);
-    }
-
-    BM_CHECK_OK(cmdbuf->End());
-
-    auto start_time = std::chrono::high_resolution_clock::now();
-    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto elapsed_seconds =
-        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
-                                                                  start_time);
-
-    switch (latency_measure->mode) {
-      case LatencyMeasureMode::kSystemDispatch: {
-        state.SetIterationTime(elapsed_seconds.count() -
-                               latency_measure->overhead_seconds);
-      } break;
-      case LatencyMeasureMode::kSystemSubmit: {
-        state.SetIterationTime(elapsed_seconds.count());
-      } break;
-      case LatencyMeasureMode::kGpuTimestamp: {
-        BM_CHECK_OK_AND_ASSIGN(
-            double timestamp_seconds,
-            query_pool->CalculateElapsedSecondsBetween(0, 1));
-        state.SetIterationTime(timestamp_seconds);
-      } break;
-    }
-
-    BM_CHECK_OK(cmdbuf->Reset());
-  }
-
-  double numOperation = double(num_element) * 2. /*fma*/ *
-                        10. /*10 elements per loop iteration*/ *
-                        double(loop_count);
-  state.counters["FLOps"] =
-      ::benchmark::Counter(numOperation,
-                           ::benchmark::Counter::kIsIterationInvariant |
-                               ::benchmark::Counter::kIsRate,
-                           ::benchmark::Counter::kIs1000);
-
-  // Reset the command pool to release all command buffers in the benchmarking
-  // loop to avoid draining GPU resources.
-  BM_CHECK_OK(device->ResetCommandPool());
+  compute->Measure(state, *latency_measure);
 }
 
+}  // namespace
+
 namespace uvkc {
 namespace benchmark {
-
-absl::StatusOr<std::unique_ptr<VulkanContext>> CreateVulkanContext() {
-  return CreateDefaultVulkanContext(kBenchmarkName);
-}
+namespace {
 
 bool RegisterVulkanOverheadBenchmark(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, double *overhead_seconds) {
+    LazyDevice *device, double *overhead_seconds) {
   return false;
 }
 
 void RegisterVulkanBenchmarks(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, const LatencyMeasure *latency_measure) {
-  const char *gpu_name = physical_device.v10_properties.deviceName;
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
 
   const size_t num_element = 1024 * 1024;
   const int min_loop_count = 100000;
@@ -297,15 +211,20 @@ void RegisterVulkanBenchmarks(
          loop_count += min_loop_count) {
       std::string test_name = absl::StrCat(gpu_name, "/", shader.name, "/",
                                            num_element, "/", loop_count);
-      ::benchmark::RegisterBenchmark(test_name.c_str(), Throughput, device,
-                                     latency_measure, shader.code,
-                                     shader.code_num_bytes / sizeof(uint32_t),
-                                     num_element, loop_count, shader.data_type)
+      RegisterDeviceBenchmark(test_name, Throughput, device, latency_measure,
+                              shader.code,
+                              shader.code_num_bytes / sizeof(uint32_t),
+                              num_element, loop_count, shader.data_type)
           ->UseManualTime()
           ->Unit(::benchmark::kMicrosecond);
     }
   }
 }
 
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
 }  // namespace benchmark
 }  // namespace uvkc
@@ -12,16 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <chrono>
 #include <memory>
 #include <numeric>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "benchmark/benchmark.h"
+#include "uvkc/benchmark/autotuner.h"
+#include "uvkc/benchmark/compute_benchmark.h"
 #include "uvkc/benchmark/data_type_util.h"
-#include "uvkc/benchmark/main.h"
+#include "uvkc/benchmark/shapes.h"
 #include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
+#include "uvkc/benchmark/verification.h"
 #include "uvkc/benchmark/vulkan_buffer_util.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include "uvkc/vulkan/device.h"
@@ -30,10 +34,15 @@
 using ::uvkc::benchmark::DataType;
 using ::uvkc::benchmark::fp16;
 using ::uvkc::benchmark::GetSize;
-using ::uvkc::benchmark::LatencyMeasureMode;
 using ::uvkc::vulkan::Pipeline;
 
-static const char kBenchmarkName[] = "2d_convolution";
+namespace {
+
+#if defined(UVKC_ADRENO)
+static const char kBenchmarkName[] = "2d_convolution_adreno";
+#elif defined(UVKC_MALI_VALHALL)
+static const char kBenchmarkName[] = "2d_convolution_mali_valhall";
+#endif
 
 struct ShaderCode {
   const uint32_t *code;   // SPIR-V code
@@ -158,35 +167,6 @@ static void Conv2D(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   BM_CHECK_EQ(wg_tile_oc % (wg_size_x * scalar_per_thread), 0)
       << "expected workgroup tile size to be a multiple of workgroup size";
 
-  //===---------------------------------------------------------------------===/
-  // Create shader module, pipeline, and descriptor sets
-  //===---------------------------------------------------------------------===/
-
-  BM_CHECK_OK_AND_ASSIGN(auto shader_module,
-                         device->CreateShaderModule(code, code_num_words));
-
-  Pipeline::SpecConstant spec_constant[] = {
-      {0, Pipeline::SpecConstant::Type::u32, output_h},
-      {1, Pipeline::SpecConstant::Type::u32, output_w},
-      {2, Pipeline::SpecConstant::Type::u32, output_c},
-      {3, Pipeline::SpecConstant::Type::u32, input_h},
-      {4, Pipeline::SpecConstant::Type::u32, input_w},
-      {5, Pipeline::SpecConstant::Type::u32, input_c},
-      {6, Pipeline::SpecConstant::Type::u32, filter_h},
-      {7, Pipeline::SpecConstant::Type::u32, filter_w},
-      {8, Pipeline::SpecConstant::Type::u32, stride_h},
-      {9, Pipeline::SpecConstant::Type::u32, stride_w},
-  };
-  BM_CHECK_OK_AND_ASSIGN(
-      auto pipeline, device->CreatePipeline(*shader_module, "main",
-                                            absl::MakeSpan(spec_constant, 10)));
-
-  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
-                         device->CreateDescriptorPool(*shader_module));
-  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
-                         descriptor_pool->AllocateDescriptorSets(
-                             shader_module->descriptor_set_layouts()));
-
   //===---------------------------------------------------------------------===/
   // Create buffers
   //===---------------------------------------------------------------------===/
@@ -293,39 +273,59 @@ static void Conv2D(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   // Dispatch
   //===---------------------------------------------------------------------===/
 
-  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers{
+  ::uvkc::benchmark::ComputeBenchmark::Options options;
+  options.label = kBenchmarkName;
+  options.code = absl::MakeConstSpan(code, code_num_words);
+  options.buffers = {
       {input_buffer.get(), /*set=*/0, /*binding=*/0},
       {filter_buffer.get(), /*set=*/0, /*binding=*/1},
       {output_buffer.get(), /*set=*/0, /*binding=*/2},
   };
 
-  BM_CHECK_OK(device->AttachBufferToDescriptor(
-      *shader_module, layout_set_map,
-      {bound_buffers.data(), bound_buffers.size()}));
-
-  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
-      << "unexpected number of descriptor sets";
-  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
-
-  std::vector<::uvkc::vulkan::CommandBuffer::BoundDescriptorSet>
-      bound_descriptor_sets(1);
-  bound_descriptor_sets[0].index = 0;
-  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
-  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
+  ::uvkc::benchmark::ComputeBenchmark::Dispatch dispatch;
+  dispatch.spec_constants = {
+      {0, Pipeline::SpecConstant::Type::u32, output_h},
+      {1, Pipeline::SpecConstant::Type::u32, output_w},
+      {2, Pipeline::SpecConstant::Type::u32, output_c},
+      {3, Pipeline::SpecConstant::Type::u32, input_h},
+      {4, Pipeline::SpecConstant::Type::u32, input_w},
+      {5, Pipeline::SpecConstant::Type::u32, input_c},
+      {6, Pipeline::SpecConstant::Type::u32, filter_h},
+      {7, Pipeline::SpecConstant::Type::u32, filter_w},
+      {8, Pipeline::SpecConstant::Type::u32, stride_h},
+      {9, Pipeline::SpecConstant::Type::u32, stride_w},
+  };
+  dispatch.group_count_x = output_c / wg_tile_oc;
+  dispatch.group_count_y = output_w / wg_tile_ow;
+  dispatch.group_count_z = output_h / wg_tile_oh;
+  options.dispatches.push_back(std::move(dispatch));
+
+  // The number of invocations the tiling should launch, checked on the
+  // verification dispatch if possible.
+  options.expected_invocations =
+      uint64_t(output_c / wg_tile_oc) * (output_w / wg_tile_ow) *
+      (output_h / wg_tile_oh) * wg_size_x * wg_size_y * wg_size_z;
+  options.num_operations =
+      // For each output element:
+      double(output_h) * double(output_w) * double(output_c) *
+      // Convolution performs dot product of the filter's size.
+      double(filter_h) * double(filter_w) * double(input_c) * 2;
+  options.report_roofline = true;
+  options.roofline_bytes = double(input_size + filter_size + output_size);
 
-  BM_CHECK_OK(dispatch_cmdbuf->Begin());
-  dispatch_cmdbuf->BindPipelineAndDescriptorSets(
-      *pipeline, {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-  dispatch_cmdbuf->Dispatch(output_c / wg_tile_oc, output_w / wg_tile_ow,
-                            output_h / wg_tile_oh);
-  BM_CHECK_OK(dispatch_cmdbuf->End());
-  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+  BM_CHECK_OK_AND_ASSIGN(auto compute,
+                         ::uvkc::benchmark::ComputeBenchmark::Create(
+                             device, std::move(options)));
+  BM_CHECK_OK(compute->DispatchOnce());
 
   //===---------------------------------------------------------------------===/
   // Verify destination buffer data
   //===---------------------------------------------------------------------===/
 
-  if (data_type == DataType::fp16) {
+  if (::uvkc::benchmark::GetVerifyMode() ==
+      ::uvkc::benchmark::VerifyMode::kNone) {
+    // Skip verification.
+  } else if (data_type == DataType::fp16) {
     BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer(
         device, output_buffer.get(), output_size,
         [&](void *ptr, size_t num_bytes) {
@@ -394,97 +394,41 @@ static void Conv2D(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   // Benchmarking
   //===---------------------------------------------------------------------===/
 
-  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
-  bool use_timestamp =
-      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
-  if (use_timestamp) {
-    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(2));
-  }
-
-  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
-  for (auto _ : state) {
-    BM_CHECK_OK(cmdbuf->Begin());
-    if (use_timestamp) cmdbuf->ResetQueryPool(*query_pool);
-
-    cmdbuf->BindPipelineAndDescriptorSets(
-        *pipeline,
-        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
-    }
-
-    cmdbuf->Dispatch(output_c / wg_tile_oc, output_w / wg_tile_ow,
-                     output_h / wg_tile_oh);
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                             1);
-    }
-
-    BM_CHECK_OK(cmdbuf->End());
-
-    auto start_time = std::chrono::high_resolution_clock::now();
-    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto elapsed_seconds =
-        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
-                                                                  start_time);
-
-    switch (latency_measure->mode) {
-      case LatencyMeasureMode::kSystemDispatch: {
-        state.SetIterationTime(elapsed_seconds.count() -
-                               latency_measure->overhead_seconds);
-      } break;
-      case LatencyMeasureMode::kSystemSubmit: {
-        state.SetIterationTime(elapsed_seconds.count());
-      } break;
-      case LatencyMeasureMode::kGpuTimestamp: {
-        BM_CHECK_OK_AND_ASSIGN(
-            double timestamp_seconds,
-            query_pool->CalculateElapsedSecondsBetween(0, 1));
-        state.SetIterationTime(timestamp_seconds);
-      } break;
-    }
-
-    BM_CHECK_OK(cmdbuf->Reset());
-  }
-
-  double num_operations =
-      // For each output element:
-      double(output_h) * double(output_w) * double(output_c) *
-      // Convolution performs dot product of the filter's size.
-      double(filter_h) * double(filter_w) * double(input_c) * 2;
-  state.counters["FLOps"] =
-      ::benchmark::Counter(num_operations,
-                           ::benchmark::Counter::kIsIterationInvariant |
-                               ::benchmark::Counter::kIsRate,
-                           ::benchmark::Counter::kIs1000);
-
-  // Reset the command pool to release all command buffers in the benchmarking
-  // loop to avoid draining GPU resources.
-  BM_CHECK_OK(device->ResetCommandPool());
+  compute->Measure(state, *latency_measure);
 }
 
+}  // namespace
+
 namespace uvkc {
 namespace benchmark {
-
-absl::StatusOr<std::unique_ptr<VulkanContext>> CreateVulkanContext() {
-  return CreateDefaultVulkanContext(kBenchmarkName);
-}
+namespace {
 
 bool RegisterVulkanOverheadBenchmark(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, double *overhead_seconds) {
+    LazyDevice *device, double *overhead_seconds) {
   return false;
 }
 
 void RegisterVulkanBenchmarks(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, const LatencyMeasure *latency_measure) {
-  const char *gpu_name = physical_device.v10_properties.deviceName;
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
 
+  // Problem shapes are HxWxCxFHxFWxOCxSHxSW: input height, width, and
+  // channels, filter height and width, output channels, and strides.
+  std::vector<Shape> default_shapes;
   for (const auto &data : kDataCases) {
+    default_shapes.push_back({data.input_h, data.input_w, data.input_c,
+                              data.filter_h, data.filter_w, data.output_c,
+                              data.stride_h, data.stride_w});
+  }
+  const std::vector<Shape> shapes =
+      GetShapes("HxWxCxFHxFWxOCxSHxSW", default_shapes);
+
+  for (const Shape &shape : shapes) {
+    const DataScaleCase data = {shape[0], shape[1], shape[2], shape[3],
+                                shape[4], shape[5], shape[6], shape[7]};
+    if (data.input_h < data.filter_h || data.input_w < data.filter_w) continue;
     std::string workload_name = absl::StrCat(
         "Input[1x", data.input_h, "x", data.input_w, "x", data.input_c,
         "]xFilter[", data.filter_h, "x", data.filter_w, "x", data.input_c, "x",
@@ -511,18 +455,26 @@ void RegisterVulkanBenchmarks(
       std::string test_name =
           absl::StrCat(gpu_name, "/", workload_name, "/", shader_name);
 
-      ::benchmark::RegisterBenchmark(
-          test_name.c_str(), Conv2D, device, latency_measure, shader.code,
-          shader.code_num_bytes / sizeof(uint32_t), data.input_h, data.input_w,
-          data.input_c, data.filter_h, data.filter_w, data.output_c,
-          data.stride_h, data.stride_w, shader.wg_size_x, shader.wg_size_y,
-          shader.wg_size_z, wg_tile_oh, wg_tile_ow, wg_tile_oc,
-          shader.scalar_per_thread, shader.data_type)
+      TuningCandidate candidate = {
+          GetTuningDevice(physical_device), "conv2d", FormatShape(shape),
+          GetName(shader.data_type), shader_name};
+      RegisterTuningCandidate(
+          std::move(candidate), test_name, Conv2D, device, latency_measure,
+          shader.code, shader.code_num_bytes / sizeof(uint32_t), data.input_h,
+          data.input_w, data.input_c, data.filter_h, data.filter_w,
+          data.output_c, data.stride_h, data.stride_w, shader.wg_size_x,
+          shader.wg_size_y, shader.wg_size_z, wg_tile_oh, wg_tile_ow,
+          wg_tile_oc, shader.scalar_per_thread, shader.data_type)
           ->UseManualTime()
           ->Unit(::benchmark::kMicrosecond);
     }
   }
 }
 
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
 }  // namespace benchmark
 }  // namespace uvkc
@@ -0,0 +1,508 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "uvkc/benchmark/buffer_pattern.h"
+#include "uvkc/benchmark/data_type_util.h"
+#include "uvkc/benchmark/device_benchmark.h"
+#include "uvkc/benchmark/latency_samples.h"
+#include "uvkc/benchmark/overhead_sampler.h"
+#include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
+#include "uvkc/benchmark/vulkan_buffer_util.h"
+#include "uvkc/benchmark/vulkan_context.h"
+#include "uvkc/vulkan/device.h"
+#include "uvkc/vulkan/pipeline.h"
+
+using ::uvkc::benchmark::BufferPattern;
+using ::uvkc::benchmark::DataType;
+using ::uvkc::benchmark::LatencyMeasureMode;
+using ::uvkc::vulkan::Pipeline;
+
+namespace {
+
+static const char kBenchmarkName[] = "compact_and_process";
+
+static const uint32_t kCompactionShader[] = {
+#include "stream_compaction_shader_spirv_instance.inc"
+};
+
+static const uint32_t kProcessShader[] = {
+#include "process_survivors_shader_spirv_instance.inc"
+};
+
+// Must match the workgroup sizes in the shaders.
+static const uint32_t kWorkgroupSize = 64;
+// Input values are uniformly distributed in [0, kValueRange).
+static const int32_t kValueRange = 1000;
+// Number of LCG iterations applied to each survivor.
+static const uint32_t kNumProcessIterations = 256;
+
+// How the grid size of the processing kernel is derived from the number of
+// survivors produced by the compaction kernel.
+enum class GridSource {
+  // Read the survivor count back to the host and record a direct dispatch.
+  kCpuReadback,
+  // Let the compaction kernel write the grid size for an indirect dispatch.
+  kGpuIndirect,
+};
+
+static const char *GetName(GridSource source) {
+  switch (source) {
+    case GridSource::kCpuReadback:
+      return "cpu_readback";
+    case GridSource::kGpuIndirect:
+      return "gpu_indirect";
+  }
+  return "";
+}
+
+// Mirrors the processing done by process_survivors.glsl.
+static uint32_t ProcessValue(uint32_t value) {
+  for (uint32_t i = 0; i < kNumProcessIterations; ++i) {
+    value = value * 1664525u + 1013904223u;
+  }
+  return value;
+}
+
+// Layout of the buffer shared by both kernels.
+struct DispatchBufferLayout {
+  uint32_t num_workgroups[3];
+  uint32_t num_survivors;
+};
+static const size_t kNumSurvivorsOffset =
+    offsetof(DispatchBufferLayout, num_survivors);
+
+static void CompactAndProcess(
+    ::benchmark::State &state, ::uvkc::vulkan::Device *device,
+    const ::uvkc::benchmark::LatencyMeasure *latency_measure,
+    uint32_t num_elements, int selectivity_percent, GridSource grid_source) {
+  //===-------------------------------------------------------------------===/
+  // Create shader modules, pipelines, and descriptor sets
+  //===-------------------------------------------------------------------===/
+
+  const uint32_t threshold = kValueRange * selectivity_percent / 100;
+
+  BM_CHECK_OK_AND_ASSIGN(
+      auto compaction_module,
+      device->CreateShaderModule(
+          kCompactionShader, sizeof(kCompactionShader) / sizeof(uint32_t)));
+  Pipeline::SpecConstant compaction_spec_constants[3] = {};
+  for (uint32_t i = 0; i < 3; ++i) {
+    compaction_spec_constants[i].id = i;
+    compaction_spec_constants[i].type = Pipeline::SpecConstant::Type::u32;
+  }
+  compaction_spec_constants[0].value.u32 = num_elements;
+  compaction_spec_constants[1].value.u32 = threshold;
+  compaction_spec_constants[2].value.u32 = kWorkgroupSize;
+  BM_CHECK_OK_AND_ASSIGN(
+      auto compaction_pipeline,
+      device->CreatePipeline(*compaction_module, "main",
+                             absl::MakeSpan(compaction_spec_constants)));
+
+  BM_CHECK_OK_AND_ASSIGN(
+      auto process_module,
+      device->CreateShaderModule(kProcessShader,
+                                 sizeof(kProcessShader) / sizeof(uint32_t)));
+  Pipeline::SpecConstant process_spec_constant = {};
+  process_spec_constant.id = 0;
+  process_spec_constant.type = Pipeline::SpecConstant::Type::u32;
+  process_spec_constant.value.u32 = kNumProcessIterations;
+  BM_CHECK_OK_AND_ASSIGN(
+      auto process_pipeline,
+      device->CreatePipeline(*process_module, "main",
+                             absl::MakeSpan(&process_spec_constant, 1)));
+
+  BM_CHECK_OK_AND_ASSIGN(auto compaction_descriptor_pool,
+                         device->CreateDescriptorPool(*compaction_module));
+  BM_CHECK_OK_AND_ASSIGN(auto compaction_layout_set_map,
+                         compaction_descriptor_pool->AllocateDescriptorSets(
+                             compaction_module->descriptor_set_layouts()));
+  BM_CHECK_OK_AND_ASSIGN(auto process_descriptor_pool,
+                         device->CreateDescriptorPool(*process_module));
+  BM_CHECK_OK_AND_ASSIGN(auto process_layout_set_map,
+                         process_descriptor_pool->AllocateDescriptorSets(
+                             process_module->descriptor_set_layouts()));
+
+  //===-------------------------------------------------------------------===/
+  // Create buffers
+  //===-------------------------------------------------------------------===/
+
+  const size_t values_size = num_elements * sizeof(uint32_t);
+  const size_t dispatch_size = sizeof(DispatchBufferLayout);
+
+  BM_CHECK_OK_AND_ASSIGN(
+      auto input_buffer,
+      device->CreateBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, values_size));
+  BM_CHECK_OK_AND_ASSIGN(
+      auto compacted_buffer,
+      device->CreateBuffer(
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, values_size));
+  BM_CHECK_OK_AND_ASSIGN(
+      auto output_buffer,
+      device->CreateBuffer(
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, values_size));
+  BM_CHECK_OK_AND_ASSIGN(
+      auto dispatch_buffer,
+      device->CreateBuffer(
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, dispatch_size));
+  // Host-visible buffer for reading back the survivor count.
+  BM_CHECK_OK_AND_ASSIGN(
+      auto readback_buffer,
+      device->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                           sizeof(uint32_t)));
+
+  //===-------------------------------------------------------------------===/
+  // Set source buffer data
+  //===-------------------------------------------------------------------===/
+
+  const BufferPattern input_pattern =
+      BufferPattern::Random(/*seed=*/42, /*low=*/0, /*high=*/kValueRange);
+  BM_CHECK_OK(::uvkc::benchmark::FillDeviceBufferWithPattern(
+      device, input_buffer.get(), DataType::i32, num_elements, input_pattern));
+
+  // Workgroup counts along Y and Z stay 1; X and the survivor count are
+  // cleared before each run.
+  BM_CHECK_OK(::uvkc::benchmark::SetDeviceBufferViaStagingBuffer(
+      device, dispatch_buffer.get(), dispatch_size,
+      [](void *ptr, size_t num_bytes) {
+        *static_cast<DispatchBufferLayout *>(ptr) = {{0, 1, 1}, 0};
+      }));
+
+  //===-------------------------------------------------------------------===/
+  // Bind descriptor sets
+  //===-------------------------------------------------------------------===/
+
+  std::vector<::uvkc::vulkan::Device::BoundBuffer> compaction_bound_buffers = {
+      {input_buffer.get(), /*set=*/0, /*binding=*/0},
+      {compacted_buffer.get(), /*set=*/0, /*binding=*/1},
+      {dispatch_buffer.get(), /*set=*/0, /*binding=*/2},
+  };
+  BM_CHECK_OK(device->AttachBufferToDescriptor(
+      *compaction_module, compaction_layout_set_map,
+      {compaction_bound_buffers.data(), compaction_bound_buffers.size()}));
+
+  std::vector<::uvkc::vulkan::Device::BoundBuffer> process_bound_buffers = {
+      {compacted_buffer.get(), /*set=*/0, /*binding=*/0},
+      {output_buffer.get(), /*set=*/0, /*binding=*/1},
+      {dispatch_buffer.get(), /*set=*/0, /*binding=*/2},
+  };
+  BM_CHECK_OK(device->AttachBufferToDescriptor(
+      *process_module, process_layout_set_map,
+      {process_bound_buffers.data(), process_bound_buffers.size()}));
+
+  BM_CHECK_EQ(compaction_module->descriptor_set_layouts().size(), 1)
+      << "unexpected number of descriptor sets";
+  BM_CHECK_EQ(process_module->descriptor_set_layouts().size(), 1)
+      << "unexpected number of descriptor sets";
+  std::vector<::uvkc::vulkan::CommandBuffer::BoundDescriptorSet>
+      compaction_descriptor_sets = {
+          {/*index=*/0, compaction_layout_set_map.at(
+                            compaction_module->descriptor_set_layouts()[0])}};
+  std::vector<::uvkc::vulkan::CommandBuffer::BoundDescriptorSet>
+      process_descriptor_sets = {
+          {/*index=*/0, process_layout_set_map.at(
+                            process_module->descriptor_set_layouts()[0])}};
+
+  const uint32_t num_compaction_workgroups =
+      (num_elements + kWorkgroupSize - 1) / kWorkgroupSize;
+
+  // Records clearing the grid size and survivor count followed by the
+  // compaction kernel.
+  auto record_compaction = [&](::uvkc::vulkan::CommandBuffer *cmdbuf) {
+    cmdbuf->FillBuffer(*dispatch_buffer, /*dst_offset=*/0, sizeof(uint32_t),
+                       /*data=*/0);
+    cmdbuf->FillBuffer(*dispatch_buffer, kNumSurvivorsOffset, sizeof(uint32_t),
+                       /*data=*/0);
+    cmdbuf->PipelineBarrier(
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    cmdbuf->BindPipelineAndDescriptorSets(
+        *compaction_pipeline,
+        {compaction_descriptor_sets.data(), compaction_descriptor_sets.size()});
+    cmdbuf->Dispatch(num_compaction_workgroups, 1, 1);
+  };
+
+  // Records copying the survivor count into the host-visible readback buffer.
+  auto record_readback = [&](::uvkc::vulkan::CommandBuffer *cmdbuf) {
+    cmdbuf->PipelineBarrier(
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    cmdbuf->CopyBuffer(*dispatch_buffer, kNumSurvivorsOffset, *readback_buffer,
+                       /*dst_offset=*/0, sizeof(uint32_t));
+    cmdbuf->PipelineBarrier(
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+  };
+
+  // Records the processing kernel with the grid size written by the
+  // compaction kernel.
+  auto record_indirect_process = [&](::uvkc::vulkan::CommandBuffer *cmdbuf) {
+    cmdbuf->DispatchIndirectBarrier();
+    cmdbuf->BindPipelineAndDescriptorSets(
+        *process_pipeline,
+        {process_descriptor_sets.data(), process_descriptor_sets.size()});
+    cmdbuf->DispatchIndirect(*dispatch_buffer, /*offset=*/0);
+  };
+
+  // Records the processing kernel with a host-provided grid size.
+  auto record_direct_process = [&](::uvkc::vulkan::CommandBuffer *cmdbuf,
+                                   uint32_t num_survivors) {
+    cmdbuf->BindPipelineAndDescriptorSets(
+        *process_pipeline,
+        {process_descriptor_sets.data(), process_descriptor_sets.size()});
+    cmdbuf->Dispatch((num_survivors + kWorkgroupSize - 1) / kWorkgroupSize, 1,
+                     1);
+  };
+
+  //===-------------------------------------------------------------------===/
+  // Dispatch
+  //===-------------------------------------------------------------------===/
+
+  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
+  BM_CHECK_OK(dispatch_cmdbuf->Begin());
+  record_compaction(dispatch_cmdbuf.get());
+  record_indirect_process(dispatch_cmdbuf.get());
+  BM_CHECK_OK(dispatch_cmdbuf->End());
+  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+
+  //===-------------------------------------------------------------------===/
+  // Verify destination buffer data
+  //===-------------------------------------------------------------------===/
+
+  uint32_t expected_survivors = 0;
+  uint64_t expected_sum = 0;
+  for (uint32_t i = 0; i < num_elements; ++i) {
+    uint32_t value = input_pattern.ValueAt(i);
+    if (value < threshold) {
+      ++expected_survivors;
+      expected_sum += value;
+    }
+  }
+
+  BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer<
+              DispatchBufferLayout>(
+      device, dispatch_buffer.get(), dispatch_size,
+      [&](absl::Span<const DispatchBufferLayout> data) {
+        const DispatchBufferLayout &dispatch = data[0];
+        BM_CHECK_EQ(dispatch.num_survivors, expected_survivors)
+            << "incorrect number of survivors";
+        BM_CHECK_EQ(dispatch.num_workgroups[0],
+                    (expected_survivors + kWorkgroupSize - 1) / kWorkgroupSize)
+            << "incorrect indirect workgroup count along X";
+        BM_CHECK_EQ(dispatch.num_workgroups[1], 1);
+        BM_CHECK_EQ(dispatch.num_workgroups[2], 1);
+      }));
+
+  // Survivors are compacted in an unspecified order, so check each of them
+  // individually and their sum as a whole.
+  std::vector<uint32_t> compacted(expected_survivors);
+  BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer<uint32_t>(
+      device, compacted_buffer.get(), values_size,
+      [&](absl::Span<const uint32_t> values) {
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < expected_survivors; ++i) {
+          BM_CHECK(values[i] < threshold)
+              << "compacted buffer element #" << i << " has value "
+              << values[i] << " that should have been filtered out";
+          compacted[i] = values[i];
+          sum += values[i];
+        }
+        BM_CHECK_EQ(sum, expected_sum) << "incorrect sum of survivors";
+      }));
+
+  BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer<uint32_t>(
+      device, output_buffer.get(), values_size,
+      [&](absl::Span<const uint32_t> values) {
+        for (uint32_t i = 0; i < expected_survivors; ++i) {
+          uint32_t expected = ProcessValue(compacted[i]);
+          BM_CHECK_EQ(values[i], expected)
+              << "destination buffer element #" << i
+              << " has incorrect value: expected to be " << expected
+              << " but found " << values[i];
+        }
+      }));
+
+  //===-------------------------------------------------------------------===/
+  // Benchmarking
+  //===-------------------------------------------------------------------===/
+
+  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
+  bool use_timestamp =
+      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
+  if (use_timestamp) {
+    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(4));
+  }
+
+  BM_CHECK_OK_AND_ASSIGN(void *readback_ptr,
+                         readback_buffer->MapMemory(0, sizeof(uint32_t)));
+  const auto *num_survivors_ptr = static_cast<const uint32_t *>(readback_ptr);
+
+  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
+  BM_CHECK_OK_AND_ASSIGN(auto process_cmdbuf, device->AllocateCommandBuffer());
+  cmdbuf->set_measured(true);
+  process_cmdbuf->set_measured(true);
+  BM_CHECK_OK_AND_ASSIGN(
+      auto overhead_sampler,
+      ::uvkc::benchmark::OverheadSampler::Create(device, state));
+  ::uvkc::benchmark::LatencySamples latency_samples(state);
+  for (auto _ : state) {
+    BM_CHECK_OK(cmdbuf->Begin());
+    if (use_timestamp) {
+      cmdbuf->ResetQueryPool(*query_pool);
+      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+    }
+    record_compaction(cmdbuf.get());
+    if (grid_source == GridSource::kGpuIndirect) {
+      record_indirect_process(cmdbuf.get());
+    } else {
+      record_readback(cmdbuf.get());
+    }
+    if (use_timestamp) {
+      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             1);
+    }
+    BM_CHECK_OK(cmdbuf->End());
+
+    // For the CPU readback path, the measured time also includes reading the
+    // survivor count and recording the second command buffer, which are
+    // inherent costs of making the grid size decision on the host.
+    int num_submissions = 1;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
+    if (grid_source == GridSource::kCpuReadback) {
+      BM_CHECK_OK(process_cmdbuf->Begin());
+      if (use_timestamp) {
+        process_cmdbuf->WriteTimestamp(*query_pool,
+                                       VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 2);
+      }
+      record_direct_process(process_cmdbuf.get(), *num_survivors_ptr);
+      if (use_timestamp) {
+        process_cmdbuf->WriteTimestamp(
+            *query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 3);
+      }
+      BM_CHECK_OK(process_cmdbuf->End());
+      BM_CHECK_OK(device->QueueSubmitAndWait(*process_cmdbuf));
+      ++num_submissions;
+    }
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds =
+        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
+                                                                  start_time);
+
+    switch (latency_measure->mode) {
+      case LatencyMeasureMode::kSystemDispatch: {
+        // Both submissions bind a pipeline with the same kind of resources,
+        // so one sample stands in for either.
+        BM_CHECK_OK_AND_ASSIGN(
+            double overhead_seconds,
+            overhead_sampler->Sample(
+                *compaction_pipeline,
+                absl::MakeConstSpan(compaction_descriptor_sets)));
+        latency_samples.SetIterationTime(
+            state,
+            elapsed_seconds.count() - num_submissions * overhead_seconds);
+      } break;
+      case LatencyMeasureMode::kSystemSubmit: {
+        latency_samples.SetIterationTime(state, elapsed_seconds.count());
+      } break;
+      case LatencyMeasureMode::kGpuTimestamp: {
+        BM_CHECK_OK_AND_ASSIGN(
+            double timestamp_seconds,
+            query_pool->CalculateElapsedSecondsBetween(0, 1));
+        if (grid_source == GridSource::kCpuReadback) {
+          BM_CHECK_OK_AND_ASSIGN(
+              double process_seconds,
+              query_pool->CalculateElapsedSecondsBetween(2, 3));
+          timestamp_seconds += process_seconds;
+        }
+        latency_samples.SetIterationTime(state, timestamp_seconds);
+      } break;
+    }
+
+    BM_CHECK_OK(cmdbuf->Reset());
+    if (grid_source == GridSource::kCpuReadback) {
+      BM_CHECK_OK(process_cmdbuf->Reset());
+    }
+  }
+  latency_samples.ReportCounters(state);
+  overhead_sampler->ReportCounters(state);
+  readback_buffer->UnmapMemory();
+
+  state.SetItemsProcessed(state.iterations() * num_elements);
+  state.counters["Survivors"] = expected_survivors;
+
+  // Reset the command pool to release all command buffers in the benchmarking
+  // loop to avoid draining GPU resources.
+  BM_CHECK_OK(device->ResetCommandPool());
+}
+
+}  // namespace
+
+namespace uvkc {
+namespace benchmark {
+namespace {
+
+bool RegisterVulkanOverheadBenchmark(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+    LazyDevice *device, double *overhead_seconds) {
+  return false;
+}
+
+void RegisterVulkanBenchmarks(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
+
+  for (uint32_t num_elements : {1u << 16, 1u << 20}) {
+    for (int selectivity_percent : {1, 10, 50, 100}) {
+      for (GridSource grid_source :
+           {GridSource::kCpuReadback, GridSource::kGpuIndirect}) {
+        std::string test_name = absl::StrCat(
+            gpu_name, "/", kBenchmarkName, "/Elements[", num_elements,
+            "]/Selectivity[", selectivity_percent, "%]/", GetName(grid_source));
+        RegisterDeviceBenchmark(test_name, CompactAndProcess, device,
+                                latency_measure, num_elements,
+                                selectivity_percent, grid_source)
+            ->UseManualTime()
+            ->Unit(::benchmark::kMicrosecond);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,46 @@
+// Copyright 2020-2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#version 450
+
+layout (local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+layout(constant_id = 0) const uint kNumIterations = 1;
+
+layout(set = 0, binding = 0) buffer CompactedBuffer {
+    uint compacted_values[];
+};
+
+layout(set = 0, binding = 1) buffer OutputBuffer {
+    uint output_values[];
+};
+
+layout(set = 0, binding = 2) buffer DispatchBuffer {
+    uint num_workgroups_x;
+    uint num_workgroups_y;
+    uint num_workgroups_z;
+    uint num_survivors;
+};
+
+void main() {
+    const uint index = gl_GlobalInvocationID.x;
+    if (index >= num_survivors) return;
+
+    // Iterate a linear congruential generator to give each survivor some work.
+    uint value = compacted_values[index];
+    for (uint i = 0; i < kNumIterations; ++i) {
+        value = value * 1664525u + 1013904223u;
+    }
+    output_values[index] = value;
+}
@@ -0,0 +1,52 @@
+// Copyright 2020-2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#version 450
+
+layout (local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+layout(constant_id = 0) const uint kNumElements = 1;
+layout(constant_id = 1) const uint kThreshold = 0;
+layout(constant_id = 2) const uint kProcessWorkgroupSize = 64;
+
+layout(set = 0, binding = 0) buffer InputBuffer {
+    uint input_values[];
+};
+
+layout(set = 0, binding = 1) buffer CompactedBuffer {
+    uint compacted_values[];
+};
+
+// The first three fields form a VkDispatchIndirectCommand for the next kernel.
+layout(set = 0, binding = 2) buffer DispatchBuffer {
+    uint num_workgroups_x;
+    uint num_workgroups_y;
+    uint num_workgroups_z;
+    uint num_survivors;
+};
+
+void main() {
+    const uint index = gl_GlobalInvocationID.x;
+    if (index >= kNumElements) return;
+
+    const uint value = input_values[index];
+    if (value >= kThreshold) return;
+
+    const uint slot = atomicAdd(num_survivors, 1);
+    compacted_values[slot] = value;
+
+    // Whoever takes the first slot of a new workgroup's worth of survivors
+    // grows the grid of the next kernel by one workgroup.
+    if (slot % kProcessWorkgroupSize == 0) atomicAdd(num_workgroups_x, 1);
+}
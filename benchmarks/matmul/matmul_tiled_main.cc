@@ -12,28 +12,40 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <numeric>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "benchmark/benchmark.h"
+#include "uvkc/benchmark/autotuner.h"
+#include "uvkc/benchmark/buffer_pattern.h"
+#include "uvkc/benchmark/compute_benchmark.h"
 #include "uvkc/benchmark/data_type_util.h"
-#include "uvkc/benchmark/main.h"
+#include "uvkc/benchmark/input_buffer_cache.h"
+#include "uvkc/benchmark/reference_matmul.h"
+#include "uvkc/benchmark/shapes.h"
 #include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
 #include "uvkc/benchmark/vulkan_buffer_util.h"
+#include "uvkc/benchmark/verification.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include "uvkc/benchmark/vulkan_image_util.h"
 #include "uvkc/vulkan/device.h"
 #include "uvkc/vulkan/pipeline.h"
 
 using namespace uvkc::benchmark;
-using ::uvkc::benchmark::LatencyMeasureMode;
 using ::uvkc::vulkan::Pipeline;
 
-static const char kBenchmarkName[] = "matmul_tiled";
+namespace {
+
+#if defined(UVKC_ADRENO)
+static const char kBenchmarkName[] = "matmul_tiled_adreno";
+#elif defined(UVKC_MALI_VALHALL)
+static const char kBenchmarkName[] = "matmul_tiled_mali_valhall";
+#endif
 
 struct ShaderCode {
   const char *name;                 // Shader case name
@@ -206,7 +218,7 @@ static void FillBuffer(DataType data_type, void *raw_buffer, size_t num_bytes,
 
     for (int i = 0; i < dim_1; ++i) {
       for (int j = 0; j < dim_2; ++j) {
-        buffer[j + i * dim_1] =
+        buffer[i * dim_2 + j] =
             static_cast<StorageType>(RuntimeType(generator(i, j)));
       }
     }
@@ -215,9 +227,9 @@ static void FillBuffer(DataType data_type, void *raw_buffer, size_t num_bytes,
   InvokeWithTraits(data_type, fill);
 }
 
-/// Checks that the output 2D matrix calculated by the shader is contains the
-/// same values as runtime matmul of matrices with values defined by |lhs| and
-/// |rhs|.
+/// Checks that the tiles of the output 2D matrix calculated by the shader
+/// that GetTilesToVerify() selects contain the same values as runtime matmul
+/// of matrices with values defined by |lhs| and |rhs|.
 template <DataType OutputType, DataType InputType, typename Generator1Fn,
           typename Generator2Fn>
 static void CheckOutput(const ShaderCode &shader, void *raw_buffer,
@@ -232,21 +244,79 @@ static void CheckOutput(const ShaderCode &shader, void *raw_buffer,
   auto output =
       absl::MakeConstSpan(static_cast<OutputStorageType *>(raw_buffer),
                           num_bytes / GetSize(OutputType));
-  for (int i = 0; i < M; ++i) {
-    for (int j = 0; j < N; ++j) {
-      OutputRuntimeType acc(0.0f);
-      for (int k = 0; k < K; ++k) {
-        acc += OutputRuntimeType(InputRuntimeType(lhs(i, k))) *
-               OutputRuntimeType(InputRuntimeType(rhs(k, j)));
+  for (const OutputTile &tile : GetTilesToVerify(M, N)) {
+    const std::vector<InputRuntimeType> lhs_values =
+        GenerateMatrix<InputRuntimeType>(tile.rows, K, [&](int i, int k) {
+          return lhs(tile.row + i, k);
+        });
+    const std::vector<InputRuntimeType> rhs_values =
+        GenerateMatrix<InputRuntimeType>(K, tile.columns, [&](int k, int j) {
+          return rhs(k, tile.column + j);
+        });
+    std::vector<OutputRuntimeType> expected(tile.rows * tile.columns,
+                                            OutputRuntimeType(0.0f));
+    ReferenceMatMul({tile.rows, tile.columns, int(K), /*transposed_rhs=*/false},
+                    absl::MakeConstSpan(lhs_values),
+                    absl::MakeConstSpan(rhs_values), absl::MakeSpan(expected));
+
+    for (int i = tile.row; i < tile.row + tile.rows; ++i) {
+      for (int j = tile.column; j < tile.column + tile.columns; ++j) {
+        const OutputRuntimeType &acc =
+            expected[(i - tile.row) * tile.columns + (j - tile.column)];
+        OutputRuntimeType gpuValue(output[size_t(i) * N + j]);
+        BM_CHECK_EQ(gpuValue, acc)
+            << "destination buffer element (" << i << "," << j << ")"
+            << " has incorrect value: expected to be " << acc
+            << " but found " << gpuValue << "\n\t^ In shader: " << shader.name
+            << ", " << GetName(shader.input_type) << "->"
+            << GetName(shader.output_type);
       }
+    }
+  }
+}
 
-      OutputRuntimeType gpuValue(output[i * N + j]);
-      BM_CHECK_EQ(gpuValue, acc)
-          << "destination buffer element (" << i << "," << j << ")"
-          << " has incorrect value: expected to be " << acc << " but found "
-          << gpuValue << "\n\t^ In shader: " << shader.name << ", "
+/// Verifies the output 2D matrix in |dst_buffer| as the verify mode requires:
+/// by checking it with CheckOutput(), by comparing its checksum computed on
+/// the GPU with the one of the matrices defined by |lhs| and |rhs|, or not at
+/// all.
+template <DataType OutputType, DataType InputType, typename Generator1Fn,
+          typename Generator2Fn>
+static void VerifyOutput(::uvkc::vulkan::Device *device,
+                         const ShaderCode &shader,
+                         ::uvkc::vulkan::Buffer *dst_buffer,
+                         unsigned M, unsigned N, unsigned K, Generator1Fn lhs,
+                         Generator2Fn rhs) {
+  using InputRuntimeType = typename DataTypeTraits<InputType>::runtime_type;
+
+  switch (GetVerifyMode()) {
+    case VerifyMode::kFull:
+    case VerifyMode::kSampled:
+      BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer(
+          device, dst_buffer, size_t(M) * N * GetSize(OutputType),
+          [&](void *ptr, size_t num_bytes) {
+            CheckOutput<OutputType, InputType>(shader, ptr, num_bytes, M, N, K,
+                                               lhs, rhs);
+          }));
+      break;
+    case VerifyMode::kChecksum: {
+      BM_CHECK_OK_AND_ASSIGN(
+          Checksum actual,
+          ComputeChecksumOnDevice(device, dst_buffer, OutputType, M, N));
+      const std::vector<InputRuntimeType> lhs_values =
+          GenerateMatrix<InputRuntimeType>(M, K, lhs);
+      const std::vector<InputRuntimeType> rhs_values =
+          GenerateMatrix<InputRuntimeType>(K, N, rhs);
+      const Checksum expected = ReferenceMatMulChecksum(
+          {int(M), int(N), int(K), /*transposed_rhs=*/false},
+          absl::MakeConstSpan(lhs_values), absl::MakeConstSpan(rhs_values));
+      BM_CHECK(ChecksumsMatch(OutputType, expected, actual))
+          << "destination buffer has incorrect checksum: expected to be "
+          << expected << " but found " << actual
+          << "\n\t^ In shader: " << shader.name << ", "
           << GetName(shader.input_type) << "->" << GetName(shader.output_type);
-    }
+    } break;
+    case VerifyMode::kNone:
+      break;
   }
 }
 
@@ -254,52 +324,20 @@ static void MatMul(::benchmark::State &state, ::uvkc::vulkan::Device *device,
                    const ::uvkc::benchmark::LatencyMeasure *latency_measure,
                    const ShaderCode &shader, int M, int N, int K) {
   //===-------------------------------------------------------------------===/
-  // Create shader module, pipeline, and descriptor sets
-  //===-------------------------------------------------------------------===/
-
-  BM_CHECK_OK_AND_ASSIGN(
-      auto shader_module,
-      device->CreateShaderModule(shader.code.data(), shader.code.size()));
-
-  ::uvkc::vulkan::Pipeline::SpecConstant spec_constant[3] = {
-      {/*id=*/0, Pipeline::SpecConstant::Type::s32, M},
-      {/*id=*/1, Pipeline::SpecConstant::Type::s32, N},
-      {/*id=*/2, Pipeline::SpecConstant::Type::s32, K},
-  };
-  BM_CHECK_OK_AND_ASSIGN(
-      auto pipeline, device->CreatePipeline(*shader_module, "main",
-                                            absl::MakeSpan(spec_constant, 3)));
-
-  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
-                         device->CreateDescriptorPool(*shader_module));
-  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
-                         descriptor_pool->AllocateDescriptorSets(
-                             shader_module->descriptor_set_layouts()));
-
-  //===-------------------------------------------------------------------===/
   // Create buffers
   //===-------------------------------------------------------------------===/
   DataType input_type = shader.input_type;
   DataType output_type = shader.output_type;
-  const size_t src0_size = M * K * GetSize(input_type);
-  const size_t src1_size = K * N * GetSize(input_type);
-  const size_t dst_size = M * N * GetSize(output_type);
+  const size_t src0_size = size_t(M) * K * GetSize(input_type);
+  const size_t src1_size = size_t(K) * N * GetSize(input_type);
+  const size_t dst_size = size_t(M) * N * GetSize(output_type);
 
-  BM_CHECK_OK_AND_ASSIGN(
-      auto src0_buffer,
-      device->CreateBuffer(
-          VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, src0_size));
-  BM_CHECK_OK_AND_ASSIGN(
-      auto src1_buffer,
-      device->CreateBuffer(
-          VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, src1_size));
   BM_CHECK_OK_AND_ASSIGN(
       auto dst_buffer,
-      device->CreateBuffer(
-          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, dst_size));
+      device->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, dst_size));
 
   VkExtent3D dimensions1 = {uint32_t(N / 8), uint32_t(K), 1};
   BM_CHECK_OK_AND_ASSIGN(
@@ -314,24 +352,28 @@ static void MatMul(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   //===-------------------------------------------------------------------===/
   // Set source buffer data
   //===-------------------------------------------------------------------===/
-  auto getSrc0 = [K](int i, int j) {
-    float v = ((float)((i + j * K) % 5) - 1.0f) / 2.0f;
-    return v;
+  // Small zero-mean integers with coprime periods keep partial sums small, so
+  // every data type computes exact results. The GPU generates them, and they
+  // are reproduced here for verification.
+  const BufferPattern src0_pattern = BufferPattern::Modular(5, /*offset=*/-2);
+  const BufferPattern src1_pattern = BufferPattern::Modular(7, /*offset=*/-3);
+  auto getSrc0 = [&](int i, int j) {
+    return float(src0_pattern.ValueAt(i * K + j));
   };
-  auto getSrc1 = [N](int i, int j) {
-    float v = ((float)((i + j * N) % 7) - 1.0f) / 2.0f;
-    return v;
+  auto getSrc1 = [&](int i, int j) {
+    return float(src1_pattern.ValueAt(i * N + j));
   };
 
-  BM_CHECK_OK(::uvkc::benchmark::SetDeviceBufferViaStagingBuffer(
-      device, src0_buffer.get(), src0_size, [&](void *ptr, size_t num_bytes) {
-        FillBuffer(input_type, ptr, num_bytes, M, K, getSrc0);
-      }));
-
-  BM_CHECK_OK(::uvkc::benchmark::SetDeviceBufferViaStagingBuffer(
-      device, src1_buffer.get(), src1_size, [&](void *ptr, size_t num_bytes) {
-        FillBuffer(input_type, ptr, num_bytes, K, N, getSrc1);
-      }));
+  // Benchmarks of the same problem share source buffers, which shaders only
+  // read.
+  const Shape src0_shape = {M, K};
+  BM_CHECK_OK_AND_ASSIGN(auto src0_buffer,
+                         ::uvkc::benchmark::GetInputBuffer(
+                             device, src0_pattern, input_type, src0_shape));
+  const Shape src1_shape = {K, N};
+  BM_CHECK_OK_AND_ASSIGN(auto src1_buffer,
+                         ::uvkc::benchmark::GetInputBuffer(
+                             device, src1_pattern, input_type, src1_shape));
 
   if (shader.texture) {
     BM_CHECK_OK(::uvkc::benchmark::SetDeviceImageViaStagingBuffer(
@@ -346,84 +388,79 @@ static void MatMul(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   // Clear the output buffer data set by the previous benchmark run
   //===-------------------------------------------------------------------===/
 
-  BM_CHECK_OK(::uvkc::benchmark::SetDeviceBufferViaStagingBuffer(
-      device, dst_buffer.get(), dst_size, [&](void *ptr, size_t num_bytes) {
-        FillBuffer(output_type, ptr, num_bytes, K, N,
-                   [](int, int) { return 0.0f; });
-      }));
+  // All supported output types use all-zero bits to represent zero.
+  BM_CHECK_OK(::uvkc::benchmark::FillDeviceBuffer(device, dst_buffer.get(),
+                                                  /*value=*/0));
 
   //===-------------------------------------------------------------------===/
   // Dispatch
   //===-------------------------------------------------------------------===/
-  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers;
+
+  ::uvkc::benchmark::ComputeBenchmark::Options options;
+  options.label = shader.name;
+  options.code = shader.code;
   if (shader.texture) {
     // For simplicity always bind the B matrix as both texture and buffer.
-    std::vector<::uvkc::vulkan::Device::BoundImage> bound_images = {
+    options.images = {
         {src_image1.get(), src_sampler1.get(), /*set=*/0, /*binding=*/3}};
-    BM_CHECK_OK(device->AttachImageToDescriptor(
-        *shader_module, layout_set_map,
-        {bound_images.data(), bound_images.size()}));
-    bound_buffers = {
+    options.buffers = {
         {src0_buffer.get(), /*set=*/0, /*binding=*/0},
         {dst_buffer.get(), /*set=*/0, /*binding=*/2},
     };
   } else {
-    bound_buffers = {
+    options.buffers = {
         {src0_buffer.get(), /*set=*/0, /*binding=*/0},
         {src1_buffer.get(), /*set=*/0, /*binding=*/1},
         {dst_buffer.get(), /*set=*/0, /*binding=*/2},
     };
   }
-  BM_CHECK_OK(device->AttachBufferToDescriptor(
-      *shader_module, layout_set_map,
-      {bound_buffers.data(), bound_buffers.size()}));
-
-  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
-      << "unexpected number of descriptor sets (" << shader.name << ")";
-  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
-
-  std::vector<::uvkc::vulkan::CommandBuffer::BoundDescriptorSet>
-      bound_descriptor_sets(1);
-  bound_descriptor_sets[0].index = 0;
-  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
-  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
-
-  BM_CHECK_OK(dispatch_cmdbuf->Begin());
-  dispatch_cmdbuf->BindPipelineAndDescriptorSets(
-      *pipeline, {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-  dispatch_cmdbuf->Dispatch(N / shader.tileN, M / shader.tileM, 1);
-  BM_CHECK_OK(dispatch_cmdbuf->End());
-  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+
+  ::uvkc::benchmark::ComputeBenchmark::Dispatch dispatch;
+  dispatch.spec_constants = {
+      {/*id=*/0, Pipeline::SpecConstant::Type::s32, M},
+      {/*id=*/1, Pipeline::SpecConstant::Type::s32, N},
+      {/*id=*/2, Pipeline::SpecConstant::Type::s32, K},
+  };
+  dispatch.group_count_x = N / shader.tileN;
+  dispatch.group_count_y = M / shader.tileM;
+  options.dispatches.push_back(std::move(dispatch));
+
+  // The number of invocations the tiling should launch, checked on the
+  // verification dispatch if possible.
+  options.expected_invocations = uint64_t(N / shader.tileN) *
+                                 (M / shader.tileM) * shader.wg_size_x *
+                                 shader.wg_size_y;
+  options.num_operations = double(N) * double(M) * double(K) * 2.;
+  // Roofline peaks are measured with fp32 multiply-adds.
+  options.report_roofline =
+      input_type == DataType::fp16 || input_type == DataType::fp32;
+  options.roofline_bytes = double(src0_size + src1_size + dst_size);
+
+  BM_CHECK_OK_AND_ASSIGN(auto compute,
+                         ::uvkc::benchmark::ComputeBenchmark::Create(
+                             device, std::move(options)));
+  BM_CHECK_OK(compute->DispatchOnce());
 
   //===-------------------------------------------------------------------===/
   // Verify destination buffer data
   //===-------------------------------------------------------------------===/
 
   if (output_type == DataType::fp16) {
-    BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer(
-        device, dst_buffer.get(), dst_size, [&](void *ptr, size_t num_bytes) {
-          CheckOutput<DataType::fp16, DataType::fp16>(shader, ptr, num_bytes, M,
-                                                      N, K, getSrc0, getSrc1);
-        }));
+    VerifyOutput<DataType::fp16, DataType::fp16>(
+        device, shader, dst_buffer.get(), M, N, K, getSrc0, getSrc1);
   } else if (output_type == DataType::fp32) {
-    BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer(
-        device, dst_buffer.get(), dst_size, [&](void *ptr, size_t num_bytes) {
-          CheckOutput<DataType::fp32, DataType::fp32>(shader, ptr, num_bytes, M,
-                                                      N, K, getSrc0, getSrc1);
-        }));
+    VerifyOutput<DataType::fp32, DataType::fp32>(
+        device, shader, dst_buffer.get(), M, N, K, getSrc0, getSrc1);
   } else if (output_type == DataType::i32) {
-    BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer(
-        device, dst_buffer.get(), dst_size, [&](void *ptr, size_t num_bytes) {
-          if (input_type == DataType::i8) {
-            CheckOutput<DataType::i32, DataType::i8>(shader, ptr, num_bytes, M,
-                                                     N, K, getSrc0, getSrc1);
-          } else if (input_type == DataType::i32) {
-            CheckOutput<DataType::i32, DataType::i32>(shader, ptr, num_bytes, M,
-                                                      N, K, getSrc0, getSrc1);
-          } else {
-            BM_CHECK(false) << "Unhandled input type";
-          }
-        }));
+    if (input_type == DataType::i8) {
+      VerifyOutput<DataType::i32, DataType::i8>(
+          device, shader, dst_buffer.get(), M, N, K, getSrc0, getSrc1);
+    } else if (input_type == DataType::i32) {
+      VerifyOutput<DataType::i32, DataType::i32>(
+          device, shader, dst_buffer.get(), M, N, K, getSrc0, getSrc1);
+    } else {
+      BM_CHECK(false) << "Unhandled input type";
+    }
   } else {
     BM_CHECK(false) << "Unhandled output type";
   }
@@ -432,116 +469,67 @@ static void MatMul(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   // Benchmarking
   //===-------------------------------------------------------------------===/
 
-  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
-  bool use_timestamp =
-      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
-  if (use_timestamp) {
-    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(2));
-  }
-
-  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
-  for (auto _ : state) {
-    BM_CHECK_OK(cmdbuf->Begin());
-    if (use_timestamp) cmdbuf->ResetQueryPool(*query_pool);
-
-    cmdbuf->BindPipelineAndDescriptorSets(
-        *pipeline,
-        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
-    }
-
-    cmdbuf->Dispatch(N / shader.tileN, M / shader.tileM, 1);
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                             1);
-    }
-
-    BM_CHECK_OK(cmdbuf->End());
-
-    auto start_time = std::chrono::high_resolution_clock::now();
-    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto elapsed_seconds =
-        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
-                                                                  start_time);
-
-    switch (latency_measure->mode) {
-      case LatencyMeasureMode::kSystemDispatch: {
-        state.SetIterationTime(elapsed_seconds.count() -
-                               latency_measure->overhead_seconds);
-      } break;
-      case LatencyMeasureMode::kSystemSubmit: {
-        state.SetIterationTime(elapsed_seconds.count());
-      } break;
-      case LatencyMeasureMode::kGpuTimestamp: {
-        BM_CHECK_OK_AND_ASSIGN(
-            double timestamp_seconds,
-            query_pool->CalculateElapsedSecondsBetween(0, 1));
-        state.SetIterationTime(timestamp_seconds);
-      } break;
-    }
-
-    BM_CHECK_OK(cmdbuf->Reset());
-  }
-
-  double numOperation = double(N) * double(M) * double(K) * 2.;
-  state.counters["FLOps"] =
-      ::benchmark::Counter(numOperation,
-                           ::benchmark::Counter::kIsIterationInvariant |
-                               ::benchmark::Counter::kIsRate,
-                           ::benchmark::Counter::kIs1000);
-
-  // Reset the command pool to release all command buffers in the benchmarking
-  // loop to avoid draining GPU resources.
-  BM_CHECK_OK(device->ResetCommandPool());
+  compute->Measure(state, *latency_measure);
 }
 
-namespace uvkc::benchmark {
+}  // namespace
 
-absl::StatusOr<std::unique_ptr<VulkanContext>> CreateVulkanContext() {
-  return CreateDefaultVulkanContext(kBenchmarkName);
-}
+namespace uvkc::benchmark {
+namespace {
 
 bool RegisterVulkanOverheadBenchmark(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, double *overhead_seconds) {
+    LazyDevice *device, double *overhead_seconds) {
   return false;
 }
 
 void RegisterVulkanBenchmarks(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, const LatencyMeasure *latency_measure) {
-  const char *gpu_name = physical_device.v10_properties.deviceName;
-
-  const int M = 1024;
-  const int N = 1024;
-  const int K = 1024;
-
-  for (DataType input_type :
-       {DataType::i8, DataType::i32, DataType::fp32, DataType::fp16}) {
-    for (const ShaderCode &shader : kShaderCodeCases) {
-      if (shader.input_type != input_type) continue;
-      int paddM = (M + shader.tileM - 1) / shader.tileM * shader.tileM;
-      int paddN = (N + shader.tileN - 1) / shader.tileN * shader.tileN;
-      std::string matmul_size = absl::StrCat(M, "x", N, "x", K);
-      std::string tiling_scheme =
-          absl::StrCat(shader.tileM, "x", shader.tileN, "x", shader.tileK);
-      std::string workgroup_size =
-          absl::StrCat(shader.wg_size_x, "x", shader.wg_size_y, "x1");
-      std::string type_info = absl::StrCat(GetName(shader.input_type), "->",
-                                           GetName(shader.output_type));
-      std::string test_name =
-          absl::StrCat(gpu_name, "/Matmul[", matmul_size, "]/", type_info, "/",
-                       shader.name, "/Workgroup[", workgroup_size, "]");
-      ::benchmark::RegisterBenchmark(test_name.c_str(), MatMul, device,
-                                     latency_measure, shader, paddM, paddN, K)
-          ->UseManualTime()
-          ->Unit(::benchmark::kMicrosecond);
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
+
+  // Problem shapes are MxNxK. M and N are padded to the tile size, while K
+  // must be a multiple of it. Benchmarks are named and tuned by the padded
+  // shape they measure.
+  const std::vector<Shape> kDefaultShapes = {{1024, 1024, 1024}};
+  const std::vector<Shape> shapes = GetShapes("MxNxK", kDefaultShapes);
+
+  for (const Shape &shape : shapes) {
+    const int M = shape[0];
+    const int N = shape[1];
+    const int K = shape[2];
+    for (DataType input_type :
+         {DataType::i8, DataType::i32, DataType::fp32, DataType::fp16}) {
+      for (const ShaderCode &shader : kShaderCodeCases) {
+        if (shader.input_type != input_type) continue;
+        if (K % shader.tileK != 0) continue;
+        int paddM = (M + shader.tileM - 1) / shader.tileM * shader.tileM;
+        int paddN = (N + shader.tileN - 1) / shader.tileN * shader.tileN;
+        std::string matmul_size = FormatShape({paddM, paddN, K});
+        std::string tiling_scheme =
+            absl::StrCat(shader.tileM, "x", shader.tileN, "x", shader.tileK);
+        std::string workgroup_size =
+            absl::StrCat(shader.wg_size_x, "x", shader.wg_size_y, "x1");
+        std::string type_info = absl::StrCat(GetName(shader.input_type), "->",
+                                             GetName(shader.output_type));
+        std::string test_name = absl::StrCat(
+            gpu_name, "/Matmul[", matmul_size, "]/", type_info, "/",
+            shader.name, "/Workgroup[", workgroup_size, "]");
+        TuningCandidate candidate = {
+            GetTuningDevice(physical_device), "matmul", matmul_size, type_info,
+            absl::StrCat(shader.name, "/Workgroup[", workgroup_size, "]")};
+        RegisterTuningCandidate(std::move(candidate), test_name, MatMul, device,
+                                latency_measure, shader, paddM, paddN, K)
+            ->UseManualTime()
+            ->Unit(::benchmark::kMicrosecond);
+      }
     }
   }
 }
 
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
 }  // namespace uvkc::benchmark
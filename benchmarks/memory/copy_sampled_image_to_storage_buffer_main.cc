@@ -19,8 +19,11 @@
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "benchmark/benchmark.h"
-#include "uvkc/benchmark/main.h"
+#include "uvkc/benchmark/device_benchmark.h"
+#include "uvkc/benchmark/latency_samples.h"
+#include "uvkc/benchmark/overhead_sampler.h"
 #include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
 #include "uvkc/benchmark/vulkan_buffer_util.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include "uvkc/benchmark/vulkan_image_util.h"
@@ -30,6 +33,8 @@
 
 using ::uvkc::benchmark::LatencyMeasureMode;
 
+namespace {
+
 static const char kBenchmarkName[] = "copy_image_to_buffer";
 
 static uint32_t kShaderCode[] = {
@@ -49,8 +54,8 @@ static ShaderCodeCase kShaderCodeCases[] = {
 static void CopyImageToBuffer(
     ::benchmark::State &state, ::uvkc::vulkan::Device *device,
     ::uvkc::benchmark::LatencyMeasureMode latency_measure_mode,
-    const double *overhead_latency_seconds, const uint32_t *code,
-    size_t code_num_words, uint32_t image_width, uint32_t image_height) {
+    const uint32_t *code, size_t code_num_words, uint32_t image_width,
+    uint32_t image_height) {
   uint32_t buffer_num_bytes = image_width * image_height * sizeof(float);
 
   //===-------------------------------------------------------------------===/
@@ -162,7 +167,12 @@ static void CopyImageToBuffer(
   }
 
   BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
+  cmdbuf->set_measured(true);
   double total_seconds = 0;
+  BM_CHECK_OK_AND_ASSIGN(
+      auto overhead_sampler,
+      ::uvkc::benchmark::OverheadSampler::Create(device, state));
+  ::uvkc::benchmark::LatencySamples latency_samples(state);
   for (auto _ : state) {
     BM_CHECK_OK(cmdbuf->Begin());
     if (use_timestamp) cmdbuf->ResetQueryPool(*query_pool);
@@ -194,7 +204,11 @@ static void CopyImageToBuffer(
     double iteration_seconds = 0;
     switch (latency_measure_mode) {
       case LatencyMeasureMode::kSystemDispatch: {
-        iteration_seconds = cpu_seconds.count() - *overhead_latency_seconds;
+        BM_CHECK_OK_AND_ASSIGN(
+            double overhead_seconds,
+            overhead_sampler->Sample(
+                *pipeline, absl::MakeConstSpan(bound_descriptor_sets)));
+        iteration_seconds = cpu_seconds.count() - overhead_seconds;
       } break;
       case LatencyMeasureMode::kSystemSubmit: {
         iteration_seconds = cpu_seconds.count();
@@ -205,11 +219,13 @@ static void CopyImageToBuffer(
             query_pool->CalculateElapsedSecondsBetween(0, 1));
       } break;
     }
-    state.SetIterationTime(iteration_seconds);
+    latency_samples.SetIterationTime(state, iteration_seconds);
     total_seconds += iteration_seconds;
 
     BM_CHECK_OK(cmdbuf->Reset());
   }
+  latency_samples.ReportCounters(state);
+  overhead_sampler->ReportCounters(state);
   state.SetBytesProcessed(state.iterations() * buffer_num_bytes * 2);  // R + W
 
   // Reset the command pool to release all command buffers in the benchmarking
@@ -217,23 +233,22 @@ static void CopyImageToBuffer(
   BM_CHECK_OK(device->ResetCommandPool());
 }
 
+}  // namespace
+
 namespace uvkc {
 namespace benchmark {
-
-absl::StatusOr<std::unique_ptr<VulkanContext>> CreateVulkanContext() {
-  return CreateDefaultVulkanContext(kBenchmarkName);
-}
+namespace {
 
 bool RegisterVulkanOverheadBenchmark(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, double *overhead_seconds) {
+    LazyDevice *device, double *overhead_seconds) {
   return false;
 }
 
 void RegisterVulkanBenchmarks(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, const LatencyMeasure *latency_measure) {
-  const char *gpu_name = physical_device.v10_properties.deviceName;
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
 
   // TODO: respect VkImageFormatProperties::maxExtent
   for (uint32_t width = (1 << 10); width < (1 << 13); width <<= 1) {  // 1/2/4K
@@ -241,10 +256,10 @@ void RegisterVulkanBenchmarks(
       for (const auto &shader : kShaderCodeCases) {
         std::string test_name =
             absl::StrCat(gpu_name, "/", shader.name, "/", width, "x", height);
-        ::benchmark::RegisterBenchmark(
-            test_name.c_str(), CopyImageToBuffer, device, latency_measure->mode,
-            &latency_measure->overhead_seconds, shader.code,
-            shader.code_num_bytes / sizeof(uint32_t), width, height)
+        RegisterDeviceBenchmark(test_name, CopyImageToBuffer, device,
+                                latency_measure->mode, shader.code,
+                                shader.code_num_bytes / sizeof(uint32_t), width,
+                                height)
             ->UseManualTime()
             ->Unit(::benchmark::kMicrosecond);
       }
@@ -252,5 +267,10 @@ void RegisterVulkanBenchmarks(
   }
 }
 
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
 }  // namespace benchmark
 }  // namespace uvkc
@@ -18,13 +18,15 @@
 #include <chrono>
 #include <cstdint>
 #include <memory>
-#include <numeric>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "benchmark/benchmark.h"
-#include "uvkc/benchmark/main.h"
+#include "uvkc/benchmark/buffer_pattern.h"
+#include "uvkc/benchmark/device_benchmark.h"
+#include "uvkc/benchmark/latency_samples.h"
+#include "uvkc/benchmark/overhead_sampler.h"
 #include "uvkc/benchmark/status_util.h"
 #include "uvkc/benchmark/vulkan_buffer_util.h"
 #include "uvkc/benchmark/vulkan_context.h"
@@ -53,8 +55,8 @@ static ShaderCode kShaderCodeCases[] = {
 static void CopyStorageBuffer(
     ::benchmark::State &state, ::uvkc::vulkan::Device *device,
     ::uvkc::benchmark::LatencyMeasureMode latency_measure_mode,
-    const double *overhead_latency_seconds, const ShaderCode &shader,
-    int buffer_num_bytes, double *avg_latency_seconds) {
+    const ShaderCode &shader, int buffer_num_bytes,
+    double *avg_latency_seconds) {
   //===-------------------------------------------------------------------===/
   // Create shader module, pipeline, and descriptor sets
   //===-------------------------------------------------------------------===/
@@ -88,21 +90,23 @@ static void CopyStorageBuffer(
           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer_num_bytes));
   BM_CHECK_OK_AND_ASSIGN(
       auto dst_buffer,
-      device->CreateBuffer(
-          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer_num_bytes));
+      device->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                           buffer_num_bytes));
 
   //===-------------------------------------------------------------------===/
   // Clear buffer data
   //===-------------------------------------------------------------------===/
 
-  BM_CHECK_OK(::uvkc::benchmark::SetDeviceBufferViaStagingBuffer<float>(
-      device, src_buffer.get(), buffer_num_bytes,
-      [](absl::Span<float> dst) { std::iota(dst.begin(), dst.end(), 0.0f); }));
+  BM_CHECK_OK(::uvkc::benchmark::FillDeviceBufferWithPattern(
+      device, src_buffer.get(), ::uvkc::benchmark::DataType::fp32,
+      buffer_num_bytes / sizeof(float),
+      ::uvkc::benchmark::BufferPattern::Iota()));
 
-  BM_CHECK_OK(::uvkc::benchmark::SetDeviceBufferViaStagingBuffer<float>(
-      device, dst_buffer.get(), buffer_num_bytes,
-      [](absl::Span<float> dst) { std::fill(dst.begin(), dst.end(), 0.0f); }));
+  BM_CHECK_OK(::uvkc::benchmark::FillDeviceBuffer(device, dst_buffer.get(),
+                                                  /*value=*/0));
 
   //===-------------------------------------------------------------------===/
   // Dispatch
@@ -169,7 +173,12 @@ static void CopyStorageBuffer(
   }
 
   BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
+  cmdbuf->set_measured(true);
   double total_seconds = 0;
+  BM_CHECK_OK_AND_ASSIGN(
+      auto overhead_sampler,
+      ::uvkc::benchmark::OverheadSampler::Create(device, state));
+  ::uvkc::benchmark::LatencySamples latency_samples(state);
   for (auto _ : state) {
     BM_CHECK_OK(cmdbuf->Begin());
     if (use_timestamp) cmdbuf->ResetQueryPool(*query_pool);
@@ -201,7 +210,11 @@ static void CopyStorageBuffer(
     double iteration_seconds = 0;
     switch (latency_measure_mode) {
       case LatencyMeasureMode::kSystemDispatch: {
-        iteration_seconds = cpu_seconds.count() - *overhead_latency_seconds;
+        BM_CHECK_OK_AND_ASSIGN(
+            double overhead_seconds,
+            overhead_sampler->Sample(
+                *pipeline, absl::MakeConstSpan(bound_descriptor_sets)));
+        iteration_seconds = cpu_seconds.count() - overhead_seconds;
       } break;
       case LatencyMeasureMode::kSystemSubmit: {
         iteration_seconds = cpu_seconds.count();
@@ -212,11 +225,13 @@ static void CopyStorageBuffer(
             query_pool->CalculateElapsedSecondsBetween(0, 1));
       } break;
     }
-    state.SetIterationTime(iteration_seconds);
+    latency_samples.SetIterationTime(state, iteration_seconds);
     total_seconds += iteration_seconds;
 
     BM_CHECK_OK(cmdbuf->Reset());
   }
+  latency_samples.ReportCounters(state);
+  overhead_sampler->ReportCounters(state);
   state.SetBytesProcessed(state.iterations() * buffer_num_bytes * 2);  // R + W
   *avg_latency_seconds = total_seconds / state.iterations();
 
@@ -230,15 +245,15 @@ namespace uvkc::benchmark::memory {
 absl::Span<const ShaderCode> GetShaderCodeCases() { return kShaderCodeCases; }
 
 void RegisterCopyStorageBufferBenchmark(
-    const char *gpu_name, vulkan::Device *device, size_t buffer_num_bytes,
+    const char *gpu_name, LazyDevice *device, size_t buffer_num_bytes,
     const ShaderCode &shader, LatencyMeasureMode latency_measure_mode,
-    const double *overhead_latency_seconds, double *avg_latency_seconds) {
+    double *avg_latency_seconds) {
   std::string test_name = absl::StrCat(
       gpu_name, "/copy_storage_buffer/", shader.name, "/PerThread[",
       shader.elements_per_thread, "]/Bytes[", buffer_num_bytes, "]");
-  ::benchmark::RegisterBenchmark(test_name.c_str(), CopyStorageBuffer, device,
-                                 latency_measure_mode, overhead_latency_seconds,
-                                 shader, buffer_num_bytes, avg_latency_seconds)
+  RegisterDeviceBenchmark(test_name, CopyStorageBuffer, device,
+                          latency_measure_mode, shader, buffer_num_bytes,
+                          avg_latency_seconds)
       ->UseManualTime()
       ->Unit(::benchmark::kMicrosecond);
 }
@@ -33,9 +33,9 @@ absl::Span<const ShaderCode> GetShaderCodeCases();
 // binding#1) on |device| with the given |gpu_name|. Writes the average latency
 // to |avg_latency_seconds| after benchmarking.
 void RegisterCopyStorageBufferBenchmark(
-    const char *gpu_name, vulkan::Device *device, size_t buffer_num_bytes,
+    const char *gpu_name, LazyDevice *device, size_t buffer_num_bytes,
     const ShaderCode &shader, LatencyMeasureMode latency_measure_mode,
-    const double *overhead_latency_seconds, double *avg_latency_seconds);
+    double *avg_latency_seconds);
 
 }  // namespace uvkc::benchmark::memory
 
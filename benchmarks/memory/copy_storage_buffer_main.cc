@@ -13,37 +13,39 @@
 // limitations under the License.
 
 #include "benchmarks/memory/copy_storage_buffer.h"
-#include "uvkc/benchmark/main.h"
+#include "uvkc/benchmark/suite.h"
 #include "uvkc/vulkan/device.h"
 
 static const char kBenchmarkName[] = "copy_storage_buffer";
 
 namespace uvkc::benchmark {
-
-absl::StatusOr<std::unique_ptr<VulkanContext>> CreateVulkanContext() {
-  return CreateDefaultVulkanContext(kBenchmarkName);
-}
+namespace {
 
 bool RegisterVulkanOverheadBenchmark(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, double *overhead_seconds) {
+    LazyDevice *device, double *overhead_seconds) {
   return false;
 }
 
 void RegisterVulkanBenchmarks(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, const LatencyMeasure *latency_measure) {
-  const char *gpu_name = physical_device.v10_properties.deviceName;
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
 
   for (int shift = 20; shift < 26; ++shift) {  // Number of bytes: 1M -> 32M
     int num_bytes = 1 << shift;
     for (const memory::ShaderCode &shader : memory::GetShaderCodeCases()) {
       double avg_latency_seconds = 0;
       memory::RegisterCopyStorageBufferBenchmark(
-          gpu_name, device, num_bytes, shader, latency_measure->mode,
-          &latency_measure->overhead_seconds, &avg_latency_seconds);
+          gpu_name.c_str(), device, num_bytes, shader, latency_measure->mode,
+          &avg_latency_seconds);
     }
   }
 }
 
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
 }  // namespace uvkc::benchmark
@@ -0,0 +1,300 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "uvkc/benchmark/device_benchmark.h"
+#include "uvkc/benchmark/latency_samples.h"
+#include "uvkc/benchmark/overhead_sampler.h"
+#include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
+#include "uvkc/benchmark/vulkan_buffer_util.h"
+#include "uvkc/benchmark/vulkan_context.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/device.h"
+
+using ::uvkc::benchmark::LatencyMeasureMode;
+using ::uvkc::vulkan::CommandBuffer;
+
+namespace {
+
+static const char kBenchmarkName[] = "barrier_chain";
+
+static const uint32_t kShader[] = {
+#include "barrier_chain_shader_spirv_instance.inc"
+};
+
+// Must match the workgroup size in the shader.
+static const uint32_t kWorkgroupSize = 64;
+
+// How consecutive dispatches in the chain are synchronized.
+enum class BarrierScope {
+  // No barriers at all. Results are racy and not verified; this gives the
+  // lower bound of back-to-back dispatches.
+  kNone,
+  // A global memory barrier covering all buffers.
+  kGlobal,
+  // A buffer memory barrier covering only the buffer being updated.
+  kBuffer,
+};
+
+static const char *GetName(BarrierScope scope) {
+  switch (scope) {
+    case BarrierScope::kNone:
+      return "none";
+    case BarrierScope::kGlobal:
+      return "global";
+    case BarrierScope::kBuffer:
+      return "buffer";
+  }
+  return "";
+}
+
+static void BarrierChain(
+    ::benchmark::State &state, ::uvkc::vulkan::Device *device,
+    const ::uvkc::benchmark::LatencyMeasure *latency_measure,
+    uint32_t num_workgroups, int chain_length, BarrierScope scope) {
+  //===-------------------------------------------------------------------===/
+  // Create shader module, pipeline, and descriptor sets
+  //===-------------------------------------------------------------------===/
+
+  BM_CHECK_OK_AND_ASSIGN(
+      auto shader_module,
+      device->CreateShaderModule(kShader, sizeof(kShader) / sizeof(uint32_t)));
+  BM_CHECK_OK_AND_ASSIGN(auto pipeline,
+                         device->CreatePipeline(*shader_module, "main", {}));
+
+  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
+                         device->CreateDescriptorPool(*shader_module));
+  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
+                         descriptor_pool->AllocateDescriptorSets(
+                             shader_module->descriptor_set_layouts()));
+
+  //===-------------------------------------------------------------------===/
+  // Create buffers
+  //===-------------------------------------------------------------------===/
+
+  const uint32_t num_elements = num_workgroups * kWorkgroupSize;
+  const size_t buffer_size = num_elements * sizeof(uint32_t);
+
+  BM_CHECK_OK_AND_ASSIGN(
+      auto data_buffer,
+      device->CreateBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer_size));
+
+  //===-------------------------------------------------------------------===/
+  // Set source buffer data
+  //===-------------------------------------------------------------------===/
+
+  BM_CHECK_OK(::uvkc::benchmark::FillDeviceBuffer(device, data_buffer.get(),
+                                                  /*value=*/0));
+
+  //===-------------------------------------------------------------------===/
+  // Dispatch
+  //===-------------------------------------------------------------------===/
+
+  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers = {
+      {data_buffer.get(), /*set=*/0, /*binding=*/0},
+  };
+  BM_CHECK_OK(device->AttachBufferToDescriptor(
+      *shader_module, layout_set_map,
+      {bound_buffers.data(), bound_buffers.size()}));
+
+  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
+      << "unexpected number of descriptor sets";
+  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
+
+  std::vector<CommandBuffer::BoundDescriptorSet> bound_descriptor_sets(1);
+  bound_descriptor_sets[0].index = 0;
+  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
+
+  // Each dispatch both reads and writes what the previous one wrote, so both
+  // read-after-write and write-after-write hazards need to be covered.
+  const VkAccessFlags src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+  const VkAccessFlags dst_access_mask =
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+  const CommandBuffer::BufferBarrier buffer_barrier = {
+      data_buffer.get(), /*offset=*/0, buffer_size, src_access_mask,
+      dst_access_mask};
+
+  auto record_chain = [&](CommandBuffer *cmdbuf) {
+    cmdbuf->BindPipelineAndDescriptorSets(
+        *pipeline,
+        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
+    for (int i = 0; i < chain_length; ++i) {
+      if (i != 0) {
+        switch (scope) {
+          case BarrierScope::kNone:
+            break;
+          case BarrierScope::kGlobal:
+            cmdbuf->PipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    src_access_mask,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    dst_access_mask);
+            break;
+          case BarrierScope::kBuffer:
+            cmdbuf->PipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                    absl::MakeSpan(&buffer_barrier, 1));
+            break;
+        }
+      }
+      cmdbuf->Dispatch(num_workgroups, 1, 1);
+    }
+  };
+
+  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
+  BM_CHECK_OK(dispatch_cmdbuf->Begin());
+  record_chain(dispatch_cmdbuf.get());
+  BM_CHECK_OK(dispatch_cmdbuf->End());
+  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+
+  //===-------------------------------------------------------------------===/
+  // Verify destination buffer data
+  //===-------------------------------------------------------------------===/
+
+  if (scope != BarrierScope::kNone) {
+    BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer<uint32_t>(
+        device, data_buffer.get(), buffer_size,
+        [&](absl::Span<const uint32_t> values) {
+          for (uint32_t i = 0; i < num_elements; ++i) {
+            BM_CHECK_EQ(values[i], chain_length)
+                << "destination buffer element #" << i
+                << " has incorrect value: expected to be " << chain_length
+                << " but found " << values[i];
+          }
+        }));
+  }
+
+  //===-------------------------------------------------------------------===/
+  // Benchmarking
+  //===-------------------------------------------------------------------===/
+
+  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
+  bool use_timestamp =
+      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
+  if (use_timestamp) {
+    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(2));
+  }
+
+  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
+  cmdbuf->set_measured(true);
+  BM_CHECK_OK_AND_ASSIGN(
+      auto overhead_sampler,
+      ::uvkc::benchmark::OverheadSampler::Create(device, state));
+  ::uvkc::benchmark::LatencySamples latency_samples(state);
+  for (auto _ : state) {
+    BM_CHECK_OK(cmdbuf->Begin());
+    if (use_timestamp) {
+      cmdbuf->ResetQueryPool(*query_pool);
+      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+    }
+    record_chain(cmdbuf.get());
+    if (use_timestamp) {
+      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             1);
+    }
+    BM_CHECK_OK(cmdbuf->End());
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds =
+        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
+                                                                  start_time);
+
+    switch (latency_measure->mode) {
+      case LatencyMeasureMode::kSystemDispatch: {
+        BM_CHECK_OK_AND_ASSIGN(
+            double overhead_seconds,
+            overhead_sampler->Sample(
+                *pipeline, absl::MakeConstSpan(bound_descriptor_sets)));
+        latency_samples.SetIterationTime(
+            state, elapsed_seconds.count() - overhead_seconds);
+      } break;
+      case LatencyMeasureMode::kSystemSubmit: {
+        latency_samples.SetIterationTime(state, elapsed_seconds.count());
+      } break;
+      case LatencyMeasureMode::kGpuTimestamp: {
+        BM_CHECK_OK_AND_ASSIGN(
+            double timestamp_seconds,
+            query_pool->CalculateElapsedSecondsBetween(0, 1));
+        latency_samples.SetIterationTime(state, timestamp_seconds);
+      } break;
+    }
+
+    BM_CHECK_OK(cmdbuf->Reset());
+  }
+  latency_samples.ReportCounters(state);
+  overhead_sampler->ReportCounters(state);
+
+  // Report dispatches per second so chains of different lengths compare.
+  state.SetItemsProcessed(state.iterations() * chain_length);
+  state.SetLabel(device->optional_features().synchronization2
+                     ? "synchronization2"
+                     : "synchronization1");
+
+  // Reset the command pool to release all command buffers in the benchmarking
+  // loop to avoid draining GPU resources.
+  BM_CHECK_OK(device->ResetCommandPool());
+}
+
+}  // namespace
+
+namespace uvkc {
+namespace benchmark {
+namespace {
+
+bool RegisterVulkanOverheadBenchmark(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+    LazyDevice *device, double *overhead_seconds) {
+  return false;
+}
+
+void RegisterVulkanBenchmarks(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
+
+  for (uint32_t num_workgroups : {1u, 64u}) {
+    for (int chain_length : {1, 4, 16, 64, 256}) {
+      for (BarrierScope scope : {BarrierScope::kNone, BarrierScope::kGlobal,
+                                 BarrierScope::kBuffer}) {
+        std::string test_name = absl::StrCat(
+            gpu_name, "/", kBenchmarkName, "/Workgroups[", num_workgroups,
+            "]/Chain[", chain_length, "]/", GetName(scope));
+        RegisterDeviceBenchmark(test_name, BarrierChain, device,
+                                latency_measure, num_workgroups, chain_length,
+                                scope)
+            ->UseManualTime()
+            ->Unit(::benchmark::kMicrosecond);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
+}  // namespace benchmark
+}  // namespace uvkc
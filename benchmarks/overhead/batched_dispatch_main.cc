@@ -0,0 +1,263 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "uvkc/benchmark/device_benchmark.h"
+#include "uvkc/benchmark/dispatch_timer.h"
+#include "uvkc/benchmark/latency_samples.h"
+#include "uvkc/benchmark/overhead_sampler.h"
+#include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
+#include "uvkc/benchmark/vulkan_buffer_util.h"
+#include "uvkc/benchmark/vulkan_context.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/device.h"
+
+using ::uvkc::benchmark::DispatchTimer;
+using ::uvkc::benchmark::LatencyMeasureMode;
+using ::uvkc::vulkan::CommandBuffer;
+
+namespace {
+
+static const char kBenchmarkName[] = "batched_dispatch";
+
+static const uint32_t kShader[] = {
+#include "barrier_chain_shader_spirv_instance.inc"
+};
+
+// Must match the workgroup size in the shader.
+static const uint32_t kWorkgroupSize = 64;
+
+static void BatchedDispatch(
+    ::benchmark::State &state, ::uvkc::vulkan::Device *device,
+    const ::uvkc::benchmark::LatencyMeasure *latency_measure,
+    uint32_t num_workgroups, int batch_size) {
+  //===-------------------------------------------------------------------===/
+  // Create shader module, pipeline, and descriptor sets
+  //===-------------------------------------------------------------------===/
+
+  BM_CHECK_OK_AND_ASSIGN(
+      auto shader_module,
+      device->CreateShaderModule(kShader, sizeof(kShader) / sizeof(uint32_t)));
+  BM_CHECK_OK_AND_ASSIGN(auto pipeline,
+                         device->CreatePipeline(*shader_module, "main", {}));
+
+  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
+                         device->CreateDescriptorPool(*shader_module));
+  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
+                         descriptor_pool->AllocateDescriptorSets(
+                             shader_module->descriptor_set_layouts()));
+
+  //===-------------------------------------------------------------------===/
+  // Create buffers
+  //===-------------------------------------------------------------------===/
+
+  const uint32_t num_elements = num_workgroups * kWorkgroupSize;
+  const size_t buffer_size = num_elements * sizeof(uint32_t);
+
+  BM_CHECK_OK_AND_ASSIGN(
+      auto data_buffer,
+      device->CreateBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer_size));
+
+  //===-------------------------------------------------------------------===/
+  // Set source buffer data
+  //===-------------------------------------------------------------------===/
+
+  BM_CHECK_OK(::uvkc::benchmark::FillDeviceBuffer(device, data_buffer.get(),
+                                                  /*value=*/0));
+
+  //===-------------------------------------------------------------------===/
+  // Dispatch
+  //===-------------------------------------------------------------------===/
+
+  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers = {
+      {data_buffer.get(), /*set=*/0, /*binding=*/0},
+  };
+  BM_CHECK_OK(device->AttachBufferToDescriptor(
+      *shader_module, layout_set_map,
+      {bound_buffers.data(), bound_buffers.size()}));
+
+  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
+      << "unexpected number of descriptor sets";
+  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
+
+  std::vector<CommandBuffer::BoundDescriptorSet> bound_descriptor_sets(1);
+  bound_descriptor_sets[0].index = 0;
+  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
+
+  // Each dispatch both reads and writes what the previous one wrote, so both
+  // read-after-write and write-after-write hazards need to be covered.
+  const CommandBuffer::BufferBarrier buffer_barrier = {
+      data_buffer.get(), /*offset=*/0, buffer_size, VK_ACCESS_SHADER_WRITE_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+
+  // Records a batch of dependent dispatches. If |timer| is not null, a
+  // timestamp is written after each dispatch.
+  auto record_batch = [&](CommandBuffer *cmdbuf, DispatchTimer *timer) {
+    cmdbuf->BindPipelineAndDescriptorSets(
+        *pipeline,
+        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
+    for (int i = 0; i < batch_size; ++i) {
+      if (i != 0) {
+        cmdbuf->PipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                absl::MakeSpan(&buffer_barrier, 1));
+      }
+      cmdbuf->Dispatch(num_workgroups, 1, 1);
+      if (timer) timer->EndDispatch(cmdbuf);
+    }
+  };
+
+  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
+  BM_CHECK_OK(dispatch_cmdbuf->Begin());
+  record_batch(dispatch_cmdbuf.get(), /*timer=*/nullptr);
+  BM_CHECK_OK(dispatch_cmdbuf->End());
+  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+
+  //===-------------------------------------------------------------------===/
+  // Verify destination buffer data
+  //===-------------------------------------------------------------------===/
+
+  BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer<uint32_t>(
+      device, data_buffer.get(), buffer_size,
+      [&](absl::Span<const uint32_t> values) {
+        for (uint32_t i = 0; i < num_elements; ++i) {
+          BM_CHECK_EQ(values[i], batch_size)
+              << "destination buffer element #" << i
+              << " has incorrect value: expected to be " << batch_size
+              << " but found " << values[i];
+        }
+      }));
+
+  //===-------------------------------------------------------------------===/
+  // Benchmarking
+  //===-------------------------------------------------------------------===/
+
+  // Dispatches are only timed individually when measuring with timestamps,
+  // to keep timestamp writes out of the work timed on the host. Each batch is
+  // waited on before recording the next one, so only one batch is pending at a
+  // time.
+  std::unique_ptr<DispatchTimer> timer;
+  if (latency_measure->mode == LatencyMeasureMode::kGpuTimestamp) {
+    BM_CHECK_OK_AND_ASSIGN(timer,
+                           DispatchTimer::Create(device, batch_size,
+                                                 /*max_pending_batches=*/1));
+  }
+
+  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
+  cmdbuf->set_measured(true);
+  BM_CHECK_OK_AND_ASSIGN(
+      auto overhead_sampler,
+      ::uvkc::benchmark::OverheadSampler::Create(device, state));
+  ::uvkc::benchmark::LatencySamples latency_samples(state);
+  for (auto _ : state) {
+    BM_CHECK_OK(cmdbuf->Begin());
+    if (timer) BM_CHECK_OK(timer->BeginBatch(cmdbuf.get()));
+    record_batch(cmdbuf.get(), timer.get());
+    BM_CHECK_OK(cmdbuf->End());
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds =
+        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
+                                                                  start_time);
+    if (timer) BM_CHECK_OK(timer->Collect());
+
+    switch (latency_measure->mode) {
+      case LatencyMeasureMode::kSystemDispatch: {
+        BM_CHECK_OK_AND_ASSIGN(
+            double overhead_seconds,
+            overhead_sampler->Sample(
+                *pipeline, absl::MakeConstSpan(bound_descriptor_sets)));
+        latency_samples.SetIterationTime(
+            state, elapsed_seconds.count() - overhead_seconds);
+      } break;
+      case LatencyMeasureMode::kSystemSubmit: {
+        latency_samples.SetIterationTime(state, elapsed_seconds.count());
+      } break;
+      case LatencyMeasureMode::kGpuTimestamp: {
+        latency_samples.SetIterationTime(state, timer->last_batch_seconds());
+      } break;
+    }
+
+    BM_CHECK_OK(cmdbuf->Reset());
+  }
+  latency_samples.ReportCounters(state);
+  overhead_sampler->ReportCounters(state);
+
+  if (timer) {
+    DispatchTimer::Summary summary = timer->Summarize();
+    state.counters["FirstDispatch(us)"] = summary.first_dispatch_seconds * 1e6;
+    if (batch_size > 1) {
+      state.counters["SteadyState(us)"] = summary.steady_state_seconds * 1e6;
+      state.counters["SteadyStateMin(us)"] =
+          summary.steady_state_min_seconds * 1e6;
+      state.counters["SteadyStateMax(us)"] =
+          summary.steady_state_max_seconds * 1e6;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+
+  // Reset the command pool to release all command buffers in the benchmarking
+  // loop to avoid draining GPU resources.
+  BM_CHECK_OK(device->ResetCommandPool());
+}
+
+}  // namespace
+
+namespace uvkc {
+namespace benchmark {
+namespace {
+
+bool RegisterVulkanOverheadBenchmark(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+    LazyDevice *device, double *overhead_seconds) {
+  return false;
+}
+
+void RegisterVulkanBenchmarks(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
+
+  for (uint32_t num_workgroups : {1u, 1024u}) {
+    for (int batch_size : {1, 4, 16, 64}) {
+      std::string test_name =
+          absl::StrCat(gpu_name, "/", kBenchmarkName, "/Workgroups[",
+                       num_workgroups, "]/Batch[", batch_size, "]");
+      RegisterDeviceBenchmark(test_name, BatchedDispatch, device,
+                              latency_measure, num_workgroups, batch_size)
+          ->UseManualTime()
+          ->Unit(::benchmark::kMicrosecond);
+    }
+  }
+}
+
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -16,8 +16,8 @@
 
 #include "benchmark/benchmark.h"
 #include "uvkc/benchmark/dispatch_void_shader.h"
-#include "uvkc/benchmark/main.h"
 #include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include "uvkc/vulkan/device.h"
 
@@ -25,29 +25,36 @@ static const char kBenchmarkName[] = "dispatch_void_shader";
 
 namespace uvkc {
 namespace benchmark {
-
-absl::StatusOr<std::unique_ptr<VulkanContext>> CreateVulkanContext() {
-  return CreateDefaultVulkanContext(kBenchmarkName);
-}
+namespace {
 
 bool RegisterVulkanOverheadBenchmark(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, double *overhead_seconds) {
+    LazyDevice *device, double *overhead_seconds) {
   return false;
 }
 
 void RegisterVulkanBenchmarks(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, const LatencyMeasure *latency_measure) {
-  BM_CHECK_EQ(latency_measure->mode,
-              ::uvkc::benchmark::LatencyMeasureMode::kSystemSubmit)
-      << kBenchmarkName << " only supports system_submit latency measure mode";
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  if (latency_measure->mode != LatencyMeasureMode::kSystemSubmit) {
+    // Other suites linked into the same binary may still run in this mode.
+    BM_CHECK(GetBenchmarkSuites().size() > 1)
+        << kBenchmarkName
+        << " only supports system_submit latency measure mode";
+    return;
+  }
 
   double void_dispatch_latency_seconds = 0;
-  const char *gpu_name = physical_device.v10_properties.deviceName;
-  RegisterDispatchVoidShaderBenchmark(gpu_name, device,
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
+  RegisterDispatchVoidShaderBenchmark(gpu_name.c_str(), device,
+                                      latency_measure->breakdown,
                                       &void_dispatch_latency_seconds);
 }
 
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
 }  // namespace benchmark
 }  // namespace uvkc
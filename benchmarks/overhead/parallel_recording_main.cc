@@ -0,0 +1,374 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "uvkc/benchmark/device_benchmark.h"
+#include "uvkc/benchmark/latency_samples.h"
+#include "uvkc/benchmark/overhead_sampler.h"
+#include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
+#include "uvkc/benchmark/vulkan_buffer_util.h"
+#include "uvkc/benchmark/vulkan_context.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/command_pool.h"
+#include "uvkc/vulkan/device.h"
+
+using ::uvkc::benchmark::LatencyMeasureMode;
+using ::uvkc::vulkan::CommandBuffer;
+
+namespace {
+
+static const char kBenchmarkName[] = "parallel_recording";
+
+static const uint32_t kShader[] = {
+#include "barrier_chain_shader_spirv_instance.inc"
+};
+
+// Must match the workgroup size in the shader.
+static const uint32_t kWorkgroupSize = 64;
+
+// Number of dispatches recorded per command buffer submission.
+static const int kNumDispatches = 1000;
+
+// A fixed set of threads that each run a task once per round. Keeping the
+// threads alive across rounds avoids measuring thread creation.
+class WorkerPool {
+ public:
+  // Starts |num_threads| threads that each call |task| with their thread index
+  // once per Run().
+  WorkerPool(int num_threads, std::function<void(int)> task)
+      : task_(std::move(task)) {
+    for (int i = 0; i < num_threads; ++i) {
+      threads_.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+  }
+
+  ~WorkerPool() {
+    {
+      absl::MutexLock lock(&mutex_);
+      shutdown_ = true;
+    }
+    for (auto &thread : threads_) thread.join();
+  }
+
+  // Runs the task on all threads and waits for all of them to finish.
+  void Run() {
+    absl::MutexLock lock(&mutex_);
+    ++round_;
+    num_pending_ = threads_.size();
+    auto all_done = [this]() { return num_pending_ == 0; };
+    mutex_.Await(absl::Condition(&all_done));
+  }
+
+ private:
+  void WorkerLoop(int index) {
+    uint64_t last_round = 0;
+    while (true) {
+      {
+        absl::MutexLock lock(&mutex_);
+        auto has_work = [this, last_round]() {
+          return shutdown_ || round_ != last_round;
+        };
+        mutex_.Await(absl::Condition(&has_work));
+        if (shutdown_) return;
+        last_round = round_;
+      }
+      task_(index);
+      absl::MutexLock lock(&mutex_);
+      --num_pending_;
+    }
+  }
+
+  std::function<void(int)> task_;
+  std::vector<std::thread> threads_;
+
+  absl::Mutex mutex_;
+  uint64_t round_ = 0;
+  int num_pending_ = 0;
+  bool shutdown_ = false;
+};
+
+// Records kNumDispatches dispatches into a primary command buffer. With
+// |num_threads| == 0, they are recorded directly into the primary command
+// buffer on the calling thread. Otherwise they are split evenly among
+// |num_threads| secondary command buffers recorded in parallel, each from its
+// own command pool.
+static void ParallelRecording(
+    ::benchmark::State &state, ::uvkc::vulkan::Device *device,
+    const ::uvkc::benchmark::LatencyMeasure *latency_measure,
+    int num_threads) {
+  //===-------------------------------------------------------------------===/
+  // Create shader module, pipeline, and descriptor sets
+  //===-------------------------------------------------------------------===/
+
+  BM_CHECK_OK_AND_ASSIGN(
+      auto shader_module,
+      device->CreateShaderModule(kShader, sizeof(kShader) / sizeof(uint32_t)));
+  BM_CHECK_OK_AND_ASSIGN(auto pipeline,
+                         device->CreatePipeline(*shader_module, "main", {}));
+
+  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
+                         device->CreateDescriptorPool(*shader_module));
+  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
+                         descriptor_pool->AllocateDescriptorSets(
+                             shader_module->descriptor_set_layouts()));
+
+  //===-------------------------------------------------------------------===/
+  // Create buffers
+  //===-------------------------------------------------------------------===/
+
+  const uint32_t num_elements = kWorkgroupSize;
+  const size_t buffer_size = num_elements * sizeof(uint32_t);
+
+  BM_CHECK_OK_AND_ASSIGN(
+      auto data_buffer,
+      device->CreateBuffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer_size));
+
+  //===-------------------------------------------------------------------===/
+  // Set source buffer data
+  //===-------------------------------------------------------------------===/
+
+  BM_CHECK_OK(::uvkc::benchmark::FillDeviceBuffer(device, data_buffer.get(),
+                                                  /*value=*/0));
+
+  //===-------------------------------------------------------------------===/
+  // Dispatch
+  //===-------------------------------------------------------------------===/
+
+  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers = {
+      {data_buffer.get(), /*set=*/0, /*binding=*/0},
+  };
+  BM_CHECK_OK(device->AttachBufferToDescriptor(
+      *shader_module, layout_set_map,
+      {bound_buffers.data(), bound_buffers.size()}));
+
+  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
+      << "unexpected number of descriptor sets";
+  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
+
+  std::vector<CommandBuffer::BoundDescriptorSet> bound_descriptor_sets(1);
+  bound_descriptor_sets[0].index = 0;
+  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
+
+  // Records dispatches [begin, end) of the sequence. Each dispatch updates the
+  // values written by the previous one. Pipeline state is not inherited by
+  // secondary command buffers, so each recording binds it again.
+  auto record_dispatches = [&](CommandBuffer *cmdbuf, int begin, int end) {
+    cmdbuf->BindPipelineAndDescriptorSets(
+        *pipeline,
+        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
+    for (int i = begin; i < end; ++i) {
+      if (i != 0) {
+        cmdbuf->PipelineBarrier(
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+      }
+      cmdbuf->Dispatch(1, 1, 1);
+    }
+  };
+
+  std::vector<std::unique_ptr<::uvkc::vulkan::CommandPool>> thread_pools;
+  std::vector<std::unique_ptr<CommandBuffer>> secondary_cmdbufs;
+  std::vector<const CommandBuffer *> secondary_cmdbuf_ptrs;
+  for (int i = 0; i < num_threads; ++i) {
+    BM_CHECK_OK_AND_ASSIGN(auto pool, device->CreateCommandPool());
+    BM_CHECK_OK_AND_ASSIGN(
+        auto secondary,
+        pool->AllocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+    secondary_cmdbuf_ptrs.push_back(secondary.get());
+    secondary_cmdbufs.push_back(std::move(secondary));
+    thread_pools.push_back(std::move(pool));
+  }
+
+  WorkerPool workers(num_threads, [&](int thread_index) {
+    CommandBuffer *secondary = secondary_cmdbufs[thread_index].get();
+    BM_CHECK_OK(secondary->Begin());
+    record_dispatches(secondary, kNumDispatches * thread_index / num_threads,
+                      kNumDispatches * (thread_index + 1) / num_threads);
+    BM_CHECK_OK(secondary->End());
+  });
+
+  // Records the whole sequence into |cmdbuf| and returns the host time spent.
+  auto record = [&](CommandBuffer *cmdbuf,
+                    ::uvkc::vulkan::TimestampQueryPool *query_pool) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    BM_CHECK_OK(cmdbuf->Begin());
+    if (query_pool) {
+      cmdbuf->ResetQueryPool(*query_pool);
+      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+    }
+    if (num_threads == 0) {
+      record_dispatches(cmdbuf, 0, kNumDispatches);
+    } else {
+      workers.Run();
+      cmdbuf->ExecuteCommands(
+          {secondary_cmdbuf_ptrs.data(), secondary_cmdbuf_ptrs.size()});
+    }
+    if (query_pool) {
+      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             1);
+    }
+    BM_CHECK_OK(cmdbuf->End());
+    auto end_time = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration_cast<std::chrono::duration<double>>(
+               end_time - start_time)
+        .count();
+  };
+
+  auto reset_secondaries = [&]() {
+    for (auto &secondary : secondary_cmdbufs) {
+      BM_CHECK_OK(secondary->Reset());
+    }
+  };
+
+  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
+  record(dispatch_cmdbuf.get(), /*query_pool=*/nullptr);
+  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+  reset_secondaries();
+
+  //===-------------------------------------------------------------------===/
+  // Verify destination buffer data
+  //===-------------------------------------------------------------------===/
+
+  BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer<uint32_t>(
+      device, data_buffer.get(), buffer_size,
+      [&](absl::Span<const uint32_t> values) {
+        for (uint32_t i = 0; i < num_elements; ++i) {
+          BM_CHECK_EQ(values[i], kNumDispatches)
+              << "destination buffer element #" << i
+              << " has incorrect value: expected to be " << kNumDispatches
+              << " but found " << values[i];
+        }
+      }));
+
+  //===-------------------------------------------------------------------===/
+  // Benchmarking
+  //===-------------------------------------------------------------------===/
+
+  // The benchmark time is the host time spent on recording. The GPU time is
+  // measured following the latency measure mode and reported as a counter.
+  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
+  bool use_timestamp =
+      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
+  if (use_timestamp) {
+    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(2));
+  }
+
+  double total_execution_seconds = 0;
+  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
+  cmdbuf->set_measured(true);
+  BM_CHECK_OK_AND_ASSIGN(
+      auto overhead_sampler,
+      ::uvkc::benchmark::OverheadSampler::Create(device, state));
+  ::uvkc::benchmark::LatencySamples latency_samples(state);
+  for (auto _ : state) {
+    double record_seconds = record(cmdbuf.get(), query_pool.get());
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds =
+        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
+                                                                  start_time);
+
+    switch (latency_measure->mode) {
+      case LatencyMeasureMode::kSystemDispatch: {
+        BM_CHECK_OK_AND_ASSIGN(
+            double overhead_seconds,
+            overhead_sampler->Sample(
+                *pipeline, absl::MakeConstSpan(bound_descriptor_sets)));
+        total_execution_seconds += elapsed_seconds.count() - overhead_seconds;
+      } break;
+      case LatencyMeasureMode::kSystemSubmit: {
+        total_execution_seconds += elapsed_seconds.count();
+      } break;
+      case LatencyMeasureMode::kGpuTimestamp: {
+        BM_CHECK_OK_AND_ASSIGN(
+            double timestamp_seconds,
+            query_pool->CalculateElapsedSecondsBetween(0, 1));
+        total_execution_seconds += timestamp_seconds;
+      } break;
+    }
+    latency_samples.SetIterationTime(state, record_seconds);
+
+    BM_CHECK_OK(cmdbuf->Reset());
+    reset_secondaries();
+  }
+  latency_samples.ReportCounters(state);
+  overhead_sampler->ReportCounters(state);
+
+  state.SetItemsProcessed(state.iterations() * kNumDispatches);
+  state.counters["ExecutionTime(us)"] = ::benchmark::Counter(
+      total_execution_seconds * 1e6, ::benchmark::Counter::kAvgIterations);
+
+  // Reset the command pools to release all command buffers in the
+  // benchmarking loop to avoid draining GPU resources.
+  for (auto &pool : thread_pools) BM_CHECK_OK(pool->Reset());
+  BM_CHECK_OK(device->ResetCommandPool());
+}
+
+}  // namespace
+
+namespace uvkc {
+namespace benchmark {
+namespace {
+
+bool RegisterVulkanOverheadBenchmark(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+    LazyDevice *device, double *overhead_seconds) {
+  return false;
+}
+
+void RegisterVulkanBenchmarks(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
+
+  for (int num_threads : {0, 1, 2, 4, 8}) {
+    std::string test_name =
+        absl::StrCat(gpu_name, "/", kBenchmarkName, "/Dispatches[",
+                     kNumDispatches, "]/");
+    if (num_threads == 0) {
+      absl::StrAppend(&test_name, "primary");
+    } else {
+      absl::StrAppend(&test_name, "secondary/Threads[", num_threads, "]");
+    }
+    RegisterDeviceBenchmark(test_name, ParallelRecording, device,
+                            latency_measure, num_threads)
+        ->UseManualTime()
+        ->Unit(::benchmark::kMicrosecond);
+  }
+}
+
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -12,24 +12,29 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <chrono>
 #include <memory>
 #include <numeric>
+#include <utility>
+#include <vector>
 
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "benchmark/benchmark.h"
+#include "uvkc/benchmark/autotuner.h"
+#include "uvkc/benchmark/compute_benchmark.h"
 #include "uvkc/benchmark/data_type_util.h"
-#include "uvkc/benchmark/main.h"
 #include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
 #include "uvkc/benchmark/vulkan_buffer_util.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include "uvkc/vulkan/device.h"
 #include "uvkc/vulkan/pipeline.h"
 
-using ::uvkc::benchmark::LatencyMeasureMode;
 using ::uvkc::vulkan::Pipeline;
 
+namespace {
+
 static const char kBenchmarkName[] = "tree_reduce";
 
 namespace tree_loop_shader {
@@ -73,23 +78,16 @@ ShaderCode kShaders[] = {
     INT_SHADER_CASE(subgroup, 64),   INT_SHADER_CASE(subgroup, 128),
 };
 
+// Default number of invocations per workgroup, which is expected to form one
+// subgroup.
+static const uint32_t kDefaultWorkgroupSize = 16;
+
 static void Reduce(::benchmark::State &state, ::uvkc::vulkan::Device *device,
                    const ::uvkc::benchmark::LatencyMeasure *latency_measure,
                    const uint32_t *code, size_t code_num_words,
                    size_t total_elements, size_t batch_elements,
-                   bool is_integer) {
-  //===-------------------------------------------------------------------===/
-  // Create shader module, pipeline, and descriptor sets
-  //===-------------------------------------------------------------------===/
-
-  BM_CHECK_OK_AND_ASSIGN(auto shader_module,
-                         device->CreateShaderModule(code, code_num_words));
-  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
-                         device->CreateDescriptorPool(*shader_module));
-  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
-                         descriptor_pool->AllocateDescriptorSets(
-                             shader_module->descriptor_set_layouts()));
-
+                   bool is_integer, uint32_t workgroup_size,
+                   Pipeline::SubgroupSizeControl subgroup_size_control) {
   //===-------------------------------------------------------------------===/
   // Create buffers
   //===-------------------------------------------------------------------===/
@@ -137,51 +135,37 @@ static void Reduce(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   // Dispatch
   //===-------------------------------------------------------------------===/
 
-  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers = {
+  ::uvkc::benchmark::ComputeBenchmark::Options options;
+  options.code = absl::MakeConstSpan(code, code_num_words);
+  options.buffers = {
       {reduce_buffer.get(), /*set=*/0, /*binding=*/0},
   };
-  BM_CHECK_OK(device->AttachBufferToDescriptor(
-      *shader_module, layout_set_map,
-      {bound_buffers.data(), bound_buffers.size()}));
-
-  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
-      << "unexpected number of descriptor sets";
-  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
-
-  std::vector<::uvkc::vulkan::CommandBuffer::BoundDescriptorSet>
-      bound_descriptor_sets(1);
-  bound_descriptor_sets[0].index = 0;
-  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
-  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
-
-  BM_CHECK_OK(dispatch_cmdbuf->Begin());
-  dispatch_cmdbuf->CopyBuffer(*data_buffer, 0, *reduce_buffer, 0, buffer_size);
-  BM_CHECK_OK(dispatch_cmdbuf->End());
-  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
-  BM_CHECK_OK(dispatch_cmdbuf->Reset());
-
-  std::vector<std::unique_ptr<::uvkc::vulkan::Pipeline>> pipelines;
-
-  BM_CHECK_OK(dispatch_cmdbuf->Begin());
+  options.subgroup_size_control = subgroup_size_control;
   for (int batch = total_elements / batch_elements; batch > 0;
        batch /= batch_elements) {
-    Pipeline::SpecConstant spec_constant[] = {
+    ::uvkc::benchmark::ComputeBenchmark::Dispatch dispatch;
+    dispatch.spec_constants = {
         {0, Pipeline::SpecConstant::Type::u32, batch},
+        {1, Pipeline::SpecConstant::Type::u32,
+         static_cast<int32_t>(workgroup_size)},
     };
-    BM_CHECK_OK_AND_ASSIGN(
-        auto pipeline,
-        device->CreatePipeline(*shader_module, "main",
-                               absl::MakeSpan(spec_constant, 1)));
-    dispatch_cmdbuf->BindPipelineAndDescriptorSets(
-        *pipeline,
-        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-    dispatch_cmdbuf->Dispatch(batch, 1, 1);
-    if (batch > 1) dispatch_cmdbuf->DispatchBarrier();
-
-    pipelines.emplace_back(std::move(pipeline));
+    dispatch.group_count_x = batch;
+    options.dispatches.push_back(std::move(dispatch));
   }
-  BM_CHECK_OK(dispatch_cmdbuf->End());
-  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+  // Restore the data reduced in place before every run.
+  options.record_reset = [&](::uvkc::vulkan::CommandBuffer *cmdbuf) {
+    cmdbuf->CopyBuffer(*data_buffer, 0, *reduce_buffer, 0, buffer_size);
+  };
+
+  options.num_operations = total_elements;
+  options.bytes_processed = buffer_size;
+  options.report_roofline = true;
+  options.roofline_bytes = buffer_size;
+
+  BM_CHECK_OK_AND_ASSIGN(auto compute,
+                         ::uvkc::benchmark::ComputeBenchmark::Create(
+                             device, std::move(options)));
+  BM_CHECK_OK(compute->DispatchOnce());
 
   //===-------------------------------------------------------------------===/
   // Verify destination buffer data
@@ -217,99 +201,30 @@ static void Reduce(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   // Benchmarking
   //===-------------------------------------------------------------------===/
 
-  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
-  bool use_timestamp =
-      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
-  if (use_timestamp) {
-    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(2));
-  }
-
-  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
-  for (auto _ : state) {
-    BM_CHECK_OK(cmdbuf->Begin());
-    cmdbuf->CopyBuffer(*data_buffer, 0, *reduce_buffer, 0, buffer_size);
-    BM_CHECK_OK(cmdbuf->End());
-    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
-    BM_CHECK_OK(cmdbuf->Reset());
-
-    BM_CHECK_OK(cmdbuf->Begin());
-    if (use_timestamp) cmdbuf->ResetQueryPool(*query_pool);
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
-    }
-
-    for (int batch = total_elements / batch_elements, i = 0; batch > 0;
-         batch /= batch_elements, ++i) {
-      cmdbuf->BindPipelineAndDescriptorSets(
-          *pipelines[i],
-          {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-      cmdbuf->Dispatch(batch, 1, 1);
-      if (batch > 1) cmdbuf->DispatchBarrier();
-    }
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                             1);
-    }
-
-    BM_CHECK_OK(cmdbuf->End());
-
-    auto start_time = std::chrono::high_resolution_clock::now();
-    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto elapsed_seconds =
-        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
-                                                                  start_time);
-
-    switch (latency_measure->mode) {
-      case LatencyMeasureMode::kSystemDispatch: {
-        state.SetIterationTime(elapsed_seconds.count() -
-                               latency_measure->overhead_seconds);
-      } break;
-      case LatencyMeasureMode::kSystemSubmit: {
-        state.SetIterationTime(elapsed_seconds.count());
-      } break;
-      case LatencyMeasureMode::kGpuTimestamp: {
-        BM_CHECK_OK_AND_ASSIGN(
-            double timestamp_seconds,
-            query_pool->CalculateElapsedSecondsBetween(0, 1));
-        state.SetIterationTime(timestamp_seconds);
-      } break;
-    }
-
-    BM_CHECK_OK(cmdbuf->Reset());
-  }
-
-  state.SetBytesProcessed(state.iterations() * buffer_size);
-  state.counters["FLOps"] =
-      ::benchmark::Counter(total_elements,
-                           ::benchmark::Counter::kIsIterationInvariant |
-                               ::benchmark::Counter::kIsRate,
-                           ::benchmark::Counter::kIs1000);
-
-  // Reset the command pool to release all command buffers in the benchmarking
-  // loop to avoid draining GPU resources.
-  BM_CHECK_OK(device->ResetCommandPool());
+  compute->Measure(state, *latency_measure);
 }
 
+}  // namespace
+
 namespace uvkc {
 namespace benchmark {
-
-absl::StatusOr<std::unique_ptr<VulkanContext>> CreateVulkanContext() {
-  return CreateDefaultVulkanContext(kBenchmarkName);
-}
+namespace {
 
 bool RegisterVulkanOverheadBenchmark(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, double *overhead_seconds) {
+    LazyDevice *device, double *overhead_seconds) {
   return false;
 }
 
 void RegisterVulkanBenchmarks(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, const LatencyMeasure *latency_measure) {
-  const char *gpu_name = physical_device.v10_properties.deviceName;
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
+
+  const std::vector<uint32_t> subgroup_sizes =
+      device->GetRequirableSubgroupSizes();
+  const bool full_subgroups =
+      device->optional_features().compute_full_subgroups;
 
   for (const auto &shader : kShaders) {
     // Find the power of batch_elements that are larger than 1M.
@@ -319,14 +234,46 @@ void RegisterVulkanBenchmarks(
     std::string test_name =
         absl::StrCat(gpu_name, "/", total_elements,
                      (shader.is_integer ? "xi32/" : "xf32/"), shader.name);
-    ::benchmark::RegisterBenchmark(
-        test_name.c_str(), Reduce, device, latency_measure, shader.code,
+    TuningCandidate candidate = {GetTuningDevice(physical_device), "reduce",
+                                 absl::StrCat(total_elements),
+                                 shader.is_integer ? "i32" : "fp32",
+                                 shader.name};
+    RegisterTuningCandidate(
+        candidate, test_name, Reduce, device, latency_measure, shader.code,
         shader.code_num_bytes / sizeof(uint32_t), total_elements,
-        shader.batch_elements, shader.is_integer)
+        shader.batch_elements, shader.is_integer, kDefaultWorkgroupSize,
+        Pipeline::SubgroupSizeControl{/*required_size=*/0,
+                                      /*require_full_subgroups=*/false})
         ->UseManualTime()
         ->Unit(::benchmark::kMicrosecond);
+
+    if (!absl::StartsWith(shader.name, "subgroup")) continue;
+
+    // Sweep all subgroup sizes the device allows, with one subgroup per
+    // workgroup.
+    for (uint32_t subgroup_size : subgroup_sizes) {
+      if (subgroup_size > shader.batch_elements) continue;
+      std::string sweep_test_name =
+          absl::StrCat(test_name, "/subgroup_size=", subgroup_size);
+      TuningCandidate sweep_candidate = candidate;
+      sweep_candidate.variant =
+          absl::StrCat(shader.name, "/subgroup_size=", subgroup_size);
+      RegisterTuningCandidate(
+          std::move(sweep_candidate), sweep_test_name, Reduce, device,
+          latency_measure, shader.code,
+          shader.code_num_bytes / sizeof(uint32_t), total_elements,
+          shader.batch_elements, shader.is_integer, subgroup_size,
+          Pipeline::SubgroupSizeControl{subgroup_size, full_subgroups})
+          ->UseManualTime()
+          ->Unit(::benchmark::kMicrosecond);
+    }
   }
 }
 
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
 }  // namespace benchmark
 }  // namespace uvkc
@@ -2,7 +2,7 @@
 #extension GL_EXT_control_flow_attributes : enable
 #extension GL_KHR_shader_subgroup_arithmetic : enable
 
-layout(local_size_x = 16, local_size_y = 1, local_size_z = 1) in;
+layout(local_size_x_id = 1, local_size_y = 1, local_size_z = 1) in;
 
 layout(set=0, binding=0) buffer DataBuffer { TYPE data[]; } IOBuffer;
 
@@ -11,7 +11,8 @@ layout(constant_id = 0) const uint stride = 1; // Stride between elements
 // Macro to be defined at compile time
 // BATCH_SIZE: how many vectors to process for each workgroup
 
-// Each workgroup contains just one subgroup.
+// Each workgroup contains just one subgroup. The workgroup size is expected to
+// divide BATCH_SIZE.
 
 void main() {
   uint wgID = gl_WorkGroupID.x;
@@ -20,7 +21,7 @@ void main() {
 
   TYPE laneResult = IOBuffer.data[wgID + stride * laneID];
 
-  [[unroll]] for (uint i = 1; i < BATCH_SIZE / 16; ++i) {
+  [[unroll]] for (uint i = 1; i < BATCH_SIZE / gl_WorkGroupSize.x; ++i) {
     laneResult += IOBuffer.data[wgID + stride * (laneCount * i + laneID)];
   }
 
@@ -18,7 +18,7 @@
 #extension GL_KHR_shader_subgroup_arithmetic : enable
 #extension GL_KHR_shader_subgroup_ballot : enable
 
-layout (local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+layout(local_size_x_id = 1, local_size_y = 1, local_size_z = 1) in;
 
 layout(constant_id = 0) const int kArraySize = 64;
 
@@ -12,17 +12,20 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <chrono>
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <numeric>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "benchmark/benchmark.h"
 #include "benchmarks/memory/copy_storage_buffer.h"
-#include "uvkc/benchmark/main.h"
+#include "uvkc/benchmark/compute_benchmark.h"
+#include "uvkc/benchmark/device_benchmark.h"
 #include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
 #include "uvkc/benchmark/vulkan_buffer_util.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include "uvkc/vulkan/device.h"
@@ -32,6 +35,8 @@
 using ::uvkc::benchmark::LatencyMeasureMode;
 using ::uvkc::vulkan::Pipeline;
 
+namespace {
+
 static const char kBenchmarkName[] = "subgroup_arthmetic";
 
 static uint32_t kAddLoopCode[] = {
@@ -68,34 +73,22 @@ static ShaderCode kShaderCodeCases[] = {
     // clang-format on
 };
 
-static uint32_t kWorkgroupSize = 64;
+// The shaders measure the subgroup size as the number of active invocations,
+// so workgroups are never smaller than the subgroups they are proposed.
+static uint32_t kMinWorkgroupSize = 64;
+
+static uint32_t GetWorkgroupSize(uint32_t subgroup_size) {
+  return std::max(kMinWorkgroupSize, subgroup_size);
+}
 
 static void CalculateSubgroupArithmetic(
     ::benchmark::State &state, ::uvkc::vulkan::Device *device,
     const ::uvkc::benchmark::LatencyMeasure *latency_measure,
     const uint32_t *code, size_t code_num_words, int num_elements,
-    uint32_t proposed_subgroup_size, Arithmetic arith_op) {
+    uint32_t proposed_subgroup_size, Arithmetic arith_op,
+    Pipeline::SubgroupSizeControl subgroup_size_control) {
   size_t buffer_num_bytes = num_elements * sizeof(float);
 
-  //===-------------------------------------------------------------------===/
-  // Create shader module, pipeline, and descriptor sets
-  //===-------------------------------------------------------------------===/
-
-  BM_CHECK_OK_AND_ASSIGN(auto shader_module,
-                         device->CreateShaderModule(code, code_num_words));
-
-  ::uvkc::vulkan::Pipeline::SpecConstant spec_constant = {
-      /*id=*/0, Pipeline::SpecConstant::Type::s32, num_elements};
-  BM_CHECK_OK_AND_ASSIGN(
-      auto pipeline, device->CreatePipeline(*shader_module, "main",
-                                            absl::MakeSpan(&spec_constant, 1)));
-
-  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
-                         device->CreateDescriptorPool(*shader_module));
-  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
-                         descriptor_pool->AllocateDescriptorSets(
-                             shader_module->descriptor_set_layouts()));
-
   //===-------------------------------------------------------------------===/
   // Create buffers
   //===-------------------------------------------------------------------===/
@@ -141,30 +134,33 @@ static void CalculateSubgroupArithmetic(
   // Dispatch
   //===-------------------------------------------------------------------===/
 
-  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers = {
+  ::uvkc::benchmark::ComputeBenchmark::Options options;
+  options.code = absl::MakeConstSpan(code, code_num_words);
+  options.buffers = {
       {src_buffer.get(), /*set=*/0, /*binding=*/0},
       {dst_buffer.get(), /*set=*/0, /*binding=*/1},
   };
-  BM_CHECK_OK(device->AttachBufferToDescriptor(
-      *shader_module, layout_set_map,
-      {bound_buffers.data(), bound_buffers.size()}));
-
-  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
-      << "unexpected number of descriptor sets";
-  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
-
-  std::vector<::uvkc::vulkan::CommandBuffer::BoundDescriptorSet>
-      bound_descriptor_sets(1);
-  bound_descriptor_sets[0].index = 0;
-  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
-  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
-
-  BM_CHECK_OK(dispatch_cmdbuf->Begin());
-  dispatch_cmdbuf->BindPipelineAndDescriptorSets(
-      *pipeline, {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-  dispatch_cmdbuf->Dispatch(num_elements / kWorkgroupSize, 1, 1);
-  BM_CHECK_OK(dispatch_cmdbuf->End());
-  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+  options.subgroup_size_control = subgroup_size_control;
+
+  ::uvkc::benchmark::ComputeBenchmark::Dispatch dispatch;
+  const uint32_t workgroup_size = GetWorkgroupSize(proposed_subgroup_size);
+  dispatch.spec_constants = {
+      {/*id=*/0, Pipeline::SpecConstant::Type::s32, num_elements},
+      {/*id=*/1, Pipeline::SpecConstant::Type::u32,
+       static_cast<int32_t>(workgroup_size)},
+  };
+  dispatch.group_count_x = num_elements / workgroup_size;
+  options.dispatches.push_back(std::move(dispatch));
+
+  options.num_operations = num_elements;
+  // The registered overhead benchmark copies a buffer of the same size, so
+  // subtracting it leaves only the time spent on arithmetic.
+  options.subtract_registered_overhead = true;
+
+  BM_CHECK_OK_AND_ASSIGN(auto compute,
+                         ::uvkc::benchmark::ComputeBenchmark::Create(
+                             device, std::move(options)));
+  BM_CHECK_OK(compute->DispatchOnce());
 
   //===-------------------------------------------------------------------===/
   // Verify destination buffer data
@@ -172,9 +168,15 @@ static void CalculateSubgroupArithmetic(
 
   BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer(
       device, dst_buffer.get(), buffer_num_bytes,
-      [arith_op, proposed_subgroup_size](void *ptr, size_t num_bytes) {
+      [arith_op, proposed_subgroup_size, &subgroup_size_control](
+          void *ptr, size_t num_bytes) {
         const uint32_t actual_subgroup_size =
             reinterpret_cast<uint32_t *>(ptr)[0];
+        if (subgroup_size_control.required_size != 0) {
+          BM_CHECK_EQ(actual_subgroup_size,
+                      subgroup_size_control.required_size)
+              << "pipeline did not run with the required subgroup size";
+        }
         float *dst_float_buffer = reinterpret_cast<float *>(ptr) + 1;
         const auto num_floats = (num_bytes / sizeof(float)) - 1;
         switch (arith_op) {
@@ -215,108 +217,72 @@ static void CalculateSubgroupArithmetic(
   // Benchmarking
   //===-------------------------------------------------------------------===/
 
-  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
-  bool use_timestamp =
-      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
-  if (use_timestamp) {
-    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(2));
-  }
-
-  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
-  for (auto _ : state) {
-    BM_CHECK_OK(cmdbuf->Begin());
-    if (use_timestamp) cmdbuf->ResetQueryPool(*query_pool);
-
-    cmdbuf->BindPipelineAndDescriptorSets(
-        *pipeline,
-        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
-    }
-
-    cmdbuf->Dispatch(num_elements / kWorkgroupSize, 1, 1);
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                             1);
-    }
-
-    BM_CHECK_OK(cmdbuf->End());
-
-    auto start_time = std::chrono::high_resolution_clock::now();
-    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto elapsed_seconds =
-        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
-                                                                  start_time);
-
-    switch (latency_measure->mode) {
-      case LatencyMeasureMode::kSystemDispatch: {
-        state.SetIterationTime(elapsed_seconds.count() -
-                               latency_measure->overhead_seconds);
-      } break;
-      case LatencyMeasureMode::kSystemSubmit: {
-        state.SetIterationTime(elapsed_seconds.count());
-      } break;
-      case LatencyMeasureMode::kGpuTimestamp: {
-        BM_CHECK_OK_AND_ASSIGN(
-            double timestamp_seconds,
-            query_pool->CalculateElapsedSecondsBetween(0, 1));
-        state.SetIterationTime(timestamp_seconds);
-      } break;
-    }
-
-    BM_CHECK_OK(cmdbuf->Reset());
-  }
-  state.counters["FLOps"] =
-      ::benchmark::Counter(num_elements,
-                           ::benchmark::Counter::kIsIterationInvariant |
-                               ::benchmark::Counter::kIsRate,
-                           ::benchmark::Counter::kIs1000);
-
-  // Reset the command pool to release all command buffers in the benchmarking
-  // loop to avoid draining GPU resources.
-  BM_CHECK_OK(device->ResetCommandPool());
+  compute->Measure(state, *latency_measure);
 }
 
 static int kBufferNumElements = 1 << 20;  // 1M
 
+}  // namespace
+
 namespace uvkc {
 namespace benchmark {
-
-absl::StatusOr<std::unique_ptr<VulkanContext>> CreateVulkanContext() {
-  return CreateDefaultVulkanContext(kBenchmarkName);
-}
+namespace {
 
 bool RegisterVulkanOverheadBenchmark(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, double *overhead_seconds) {
+    LazyDevice *device, double *overhead_seconds) {
   memory::RegisterCopyStorageBufferBenchmark(
-      physical_device.v10_properties.deviceName, device,
+      GetBenchmarkNamePrefix(physical_device).c_str(), device,
       kBufferNumElements * sizeof(float), memory::GetShaderCodeCases().front(),
-      LatencyMeasureMode::kSystemSubmit,
-      /*overhead_seconds=*/0, overhead_seconds);
+      LatencyMeasureMode::kSystemSubmit, overhead_seconds);
   return true;
 }
 
 void RegisterVulkanBenchmarks(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, const LatencyMeasure *latency_measure) {
-  const char *gpu_name = physical_device.v10_properties.deviceName;
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
 
   for (const auto &shader : kShaderCodeCases) {  // Loop/intrinsic shader
     std::string test_name =
         absl::StrCat(gpu_name, "/", shader.name, "/", kBufferNumElements);
-    ::benchmark::RegisterBenchmark(
-        test_name.c_str(), CalculateSubgroupArithmetic, device, latency_measure,
+    RegisterDeviceBenchmark(
+        test_name, CalculateSubgroupArithmetic, device, latency_measure,
         shader.code, shader.code_num_bytes / sizeof(uint32_t),
         kBufferNumElements, physical_device.subgroup_properties.subgroupSize,
-        shader.op)
+        shader.op,
+        Pipeline::SubgroupSizeControl{/*required_size=*/0,
+                                      /*require_full_subgroups=*/false})
         ->UseManualTime()
         ->Unit(::benchmark::kMicrosecond);
   }
+
+  // Sweep all subgroup sizes the device allows. Workgroups grow with the
+  // subgroup size and stay a multiple of it, so full subgroups can be
+  // requested whenever the device supports them.
+  const bool full_subgroups =
+      device->optional_features().compute_full_subgroups;
+  for (uint32_t subgroup_size : device->GetRequirableSubgroupSizes()) {
+    for (const auto &shader : kShaderCodeCases) {
+      std::string test_name =
+          absl::StrCat(gpu_name, "/", shader.name, "/", kBufferNumElements,
+                       "/subgroup_size=", subgroup_size);
+      RegisterDeviceBenchmark(
+          test_name, CalculateSubgroupArithmetic, device, latency_measure,
+          shader.code,
+          shader.code_num_bytes / sizeof(uint32_t), kBufferNumElements,
+          subgroup_size, shader.op,
+          Pipeline::SubgroupSizeControl{subgroup_size, full_subgroups})
+          ->UseManualTime()
+          ->Unit(::benchmark::kMicrosecond);
+    }
+  }
 }
 
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
 }  // namespace benchmark
 }  // namespace uvkc
@@ -13,28 +13,35 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <numeric>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/span.h"
 #include "benchmark/benchmark.h"
-#include "uvkc/base/log.h"
+#include "uvkc/benchmark/autotuner.h"
+#include "uvkc/benchmark/buffer_pattern.h"
+#include "uvkc/benchmark/compute_benchmark.h"
 #include "uvkc/benchmark/data_type_util.h"
-#include "uvkc/benchmark/main.h"
+#include "uvkc/benchmark/input_buffer_cache.h"
+#include "uvkc/benchmark/reference_matmul.h"
+#include "uvkc/benchmark/shapes.h"
 #include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
 #include "uvkc/benchmark/vulkan_buffer_util.h"
+#include "uvkc/benchmark/verification.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include "uvkc/vulkan/device.h"
 #include "uvkc/vulkan/pipeline.h"
 
 using namespace uvkc::benchmark;
-using ::uvkc::benchmark::LatencyMeasureMode;
 using ::uvkc::vulkan::Pipeline;
 
+namespace {
+
 static const char kBenchmarkName[] = "vmt";
 
 struct ShaderCode {
@@ -74,30 +81,9 @@ static ShaderCode kShaderCodeCases[] = {
 #error "unsupported GPU architecture/strategy"
 #endif
 
-/// Fills the 2D matrix with values produced by the |generator| function.
-template <typename GeneratorFn>
-static void FillBuffer(DataType data_type, void *raw_buffer, size_t num_bytes,
-                       unsigned dim_1, unsigned dim_2, GeneratorFn generator) {
-  auto fill = [&](auto traits) {
-    using Traits = decltype(traits);
-    using StorageType = typename Traits::storage_type;
-    using RuntimeType = typename Traits::storage_type;
-    auto buffer = absl::MakeSpan(static_cast<StorageType *>(raw_buffer),
-                                 num_bytes / GetSize(data_type));
-
-    for (int i = 0; i < dim_1; ++i) {
-      for (int j = 0; j < dim_2; ++j) {
-        buffer[j + i * dim_1] =
-            static_cast<StorageType>(RuntimeType(generator(i, j)));
-      }
-    }
-  };
-
-  InvokeWithTraits(data_type, fill);
-}
-
-/// Checks that the output vector calculated by the shader is contains the
-/// same values as runtime vecmat with values defined by |lhs| and |rhs|.
+/// Checks that the tiles of the output vector calculated by the shader that
+/// GetTilesToVerify() selects contain the same values as runtime vecmat with
+/// values defined by |lhs| and |rhs|.
 template <DataType OutputType, DataType InputType, typename Generator1Fn,
           typename Generator2Fn>
 static void CheckOutput(const ShaderCode &shader, void *raw_buffer,
@@ -112,19 +98,73 @@ static void CheckOutput(const ShaderCode &shader, void *raw_buffer,
   auto output =
       absl::MakeConstSpan(static_cast<OutputStorageType *>(raw_buffer),
                           num_bytes / GetSize(OutputType));
-  for (int j = 0; j < N; ++j) {
-    OutputRuntimeType acc(0.0f);
-    for (int k = 0; k < K; ++k) {
-      acc += OutputRuntimeType(InputRuntimeType(lhs(0, k))) *
-             OutputRuntimeType(InputRuntimeType(rhs(j, k)));
+  for (const OutputTile &tile : GetTilesToVerify(1, N)) {
+    const std::vector<InputRuntimeType> lhs_values =
+        GenerateMatrix<InputRuntimeType>(1, K, lhs);
+    const std::vector<InputRuntimeType> rhs_values =
+        GenerateMatrix<InputRuntimeType>(tile.columns, K, [&](int j, int k) {
+          return rhs(tile.column + j, k);
+        });
+    std::vector<OutputRuntimeType> expected(tile.columns,
+                                            OutputRuntimeType(0.0f));
+    ReferenceMatMul({1, tile.columns, int(K), /*transposed_rhs=*/true},
+                    absl::MakeConstSpan(lhs_values),
+                    absl::MakeConstSpan(rhs_values), absl::MakeSpan(expected));
+
+    for (int j = tile.column; j < tile.column + tile.columns; ++j) {
+      const OutputRuntimeType &acc = expected[j - tile.column];
+      OutputRuntimeType gpuValue(output[j]);
+      BM_CHECK_EQ(gpuValue, acc)
+          << "destination buffer element (" << j << ")"
+          << " has incorrect value: expected to be " << acc << " but found "
+          << gpuValue << "\n\t^ In shader: " << shader.name << ", "
+          << GetName(shader.input_type) << "->" << GetName(shader.output_type);
     }
+  }
+}
 
-    OutputRuntimeType gpuValue(output[j]);
-    BM_CHECK_EQ(gpuValue, acc)
-        << "destination buffer element (" << j << ")"
-        << " has incorrect value: expected to be " << acc << " but found "
-        << gpuValue << "\n\t^ In shader: " << shader.name << ", "
-        << GetName(shader.input_type) << "->" << GetName(shader.output_type);
+/// Verifies the output vector in |dst_buffer| as the verify mode requires:
+/// by checking it with CheckOutput(), by comparing its checksum computed on
+/// the GPU with the one of the matrices defined by |lhs| and |rhs|, or not at
+/// all.
+template <DataType OutputType, DataType InputType, typename Generator1Fn,
+          typename Generator2Fn>
+static void VerifyOutput(::uvkc::vulkan::Device *device,
+                         const ShaderCode &shader,
+                         ::uvkc::vulkan::Buffer *dst_buffer,
+                         unsigned N, unsigned K, Generator1Fn lhs,
+                         Generator2Fn rhs) {
+  using InputRuntimeType = typename DataTypeTraits<InputType>::runtime_type;
+
+  switch (GetVerifyMode()) {
+    case VerifyMode::kFull:
+    case VerifyMode::kSampled:
+      BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer(
+          device, dst_buffer, N * GetSize(OutputType),
+          [&](void *ptr, size_t num_bytes) {
+            CheckOutput<OutputType, InputType>(shader, ptr, num_bytes, N, K,
+                                               lhs, rhs);
+          }));
+      break;
+    case VerifyMode::kChecksum: {
+      BM_CHECK_OK_AND_ASSIGN(
+          Checksum actual,
+          ComputeChecksumOnDevice(device, dst_buffer, OutputType, 1, N));
+      const std::vector<InputRuntimeType> lhs_values =
+          GenerateMatrix<InputRuntimeType>(1, K, lhs);
+      const std::vector<InputRuntimeType> rhs_values =
+          GenerateMatrix<InputRuntimeType>(N, K, rhs);
+      const Checksum expected = ReferenceMatMulChecksum(
+          {1, int(N), int(K), /*transposed_rhs=*/true},
+          absl::MakeConstSpan(lhs_values), absl::MakeConstSpan(rhs_values));
+      BM_CHECK(ChecksumsMatch(OutputType, expected, actual))
+          << "destination buffer has incorrect checksum: expected to be "
+          << expected << " but found " << actual
+          << "\n\t^ In shader: " << shader.name << ", "
+          << GetName(shader.input_type) << "->" << GetName(shader.output_type);
+    } break;
+    case VerifyMode::kNone:
+      break;
   }
 }
 
@@ -132,130 +172,94 @@ static void Vmt(::benchmark::State &state, ::uvkc::vulkan::Device *device,
                 const ::uvkc::benchmark::LatencyMeasure *latency_measure,
                 const ShaderCode &shader, int N, int K) {
   //===-------------------------------------------------------------------===/
-  // Create shader module, pipeline, and descriptor sets
-  //===-------------------------------------------------------------------===/
-
-  BM_CHECK_OK_AND_ASSIGN(
-      auto shader_module,
-      device->CreateShaderModule(shader.code.data(), shader.code.size()));
-
-  ::uvkc::vulkan::Pipeline::SpecConstant spec_constant[2] = {
-      {/*id=*/0, Pipeline::SpecConstant::Type::s32, N},
-      {/*id=*/1, Pipeline::SpecConstant::Type::s32, K},
-  };
-  BM_CHECK_OK_AND_ASSIGN(
-      auto pipeline,
-      device->CreatePipeline(*shader_module, "main", spec_constant));
-
-  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
-                         device->CreateDescriptorPool(*shader_module));
-  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
-                         descriptor_pool->AllocateDescriptorSets(
-                             shader_module->descriptor_set_layouts()));
-
-  //===-------------------------------------------------------------------===/
   // Create buffers
   //===-------------------------------------------------------------------===/
   DataType input_type = shader.input_type;
   DataType output_type = shader.output_type;
-  const size_t src0_size = K * GetSize(input_type);
-  const size_t src1_size = K * N * GetSize(input_type);
   const size_t dst_size = N * GetSize(output_type);
 
-  BM_CHECK_OK_AND_ASSIGN(
-      auto src0_buffer,
-      device->CreateBuffer(
-          VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, src0_size));
-  BM_CHECK_OK_AND_ASSIGN(
-      auto src1_buffer,
-      device->CreateBuffer(
-          VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, src1_size));
   BM_CHECK_OK_AND_ASSIGN(
       auto dst_buffer,
-      device->CreateBuffer(
-          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, dst_size));
+      device->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                               VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, dst_size));
 
   //===-------------------------------------------------------------------===/
   // Set source buffer data
   //===-------------------------------------------------------------------===/
-  auto getLhs = [K](int i, int j) {
-    float v = ((float)((i * K + j) % 5) - 1.0f) / 2.0f;
-    return v;
+  // Small zero-mean integers with coprime periods keep partial sums small, so
+  // every data type computes exact results. The GPU generates them, and they
+  // are reproduced here for verification.
+  const BufferPattern lhs_pattern = BufferPattern::Modular(5, /*offset=*/-2);
+  const BufferPattern rhs_pattern = BufferPattern::Modular(7, /*offset=*/-3);
+  auto getLhs = [&](int i, int j) {
+    return float(lhs_pattern.ValueAt(i * K + j));
   };
-  auto getRhs = [K](int i, int j) {
-    float v = ((float)((i * K + j) % 7) - 1.0f) / 2.0f;
-    return v;
+  auto getRhs = [&](int i, int j) {
+    return float(rhs_pattern.ValueAt(i * K + j));
   };
 
-  BM_CHECK_OK(::uvkc::benchmark::SetDeviceBufferViaStagingBuffer(
-      device, src0_buffer.get(), src0_size, [&](void *ptr, size_t num_bytes) {
-        FillBuffer(input_type, ptr, num_bytes, 1, K, getLhs);
-      }));
-
-  // In vmt, the RHS is input is transposed, which makes the matrix
-  // column-major.
-  BM_CHECK_OK(::uvkc::benchmark::SetDeviceBufferViaStagingBuffer(
-      device, src1_buffer.get(), src1_size, [&](void *ptr, size_t num_bytes) {
-        FillBuffer(input_type, ptr, num_bytes, N, K, getRhs);
-      }));
+  // Benchmarks of the same problem share source buffers, which shaders only
+  // read.
+  const Shape src0_shape = {1, K};
+  BM_CHECK_OK_AND_ASSIGN(auto src0_buffer,
+                         ::uvkc::benchmark::GetInputBuffer(
+                             device, lhs_pattern, input_type, src0_shape));
+  const Shape src1_shape = {N, K};
+  BM_CHECK_OK_AND_ASSIGN(auto src1_buffer,
+                         ::uvkc::benchmark::GetInputBuffer(
+                             device, rhs_pattern, input_type, src1_shape));
 
   //===-------------------------------------------------------------------===/
   // Clear the output buffer data set by the previous benchmark run
   //===-------------------------------------------------------------------===/
 
-  BM_CHECK_OK(::uvkc::benchmark::SetDeviceBufferViaStagingBuffer(
-      device, dst_buffer.get(), dst_size, [&](void *ptr, size_t num_bytes) {
-        FillBuffer(output_type, ptr, num_bytes, 1, N,
-                   [](int, int) { return 0.0f; });
-      }));
+  // All supported output types use all-zero bits to represent zero.
+  BM_CHECK_OK(::uvkc::benchmark::FillDeviceBuffer(device, dst_buffer.get(),
+                                                  /*value=*/0));
 
   //===-------------------------------------------------------------------===/
   // Dispatch
   //===-------------------------------------------------------------------===/
-  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers = {
+
+  ::uvkc::benchmark::ComputeBenchmark::Options options;
+  options.code = shader.code;
+  options.buffers = {
       {src0_buffer.get(), /*set=*/0, /*binding=*/0},
       {src1_buffer.get(), /*set=*/0, /*binding=*/1},
       {dst_buffer.get(), /*set=*/0, /*binding=*/2},
   };
-  BM_CHECK_OK(device->AttachBufferToDescriptor(
-      *shader_module, layout_set_map,
-      {bound_buffers.data(), bound_buffers.size()}));
-
-  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
-      << "unexpected number of descriptor sets (" << shader.name << ")";
-  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
-
-  std::vector<::uvkc::vulkan::CommandBuffer::BoundDescriptorSet>
-      bound_descriptor_sets(1);
-  bound_descriptor_sets[0].index = 0;
-  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
-  BM_CHECK_OK_AND_ASSIGN(auto dispatch_cmdbuf, device->AllocateCommandBuffer());
-
-  BM_CHECK_OK(dispatch_cmdbuf->Begin());
-  dispatch_cmdbuf->BindPipelineAndDescriptorSets(
-      *pipeline, {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
+
+  ::uvkc::benchmark::ComputeBenchmark::Dispatch dispatch;
+  dispatch.spec_constants = {
+      {/*id=*/0, Pipeline::SpecConstant::Type::s32, N},
+      {/*id=*/1, Pipeline::SpecConstant::Type::s32, K},
+  };
   // Each workgroup processes N0 rows with S0 subgroups per row.
-  dispatch_cmdbuf->Dispatch(N / shader.N0, 1, 1);
-  BM_CHECK_OK(dispatch_cmdbuf->End());
-  BM_CHECK_OK(device->QueueSubmitAndWait(*dispatch_cmdbuf));
+  dispatch.group_count_x = N / shader.N0;
+  options.dispatches.push_back(std::move(dispatch));
+
+  options.num_operations =
+      double(N) * double(K) + double(K) + double(K) * sizeof(int32_t);
+  options.operations_counter_name = "Bytes";
+
+  BM_CHECK_OK_AND_ASSIGN(auto compute,
+                         ::uvkc::benchmark::ComputeBenchmark::Create(
+                             device, std::move(options)));
+  BM_CHECK_OK(compute->DispatchOnce());
 
   //===-------------------------------------------------------------------===/
   // Verify destination buffer data
   //===-------------------------------------------------------------------===/
 
   if (output_type == DataType::i32) {
-    BM_CHECK_OK(::uvkc::benchmark::GetDeviceBufferViaStagingBuffer(
-        device, dst_buffer.get(), dst_size, [&](void *ptr, size_t num_bytes) {
-          if (input_type == DataType::i8) {
-            CheckOutput<DataType::i32, DataType::i8>(shader, ptr, num_bytes, N,
-                                                     K, getLhs, getRhs);
-          } else {
-            BM_CHECK(false) << "Unhandled input type";
-          }
-        }));
+    if (input_type == DataType::i8) {
+      VerifyOutput<DataType::i32, DataType::i8>(
+          device, shader, dst_buffer.get(), N, K, getLhs, getRhs);
+    } else {
+      BM_CHECK(false) << "Unhandled input type";
+    }
   } else {
     BM_CHECK(false) << "Unhandled output type";
   }
@@ -264,106 +268,43 @@ static void Vmt(::benchmark::State &state, ::uvkc::vulkan::Device *device,
   // Benchmarking
   //===-------------------------------------------------------------------===/
 
-  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
-  bool use_timestamp =
-      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
-  if (use_timestamp) {
-    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(2));
-  }
-
-  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
-  for (auto _ : state) {
-    BM_CHECK_OK(cmdbuf->Begin());
-    if (use_timestamp) cmdbuf->ResetQueryPool(*query_pool);
-
-    cmdbuf->BindPipelineAndDescriptorSets(
-        *pipeline,
-        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
-    }
-
-    cmdbuf->Dispatch(N / shader.N0, 1, 1);
-
-    if (use_timestamp) {
-      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                             1);
-    }
-
-    BM_CHECK_OK(cmdbuf->End());
-
-    auto start_time = std::chrono::high_resolution_clock::now();
-    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto elapsed_seconds =
-        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
-                                                                  start_time);
-
-    switch (latency_measure->mode) {
-      case LatencyMeasureMode::kSystemDispatch: {
-        state.SetIterationTime(elapsed_seconds.count() -
-                               latency_measure->overhead_seconds);
-      } break;
-      case LatencyMeasureMode::kSystemSubmit: {
-        state.SetIterationTime(elapsed_seconds.count());
-      } break;
-      case LatencyMeasureMode::kGpuTimestamp: {
-        BM_CHECK_OK_AND_ASSIGN(
-            double timestamp_seconds,
-            query_pool->CalculateElapsedSecondsBetween(0, 1));
-        state.SetIterationTime(timestamp_seconds);
-      } break;
-    }
-
-    BM_CHECK_OK(cmdbuf->Reset());
-  }
-
-  double numOperation =
-      double(N) * double(K) + double(K) + double(K) * sizeof(int32_t);
-  state.counters["Bytes"] =
-      ::benchmark::Counter(numOperation,
-                           ::benchmark::Counter::kIsIterationInvariant |
-                               ::benchmark::Counter::kIsRate,
-                           ::benchmark::Counter::kIs1000);
-
-  // Reset the command pool to release all command buffers in the benchmarking
-  // loop to avoid draining GPU resources.
-  BM_CHECK_OK(device->ResetCommandPool());
+  compute->Measure(state, *latency_measure);
 }
 
 // Returns true iff |a| is a multiple of |b|.
 static bool isMultipleOf(int a, int b) { return a >= b && a % b == 0; }
 
-namespace uvkc::benchmark {
+}  // namespace
 
-absl::StatusOr<std::unique_ptr<VulkanContext>> CreateVulkanContext() {
-  return CreateDefaultVulkanContext(kBenchmarkName);
-}
+namespace uvkc::benchmark {
+namespace {
 
 bool RegisterVulkanOverheadBenchmark(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, double *overhead_seconds) {
+    LazyDevice *device, double *overhead_seconds) {
   return false;
 }
 
 void RegisterVulkanBenchmarks(
     const vulkan::Driver::PhysicalDeviceInfo &physical_device,
-    vulkan::Device *device, const LatencyMeasure *latency_measure) {
-  const char *gpu_name = physical_device.v10_properties.deviceName;
-
-  for (const int sz : {4096, 8192, 16384}) {
-    const int N = sz;
-    const int K = sz;
+    LazyDevice *device, const LatencyMeasure *latency_measure) {
+  const std::string gpu_name = GetBenchmarkNamePrefix(physical_device);
+
+  // Problem shapes are NxK. Shapes that do not divide into a shader's tiles
+  // are skipped for that shader.
+  const std::vector<Shape> kDefaultShapes = {
+      {4096, 4096}, {8192, 8192}, {16384, 16384}};
+  const std::vector<Shape> shapes = GetShapes("NxK", kDefaultShapes);
+
+  for (const Shape &shape : shapes) {
+    const int N = shape[0];
+    const int K = shape[1];
     for (const ShaderCode &shader : kShaderCodeCases) {
-      std::string vecmat_size = absl::StrCat(N, "x", K);
+      std::string vecmat_size = FormatShape(shape);
       std::string tiling_scheme = absl::StrCat(shader.N0, "x", shader.K0);
-      BM_CHECK(isMultipleOf(N, shader.N0))
-          << "Incompatible tiling scheme: " << tiling_scheme;
-      BM_CHECK(isMultipleOf(K, shader.K0))
-          << "Incompatible tiling scheme: " << tiling_scheme;
       BM_CHECK(isMultipleOf(shader.K0, 4))
           << "Incompatible tiling scheme: " << tiling_scheme;
+      if (!isMultipleOf(N, shader.N0) || !isMultipleOf(K, shader.K0)) continue;
 
       std::string workgroup_size =
           absl::StrCat(shader.wg_size_x, "x", shader.wg_size_y, "x1");
@@ -372,12 +313,20 @@ void RegisterVulkanBenchmarks(
       std::string test_name =
           absl::StrCat(gpu_name, "/vmt[", vecmat_size, "]/", type_info, "/",
                        shader.name, "/Workgroup[", workgroup_size, "]");
-      ::benchmark::RegisterBenchmark(test_name.c_str(), Vmt, device,
-                                     latency_measure, shader, N, K)
+      TuningCandidate candidate = {
+          GetTuningDevice(physical_device), "vmt", vecmat_size, type_info,
+          absl::StrCat(shader.name, "/Workgroup[", workgroup_size, "]")};
+      RegisterTuningCandidate(std::move(candidate), test_name, Vmt, device,
+                              latency_measure, shader, N, K)
           ->UseManualTime()
           ->Unit(::benchmark::kMicrosecond);
     }
   }
 }
 
+}  // namespace
+
+UVKC_BENCHMARK_SUITE(kBenchmarkName, RegisterVulkanOverheadBenchmark,
+                     RegisterVulkanBenchmarks);
+
 }  // namespace uvkc::benchmark
@@ -28,10 +28,13 @@ include(CMakeParseArguments)
 # * INCLUDES: the list of additional public include directories to this library
 # * COPTS: the list of private compile options
 # * LINKOPTS: the list of private link options
+# * ALWAYSLINK: links all objects of this library into binaries that directly
+#   depend on it, even if nothing references them, e.g., for objects that
+#   register themselves with static initializers
 function(uvkc_cc_library)
   cmake_parse_arguments(
     _RULE
-    ""
+    "ALWAYSLINK"
     "NAME"
     "HDRS;SRCS;DEPS;INCLUDES;COPTS;LINKOPTS"
     ${ARGN}
@@ -46,7 +49,12 @@ function(uvkc_cc_library)
   uvkc_package_name(_PACKAGE_NAME)
   set(_NAME "${_PACKAGE_NAME}_${_RULE_NAME}")
 
-  add_library(${_NAME} STATIC "")
+  if(_RULE_ALWAYSLINK)
+    # Objects of object libraries are linked into direct dependents as is.
+    add_library(${_NAME} OBJECT "")
+  else()
+    add_library(${_NAME} STATIC "")
+  endif()
   # Create an alis library with the namespaced name for dependency reference use
   add_library(${_PACKAGE_NS}::${_RULE_NAME} ALIAS ${_NAME})
 
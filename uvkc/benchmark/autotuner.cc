@@ -0,0 +1,165 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/autotuner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <limits>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "uvkc/benchmark/json_util.h"
+
+namespace uvkc {
+namespace benchmark {
+
+namespace {
+
+std::atomic<Autotuner *> global_autotuner{nullptr};
+
+thread_local const TuningCandidate *current_candidate = nullptr;
+
+}  // namespace
+
+TuningDevice GetTuningDevice(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device) {
+  const VkPhysicalDeviceProperties &properties = physical_device.v10_properties;
+  return {properties.deviceName, properties.vendorID, properties.deviceID,
+          properties.driverVersion};
+}
+
+Autotuner::Autotuner(Search search, double pruning_margin)
+    : search_(search), pruning_margin_(pruning_margin) {}
+
+// static
+Autotuner *Autotuner::GetGlobal() {
+  return global_autotuner.load(std::memory_order_acquire);
+}
+
+// static
+void Autotuner::SetGlobal(Autotuner *autotuner) {
+  global_autotuner.store(autotuner, std::memory_order_release);
+}
+
+// static
+void Autotuner::BeginCandidate(const TuningCandidate *candidate) {
+  current_candidate = candidate;
+}
+
+// static
+void Autotuner::EndCandidate() { current_candidate = nullptr; }
+
+bool Autotuner::RecordRun(int64_t iterations, double latency_seconds) {
+  const TuningCandidate *candidate = current_candidate;
+  if (!candidate) return true;
+
+  absl::MutexLock lock(&mutex_);
+  DeviceResults &results =
+      devices_
+          .try_emplace({candidate->device.name,
+                        candidate->device.driver_version},
+                       DeviceResults{candidate->device, {}})
+          .first->second;
+  Variants &variants = results.problems[{candidate->kernel, candidate->shape,
+                                         candidate->data_type}];
+  Measurement &measurement = variants[candidate->variant];
+  if (iterations > measurement.iterations ||
+      (iterations == measurement.iterations &&
+       latency_seconds < measurement.latency_seconds)) {
+    measurement.iterations = iterations;
+    measurement.latency_seconds = latency_seconds;
+  }
+
+  if (search_ != Search::kEarlyStopping ||
+      iterations < kMinIterationsToPrune) {
+    return true;
+  }
+
+  // Only compare with other warmed-up measurements.
+  double best_seconds = std::numeric_limits<double>::infinity();
+  for (const auto &variant : variants) {
+    if (variant.first == candidate->variant || variant.second.pruned ||
+        variant.second.iterations < kMinIterationsToPrune) {
+      continue;
+    }
+    best_seconds = std::min(best_seconds, variant.second.latency_seconds);
+  }
+  if (latency_seconds > best_seconds * (1 + pruning_margin_)) {
+    measurement.pruned = true;
+    return false;
+  }
+  return true;
+}
+
+absl::Status Autotuner::WriteJson(const std::string &path) const {
+  absl::MutexLock lock(&mutex_);
+
+  std::ofstream file(path, std::ios::out | std::ios::trunc);
+  if (!file) {
+    return absl::UnavailableError(absl::StrCat("cannot open ", path));
+  }
+
+  file << "{\"devices\":[";
+  bool first_device = true;
+  for (const auto &device_results : devices_) {
+    const DeviceResults &results = device_results.second;
+    if (!first_device) file << ",";
+    first_device = false;
+    file << "\n{\"name\":" << JsonString(results.device.name)
+         << ",\"vendor_id\":" << results.device.vendor_id
+         << ",\"device_id\":" << results.device.device_id
+         << ",\"driver_version\":" << results.device.driver_version
+         << ",\"kernels\":[";
+
+    bool first_problem = true;
+    for (const auto &problem : results.problems) {
+      const Variants &variants = problem.second;
+      auto best = variants.end();
+      int num_pruned = 0;
+      for (auto it = variants.begin(); it != variants.end(); ++it) {
+        if (it->second.pruned) {
+          ++num_pruned;
+        } else if (best == variants.end() ||
+                   it->second.latency_seconds < best->second.latency_seconds) {
+          best = it;
+        }
+      }
+      if (best == variants.end()) continue;
+
+      if (!first_problem) file << ",";
+      first_problem = false;
+      file << "\n  {\"kernel\":" << JsonString(std::get<0>(problem.first))
+           << ",\"shape\":" << JsonString(std::get<1>(problem.first))
+           << ",\"data_type\":" << JsonString(std::get<2>(problem.first))
+           << ",\"variant\":" << JsonString(best->first)
+           << absl::StrFormat(",\"latency_us\":%.3f",
+                              best->second.latency_seconds * 1e6)
+           << ",\"candidates\":" << variants.size()
+           << ",\"pruned\":" << num_pruned << "}";
+    }
+    file << "\n]}";
+  }
+  file << "\n]}\n";
+
+  file.close();
+  if (!file) {
+    return absl::InternalError(absl::StrCat("failed to write ", path));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
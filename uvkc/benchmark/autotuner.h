@@ -0,0 +1,155 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_AUTOTUNER_H_
+#define UVKC_BENCHMARK_AUTOTUNER_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "benchmark/benchmark.h"
+#include "uvkc/benchmark/device_benchmark.h"
+#include "uvkc/vulkan/device.h"
+#include "uvkc/vulkan/driver.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Identifies a device and the driver version tuning results are valid for.
+struct TuningDevice {
+  std::string name;
+  uint32_t vendor_id;
+  uint32_t device_id;
+  uint32_t driver_version;
+};
+
+TuningDevice GetTuningDevice(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device);
+
+// A shader variant solving a problem on a device.
+struct TuningCandidate {
+  TuningDevice device;
+  // The problem: the kernel, e.g., "matmul", its shape, and its data types.
+  std::string kernel;
+  std::string shape;
+  std::string data_type;
+  // Describes the shader variant, e.g., its tile and workgroup sizes.
+  std::string variant;
+};
+
+// Searches the shader variants of each problem for the fastest one on each
+// device and writes them as a JSON tuning database.
+//
+// Kernel benchmarks register each variant with RegisterTuningCandidate(), and
+// ComputeBenchmark::Measure() feeds the median latency of each run to the
+// global autotuner. A variant that failed verification aborts the process, so
+// all candidates in the database produce correct results.
+class Autotuner {
+ public:
+  enum class Search {
+    // Measures every candidate in full.
+    kExhaustive,
+    // Stops measuring a candidate as soon as one of its runs is slower than
+    // the fastest candidate of its problem so far by more than the pruning
+    // margin. Only runs of at least kMinIterationsToPrune iterations are
+    // compared, so that the cold first run Google Benchmark starts with,
+    // which includes first-touch costs, never prunes a candidate.
+    kEarlyStopping,
+  };
+
+  static constexpr int64_t kMinIterationsToPrune = 10;
+
+  // Creates an autotuner that prunes candidates more than |pruning_margin|, a
+  // fraction of the best latency, slower than the best one when searching
+  // with kEarlyStopping.
+  Autotuner(Search search, double pruning_margin);
+
+  // Returns the autotuner that ComputeBenchmark feeds measurements to, or
+  // nullptr if there is none.
+  static Autotuner *GetGlobal();
+
+  // Sets the autotuner returned by GetGlobal(); may be nullptr to stop
+  // tuning. |autotuner| must outlive all benchmarks run while it is set.
+  static void SetGlobal(Autotuner *autotuner);
+
+  // Sets the candidate that benchmarks run on the calling thread measure,
+  // until EndCandidate().
+  static void BeginCandidate(const TuningCandidate *candidate);
+  static void EndCandidate();
+
+  // Records a run of the current candidate of the calling thread, if any,
+  // with |iterations| iterations and a median latency of |latency_seconds|.
+  // Returns false if the search prunes the candidate, in which case the
+  // benchmark should stop.
+  bool RecordRun(int64_t iterations, double latency_seconds);
+
+  // Writes the fastest candidate of each problem on each device to |path|.
+  absl::Status WriteJson(const std::string &path) const;
+
+ private:
+  // The run recorded for a candidate: Google Benchmark repeats a benchmark
+  // with growing iteration counts until it runs long enough, so keep the
+  // longest, and the fastest of repetitions with as many iterations.
+  struct Measurement {
+    int64_t iterations = 0;
+    double latency_seconds = 0;
+    bool pruned = false;
+  };
+
+  // Measurements of the variants of one problem, by variant.
+  using Variants = std::map<std::string, Measurement>;
+
+  // Problems by kernel, shape, and data type.
+  using ProblemKey = std::tuple<std::string, std::string, std::string>;
+
+  struct DeviceResults {
+    TuningDevice device;
+    std::map<ProblemKey, Variants> problems;
+  };
+
+  const Search search_;
+  const double pruning_margin_;
+
+  mutable absl::Mutex mutex_;
+  // Results by device name and driver version.
+  std::map<std::pair<std::string, uint32_t>, DeviceResults> devices_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+// Registers a benchmark like RegisterDeviceBenchmark(), measuring the given
+// tuning candidate when run.
+template <class Function, class... Args>
+::benchmark::internal::Benchmark *RegisterTuningCandidate(
+    TuningCandidate candidate, const std::string &name, Function function,
+    LazyDevice *device, Args... args) {
+  return RegisterDeviceBenchmark(
+      name,
+      [=](::benchmark::State &state, vulkan::Device *device) {
+        Autotuner::BeginCandidate(&candidate);
+        function(state, device, args...);
+        Autotuner::EndCandidate();
+      },
+      device);
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_AUTOTUNER_H_
@@ -0,0 +1,165 @@
+// Copyright 2020-2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/buffer_pattern.h"
+
+#include <algorithm>
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "uvkc/base/status.h"
+#include "uvkc/vulkan/pipeline.h"
+
+static uint32_t kShaderCode[] = {
+#include "buffer_pattern_shader_spirv_instance.inc"
+};
+
+namespace uvkc::benchmark {
+namespace {
+
+// Must match the workgroup size in buffer_pattern.glsl.
+constexpr uint32_t kWorkgroupSize = 64;
+// The minimum guaranteed maxComputeWorkGroupCount[0] value.
+constexpr uint32_t kMaxWorkgroupCountX = 65535;
+
+uint32_t PcgHash(uint32_t v) {
+  uint32_t state = v * 747796405u + 2891336453u;
+  uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+// Returns the element type constant expected by buffer_pattern.glsl.
+int32_t GetShaderElementType(DataType data_type) {
+  switch (data_type) {
+    case DataType::fp32:
+      return 0;
+    case DataType::i32:
+      return 1;
+    case DataType::fp16:
+      return 2;
+    case DataType::i8:
+      return 3;
+  }
+  return 0;
+}
+
+}  // namespace
+
+BufferPattern BufferPattern::Iota(int32_t start, int32_t step) {
+  return {Kind::kIota, start, step, /*modulus=*/1, /*seed=*/0};
+}
+
+BufferPattern BufferPattern::Modular(uint32_t modulus, int32_t offset,
+                                     int32_t scale) {
+  return {Kind::kModular, offset, scale, modulus, /*seed=*/0};
+}
+
+BufferPattern BufferPattern::Random(uint32_t seed, int32_t low, int32_t high) {
+  return {Kind::kRandom, low, /*stride=*/1, static_cast<uint32_t>(high - low),
+          seed};
+}
+
+int32_t BufferPattern::ValueAt(uint32_t index) const {
+  // Use unsigned arithmetic to get the same wrap-around behavior as the GPU.
+  uint32_t value = 0;
+  switch (kind) {
+    case Kind::kIota:
+      value = uint32_t(base) + index * uint32_t(stride);
+      break;
+    case Kind::kModular:
+      value = uint32_t(base) + (index % modulus) * uint32_t(stride);
+      break;
+    case Kind::kRandom:
+      value = uint32_t(base) + PcgHash(index + PcgHash(seed)) % modulus;
+      break;
+  }
+  return static_cast<int32_t>(value);
+}
+
+absl::Status FillDeviceBufferWithPattern(vulkan::Device *device,
+                                         vulkan::Buffer *device_buffer,
+                                         DataType data_type,
+                                         size_t num_elements,
+                                         const BufferPattern &pattern) {
+  const size_t num_bytes = num_elements * GetSize(data_type);
+  if (num_bytes % sizeof(uint32_t) != 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("cannot fill ", num_elements, " ", GetName(data_type),
+                     " elements: not a multiple of 32-bit words"));
+  }
+  if (pattern.kind != BufferPattern::Kind::kIota && pattern.modulus == 0) {
+    return absl::InvalidArgumentError("pattern modulus must be positive");
+  }
+  const uint32_t num_words = num_bytes / sizeof(uint32_t);
+  if (num_words == 0) return absl::OkStatus();
+
+  UVKC_ASSIGN_OR_RETURN(
+      auto shader_module,
+      device->CreateShaderModule(kShaderCode,
+                                 sizeof(kShaderCode) / sizeof(uint32_t)));
+
+  vulkan::Pipeline::SpecConstant spec_constants[7] = {};
+  for (uint32_t i = 0; i < 7; ++i) spec_constants[i].id = i;
+  spec_constants[0].type = vulkan::Pipeline::SpecConstant::Type::s32;
+  spec_constants[0].value.s32 = static_cast<int32_t>(pattern.kind);
+  spec_constants[1].type = vulkan::Pipeline::SpecConstant::Type::s32;
+  spec_constants[1].value.s32 = pattern.base;
+  spec_constants[2].type = vulkan::Pipeline::SpecConstant::Type::s32;
+  spec_constants[2].value.s32 = pattern.stride;
+  spec_constants[3].type = vulkan::Pipeline::SpecConstant::Type::u32;
+  spec_constants[3].value.u32 = std::max(pattern.modulus, 1u);
+  spec_constants[4].type = vulkan::Pipeline::SpecConstant::Type::u32;
+  spec_constants[4].value.u32 = pattern.seed;
+  spec_constants[5].type = vulkan::Pipeline::SpecConstant::Type::s32;
+  spec_constants[5].value.s32 = GetShaderElementType(data_type);
+  spec_constants[6].type = vulkan::Pipeline::SpecConstant::Type::u32;
+  spec_constants[6].value.u32 = num_words;
+  UVKC_ASSIGN_OR_RETURN(
+      auto pipeline, device->CreatePipeline(*shader_module, "main",
+                                            absl::MakeSpan(spec_constants)));
+
+  UVKC_ASSIGN_OR_RETURN(auto descriptor_pool,
+                        device->CreateDescriptorPool(*shader_module));
+  UVKC_ASSIGN_OR_RETURN(auto layout_set_map,
+                        descriptor_pool->AllocateDescriptorSets(
+                            shader_module->descriptor_set_layouts()));
+
+  vulkan::Device::BoundBuffer bound_buffer = {device_buffer, /*set=*/0,
+                                              /*binding=*/0};
+  UVKC_RETURN_IF_ERROR(device->AttachBufferToDescriptor(
+      *shader_module, layout_set_map, absl::MakeConstSpan(&bound_buffer, 1)));
+
+  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
+  vulkan::CommandBuffer::BoundDescriptorSet bound_descriptor_set = {
+      /*index=*/0, layout_set_map.at(descriptor_set_layout)};
+
+  // Spread workgroups over the Y dimension once the X dimension is exhausted.
+  const uint32_t num_workgroups =
+      (num_words + kWorkgroupSize - 1) / kWorkgroupSize;
+  const uint32_t workgroups_x = std::min(num_workgroups, kMaxWorkgroupCountX);
+  const uint32_t workgroups_y =
+      (num_workgroups + workgroups_x - 1) / workgroups_x;
+
+  UVKC_ASSIGN_OR_RETURN(auto cmdbuffer, device->AllocateCommandBuffer());
+  UVKC_RETURN_IF_ERROR(cmdbuffer->Begin());
+  cmdbuffer->BindPipelineAndDescriptorSets(
+      *pipeline, absl::MakeConstSpan(&bound_descriptor_set, 1));
+  cmdbuffer->Dispatch(workgroups_x, workgroups_y, 1);
+  UVKC_RETURN_IF_ERROR(cmdbuffer->End());
+  UVKC_RETURN_IF_ERROR(device->QueueSubmitAndWait(*cmdbuffer));
+
+  return absl::OkStatus();
+}
+
+}  // namespace uvkc::benchmark
@@ -0,0 +1,85 @@
+// Copyright 2020-2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#version 450
+
+// Writes a deterministic integer pattern into a buffer, converted to the
+// requested element type. Each invocation produces one 32-bit word, which
+// packs 1 (fp32/i32), 2 (fp16), or 4 (i8) elements. Keep the pattern math in
+// sync with BufferPattern::ValueAt() in buffer_pattern.cc.
+
+layout (local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+layout(constant_id = 0) const int kPatternKind = 0;   // BufferPattern::Kind
+layout(constant_id = 1) const int kBase = 0;
+layout(constant_id = 2) const int kStride = 1;
+layout(constant_id = 3) const uint kModulus = 1;
+layout(constant_id = 4) const uint kSeed = 0;
+layout(constant_id = 5) const int kElementType = 0;   // See GetShaderElementType()
+layout(constant_id = 6) const uint kNumWords = 0;
+
+const int PATTERN_IOTA = 0;
+const int PATTERN_MODULAR = 1;
+const int PATTERN_RANDOM = 2;
+
+const int ELEMENT_FP32 = 0;
+const int ELEMENT_I32 = 1;
+const int ELEMENT_FP16 = 2;
+const int ELEMENT_I8 = 3;
+
+layout(set = 0, binding = 0) buffer OutputBuffer {
+    uint output_words[];
+};
+
+// PCG-based integer hash; see "Hash Functions for GPU Rendering" (Jarzynski &
+// Olano, 2020).
+uint PcgHash(uint v) {
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+int ValueAt(uint index) {
+    if (kPatternKind == PATTERN_IOTA) {
+        return kBase + int(index) * kStride;
+    } else if (kPatternKind == PATTERN_MODULAR) {
+        return kBase + int(index % kModulus) * kStride;
+    }
+    return kBase + int(PcgHash(index + PcgHash(kSeed)) % kModulus);
+}
+
+void main() {
+    const uint words_per_row = gl_NumWorkGroups.x * gl_WorkGroupSize.x;
+    const uint word_index = gl_GlobalInvocationID.y * words_per_row +
+                            gl_GlobalInvocationID.x;
+    if (word_index >= kNumWords) return;
+
+    uint word;
+    if (kElementType == ELEMENT_FP32) {
+        word = floatBitsToUint(float(ValueAt(word_index)));
+    } else if (kElementType == ELEMENT_I32) {
+        word = uint(ValueAt(word_index));
+    } else if (kElementType == ELEMENT_FP16) {
+        const uint first = word_index * 2u;
+        word = packHalf2x16(vec2(float(ValueAt(first)),
+                                 float(ValueAt(first + 1u))));
+    } else {
+        const uint first = word_index * 4u;
+        word = (uint(ValueAt(first)) & 0xffu) |
+               ((uint(ValueAt(first + 1u)) & 0xffu) << 8u) |
+               ((uint(ValueAt(first + 2u)) & 0xffu) << 16u) |
+               ((uint(ValueAt(first + 3u)) & 0xffu) << 24u);
+    }
+    output_words[word_index] = word;
+}
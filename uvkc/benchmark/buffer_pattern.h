@@ -0,0 +1,81 @@
+// Copyright 2020-2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_BUFFER_PATTERN_H_
+#define UVKC_BENCHMARK_BUFFER_PATTERN_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "uvkc/benchmark/data_type_util.h"
+#include "uvkc/vulkan/buffer.h"
+#include "uvkc/vulkan/device.h"
+
+namespace uvkc::benchmark {
+
+// A deterministic integer pattern that can be generated directly on the GPU
+// with FillDeviceBufferWithPattern() and reproduced on the CPU with ValueAt()
+// for verification.
+//
+// The pattern produces 32-bit integers that are then converted to the buffer's
+// element type. Floating point elements are exact as long as the values are
+// representable in the target type (e.g., |value| <= 2048 for fp16); i8
+// elements keep the lowest 8 bits.
+struct BufferPattern {
+  enum class Kind {
+    // value[i] = base + i * stride
+    kIota = 0,
+    // value[i] = base + (i % modulus) * stride
+    kModular = 1,
+    // value[i] = base + hash(i, seed) % modulus
+    kRandom = 2,
+  };
+
+  Kind kind;
+  int32_t base;
+  int32_t stride;
+  uint32_t modulus;
+  uint32_t seed;
+
+  // Returns a pattern counting up from |start| by |step|.
+  static BufferPattern Iota(int32_t start = 0, int32_t step = 1);
+
+  // Returns a pattern repeating every |modulus| elements with values
+  // |offset|, |offset| + |scale|, |offset| + 2 * |scale|, ...
+  static BufferPattern Modular(uint32_t modulus, int32_t offset = 0,
+                               int32_t scale = 1);
+
+  // Returns a pseudo-random pattern with values uniformly distributed in
+  // [|low|, |high|), determined by |seed|.
+  static BufferPattern Random(uint32_t seed, int32_t low, int32_t high);
+
+  // Returns the value at |index|, as generated by the GPU.
+  int32_t ValueAt(uint32_t index) const;
+};
+
+// Fills the first |num_elements| elements of |device_buffer|, interpreted as an
+// array of |data_type|, with values from |pattern| by dispatching a compute
+// shader. No data goes through the host. |device_buffer| is expected to have
+// VK_BUFFER_USAGE_STORAGE_BUFFER_BIT bit, and |num_elements| must cover
+// complete 32-bit words.
+absl::Status FillDeviceBufferWithPattern(vulkan::Device *device,
+                                         vulkan::Buffer *device_buffer,
+                                         DataType data_type,
+                                         size_t num_elements,
+                                         const BufferPattern &pattern);
+
+}  // namespace uvkc::benchmark
+
+#endif  // UVKC_BENCHMARK_BUFFER_PATTERN_H_
@@ -0,0 +1,298 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/compute_benchmark.h"
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "uvkc/base/log.h"
+#include "uvkc/base/status.h"
+#include "uvkc/benchmark/autotuner.h"
+#include "uvkc/benchmark/latency_breakdown.h"
+#include "uvkc/benchmark/latency_samples.h"
+#include "uvkc/benchmark/overhead_sampler.h"
+#include "uvkc/benchmark/roofline.h"
+#include "uvkc/benchmark/status_util.h"
+#include "uvkc/vulkan/pipeline_statistics_query_pool.h"
+#include "uvkc/vulkan/timestamp_query_pool.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// static
+absl::StatusOr<std::unique_ptr<ComputeBenchmark>> ComputeBenchmark::Create(
+    vulkan::Device *device, Options options) {
+  if (options.dispatches.empty()) {
+    return absl::InvalidArgumentError("no dispatches to benchmark");
+  }
+
+  UVKC_ASSIGN_OR_RETURN(
+      auto shader_module,
+      device->CreateShaderModule(options.code.data(), options.code.size()));
+  if (shader_module->descriptor_set_layouts().size() != 1) {
+    return absl::InvalidArgumentError("unexpected number of descriptor sets");
+  }
+
+  std::vector<std::unique_ptr<vulkan::Pipeline>> pipelines;
+  pipelines.reserve(options.dispatches.size());
+  for (Dispatch &dispatch : options.dispatches) {
+    UVKC_ASSIGN_OR_RETURN(
+        auto pipeline,
+        device->CreatePipeline(*shader_module, "main",
+                               absl::MakeSpan(dispatch.spec_constants),
+                               options.subgroup_size_control));
+    pipelines.push_back(std::move(pipeline));
+  }
+
+  UVKC_ASSIGN_OR_RETURN(auto descriptor_pool,
+                        device->CreateDescriptorPool(*shader_module));
+  UVKC_ASSIGN_OR_RETURN(auto layout_set_map,
+                        descriptor_pool->AllocateDescriptorSets(
+                            shader_module->descriptor_set_layouts()));
+  if (!options.buffers.empty()) {
+    UVKC_RETURN_IF_ERROR(device->AttachBufferToDescriptor(
+        *shader_module, layout_set_map, options.buffers));
+  }
+  if (!options.images.empty()) {
+    UVKC_RETURN_IF_ERROR(device->AttachImageToDescriptor(
+        *shader_module, layout_set_map, options.images));
+  }
+
+  std::vector<vulkan::CommandBuffer::BoundDescriptorSet> bound_descriptor_sets(
+      1);
+  bound_descriptor_sets[0].index = 0;
+  bound_descriptor_sets[0].set =
+      layout_set_map.at(shader_module->descriptor_set_layouts().front());
+
+  return absl::WrapUnique(new ComputeBenchmark(
+      device, std::move(options), std::move(shader_module),
+      std::move(descriptor_pool), std::move(pipelines),
+      std::move(bound_descriptor_sets)));
+}
+
+absl::Status ComputeBenchmark::DispatchOnce() {
+  UVKC_ASSIGN_OR_RETURN(auto cmdbuf, device_->AllocateCommandBuffer());
+  UVKC_RETURN_IF_ERROR(Reset(cmdbuf.get()));
+
+  // Count the invocations if possible, to check that the grid launches as
+  // many as expected.
+  std::unique_ptr<vulkan::PipelineStatisticsQueryPool> statistics_query_pool;
+  if (options_.expected_invocations != 0 &&
+      device_->optional_features().pipeline_statistics_query) {
+    UVKC_ASSIGN_OR_RETURN(statistics_query_pool,
+                          device_->CreatePipelineStatisticsQueryPool(1));
+  }
+
+  UVKC_RETURN_IF_ERROR(cmdbuf->Begin());
+  if (statistics_query_pool) {
+    cmdbuf->ResetQueryPool(*statistics_query_pool);
+    cmdbuf->BeginQuery(*statistics_query_pool, 0);
+  }
+  RecordDispatches(cmdbuf.get());
+  if (statistics_query_pool) cmdbuf->EndQuery(*statistics_query_pool, 0);
+  UVKC_RETURN_IF_ERROR(cmdbuf->End());
+  UVKC_RETURN_IF_ERROR(device_->QueueSubmitAndWait(*cmdbuf));
+
+  invocations_ = 0;
+  if (statistics_query_pool) {
+    UVKC_ASSIGN_OR_RETURN(
+        invocations_, statistics_query_pool->GetComputeShaderInvocations(0));
+    // Implementations may legitimately run more or fewer invocations than
+    // dispatched, so only warn about a mismatch.
+    if (invocations_ != options_.expected_invocations) {
+      GetErrorLogger() << "warning: " << options_.label << " ran "
+                       << invocations_ << " invocations; expected "
+                       << options_.expected_invocations << "\n";
+    }
+  }
+  return absl::OkStatus();
+}
+
+void ComputeBenchmark::Measure(::benchmark::State &state,
+                               const LatencyMeasure &latency_measure) {
+  // If requested, break each iteration down into host and GPU phases if the
+  // device can map GPU timestamps into the host clock domain. The timestamps
+  // it writes around the dispatches also serve kGpuTimestamp, which otherwise
+  // needs its own.
+  std::unique_ptr<LatencyBreakdown> breakdown;
+  if (latency_measure.breakdown &&
+      device_->optional_features().calibrated_timestamps) {
+    BM_CHECK_OK_AND_ASSIGN(breakdown, LatencyBreakdown::Create(device_));
+  }
+  std::unique_ptr<vulkan::TimestampQueryPool> query_pool;
+  if (latency_measure.mode == LatencyMeasureMode::kGpuTimestamp &&
+      !breakdown) {
+    BM_CHECK_OK_AND_ASSIGN(query_pool, device_->CreateTimestampQueryPool(2));
+  }
+
+  // Reset commands go into their own command buffer, so that only the
+  // dispatches are marked as measured.
+  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device_->AllocateCommandBuffer());
+  cmdbuf->set_measured(true);
+  BM_CHECK_OK_AND_ASSIGN(auto reset_cmdbuf, device_->AllocateCommandBuffer());
+  BM_CHECK_OK_AND_ASSIGN(auto overhead_sampler,
+                         OverheadSampler::Create(device_, state));
+  LatencySamples latency_samples(state);
+  for (auto _ : state) {
+    BM_CHECK_OK(Reset(reset_cmdbuf.get()));
+
+    int64_t record_start_ns = LatencyBreakdown::HostNanoseconds();
+    BM_CHECK_OK(cmdbuf->Begin());
+    if (breakdown) {
+      breakdown->RecordStart(cmdbuf.get());
+    } else if (query_pool) {
+      cmdbuf->ResetQueryPool(*query_pool);
+      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+    }
+
+    RecordDispatches(cmdbuf.get());
+
+    if (breakdown) {
+      breakdown->RecordEnd(cmdbuf.get());
+    } else if (query_pool) {
+      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             1);
+    }
+
+    BM_CHECK_OK(cmdbuf->End());
+
+    int64_t submit_ns = LatencyBreakdown::HostNanoseconds();
+    auto start_time = std::chrono::high_resolution_clock::now();
+    BM_CHECK_OK(device_->QueueSubmitAndWait(*cmdbuf));
+    auto end_time = std::chrono::high_resolution_clock::now();
+    int64_t wakeup_ns = LatencyBreakdown::HostNanoseconds();
+    auto elapsed_seconds =
+        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
+                                                                  start_time);
+    if (breakdown) {
+      BM_CHECK_OK(
+          breakdown->AddIteration(record_start_ns, submit_ns, wakeup_ns));
+    }
+
+    switch (latency_measure.mode) {
+      case LatencyMeasureMode::kSystemDispatch: {
+        double overhead_seconds = latency_measure.overhead_seconds;
+        if (!options_.subtract_registered_overhead) {
+          BM_CHECK_OK_AND_ASSIGN(
+              overhead_seconds,
+              overhead_sampler->Sample(
+                  *pipelines_.front(),
+                  absl::MakeConstSpan(bound_descriptor_sets_)));
+        }
+        latency_samples.SetIterationTime(
+            state, elapsed_seconds.count() - overhead_seconds);
+      } break;
+      case LatencyMeasureMode::kSystemSubmit: {
+        latency_samples.SetIterationTime(state, elapsed_seconds.count());
+      } break;
+      case LatencyMeasureMode::kGpuTimestamp: {
+        double timestamp_seconds = 0;
+        if (breakdown) {
+          timestamp_seconds = breakdown->last_gpu_execution_seconds();
+        } else {
+          BM_CHECK_OK_AND_ASSIGN(
+              timestamp_seconds,
+              query_pool->CalculateElapsedSecondsBetween(0, 1));
+        }
+        latency_samples.SetIterationTime(state, timestamp_seconds);
+      } break;
+    }
+
+    BM_CHECK_OK(cmdbuf->Reset());
+  }
+  latency_samples.ReportCounters(state);
+  overhead_sampler->ReportCounters(state);
+  const LatencySamples::Summary latency = latency_samples.Summarize();
+
+  if (breakdown) {
+    const LatencyBreakdown::Phases phases = breakdown->Average();
+    state.counters["Record(us)"] = phases.record_seconds * 1e6;
+    state.counters["SubmitToGpuStart(us)"] =
+        phases.submit_to_gpu_start_seconds * 1e6;
+    state.counters["GpuExecution(us)"] = phases.gpu_execution_seconds * 1e6;
+    state.counters["GpuEndToWakeup(us)"] =
+        phases.gpu_end_to_wakeup_seconds * 1e6;
+  }
+
+  if (invocations_ != 0) {
+    state.counters["Invocations"] = invocations_;
+    state.counters["ExpectedInvocations"] = options_.expected_invocations;
+    state.counters["TimePerInvocation(ns)"] =
+        latency.mean_seconds * 1e9 / invocations_;
+  }
+
+  if (options_.bytes_processed != 0) {
+    state.SetBytesProcessed(state.iterations() * options_.bytes_processed);
+  }
+  if (options_.num_operations != 0) {
+    state.counters[options_.operations_counter_name] =
+        ::benchmark::Counter(options_.num_operations,
+                             ::benchmark::Counter::kIsIterationInvariant |
+                                 ::benchmark::Counter::kIsRate,
+                             ::benchmark::Counter::kIs1000);
+  }
+  if (options_.report_roofline) {
+    ReportRoofline(state, options_.num_operations, options_.roofline_bytes,
+                   latency.p50_seconds, latency_measure.roofline_peaks);
+  }
+
+  Autotuner *autotuner = Autotuner::GetGlobal();
+  if (autotuner &&
+      !autotuner->RecordRun(state.iterations(), latency.p50_seconds)) {
+    state.SkipWithError("pruned by the autotuner");
+  }
+
+  // Reset the command pool to release all command buffers in the benchmarking
+  // loop to avoid draining GPU resources.
+  BM_CHECK_OK(device_->ResetCommandPool());
+}
+
+ComputeBenchmark::ComputeBenchmark(
+    vulkan::Device *device, Options options,
+    std::unique_ptr<vulkan::ShaderModule> shader_module,
+    std::unique_ptr<vulkan::DescriptorPool> descriptor_pool,
+    std::vector<std::unique_ptr<vulkan::Pipeline>> pipelines,
+    std::vector<vulkan::CommandBuffer::BoundDescriptorSet> descriptor_sets)
+    : device_(device),
+      options_(std::move(options)),
+      shader_module_(std::move(shader_module)),
+      descriptor_pool_(std::move(descriptor_pool)),
+      pipelines_(std::move(pipelines)),
+      bound_descriptor_sets_(std::move(descriptor_sets)) {}
+
+absl::Status ComputeBenchmark::Reset(vulkan::CommandBuffer *cmdbuf) {
+  if (!options_.record_reset) return absl::OkStatus();
+  UVKC_RETURN_IF_ERROR(cmdbuf->Begin());
+  options_.record_reset(cmdbuf);
+  UVKC_RETURN_IF_ERROR(cmdbuf->End());
+  UVKC_RETURN_IF_ERROR(device_->QueueSubmitAndWait(*cmdbuf));
+  return cmdbuf->Reset();
+}
+
+void ComputeBenchmark::RecordDispatches(vulkan::CommandBuffer *cmdbuf) const {
+  for (size_t i = 0; i < pipelines_.size(); ++i) {
+    if (i != 0) cmdbuf->DispatchBarrier();
+    const Dispatch &dispatch = options_.dispatches[i];
+    cmdbuf->BindPipelineAndDescriptorSets(
+        *pipelines_[i], absl::MakeConstSpan(bound_descriptor_sets_));
+    cmdbuf->Dispatch(dispatch.group_count_x, dispatch.group_count_y,
+                     dispatch.group_count_z);
+  }
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
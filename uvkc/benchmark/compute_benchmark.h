@@ -0,0 +1,154 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_COMPUTE_BENCHMARK_H_
+#define UVKC_BENCHMARK_COMPUTE_BENCHMARK_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "uvkc/benchmark/vulkan_context.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/descriptor_pool.h"
+#include "uvkc/vulkan/device.h"
+#include "uvkc/vulkan/pipeline.h"
+#include "uvkc/vulkan/shader_module.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// A compute shader benchmark described by its shader, resources, and grid.
+//
+// It creates the shader module, pipelines, and descriptor sets, and owns the
+// measurement loop shared by all kernel benchmarks: recording and submitting
+// the dispatches under the chosen LatencyMeasureMode, and reporting latency
+// distribution, overhead, throughput, and roofline counters. Suites only
+// create and fill buffers and verify results:
+//
+//   ComputeBenchmark::Options options;
+//   options.code = shader.code;
+//   options.buffers = {{src_buffer.get(), 0, 0}, {dst_buffer.get(), 0, 1}};
+//   options.dispatches = {{spec_constants, N / tile, 1, 1}};
+//   options.num_operations = 2. * M * N * K;
+//   BM_CHECK_OK_AND_ASSIGN(auto compute, ComputeBenchmark::Create(
+//                                            device, std::move(options)));
+//   BM_CHECK_OK(compute->DispatchOnce());
+//   ... verify results ...
+//   compute->Measure(state, *latency_measure);
+class ComputeBenchmark {
+ public:
+  // One dispatch of the benchmark, with its own pipeline specialization.
+  struct Dispatch {
+    std::vector<vulkan::Pipeline::SpecConstant> spec_constants;
+    uint32_t group_count_x = 1;
+    uint32_t group_count_y = 1;
+    uint32_t group_count_z = 1;
+  };
+
+  struct Options {
+    // Names the benchmark in warnings.
+    std::string label;
+    // SPIR-V code of the shader, with a "main" entry point and a single
+    // descriptor set.
+    absl::Span<const uint32_t> code;
+    std::vector<vulkan::Device::BoundBuffer> buffers;
+    std::vector<vulkan::Device::BoundImage> images;
+    vulkan::Pipeline::SubgroupSizeControl subgroup_size_control = {0, false};
+
+    // Dispatches recorded in order, separated by barriers, and timed as a
+    // whole.
+    std::vector<Dispatch> dispatches;
+
+    // If set, records commands restoring inputs the dispatches overwrite.
+    // They are submitted before every run of the dispatches and not timed.
+    std::function<void(vulkan::CommandBuffer *)> record_reset;
+
+    // Operations per run of the dispatches, reported as a rate counter with
+    // the given name if nonzero.
+    double num_operations = 0;
+    const char *operations_counter_name = "FLOps";
+    // Bytes per run of the dispatches reported as processed to Google
+    // Benchmark if nonzero.
+    double bytes_processed = 0;
+    // Whether to report against the roofline of the device, with the
+    // compulsory memory traffic of one run in bytes. Only meaningful for
+    // floating point operations.
+    bool report_roofline = false;
+    double roofline_bytes = 0;
+
+    // If nonzero and the device supports pipeline statistics queries,
+    // DispatchOnce() counts invocations to compare with this number.
+    uint64_t expected_invocations = 0;
+
+    // Whether kSystemDispatch subtracts the overhead measured by the
+    // benchmark registered via RegisterVulkanOverheadBenchmark() instead of
+    // sampling an empty dispatch after every iteration.
+    bool subtract_registered_overhead = false;
+  };
+
+  static absl::StatusOr<std::unique_ptr<ComputeBenchmark>> Create(
+      vulkan::Device *device, Options options);
+
+  // Runs the dispatches once, after the reset commands if any, and waits for
+  // them, e.g., to verify results. Warns if the number of invocations differs
+  // from the expected one.
+  absl::Status DispatchOnce();
+
+  // Runs the benchmark loop of |state| and reports its counters, measuring
+  // latency as |latency_measure| requires and, if it asks for a breakdown,
+  // breaking it down into host and GPU phases if the device supports
+  // calibrated timestamps. Feeds the median
+  // latency to the global Autotuner if any, and stops the benchmark if it
+  // prunes the candidate.
+  void Measure(::benchmark::State &state,
+               const LatencyMeasure &latency_measure);
+
+ private:
+  ComputeBenchmark(
+      vulkan::Device *device, Options options,
+      std::unique_ptr<vulkan::ShaderModule> shader_module,
+      std::unique_ptr<vulkan::DescriptorPool> descriptor_pool,
+      std::vector<std::unique_ptr<vulkan::Pipeline>> pipelines,
+      std::vector<vulkan::CommandBuffer::BoundDescriptorSet> descriptor_sets);
+
+  // Submits the reset commands if any, and waits for them.
+  absl::Status Reset(vulkan::CommandBuffer *cmdbuf);
+
+  // Records binding each pipeline and dispatching it.
+  void RecordDispatches(vulkan::CommandBuffer *cmdbuf) const;
+
+  vulkan::Device *device_;
+  const Options options_;
+
+  std::unique_ptr<vulkan::ShaderModule> shader_module_;
+  std::unique_ptr<vulkan::DescriptorPool> descriptor_pool_;
+  std::vector<std::unique_ptr<vulkan::Pipeline>> pipelines_;
+  std::vector<vulkan::CommandBuffer::BoundDescriptorSet>
+      bound_descriptor_sets_;
+
+  // Invocations counted by the last DispatchOnce(), or 0 if not counted.
+  uint64_t invocations_ = 0;
+};
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_COMPUTE_BENCHMARK_H_
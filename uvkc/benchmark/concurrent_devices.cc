@@ -0,0 +1,158 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/concurrent_devices.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include "absl/synchronization/mutex.h"
+#include "uvkc/benchmark/device_benchmark.h"
+
+namespace uvkc {
+namespace benchmark {
+
+namespace {
+
+// Reports the runs of one device thread: drops the benchmarks of other
+// devices, and annotates the rest with their slowdown. Output is buffered and
+// printed a whole report at a time so that device threads do not interleave.
+class ConcurrentReporter : public ::benchmark::ConsoleReporter {
+ public:
+  ConcurrentReporter(const std::map<std::string, double> *solo_latencies,
+                     absl::Mutex *output_mutex, bool print_context)
+      : solo_latencies_(solo_latencies),
+        output_mutex_(output_mutex),
+        print_context_(print_context) {
+    SetOutputStream(&buffer_);
+    SetErrorStream(&buffer_);
+  }
+
+  bool ReportContext(const Context &context) override {
+    // All device threads share the same context, so only print it once.
+    bool result = ::benchmark::ConsoleReporter::ReportContext(context);
+    if (print_context_) {
+      Flush();
+    } else {
+      buffer_.str("");
+    }
+    return result;
+  }
+
+  void ReportRuns(const std::vector<Run> &reports) override {
+    std::vector<Run> annotated_reports;
+    for (const Run &run : reports) {
+      if (IsSkippedForOtherDevice(run)) continue;
+      annotated_reports.push_back(run);
+      Run &annotated = annotated_reports.back();
+      if (annotated.run_type != Run::RT_Iteration || annotated.error_occurred) {
+        continue;
+      }
+      auto solo = solo_latencies_->find(annotated.benchmark_name());
+      if (solo == solo_latencies_->end() || solo->second <= 0) continue;
+      double slowdown = annotated.GetAdjustedRealTime() / solo->second;
+      annotated.counters["Slowdown(x)"] = slowdown;
+      if (slowdown > 0) slowdowns_.push_back(slowdown);
+    }
+    if (annotated_reports.empty()) return;
+
+    ::benchmark::ConsoleReporter::ReportRuns(annotated_reports);
+    Flush();
+  }
+
+  // Returns the slowdown of each run reported.
+  const std::vector<double> &slowdowns() const { return slowdowns_; }
+
+ private:
+  void Flush() {
+    absl::MutexLock lock(output_mutex_);
+    std::cout << buffer_.str() << std::flush;
+    buffer_.str("");
+  }
+
+  const std::map<std::string, double> *solo_latencies_;
+  absl::Mutex *output_mutex_;
+  const bool print_context_;
+
+  std::ostringstream buffer_;
+  std::vector<double> slowdowns_;
+};
+
+}  // namespace
+
+void SoloLatencyReporter::ReportRuns(const std::vector<Run> &reports) {
+  for (const Run &run : reports) {
+    if (run.run_type != Run::RT_Iteration || run.error_occurred) continue;
+    auto &latency = latencies_[run.benchmark_name()];
+    latency.first += run.GetAdjustedRealTime();
+    ++latency.second;
+  }
+  ::benchmark::ConsoleReporter::ReportRuns(reports);
+}
+
+std::map<std::string, double> SoloLatencyReporter::GetLatencies() const {
+  std::map<std::string, double> latencies;
+  for (const auto &latency : latencies_) {
+    latencies[latency.first] = latency.second.first / latency.second.second;
+  }
+  return latencies;
+}
+
+void RunBenchmarksConcurrently(
+    absl::Span<LazyDevice *const> devices,
+    absl::Span<const std::string> device_names,
+    const std::map<std::string, double> &solo_latencies) {
+  std::cout << "\nRunning the benchmarks of " << devices.size()
+            << " devices concurrently\n";
+
+  absl::Mutex output_mutex;
+  std::vector<std::unique_ptr<ConcurrentReporter>> reporters;
+  for (int i = 0; i < devices.size(); ++i) {
+    reporters.push_back(std::make_unique<ConcurrentReporter>(
+        &solo_latencies, &output_mutex, /*print_context=*/i == 0));
+  }
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < devices.size(); ++i) {
+    threads.emplace_back([device = devices[i], reporter = reporters[i].get()] {
+      SetThreadBenchmarkDevice(device);
+      ::benchmark::RunSpecifiedBenchmarks(reporter);
+      SetThreadBenchmarkDevice(nullptr);
+    });
+  }
+  for (std::thread &thread : threads) thread.join();
+
+  // Summarize with the geometric mean, as slowdowns are ratios.
+  std::cout << "\nSlowdown under contention:\n";
+  for (int i = 0; i < devices.size(); ++i) {
+    const std::vector<double> &slowdowns = reporters[i]->slowdowns();
+    std::cout << "  " << device_names[i] << ": ";
+    if (slowdowns.empty()) {
+      std::cout << "no benchmarks\n";
+      continue;
+    }
+    double log_sum = 0;
+    for (double slowdown : slowdowns) log_sum += std::log(slowdown);
+    std::cout << std::exp(log_sum / slowdowns.size()) << "x geomean, "
+              << *std::max_element(slowdowns.begin(), slowdowns.end())
+              << "x max over " << slowdowns.size() << " runs\n";
+  }
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,60 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_CONCURRENT_DEVICES_H_
+#define UVKC_BENCHMARK_CONCURRENT_DEVICES_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "uvkc/benchmark/vulkan_context.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// A console reporter recording the latency of each benchmark, to compare
+// with when devices run their benchmarks at the same time.
+class SoloLatencyReporter : public ::benchmark::ConsoleReporter {
+ public:
+  void ReportRuns(const std::vector<Run> &reports) override;
+
+  // Returns the mean latency of each benchmark over its repetitions, by
+  // benchmark name, in the time unit of the benchmark.
+  std::map<std::string, double> GetLatencies() const;
+
+ private:
+  // The sum and number of the latencies of each benchmark.
+  std::map<std::string, std::pair<double, int>> latencies_;
+};
+
+// Runs the benchmarks of each device in |devices|, named |device_names|, on
+// its own host thread at the same time, to measure contention for shared host
+// resources such as submission threads, PCIe, and memory bandwidth.
+//
+// Each run reports its latency relative to |solo_latencies| as `Slowdown(x)`,
+// and a summary of the slowdown of each device is printed at the end.
+// Benchmarks must be registered with RegisterDeviceBenchmark().
+void RunBenchmarksConcurrently(
+    absl::Span<LazyDevice *const> devices,
+    absl::Span<const std::string> device_names,
+    const std::map<std::string, double> &solo_latencies);
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_CONCURRENT_DEVICES_H_
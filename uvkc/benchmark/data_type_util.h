@@ -12,6 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#ifndef UVKC_BENCHMARK_DATA_TYPE_UTIL_H_
+#define UVKC_BENCHMARK_DATA_TYPE_UTIL_H_
+
 #include <cstddef>
 #include <cstdint>
 #include <ostream>
@@ -132,3 +135,5 @@ class fp16 {
 };
 
 }  // namespace uvkc::benchmark
+
+#endif  // UVKC_BENCHMARK_DATA_TYPE_UTIL_H_
@@ -0,0 +1,42 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/device_benchmark.h"
+
+namespace uvkc {
+namespace benchmark {
+
+namespace {
+
+thread_local const LazyDevice *thread_device = nullptr;
+
+}  // namespace
+
+const char kSkippedForOtherDeviceMessage[] = "runs on another device thread";
+
+void SetThreadBenchmarkDevice(const LazyDevice *device) {
+  thread_device = device;
+}
+
+bool RunsBenchmarksOf(const LazyDevice *device) {
+  return thread_device == nullptr || thread_device == device;
+}
+
+bool IsSkippedForOtherDevice(const ::benchmark::BenchmarkReporter::Run &run) {
+  return run.error_occurred &&
+         run.error_message == kSkippedForOtherDeviceMessage;
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,66 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_DEVICE_BENCHMARK_H_
+#define UVKC_BENCHMARK_DEVICE_BENCHMARK_H_
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/vulkan_context.h"
+#include "uvkc/vulkan/device.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Sets the device whose benchmarks the calling thread runs, so that each
+// device can run its benchmarks on its own host thread at the same time.
+// Benchmarks registered with RegisterDeviceBenchmark() for other devices are
+// skipped on the calling thread. nullptr, the default, runs them all.
+void SetThreadBenchmarkDevice(const LazyDevice *device);
+
+// Returns true if the benchmarks of |device| run on the calling thread.
+bool RunsBenchmarksOf(const LazyDevice *device);
+
+// Returns true if |run| was skipped because the calling thread runs the
+// benchmarks of another device.
+bool IsSkippedForOtherDevice(const ::benchmark::BenchmarkReporter::Run &run);
+
+// The error message of benchmarks skipped for another device.
+extern const char kSkippedForOtherDeviceMessage[];
+
+// Registers a benchmark like ::benchmark::RegisterBenchmark(), running
+// |function| with the logical device of |device| and |args| on the threads
+// that run the benchmarks of |device|. The logical device is created when the
+// first benchmark on it runs.
+template <class Function, class... Args>
+::benchmark::internal::Benchmark *RegisterDeviceBenchmark(
+    const std::string &name, Function function, LazyDevice *device,
+    Args... args) {
+  return ::benchmark::RegisterBenchmark(
+      name.c_str(), [=](::benchmark::State &state) {
+        if (!RunsBenchmarksOf(device)) {
+          state.SkipWithError(kSkippedForOtherDeviceMessage);
+          return;
+        }
+        BM_CHECK_OK_AND_ASSIGN(vulkan::Device *logical_device, device->Get());
+        function(state, logical_device, args...);
+      });
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_DEVICE_BENCHMARK_H_
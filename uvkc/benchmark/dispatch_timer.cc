@@ -0,0 +1,114 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/dispatch_timer.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "uvkc/base/status.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// static
+absl::StatusOr<std::unique_ptr<DispatchTimer>> DispatchTimer::Create(
+    vulkan::Device *device, int dispatches_per_batch,
+    int max_pending_batches) {
+  if (dispatches_per_batch <= 0 || max_pending_batches <= 0) {
+    return absl::InvalidArgumentError(
+        "dispatch and batch counts must be positive");
+  }
+
+  // One query for the start of each batch and one after each dispatch.
+  UVKC_ASSIGN_OR_RETURN(auto query_pool,
+                        device->CreateTimestampQueryPool(
+                            (dispatches_per_batch + 1) * max_pending_batches));
+  return absl::WrapUnique(new DispatchTimer(
+      std::move(query_pool), dispatches_per_batch, max_pending_batches));
+}
+
+absl::Status DispatchTimer::BeginBatch(vulkan::CommandBuffer *cmdbuf) {
+  const uint32_t query_count = dispatches_per_batch_ + 1;
+  UVKC_ASSIGN_OR_RETURN(uint32_t first_query,
+                        query_pool_->AcquireQueries(query_count));
+  cmdbuf->ResetQueryPool(*query_pool_, first_query, query_count);
+  cmdbuf->WriteTimestamp(*query_pool_, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         first_query);
+  next_query_ = first_query + 1;
+  return absl::OkStatus();
+}
+
+void DispatchTimer::EndDispatch(vulkan::CommandBuffer *cmdbuf) {
+  cmdbuf->WriteTimestamp(*query_pool_, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         next_query_++);
+}
+
+absl::Status DispatchTimer::Collect() {
+  elapsed_seconds_.clear();
+  UVKC_ASSIGN_OR_RETURN(int num_collected,
+                        query_pool_->CollectElapsedSeconds(&elapsed_seconds_));
+
+  for (int batch = 0; batch < num_collected; ++batch) {
+    const double *times =
+        elapsed_seconds_.data() + batch * dispatches_per_batch_;
+    double batch_seconds = times[0];
+    first_dispatch_total_seconds_ += times[0];
+    for (int i = 1; i < dispatches_per_batch_; ++i) {
+      batch_seconds += times[i];
+      steady_state_total_seconds_ += times[i];
+      steady_state_min_seconds_ = std::min(steady_state_min_seconds_, times[i]);
+      steady_state_max_seconds_ = std::max(steady_state_max_seconds_, times[i]);
+    }
+    last_batch_seconds_ = batch_seconds;
+    ++num_batches_;
+  }
+  return absl::OkStatus();
+}
+
+DispatchTimer::Summary DispatchTimer::Summarize() const {
+  Summary summary = {};
+  summary.num_batches = num_batches_;
+  if (num_batches_ == 0) return summary;
+
+  summary.first_dispatch_seconds = first_dispatch_total_seconds_ / num_batches_;
+  if (dispatches_per_batch_ > 1) {
+    summary.steady_state_seconds =
+        steady_state_total_seconds_ /
+        (static_cast<double>(num_batches_) * (dispatches_per_batch_ - 1));
+    summary.steady_state_min_seconds = steady_state_min_seconds_;
+    summary.steady_state_max_seconds = steady_state_max_seconds_;
+  }
+  return summary;
+}
+
+DispatchTimer::DispatchTimer(
+    std::unique_ptr<vulkan::TimestampQueryPool> query_pool,
+    int dispatches_per_batch, int max_pending_batches)
+    : query_pool_(std::move(query_pool)),
+      dispatches_per_batch_(dispatches_per_batch),
+      next_query_(0),
+      num_batches_(0),
+      last_batch_seconds_(0),
+      first_dispatch_total_seconds_(0),
+      steady_state_total_seconds_(0),
+      steady_state_min_seconds_(std::numeric_limits<double>::max()),
+      steady_state_max_seconds_(0) {
+  elapsed_seconds_.reserve(dispatches_per_batch * max_pending_batches);
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_DISPATCH_TIMER_H_
+#define UVKC_BENCHMARK_DISPATCH_TIMER_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/device.h"
+#include "uvkc/vulkan/timestamp_query_pool.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Times each dispatch in batches of dispatches recorded into one command
+// buffer, by writing a GPU timestamp after every dispatch.
+//
+// The time of dispatch #i in a batch is measured from the completion of
+// dispatch #(i - 1), or from the start of the batch for the first one, to the
+// completion of dispatch #i. So the first dispatch includes any warmup cost,
+// while later ones show the steady state when dispatches are pipelined.
+class DispatchTimer {
+ public:
+  // Statistics of per-dispatch times over all collected batches.
+  struct Summary {
+    int num_batches;
+    // Average time of the first dispatch in a batch.
+    double first_dispatch_seconds;
+    // Average, minimum and maximum time of the rest of the dispatches. These
+    // are zero for batches of one dispatch.
+    double steady_state_seconds;
+    double steady_state_min_seconds;
+    double steady_state_max_seconds;
+  };
+
+  // Creates a timer for batches of |dispatches_per_batch| dispatches, with at
+  // most |max_pending_batches| batches recorded but not collected yet.
+  static absl::StatusOr<std::unique_ptr<DispatchTimer>> Create(
+      vulkan::Device *device, int dispatches_per_batch,
+      int max_pending_batches);
+
+  // Records commands into |cmdbuf| to start a new batch. Exactly
+  // |dispatches_per_batch| calls to EndDispatch() should follow.
+  absl::Status BeginBatch(vulkan::CommandBuffer *cmdbuf);
+
+  // Records a command into |cmdbuf| to mark the completion of the dispatch
+  // just recorded.
+  void EndDispatch(vulkan::CommandBuffer *cmdbuf);
+
+  // Reads back the times of all batches the GPU has finished, without
+  // waiting for the rest.
+  absl::Status Collect();
+
+  // Returns the total time of the most recently collected batch.
+  double last_batch_seconds() const { return last_batch_seconds_; }
+
+  // Returns statistics over all batches collected so far.
+  Summary Summarize() const;
+
+ private:
+  DispatchTimer(std::unique_ptr<vulkan::TimestampQueryPool> query_pool,
+                int dispatches_per_batch, int max_pending_batches);
+
+  std::unique_ptr<vulkan::TimestampQueryPool> query_pool_;
+  int dispatches_per_batch_;
+
+  // The query for the next EndDispatch() call in the current batch.
+  uint32_t next_query_;
+
+  // Per-dispatch times read back but not accumulated yet.
+  std::vector<double> elapsed_seconds_;
+
+  int num_batches_;
+  double last_batch_seconds_;
+  double first_dispatch_total_seconds_;
+  double steady_state_total_seconds_;
+  double steady_state_min_seconds_;
+  double steady_state_max_seconds_;
+};
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_DISPATCH_TIMER_H_
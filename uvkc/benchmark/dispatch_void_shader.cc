@@ -19,6 +19,9 @@
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "benchmark/benchmark.h"
+#include "uvkc/benchmark/device_benchmark.h"
+#include "uvkc/benchmark/latency_breakdown.h"
+#include "uvkc/benchmark/latency_samples.h"
 #include "uvkc/benchmark/status_util.h"
 #include "uvkc/vulkan/device.h"
 
@@ -28,6 +31,7 @@ static uint32_t kShaderCode[] = {
 
 static void DispatchVoidShader(::benchmark::State &state,
                                ::uvkc::vulkan::Device *device,
+                               bool latency_breakdown,
                                double *avg_latency_seconds) {
   //===-------------------------------------------------------------------===/
   // Create shader module and pipeline
@@ -46,26 +50,57 @@ static void DispatchVoidShader(::benchmark::State &state,
   // Benchmarking
   //===-------------------------------------------------------------------===/
 
+  // If requested, break the latency down into host and GPU phases if the
+  // device can map GPU timestamps into the host clock domain.
+  std::unique_ptr<::uvkc::benchmark::LatencyBreakdown> breakdown;
+  if (latency_breakdown && device->optional_features().calibrated_timestamps) {
+    BM_CHECK_OK_AND_ASSIGN(breakdown,
+                           ::uvkc::benchmark::LatencyBreakdown::Create(device));
+  }
+
   BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
+  cmdbuf->set_measured(true);
   double total_seconds = 0;
+  ::uvkc::benchmark::LatencySamples latency_samples(state);
   for (auto _ : state) {
+    int64_t record_start_ns =
+        ::uvkc::benchmark::LatencyBreakdown::HostNanoseconds();
     BM_CHECK_OK(cmdbuf->Begin());
+    if (breakdown) breakdown->RecordStart(cmdbuf.get());
     cmdbuf->BindPipelineAndDescriptorSets(*pipeline,
                                           /*bound_descriptor_sets=*/{});
     cmdbuf->Dispatch(1, 1, 1);
+    if (breakdown) breakdown->RecordEnd(cmdbuf.get());
     BM_CHECK_OK(cmdbuf->End());
+    int64_t submit_ns = ::uvkc::benchmark::LatencyBreakdown::HostNanoseconds();
     auto start_time = std::chrono::high_resolution_clock::now();
     BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
     auto end_time = std::chrono::high_resolution_clock::now();
+    int64_t wakeup_ns = ::uvkc::benchmark::LatencyBreakdown::HostNanoseconds();
     auto elapsed_seconds =
         std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
                                                                   start_time);
-    state.SetIterationTime(elapsed_seconds.count());
+    latency_samples.SetIterationTime(state, elapsed_seconds.count());
     total_seconds += elapsed_seconds.count();
+    if (breakdown) {
+      BM_CHECK_OK(
+          breakdown->AddIteration(record_start_ns, submit_ns, wakeup_ns));
+    }
     BM_CHECK_OK(cmdbuf->Reset());
   }
+  latency_samples.ReportCounters(state);
   *avg_latency_seconds = total_seconds / state.iterations();
 
+  if (breakdown) {
+    auto phases = breakdown->Average();
+    state.counters["Record(us)"] = phases.record_seconds * 1e6;
+    state.counters["SubmitToGpuStart(us)"] =
+        phases.submit_to_gpu_start_seconds * 1e6;
+    state.counters["GpuExecution(us)"] = phases.gpu_execution_seconds * 1e6;
+    state.counters["GpuEndToWakeup(us)"] =
+        phases.gpu_end_to_wakeup_seconds * 1e6;
+  }
+
   // Reset the command pool to release all command buffers in the benchmarking
   // loop to avoid draining GPU resources.
   BM_CHECK_OK(device->ResetCommandPool());
@@ -75,11 +110,12 @@ namespace uvkc {
 namespace benchmark {
 
 void RegisterDispatchVoidShaderBenchmark(const char *gpu_name,
-                                         vulkan::Device *device,
+                                         LazyDevice *device,
+                                         bool latency_breakdown,
                                          double *avg_latency_seconds) {
   std::string test_name = absl::StrCat(gpu_name, "/dispatch_void_shader");
-  ::benchmark::RegisterBenchmark(test_name.c_str(), DispatchVoidShader, device,
-                                 avg_latency_seconds)
+  RegisterDeviceBenchmark(test_name, DispatchVoidShader, device,
+                          latency_breakdown, avg_latency_seconds)
       ->UseManualTime()
       ->Unit(::benchmark::kMicrosecond);
 }
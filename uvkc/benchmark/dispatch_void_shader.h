@@ -15,6 +15,7 @@
 #ifndef UVKC_BENCHMARK_DISPATCH_VOID_SHADER_H_
 #define UVKC_BENCHMARK_DISPATCH_VOID_SHADER_H_
 
+#include "uvkc/benchmark/vulkan_context.h"
 #include "uvkc/vulkan/device.h"
 
 namespace uvkc {
@@ -22,9 +23,12 @@ namespace benchmark {
 
 // Regisers a benchmark that measures the average latency of dispatching a void
 // shader to the given |device| with the given |gpu_name|. Writes the average
-// latency to |avg_latency_seconds| after benchmarking.
+// latency to |avg_latency_seconds| after benchmarking. If |latency_breakdown|,
+// also breaks the latency down into host and GPU phases on devices supporting
+// calibrated timestamps.
 void RegisterDispatchVoidShaderBenchmark(const char *gpu_name,
-                                         vulkan::Device *device,
+                                         LazyDevice *device,
+                                         bool latency_breakdown,
                                          double *avg_latency_seconds);
 
 }  // namespace benchmark
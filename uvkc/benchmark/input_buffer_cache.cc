@@ -0,0 +1,148 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/input_buffer_cache.h"
+
+#include <atomic>
+#include <string>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "uvkc/base/status.h"
+#include "uvkc/benchmark/vulkan_buffer_util.h"
+
+namespace uvkc {
+namespace benchmark {
+
+namespace {
+
+std::atomic<InputBufferCache *> global_cache{nullptr};
+
+absl::StatusOr<std::shared_ptr<vulkan::Buffer>> CreateInputBuffer(
+    vulkan::Device *device, size_t size_in_bytes,
+    const std::function<absl::Status(vulkan::Buffer *)> &initialize) {
+  UVKC_ASSIGN_OR_RETURN(
+      std::shared_ptr<vulkan::Buffer> buffer,
+      device->CreateBuffer(
+          VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, size_in_bytes));
+  UVKC_RETURN_IF_ERROR(initialize(buffer.get()));
+  return buffer;
+}
+
+// Returns an input buffer from the global cache if any, or a new one.
+absl::StatusOr<std::shared_ptr<vulkan::Buffer>> GetOrCreateInputBuffer(
+    vulkan::Device *device, absl::string_view generator, DataType data_type,
+    absl::Span<const int> shape, size_t size_in_bytes,
+    const std::function<absl::Status(vulkan::Buffer *)> &initialize) {
+  if (InputBufferCache *cache = InputBufferCache::GetGlobal()) {
+    return cache->GetOrCreate(device, generator, data_type, shape,
+                              size_in_bytes, initialize);
+  }
+  return CreateInputBuffer(device, size_in_bytes, initialize);
+}
+
+}  // namespace
+
+InputBufferCache::InputBufferCache(size_t capacity_bytes)
+    : capacity_bytes_(capacity_bytes) {}
+
+// static
+InputBufferCache *InputBufferCache::GetGlobal() {
+  return global_cache.load(std::memory_order_acquire);
+}
+
+// static
+void InputBufferCache::SetGlobal(InputBufferCache *cache) {
+  global_cache.store(cache, std::memory_order_release);
+}
+
+absl::StatusOr<std::shared_ptr<vulkan::Buffer>> InputBufferCache::GetOrCreate(
+    vulkan::Device *device, absl::string_view generator, DataType data_type,
+    absl::Span<const int> shape, size_t size_in_bytes,
+    const std::function<absl::Status(vulkan::Buffer *)> &initialize) {
+  auto key = std::make_pair(
+      device, absl::StrCat(generator, "/", GetName(data_type), "/",
+                           absl::StrJoin(shape, "x")));
+
+  // Initialization happens under the lock, so that concurrent benchmarks of
+  // the same problem create it only once.
+  absl::MutexLock lock(&mutex_);
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    if (it->second.size_in_bytes != size_in_bytes) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "input buffer '", key.second, "' requested with ", size_in_bytes,
+          " bytes but cached with ", it->second.size_in_bytes));
+    }
+    it->second.last_use = ++num_uses_;
+    return it->second.buffer;
+  }
+
+  UVKC_ASSIGN_OR_RETURN(auto buffer,
+                        CreateInputBuffer(device, size_in_bytes, initialize));
+  entries_[key] = {buffer, size_in_bytes, ++num_uses_};
+  size_in_bytes_ += size_in_bytes;
+  Evict(key);
+  return buffer;
+}
+
+void InputBufferCache::Evict(
+    const std::pair<vulkan::Device *, std::string> &key) {
+  while (size_in_bytes_ > capacity_bytes_ && entries_.size() > 1) {
+    auto oldest = entries_.end();
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->first == key) continue;
+      if (oldest == entries_.end() ||
+          it->second.last_use < oldest->second.last_use) {
+        oldest = it;
+      }
+    }
+    size_in_bytes_ -= oldest->second.size_in_bytes;
+    entries_.erase(oldest);
+  }
+}
+
+absl::StatusOr<std::shared_ptr<vulkan::Buffer>> GetInputBuffer(
+    vulkan::Device *device, absl::string_view generator, DataType data_type,
+    absl::Span<const int> shape, size_t size_in_bytes,
+    const std::function<void(void *, size_t)> &fill) {
+  return GetOrCreateInputBuffer(device, generator, data_type, shape,
+                                size_in_bytes, [&](vulkan::Buffer *buffer) {
+                                  return SetDeviceBufferViaStagingBuffer(
+                                      device, buffer, size_in_bytes, fill);
+                                });
+}
+
+absl::StatusOr<std::shared_ptr<vulkan::Buffer>> GetInputBuffer(
+    vulkan::Device *device, const BufferPattern &pattern, DataType data_type,
+    absl::Span<const int> shape) {
+  // Patterns are fully described by their parameters, so they name their own
+  // generator.
+  const std::string generator = absl::StrCat(
+      "pattern", static_cast<int>(pattern.kind), "(", pattern.base, ",",
+      pattern.stride, ",", pattern.modulus, ",", pattern.seed, ")");
+  size_t num_elements = 1;
+  for (int size : shape) num_elements *= size;
+  return GetOrCreateInputBuffer(
+      device, generator, data_type, shape, num_elements * GetSize(data_type),
+      [&](vulkan::Buffer *buffer) {
+        return FillDeviceBufferWithPattern(device, buffer, data_type,
+                                           num_elements, pattern);
+      });
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,111 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_INPUT_BUFFER_CACHE_H_
+#define UVKC_BENCHMARK_INPUT_BUFFER_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "uvkc/benchmark/buffer_pattern.h"
+#include "uvkc/benchmark/data_type_util.h"
+#include "uvkc/vulkan/buffer.h"
+#include "uvkc/vulkan/device.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// A cache of device buffers holding benchmark inputs, so that benchmarks of
+// the same problem, e.g., the hundreds of shader variants of a matmul shape,
+// share one buffer instead of each creating, filling, and uploading its own.
+//
+// Buffers are keyed by device, the generator of their values, data type, and
+// shape, and must only be read by benchmarks. Once the cached buffers exceed
+// the capacity, the least recently used ones are released; buffers stay
+// alive while benchmarks hold them.
+class InputBufferCache {
+ public:
+  static constexpr size_t kDefaultCapacityBytes = size_t(256) << 20;
+
+  explicit InputBufferCache(size_t capacity_bytes = kDefaultCapacityBytes);
+
+  // Returns the cache that benchmarks take input buffers from, or nullptr if
+  // there is none.
+  static InputBufferCache *GetGlobal();
+
+  // Sets the cache returned by GetGlobal(); may be nullptr to stop caching.
+  // |cache| must outlive all benchmarks run while it is set.
+  static void SetGlobal(InputBufferCache *cache);
+
+  // Returns a device-local storage buffer on |device| of |size_in_bytes|
+  // bytes, holding the values of a |data_type| tensor of |shape| generated by
+  // the generator named |generator|. On a miss, the buffer is created and
+  // |initialize| writes its contents. |generator| must name the generator
+  // uniquely among all benchmarks linked together.
+  absl::StatusOr<std::shared_ptr<vulkan::Buffer>> GetOrCreate(
+      vulkan::Device *device, absl::string_view generator, DataType data_type,
+      absl::Span<const int> shape, size_t size_in_bytes,
+      const std::function<absl::Status(vulkan::Buffer *)> &initialize);
+
+ private:
+  struct Entry {
+    std::shared_ptr<vulkan::Buffer> buffer;
+    size_t size_in_bytes;
+    uint64_t last_use;
+  };
+
+  // Releases least recently used buffers other than |key| until the cache
+  // fits in its capacity.
+  void Evict(const std::pair<vulkan::Device *, std::string> &key)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  const size_t capacity_bytes_;
+
+  absl::Mutex mutex_;
+  std::map<std::pair<vulkan::Device *, std::string>, Entry> entries_
+      ABSL_GUARDED_BY(mutex_);
+  size_t size_in_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+  uint64_t num_uses_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+// Returns an input buffer from the global InputBufferCache as
+// InputBufferCache::GetOrCreate() does, or a new uncached one if there is no
+// global cache. |fill| writes the contents into a staging buffer.
+absl::StatusOr<std::shared_ptr<vulkan::Buffer>> GetInputBuffer(
+    vulkan::Device *device, absl::string_view generator, DataType data_type,
+    absl::Span<const int> shape, size_t size_in_bytes,
+    const std::function<void(void *, size_t)> &fill);
+
+// Returns an input buffer like the above holding a |data_type| tensor of
+// |shape| with the values of |pattern| in row-major order, generated on the
+// GPU with FillDeviceBufferWithPattern(). Benchmarks reproduce the values
+// with BufferPattern::ValueAt() for verification.
+absl::StatusOr<std::shared_ptr<vulkan::Buffer>> GetInputBuffer(
+    vulkan::Device *device, const BufferPattern &pattern, DataType data_type,
+    absl::Span<const int> shape);
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_INPUT_BUFFER_CACHE_H_
@@ -0,0 +1,31 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_JSON_UTIL_H_
+#define UVKC_BENCHMARK_JSON_UTIL_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Returns |text| quoted as a JSON string.
+std::string JsonString(absl::string_view text);
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_JSON_UTIL_H_
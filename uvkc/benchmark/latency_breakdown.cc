@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/latency_breakdown.h"
+
+#include <chrono>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "uvkc/base/status.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// static
+absl::StatusOr<std::unique_ptr<LatencyBreakdown>> LatencyBreakdown::Create(
+    vulkan::Device *device) {
+  if (!device->optional_features().calibrated_timestamps) {
+    return absl::UnimplementedError(
+        "calibrated timestamps are not supported by the device");
+  }
+  UVKC_ASSIGN_OR_RETURN(auto query_pool, device->CreateTimestampQueryPool(2));
+  return absl::WrapUnique(new LatencyBreakdown(device, std::move(query_pool)));
+}
+
+// static
+int64_t LatencyBreakdown::HostNanoseconds() {
+  // Vulkan's CLOCK_MONOTONIC time domain is what steady_clock uses on the
+  // platforms where calibrated timestamps are enabled.
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void LatencyBreakdown::RecordStart(vulkan::CommandBuffer *cmdbuf) {
+  cmdbuf->ResetQueryPool(*query_pool_);
+  cmdbuf->WriteTimestamp(*query_pool_, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+}
+
+void LatencyBreakdown::RecordEnd(vulkan::CommandBuffer *cmdbuf) {
+  cmdbuf->WriteTimestamp(*query_pool_, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+}
+
+absl::Status LatencyBreakdown::AddIteration(int64_t record_start_ns,
+                                            int64_t submit_ns,
+                                            int64_t wakeup_ns) {
+  // Sample after the wait so both GPU timestamps precede the calibration.
+  UVKC_ASSIGN_OR_RETURN(vulkan::CalibratedTimestamps calibration,
+                        device_->SampleCalibratedTimestamps());
+  UVKC_ASSIGN_OR_RETURN(
+      int64_t gpu_start_ns,
+      query_pool_->ConvertToHostNanoseconds(0, calibration));
+  UVKC_ASSIGN_OR_RETURN(
+      int64_t gpu_end_ns,
+      query_pool_->ConvertToHostNanoseconds(1, calibration));
+
+  total_nanoseconds_[0] += submit_ns - record_start_ns;
+  total_nanoseconds_[1] += gpu_start_ns - submit_ns;
+  total_nanoseconds_[2] += gpu_end_ns - gpu_start_ns;
+  total_nanoseconds_[3] += wakeup_ns - gpu_end_ns;
+  last_gpu_execution_seconds_ = (gpu_end_ns - gpu_start_ns) * 1e-9;
+  ++num_iterations_;
+  return absl::OkStatus();
+}
+
+LatencyBreakdown::Phases LatencyBreakdown::Average() const {
+  Phases phases = {};
+  if (num_iterations_ == 0) return phases;
+
+  const double scale = 1e-9 / num_iterations_;
+  phases.record_seconds = total_nanoseconds_[0] * scale;
+  phases.submit_to_gpu_start_seconds = total_nanoseconds_[1] * scale;
+  phases.gpu_execution_seconds = total_nanoseconds_[2] * scale;
+  phases.gpu_end_to_wakeup_seconds = total_nanoseconds_[3] * scale;
+  return phases;
+}
+
+LatencyBreakdown::LatencyBreakdown(
+    vulkan::Device *device,
+    std::unique_ptr<vulkan::TimestampQueryPool> query_pool)
+    : device_(device),
+      query_pool_(std::move(query_pool)),
+      num_iterations_(0),
+      total_nanoseconds_{0, 0, 0, 0},
+      last_gpu_execution_seconds_(0) {}
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,104 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_LATENCY_BREAKDOWN_H_
+#define UVKC_BENCHMARK_LATENCY_BREAKDOWN_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/device.h"
+#include "uvkc/vulkan/timestamp_query_pool.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Breaks the latency of recording, submitting, and waiting for a command
+// buffer down into host and GPU phases, by mapping GPU timestamps into the
+// host clock domain with calibrated timestamps.
+//
+// Each iteration is expected to go like:
+//
+//   int64_t record_start = LatencyBreakdown::HostNanoseconds();
+//   cmdbuf->Begin();
+//   breakdown->RecordStart(cmdbuf);
+//   ... record work ...
+//   breakdown->RecordEnd(cmdbuf);
+//   cmdbuf->End();
+//   int64_t submit = LatencyBreakdown::HostNanoseconds();
+//   device->QueueSubmitAndWait(*cmdbuf);
+//   int64_t wakeup = LatencyBreakdown::HostNanoseconds();
+//   breakdown->AddIteration(record_start, submit, wakeup);
+class LatencyBreakdown {
+ public:
+  // Average seconds spent in each phase of an iteration.
+  struct Phases {
+    // Recording the command buffer on the host.
+    double record_seconds;
+    // From calling queue submit on the host to the GPU starting the work.
+    double submit_to_gpu_start_seconds;
+    // Executing the work on the GPU.
+    double gpu_execution_seconds;
+    // From the GPU finishing the work to the host waking up from the wait.
+    double gpu_end_to_wakeup_seconds;
+  };
+
+  // Creates a latency breakdown for |device|. Returns an unimplemented error
+  // if the device does not support calibrated timestamps.
+  static absl::StatusOr<std::unique_ptr<LatencyBreakdown>> Create(
+      vulkan::Device *device);
+
+  // Returns the current host time in nanoseconds, in the same clock domain as
+  // calibrated timestamps.
+  static int64_t HostNanoseconds();
+
+  // Records commands into |cmdbuf| to mark the start of the GPU work.
+  void RecordStart(vulkan::CommandBuffer *cmdbuf);
+
+  // Records commands into |cmdbuf| to mark the end of the GPU work.
+  void RecordEnd(vulkan::CommandBuffer *cmdbuf);
+
+  // Adds one iteration given the host times when recording started, when the
+  // command buffer was submitted, and when the wait for it returned.
+  absl::Status AddIteration(int64_t record_start_ns, int64_t submit_ns,
+                            int64_t wakeup_ns);
+
+  // Returns the GPU execution time of the most recently added iteration.
+  double last_gpu_execution_seconds() const {
+    return last_gpu_execution_seconds_;
+  }
+
+  // Returns the average phases over all iterations added so far.
+  Phases Average() const;
+
+ private:
+  LatencyBreakdown(vulkan::Device *device,
+                   std::unique_ptr<vulkan::TimestampQueryPool> query_pool);
+
+  vulkan::Device *device_;
+  std::unique_ptr<vulkan::TimestampQueryPool> query_pool_;
+
+  int64_t num_iterations_;
+  // Total nanoseconds of each phase, in the order of Phases.
+  int64_t total_nanoseconds_[4];
+  double last_gpu_execution_seconds_;
+};
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_LATENCY_BREAKDOWN_H_
@@ -0,0 +1,79 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/latency_samples.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "uvkc/benchmark/sustained_load.h"
+
+namespace uvkc {
+namespace benchmark {
+
+LatencySamples::LatencySamples(const ::benchmark::State &state) {
+  samples_.reserve(state.max_iterations);
+}
+
+void LatencySamples::SetIterationTime(::benchmark::State &state,
+                                      double seconds) {
+  state.SetIterationTime(seconds);
+  samples_.push_back(seconds);
+  if (auto *monitor = SustainedLoadMonitor::GetGlobal()) {
+    monitor->AddIteration(seconds);
+  }
+}
+
+LatencySamples::Summary LatencySamples::Summarize() const {
+  Summary summary = {};
+  if (samples_.empty()) return summary;
+
+  std::vector<double> sorted = samples_;
+  std::sort(sorted.begin(), sorted.end());
+  auto percentile = [&sorted](double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[std::max<size_t>(rank, 1) - 1];
+  };
+
+  double sum = 0;
+  for (double sample : sorted) sum += sample;
+  double mean = sum / sorted.size();
+  double squared_error = 0;
+  for (double sample : sorted) {
+    squared_error += (sample - mean) * (sample - mean);
+  }
+  double stddev = std::sqrt(squared_error / sorted.size());
+
+  summary.min_seconds = sorted.front();
+  summary.p50_seconds = percentile(0.5);
+  summary.p90_seconds = percentile(0.9);
+  summary.p99_seconds = percentile(0.99);
+  summary.max_seconds = sorted.back();
+  summary.mean_seconds = mean;
+  summary.coefficient_of_variation = mean != 0 ? stddev / mean : 0;
+  return summary;
+}
+
+void LatencySamples::ReportCounters(::benchmark::State &state) const {
+  Summary summary = Summarize();
+  state.counters["Min(us)"] = summary.min_seconds * 1e6;
+  state.counters["P50(us)"] = summary.p50_seconds * 1e6;
+  state.counters["P90(us)"] = summary.p90_seconds * 1e6;
+  state.counters["P99(us)"] = summary.p99_seconds * 1e6;
+  state.counters["Max(us)"] = summary.max_seconds * 1e6;
+  state.counters["CV"] = summary.coefficient_of_variation;
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
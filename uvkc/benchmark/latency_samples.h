@@ -0,0 +1,66 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_LATENCY_SAMPLES_H_
+#define UVKC_BENCHMARK_LATENCY_SAMPLES_H_
+
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Records the latency of every iteration of a benchmark run and reports their
+// distribution as counters, since averages hide tail latency and hiccups.
+//
+// Storage for all iterations is allocated up front so that recording does not
+// allocate inside the benchmarking loop.
+class LatencySamples {
+ public:
+  // Distribution of the recorded latencies.
+  struct Summary {
+    double min_seconds;
+    double p50_seconds;
+    double p90_seconds;
+    double p99_seconds;
+    double max_seconds;
+    double mean_seconds;
+    // Standard deviation divided by mean.
+    double coefficient_of_variation;
+  };
+
+  // Creates an object with space for all iterations of the run of |state|.
+  explicit LatencySamples(const ::benchmark::State &state);
+
+  // Sets the latency of the current iteration of |state| to |seconds| and
+  // records it, also feeding it to the global SustainedLoadMonitor if any.
+  void SetIterationTime(::benchmark::State &state, double seconds);
+
+  // Returns the distribution of latencies recorded so far. Percentiles use the
+  // nearest-rank method.
+  Summary Summarize() const;
+
+  // Reports the distribution as counters of |state|: Min, P50, P90, P99, and
+  // Max in microseconds, and the coefficient of variation CV.
+  void ReportCounters(::benchmark::State &state) const;
+
+ private:
+  std::vector<double> samples_;
+};
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_LATENCY_SAMPLES_H_
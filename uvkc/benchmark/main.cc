@@ -13,17 +13,36 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#include "uvkc/benchmark/main.h"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "absl/flags/flag.h"
 #include "absl/flags/internal/parse.h"
 #include "absl/flags/parse.h"
 #include "absl/flags/usage.h"
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "benchmark/benchmark.h"
 #include "renderdoc/renderdoc_app.h"
+#include "uvkc/base/file.h"
+#include "uvkc/base/status.h"
+#include "uvkc/benchmark/autotuner.h"
+#include "uvkc/benchmark/concurrent_devices.h"
 #include "uvkc/benchmark/dispatch_void_shader.h"
+#include "uvkc/benchmark/perf_counters.h"
+#include "uvkc/benchmark/roofline.h"
+#include "uvkc/benchmark/shapes.h"
 #include "uvkc/benchmark/status_util.h"
+#include "uvkc/benchmark/suite.h"
+#include "uvkc/benchmark/sustained_load.h"
+#include "uvkc/benchmark/trace.h"
+#include "uvkc/benchmark/verification.h"
 #include "uvkc/benchmark/vulkan_context.h"
 
 // Platform-specific includes for RenderDoc.
@@ -67,15 +86,207 @@ std::string AbslUnparseFlag(LatencyMeasureMode mode) {
   }
 }
 
+bool AbslParseFlag(absl::string_view text, VerifyMode *mode,
+                   std::string *error) {
+  if (text == "full") {
+    *mode = VerifyMode::kFull;
+    return true;
+  }
+  if (text == "sampled") {
+    *mode = VerifyMode::kSampled;
+    return true;
+  }
+  if (text == "checksum") {
+    *mode = VerifyMode::kChecksum;
+    return true;
+  }
+  if (text == "none") {
+    *mode = VerifyMode::kNone;
+    return true;
+  }
+
+  *error =
+      "unknown value for verify mode; supported choices are 'full', "
+      "'sampled', 'checksum', 'none'";
+  return false;
+}
+
+std::string AbslUnparseFlag(VerifyMode mode) {
+  switch (mode) {
+    case VerifyMode::kFull:
+      return "full";
+    case VerifyMode::kSampled:
+      return "sampled";
+    case VerifyMode::kChecksum:
+      return "checksum";
+    case VerifyMode::kNone:
+      return "none";
+  }
+}
+
 }  // namespace benchmark
 }  // namespace uvkc
 
 ABSL_FLAG(bool, enable_renderdoc, false, "Enable RenderDoc");
 
+ABSL_FLAG(std::string, device, "",
+          "Device to benchmark: an index, a UUID, or a regex matching device "
+          "names; all devices by default");
+
+ABSL_FLAG(bool, concurrent_devices, false,
+          "After running the benchmarks of each device alone, run those of "
+          "all devices at the same time and report their slowdown");
+
 ABSL_FLAG(uvkc::benchmark::LatencyMeasureMode, latency_measure_mode,
           uvkc::benchmark::LatencyMeasureMode::kSystemSubmit,
           "Latency measure modes");
 
+ABSL_FLAG(bool, latency_breakdown, false,
+          "Break the latency of each iteration down into host and GPU phases "
+          "on devices supporting calibrated timestamps");
+
+ABSL_FLAG(uvkc::benchmark::VerifyMode, verify,
+          uvkc::benchmark::VerifyMode::kFull,
+          "How to verify kernel results: 'full', 'sampled', 'checksum', or "
+          "'none'");
+
+ABSL_FLAG(std::string, trace_out, "",
+          "Path to write a Chrome trace event JSON file of benchmark "
+          "execution");
+
+ABSL_FLAG(std::string, perf_counters, "",
+          "Comma-separated hardware performance counters to collect for each "
+          "benchmark, or 'list' to print the available ones");
+
+ABSL_FLAG(bool, roofline, false,
+          "Measure peak ALU throughput and memory bandwidth of each device and "
+          "report kernels against the roofline");
+
+ABSL_FLAG(double, sustained_seconds, 0,
+          "Run each benchmark under sustained load for at least this many "
+          "seconds and report its throughput over time; 0 disables it");
+
+ABSL_FLAG(double, throttle_threshold, 0.1,
+          "Fraction of the burst throughput that throughput under sustained "
+          "load must fall by to count as throttled");
+
+ABSL_FLAG(double, cooldown_seconds, 0,
+          "Seconds to idle between benchmarks to let the device cool down");
+
+ABSL_FLAG(std::string, autotune, "",
+          "Search the shader variants of each problem for the fastest one: "
+          "'exhaustive' or 'early_stopping'");
+
+ABSL_FLAG(double, autotune_margin, 0.2,
+          "Fraction of the best latency that a candidate must be slower by to "
+          "be pruned when autotuning with early stopping");
+
+ABSL_FLAG(std::string, tuning_db_out, "",
+          "Path to write the JSON tuning database found by --autotune");
+
+ABSL_FLAG(std::string, shapes, "",
+          "Comma-separated problem shapes to benchmark instead of the "
+          "defaults, e.g., 512x512x256");
+
+ABSL_FLAG(std::string, shapes_file, "",
+          "Path to a file listing problem shapes to benchmark, one per line");
+
+// Caps the memory used by tracing long runs.
+static constexpr size_t kMaxTraceSpans = 1 << 22;
+
+// A console reporter that attributes trace spans to the benchmark that just
+// finished running, attaches the hardware performance counters collected and
+// the throughput under sustained load observed while it ran, and idles for a
+// cool-down period before the next benchmark.
+class AnnotatingReporter : public ::benchmark::ConsoleReporter {
+ public:
+  // |perf_recorders| grows as devices are created, when their first
+  // benchmarks run.
+  AnnotatingReporter(
+      uvkc::benchmark::TraceWriter *trace_writer,
+      const std::vector<std::unique_ptr<uvkc::benchmark::PerfCounterRecorder>>
+          *perf_recorders,
+      uvkc::benchmark::SustainedLoadMonitor *sustained_monitor,
+      double cooldown_seconds)
+      : trace_writer_(trace_writer),
+        perf_recorders_(perf_recorders),
+        sustained_monitor_(sustained_monitor),
+        cooldown_seconds_(cooldown_seconds) {}
+
+  void ReportRuns(const std::vector<Run> &reports) override {
+    if (trace_writer_ && !reports.empty()) {
+      trace_writer_->SetBenchmarkForPendingSpans(
+          reports.front().benchmark_name());
+    }
+
+    // Only the device that ran the benchmark has anything to report.
+    std::vector<Run> annotated_reports = reports;
+    for (const auto &recorder : *perf_recorders_) {
+      for (const auto &counter : recorder->TakeAverages()) {
+        for (Run &run : annotated_reports) {
+          run.counters[counter.first] = counter.second;
+        }
+      }
+    }
+
+    uvkc::benchmark::SustainedLoadMonitor::Summary sustained = {};
+    if (sustained_monitor_) {
+      sustained = sustained_monitor_->TakeSummary();
+      double degradation =
+          sustained.burst_throughput > 0
+              ? 1 - sustained.sustained_throughput / sustained.burst_throughput
+              : 0;
+      for (Run &run : annotated_reports) {
+        run.counters["Burst(/s)"] = sustained.burst_throughput;
+        run.counters["Sustained(/s)"] = sustained.sustained_throughput;
+        run.counters["Degradation(%)"] = degradation * 100;
+        run.counters["RampUp(s)"] = sustained.ramp_up_seconds;
+        run.counters["ThrottledAt(s)"] = sustained.throttled_at_seconds;
+      }
+    }
+
+    ::benchmark::ConsoleReporter::ReportRuns(annotated_reports);
+
+    if (sustained_monitor_) {
+      std::ostream &out = GetOutputStream();
+      out << "  throughput per second (/s):";
+      for (double throughput : sustained.throughputs) out << " " << throughput;
+      out << "\n";
+    }
+    if (cooldown_seconds_ > 0) {
+      std::this_thread::sleep_for(
+          std::chrono::duration<double>(cooldown_seconds_));
+    }
+  }
+
+ private:
+  uvkc::benchmark::TraceWriter *trace_writer_;
+  const std::vector<std::unique_ptr<uvkc::benchmark::PerfCounterRecorder>>
+      *perf_recorders_;
+  uvkc::benchmark::SustainedLoadMonitor *sustained_monitor_;
+  double cooldown_seconds_;
+};
+
+// Prints the hardware performance counters available on each device.
+static void PrintPerfCounters(uvkc::benchmark::VulkanContext *context) {
+  for (int i = 0; i < context->physical_devices.size(); ++i) {
+    std::cout << context->physical_devices[i].v10_properties.deviceName
+              << ":\n";
+    BM_CHECK_OK_AND_ASSIGN(auto *device, context->GetDevice(i));
+    auto counters = device->EnumeratePerformanceCounters();
+    if (!counters.ok()) {
+      std::cout << "  " << counters.status().message() << "\n";
+      continue;
+    }
+    for (const auto &counter : *counters) {
+      std::cout << "  " << counter.name << " ["
+                << uvkc::benchmark::GetPerformanceCounterUnitName(counter.unit)
+                << "] (" << counter.category << "): " << counter.description
+                << "\n";
+    }
+  }
+}
+
 /// Returns the RenderDoc API handle on success, or `nullptr` on failure.
 static RENDERDOC_API_1_6_0 *GetRdocApi() {
   static bool initialized = false;
@@ -134,10 +345,66 @@ extern "C" int main(int argc, char **argv) {
   absl::SetProgramUsageMessage(R"(Run Vulkan compute benchmarks
     --enable_renderdoc=[false|true]
       * true: starts a renderdoc capture
+    --device=<index|uuid|regex>
+      * benchmarks only the device at the given index, with the given UUID,
+        or with names matching the regex; devices are created when their
+        first benchmark runs
+    --concurrent_devices=[false|true]
+      * true: after running the benchmarks of each device alone, runs those of
+        all devices at the same time, each device on its own thread, and
+        reports how much each benchmark and device slows down
     --latency_measure_mode=[system_submit|system_dispatch|gpu_timestamp]
       * system_submit: time spent from queue submit to returning from queue wait
       * system_dispatch: system_submit subtracted by time for void dispatch
       * gpu_timestamp: timestamp difference measured on GPU
+    --latency_breakdown=[false|true]
+      * true: breaks the latency of each iteration down into host recording,
+        submit to GPU start, GPU execution, and GPU end to host wakeup, on
+        devices supporting calibrated timestamps; this writes timestamps
+        around the dispatches in all latency measure modes
+    --verify=[full|sampled|checksum|none]
+      * full: checks every output element against a CPU reference
+      * sampled: checks a few tiles of the output
+      * checksum: compares a checksum of the output reduced on the GPU with
+        one computed on the host, without reading back the output
+      * none: skips verification
+      * matmul, mmt, and vmt support all modes; other benchmarks verify in full
+        unless none, which conv2d and depthwise_conv2d also honor
+    --trace_out=<filename>
+      * writes host and per-dispatch GPU spans as Chrome trace event JSON,
+        which can be loaded into Perfetto; results are printed to the console
+    --perf_counters=<name>[,<name>...]|list
+      * collects the named hardware performance counters for each benchmark
+        via VK_KHR_performance_query and reports their average per timed
+        command buffer as counters; results are printed to the console
+      * list: prints the counters available on each device and exits
+    --roofline=[false|true]
+      * true: measures the peak ALU throughput and memory bandwidth of each
+        device first, and reports kernels' arithmetic intensity and percentage
+        of the roofline bound as counters
+    --sustained_seconds=<seconds>
+      * runs each benchmark for at least the given measured time and reports
+        its burst and sustained throughput, when clocks ramped up and when
+        throttling started, and the throughput in each second
+    --throttle_threshold=<fraction>
+      * how far below the burst throughput counts as throttled; 0.1 by default
+    --cooldown_seconds=<seconds>
+      * idles for the given time after each benchmark
+    --autotune=[exhaustive|early_stopping]
+      * searches the shader variants of each problem for the fastest one on
+        each device and writes them to --tuning_db_out
+      * exhaustive: measures every variant in full
+      * early_stopping: stops measuring a variant once it is slower than the
+        best one so far by more than --autotune_margin (0.2 by default)
+    --tuning_db_out=<filename>
+      * where to write the JSON tuning database found by --autotune
+    --shapes=<shape>[,<shape>...]
+      * benchmarks the given problem shapes instead of the defaults; a shape
+        lists sizes separated by 'x' in the order each benchmark documents,
+        e.g., MxNxK for matmul; benchmarks skip shapes of other ranks
+    --shapes_file=<filename>
+      * reads additional shapes from the file, one or more per line; '#'
+        starts a comment
 
   Optional flags from the Google Benchmark library:
     [--benchmark_list_tests={true|false}]
@@ -157,35 +424,149 @@ extern "C" int main(int argc, char **argv) {
       argc, argv, absl::flags_internal::ArgvListAction::kRemoveParsedArgs,
       absl::flags_internal::UsageFlagsAction::kHandleUsage,
       absl::flags_internal::OnUndefinedFlag::kIgnoreUndefined);
+
+  // Sustained load is implemented with Google Benchmark's minimal time, which
+  // goes before the command-line arguments so an explicit one still wins.
+  const double sustained_seconds = absl::GetFlag(FLAGS_sustained_seconds);
+  std::string min_time_arg;
+  std::vector<char *> args(argv, argv + argc);
+  if (sustained_seconds > 0) {
+    min_time_arg = absl::StrCat("--benchmark_min_time=", sustained_seconds);
+    args.insert(args.begin() + 1, min_time_arg.data());
+  }
+  argc = args.size();
+  args.push_back(nullptr);
+  argv = args.data();
+
   ::benchmark::Initialize(&argc, argv);
   auto positional_args = absl::ParseCommandLine(argc, argv);
   BM_CHECK_EQ(positional_args.size(), 1)  // argv[0]
       << "cannot accept positional arguments";
 
-  BM_CHECK_OK_AND_ASSIGN(auto context, uvkc::benchmark::CreateVulkanContext());
+  // Benchmarks query the verify mode when run.
+  uvkc::benchmark::SetVerifyMode(absl::GetFlag(FLAGS_verify));
+
+  // Benchmarks query the requested shapes when registered.
+  std::string shape_list = absl::GetFlag(FLAGS_shapes);
+  const std::string shapes_path = absl::GetFlag(FLAGS_shapes_file);
+  if (!shapes_path.empty()) {
+    BM_CHECK_OK_AND_ASSIGN(std::string shape_file, uvkc::ReadFile(shapes_path));
+    absl::StrAppend(&shape_list, "\n", shape_file);
+  }
+  BM_CHECK_OK_AND_ASSIGN(auto shapes,
+                         uvkc::benchmark::ParseShapeList(shape_list));
+  uvkc::benchmark::SetRequestedShapes(std::move(shapes));
+
+  // The Vulkan context is shared among all suites linked into this binary.
+  const std::vector<uvkc::benchmark::BenchmarkSuite> &suites =
+      uvkc::benchmark::GetBenchmarkSuites();
+  BM_CHECK(!suites.empty()) << "no benchmark suites linked into this binary";
+  BM_CHECK_OK_AND_ASSIGN(auto context,
+                         uvkc::benchmark::CreateDefaultVulkanContext(
+                             suites.size() == 1 ? suites.front().name
+                                                : "uvkc_bench_all",
+                             absl::GetFlag(FLAGS_device)));
+  // Benchmarks of the same problem share input buffers through the context.
+  uvkc::benchmark::InputBufferCache::SetGlobal(context->input_buffers.get());
   auto mode = absl::GetFlag(FLAGS_latency_measure_mode);
-  context->latency_measure.mode = mode;
+  const bool latency_breakdown = absl::GetFlag(FLAGS_latency_breakdown);
+  for (auto &latency_measure : context->latency_measures) {
+    latency_measure.mode = mode;
+    latency_measure.breakdown = latency_breakdown;
+  }
+
+  const std::string perf_counters = absl::GetFlag(FLAGS_perf_counters);
+  if (perf_counters == "list") {
+    PrintPerfCounters(context.get());
+    return 0;
+  }
+
+  // If requested, trace all command buffers allocated from each device. The
+  // recorders are destroyed before the devices they trace.
+  const std::string trace_path = absl::GetFlag(FLAGS_trace_out);
+  BM_CHECK(trace_path.empty() || perf_counters.empty())
+      << "--trace_out and --perf_counters cannot be used together";
+  std::unique_ptr<uvkc::benchmark::TraceWriter> trace_writer;
+  std::vector<std::unique_ptr<uvkc::benchmark::TraceRecorder>> trace_recorders;
+  if (!trace_path.empty()) {
+    trace_writer =
+        std::make_unique<uvkc::benchmark::TraceWriter>(kMaxTraceSpans);
+  }
+
+  // If requested, sample hardware performance counters over all command
+  // buffers allocated from each device that supports them.
+  std::vector<std::string> counter_names =
+      absl::StrSplit(perf_counters, ',', absl::SkipEmpty());
+  std::vector<std::unique_ptr<uvkc::benchmark::PerfCounterRecorder>>
+      perf_recorders;
+
+  bool any_performance_query = false;
+  for (const auto &features : context->optional_features) {
+    any_performance_query |= features.performance_query;
+  }
+  BM_CHECK(counter_names.empty() || any_performance_query)
+      << "no device supports performance counters";
 
-  for (int i = 0; i < context->devices.size(); ++i) {
+  // Logical devices are created when their first benchmarks run, so that
+  // devices whose benchmarks are all filtered out are never created. Attach
+  // the recorders to each device as it is created.
+  context->on_device_created =
+      [&](int index, uvkc::vulkan::Device *device) -> absl::Status {
+    if (trace_writer) {
+      int pid = trace_writer->AddProcess(
+          context->physical_devices[index].v10_properties.deviceName);
+      trace_recorders.push_back(
+          std::make_unique<uvkc::benchmark::TraceRecorder>(
+              device, trace_writer.get(), pid));
+      device->set_tracer(trace_recorders.back().get());
+    }
+    if (!counter_names.empty() &&
+        device->optional_features().performance_query) {
+      UVKC_ASSIGN_OR_RETURN(auto recorder,
+                            uvkc::benchmark::PerfCounterRecorder::Create(
+                                device, counter_names));
+      device->set_tracer(recorder.get());
+      perf_recorders.push_back(std::move(recorder));
+    }
+    return absl::OkStatus();
+  };
+
+  for (int i = 0; i < context->physical_devices.size(); ++i) {
     const auto &physical_device = context->physical_devices[i];
-    auto *device = context->devices[i].get();
-    if (mode == uvkc::benchmark::LatencyMeasureMode::kSystemDispatch) {
-      // Register the overhead benchmark first to update the overhead latency,
-      // which will be used by following benchmarks. Note that we are only
-      // **registering** the benchmark here. So relies on the implicit ordering
-      // in benchmark execution to make sure the overhead is there when we run
-      // following benchmarks. This is true if Google Benchmark, which runs
-      // benchmarks at registration order.
-      if (!uvkc::benchmark::RegisterVulkanOverheadBenchmark(
-              physical_device, device,
-              &context->latency_measure.overhead_seconds)) {
-        uvkc::benchmark::RegisterDispatchVoidShaderBenchmark(
+    auto *latency_measure = &context->latency_measures[i];
+    // Suites register benchmarks with the lazy device, querying its features
+    // to decide what to register without creating it.
+    auto *device = &context->lazy_devices[i];
+
+    for (const auto &suite : suites) {
+      uvkc::benchmark::SetRegisteringBenchmarkSuite(&suite);
+      if (mode == uvkc::benchmark::LatencyMeasureMode::kSystemDispatch) {
+        // Register the overhead benchmark first to update the overhead
+        // latency, which will be used by following benchmarks. Note that we
+        // are only **registering** the benchmark here. So relies on the
+        // implicit ordering in benchmark execution to make sure the overhead
+        // is there when we run following benchmarks. This is true if Google
+        // Benchmark, which runs benchmarks at registration order. Each suite
+        // gets its own, as suites may measure the overhead differently.
+        if (!suite.register_overhead_benchmark(
+                physical_device, device,
+                &latency_measure->overhead_seconds)) {
+          uvkc::benchmark::RegisterDispatchVoidShaderBenchmark(
+              uvkc::benchmark::GetBenchmarkNamePrefix(physical_device).c_str(),
+              device, latency_measure->breakdown,
+              &latency_measure->overhead_seconds);
+        }
+      }
+      if (absl::GetFlag(FLAGS_roofline) && &suite == &suites.front()) {
+        // Like the overhead benchmark, this relies on benchmarks running in
+        // registration order so peaks are measured before the kernels run.
+        uvkc::benchmark::RegisterRooflinePeakBenchmarks(
             physical_device.v10_properties.deviceName, device,
-            &context->latency_measure.overhead_seconds);
+            latency_measure);
       }
+      suite.register_benchmarks(physical_device, device, latency_measure);
     }
-    uvkc::benchmark::RegisterVulkanBenchmarks(physical_device, device,
-                                              &context->latency_measure);
+    uvkc::benchmark::SetRegisteringBenchmarkSuite(nullptr);
   }
 
   // If requested, tell the running RenderDoc instance when the capture begin
@@ -197,7 +578,80 @@ extern "C" int main(int argc, char **argv) {
   const bool useRenderDoc = absl::GetFlag(FLAGS_enable_renderdoc);
   if (useRenderDoc) StartRenderDocCapture(instance);
 
-  ::benchmark::RunSpecifiedBenchmarks();
+  // If requested, track the throughput of each benchmark over time.
+  std::unique_ptr<uvkc::benchmark::SustainedLoadMonitor> sustained_monitor;
+  if (sustained_seconds > 0) {
+    const double threshold = absl::GetFlag(FLAGS_throttle_threshold);
+    BM_CHECK(threshold > 0 && threshold < 1)
+        << "--throttle_threshold must be between 0 and 1";
+    sustained_monitor =
+        std::make_unique<uvkc::benchmark::SustainedLoadMonitor>(threshold);
+    uvkc::benchmark::SustainedLoadMonitor::SetGlobal(sustained_monitor.get());
+  }
+  const double cooldown_seconds = absl::GetFlag(FLAGS_cooldown_seconds);
+
+  // If requested, search for the fastest shader variant of each problem.
+  const std::string autotune = absl::GetFlag(FLAGS_autotune);
+  const std::string tuning_db_path = absl::GetFlag(FLAGS_tuning_db_out);
+  std::unique_ptr<uvkc::benchmark::Autotuner> autotuner;
+  if (!autotune.empty()) {
+    using Search = uvkc::benchmark::Autotuner::Search;
+    BM_CHECK(autotune == "exhaustive" || autotune == "early_stopping")
+        << "--autotune must be 'exhaustive' or 'early_stopping'";
+    BM_CHECK(!tuning_db_path.empty()) << "--autotune requires --tuning_db_out";
+    BM_CHECK(absl::GetFlag(FLAGS_verify) != uvkc::benchmark::VerifyMode::kNone)
+        << "--autotune verifies every variant and cannot be used with "
+           "--verify=none";
+    autotuner = std::make_unique<uvkc::benchmark::Autotuner>(
+        autotune == "exhaustive" ? Search::kExhaustive
+                                 : Search::kEarlyStopping,
+        absl::GetFlag(FLAGS_autotune_margin));
+    uvkc::benchmark::Autotuner::SetGlobal(autotuner.get());
+  }
+
+  if (absl::GetFlag(FLAGS_concurrent_devices)) {
+    BM_CHECK(context->physical_devices.size() > 1)
+        << "--concurrent_devices requires more than one device";
+    BM_CHECK(!trace_writer && counter_names.empty() && !sustained_monitor &&
+             cooldown_seconds == 0 && !autotuner)
+        << "--concurrent_devices cannot be used with --trace_out, "
+           "--perf_counters, --sustained_seconds, --cooldown_seconds, or "
+           "--autotune";
+    // Run each device alone first, to compare with.
+    uvkc::benchmark::SoloLatencyReporter solo_reporter;
+    ::benchmark::RunSpecifiedBenchmarks(&solo_reporter);
+    std::vector<uvkc::benchmark::LazyDevice *> devices;
+    std::vector<std::string> device_names;
+    for (int i = 0; i < context->physical_devices.size(); ++i) {
+      devices.push_back(&context->lazy_devices[i]);
+      device_names.push_back(
+          context->physical_devices[i].v10_properties.deviceName);
+    }
+    uvkc::benchmark::RunBenchmarksConcurrently(devices, device_names,
+                                               solo_reporter.GetLatencies());
+  } else if (trace_writer || !counter_names.empty() || sustained_monitor ||
+             cooldown_seconds > 0) {
+    AnnotatingReporter reporter(trace_writer.get(), &perf_recorders,
+                                sustained_monitor.get(), cooldown_seconds);
+    ::benchmark::RunSpecifiedBenchmarks(&reporter);
+  } else {
+    ::benchmark::RunSpecifiedBenchmarks();
+  }
 
   if (useRenderDoc) EndRenderDocCapture(instance);
+
+  if (sustained_monitor) {
+    uvkc::benchmark::SustainedLoadMonitor::SetGlobal(nullptr);
+  }
+  if (autotuner) {
+    uvkc::benchmark::Autotuner::SetGlobal(nullptr);
+    BM_CHECK_OK(autotuner->WriteJson(tuning_db_path));
+  }
+
+  if (trace_writer || !counter_names.empty()) {
+    for (auto *device : context->GetCreatedDevices()) {
+      device->set_tracer(nullptr);
+    }
+  }
+  if (trace_writer) BM_CHECK_OK(trace_writer->WriteJson(trace_path));
 }
@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#version 450
+
+// Reduces an MxN row-major matrix into one partial checksum per workgroup:
+// the sum of its elements, each multiplied by the pseudo-random signs of its
+// row and column. Integers sum modulo 2^32 and floating point numbers in
+// fp32. Keep the signs in sync with GetChecksumRowSign() and
+// GetChecksumColumnSign() in verification.cc.
+
+layout (local_size_x = 256, local_size_y = 1, local_size_z = 1) in;
+
+layout(constant_id = 0) const int kElementType = 0;   // See GetShaderElementType()
+layout(constant_id = 1) const uint kRows = 1;
+layout(constant_id = 2) const uint kColumns = 1;
+
+const int ELEMENT_FP32 = 0;
+const int ELEMENT_I32 = 1;
+const int ELEMENT_FP16 = 2;
+
+layout(set = 0, binding = 0) buffer InputBuffer {
+    uint input_words[];
+};
+
+// The integer or fp32 bits of the partial sum of each workgroup.
+layout(set = 0, binding = 1) buffer OutputBuffer {
+    uint partial_sums[];
+};
+
+shared uint shared_ints[256];
+shared float shared_floats[256];
+
+// PCG-based integer hash; see "Hash Functions for GPU Rendering" (Jarzynski &
+// Olano, 2020).
+uint PcgHash(uint v) {
+    uint state = v * 747796405u + 2891336453u;
+    uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+bool IsNegative(uint element) {
+    const uint row = element / kColumns;
+    const uint column = element % kColumns;
+    return ((PcgHash(2u * row) ^ PcgHash(2u * column + 1u)) & 1u) != 0u;
+}
+
+void main() {
+    const uint num_elements = kRows * kColumns;
+    const uint num_invocations = gl_NumWorkGroups.x * gl_WorkGroupSize.x;
+    const uint lane = gl_LocalInvocationID.x;
+
+    uint int_sum = 0u;
+    float float_sum = 0.0;
+    for (uint element = gl_GlobalInvocationID.x; element < num_elements;
+         element += num_invocations) {
+        const bool negative = IsNegative(element);
+        if (kElementType == ELEMENT_I32) {
+            const uint value = input_words[element];
+            int_sum += negative ? 0u - value : value;
+        } else {
+            float value;
+            if (kElementType == ELEMENT_FP32) {
+                value = uintBitsToFloat(input_words[element]);
+            } else {
+                const vec2 values = unpackHalf2x16(input_words[element / 2u]);
+                value = values[element % 2u];
+            }
+            float_sum += negative ? -value : value;
+        }
+    }
+    shared_ints[lane] = int_sum;
+    shared_floats[lane] = float_sum;
+
+    for (uint stride = gl_WorkGroupSize.x / 2u; stride > 0u; stride /= 2u) {
+        barrier();
+        if (lane < stride) {
+            shared_ints[lane] += shared_ints[lane + stride];
+            shared_floats[lane] += shared_floats[lane + stride];
+        }
+    }
+
+    if (lane == 0u) {
+        partial_sums[gl_WorkGroupID.x] = kElementType == ELEMENT_I32
+            ? shared_ints[0]
+            : floatBitsToUint(shared_floats[0]);
+    }
+}
@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/overhead_sampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "uvkc/base/status.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// static
+absl::StatusOr<std::unique_ptr<OverheadSampler>> OverheadSampler::Create(
+    vulkan::Device *device, const ::benchmark::State &state) {
+  UVKC_ASSIGN_OR_RETURN(auto cmdbuf, device->AllocateCommandBuffer());
+  return absl::WrapUnique(
+      new OverheadSampler(device, std::move(cmdbuf), state));
+}
+
+absl::StatusOr<double> OverheadSampler::Sample(
+    const vulkan::Pipeline &pipeline,
+    absl::Span<const vulkan::CommandBuffer::BoundDescriptorSet>
+        bound_descriptor_sets) {
+  UVKC_RETURN_IF_ERROR(cmdbuf_->Begin());
+  cmdbuf_->BindPipelineAndDescriptorSets(pipeline, bound_descriptor_sets);
+  // Dispatching no workgroups is valid and leaves only the overhead.
+  cmdbuf_->Dispatch(0, 0, 0);
+  UVKC_RETURN_IF_ERROR(cmdbuf_->End());
+
+  auto start_time = std::chrono::high_resolution_clock::now();
+  UVKC_RETURN_IF_ERROR(device_->QueueSubmitAndWait(*cmdbuf_));
+  auto end_time = std::chrono::high_resolution_clock::now();
+  UVKC_RETURN_IF_ERROR(cmdbuf_->Reset());
+  samples_.push_back(
+      std::chrono::duration<double>(end_time - start_time).count());
+
+  // The median keeps one preempted sample from skewing the estimate.
+  size_t window_size = std::min(samples_.size(), kWindowSize);
+  window_.assign(samples_.end() - window_size, samples_.end());
+  auto median = window_.begin() + window_size / 2;
+  std::nth_element(window_.begin(), median, window_.end());
+  return *median;
+}
+
+OverheadSampler::Summary OverheadSampler::Summarize() const {
+  Summary summary = {};
+  summary.num_samples = samples_.size();
+  if (samples_.empty()) return summary;
+
+  double sum = 0;
+  for (double sample : samples_) sum += sample;
+  double mean = sum / samples_.size();
+  summary.mean_seconds = mean;
+  if (samples_.size() < 2) return summary;
+
+  double squared_error = 0;
+  for (double sample : samples_) {
+    squared_error += (sample - mean) * (sample - mean);
+  }
+  double stddev = std::sqrt(squared_error / (samples_.size() - 1));
+  // Normal approximation, which holds for the number of iterations benchmarks
+  // usually run.
+  summary.ci95_seconds = 1.96 * stddev / std::sqrt(samples_.size());
+  return summary;
+}
+
+void OverheadSampler::ReportCounters(::benchmark::State &state) const {
+  if (samples_.empty()) return;
+  Summary summary = Summarize();
+  state.counters["Overhead(us)"] = summary.mean_seconds * 1e6;
+  state.counters["OverheadCI95(us)"] = summary.ci95_seconds * 1e6;
+}
+
+OverheadSampler::OverheadSampler(vulkan::Device *device,
+                                 std::unique_ptr<vulkan::CommandBuffer> cmdbuf,
+                                 const ::benchmark::State &state)
+    : device_(device), cmdbuf_(std::move(cmdbuf)) {
+  samples_.reserve(state.max_iterations);
+  window_.reserve(kWindowSize);
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
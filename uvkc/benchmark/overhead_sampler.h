@@ -0,0 +1,95 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_OVERHEAD_SAMPLER_H_
+#define UVKC_BENCHMARK_OVERHEAD_SAMPLER_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/device.h"
+#include "uvkc/vulkan/pipeline.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Samples the overhead of submitting a command buffer and waiting for it,
+// interleaved with the iterations of a benchmark, to subtract from latencies
+// measured with LatencyMeasureMode::kSystemDispatch.
+//
+// An overhead measured once before all benchmarks drifts with GPU clock
+// states and does not account for what the benchmark binds. Each sample
+// instead submits a command buffer binding the same pipeline and descriptor
+// sets as the benchmark but dispatching no workgroups, and iterations are
+// corrected with the median of the most recent samples.
+//
+// Each iteration is expected to go like:
+//
+//   ... submit and wait for the benchmark command buffer ...
+//   UVKC_ASSIGN_OR_RETURN(double overhead,
+//                         sampler->Sample(*pipeline, bound_descriptor_sets));
+//   latency_samples.SetIterationTime(state, elapsed_seconds - overhead);
+class OverheadSampler {
+ public:
+  // Statistics of all samples taken so far.
+  struct Summary {
+    int num_samples;
+    double mean_seconds;
+    // Half width of the 95% confidence interval of the mean.
+    double ci95_seconds;
+  };
+
+  // Creates a sampler for |device| with space for one sample per iteration
+  // of the run of |state|.
+  static absl::StatusOr<std::unique_ptr<OverheadSampler>> Create(
+      vulkan::Device *device, const ::benchmark::State &state);
+
+  // Takes one sample binding |pipeline| and |bound_descriptor_sets| and
+  // returns the current overhead estimate.
+  absl::StatusOr<double> Sample(
+      const vulkan::Pipeline &pipeline,
+      absl::Span<const vulkan::CommandBuffer::BoundDescriptorSet>
+          bound_descriptor_sets);
+
+  Summary Summarize() const;
+
+  // Reports the mean overhead and its 95% confidence interval as counters of
+  // |state| in microseconds: Overhead(us) and OverheadCI95(us). Does nothing
+  // if no samples were taken.
+  void ReportCounters(::benchmark::State &state) const;
+
+ private:
+  // The number of most recent samples the estimate is the median of.
+  static constexpr size_t kWindowSize = 16;
+
+  OverheadSampler(vulkan::Device *device,
+                  std::unique_ptr<vulkan::CommandBuffer> cmdbuf,
+                  const ::benchmark::State &state);
+
+  vulkan::Device *device_;
+  std::unique_ptr<vulkan::CommandBuffer> cmdbuf_;
+
+  std::vector<double> samples_;
+  // Scratch space for finding the median of the window.
+  std::vector<double> window_;
+};
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_OVERHEAD_SAMPLER_H_
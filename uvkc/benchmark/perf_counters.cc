@@ -0,0 +1,164 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/perf_counters.h"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "uvkc/base/status.h"
+
+namespace uvkc {
+namespace benchmark {
+
+const char *GetPerformanceCounterUnitName(VkPerformanceCounterUnitKHR unit) {
+  switch (unit) {
+    case VK_PERFORMANCE_COUNTER_UNIT_GENERIC_KHR:
+      return "generic";
+    case VK_PERFORMANCE_COUNTER_UNIT_PERCENTAGE_KHR:
+      return "%";
+    case VK_PERFORMANCE_COUNTER_UNIT_NANOSECONDS_KHR:
+      return "ns";
+    case VK_PERFORMANCE_COUNTER_UNIT_BYTES_KHR:
+      return "bytes";
+    case VK_PERFORMANCE_COUNTER_UNIT_BYTES_PER_SECOND_KHR:
+      return "bytes/s";
+    case VK_PERFORMANCE_COUNTER_UNIT_KELVIN_KHR:
+      return "K";
+    case VK_PERFORMANCE_COUNTER_UNIT_WATTS_KHR:
+      return "W";
+    case VK_PERFORMANCE_COUNTER_UNIT_VOLTS_KHR:
+      return "V";
+    case VK_PERFORMANCE_COUNTER_UNIT_AMPS_KHR:
+      return "A";
+    case VK_PERFORMANCE_COUNTER_UNIT_HERTZ_KHR:
+      return "Hz";
+    case VK_PERFORMANCE_COUNTER_UNIT_CYCLES_KHR:
+      return "cycles";
+    default:
+      return "unknown";
+  }
+}
+
+// static
+absl::StatusOr<std::unique_ptr<PerfCounterRecorder>>
+PerfCounterRecorder::Create(vulkan::Device *device,
+                            absl::Span<const std::string> counter_names) {
+  UVKC_ASSIGN_OR_RETURN(std::vector<vulkan::PerformanceCounter> available,
+                        device->EnumeratePerformanceCounters());
+
+  std::vector<vulkan::PerformanceCounter> counters;
+  for (const std::string &name : counter_names) {
+    auto it = std::find_if(
+        available.begin(), available.end(),
+        [&](const vulkan::PerformanceCounter &c) { return c.name == name; });
+    if (it == available.end()) {
+      return absl::NotFoundError(
+          absl::StrCat("unknown performance counter '", name, "'"));
+    }
+    counters.push_back(*it);
+  }
+
+  // Check early that the counters can be collected together.
+  UVKC_RETURN_IF_ERROR(
+      device->CreatePerformanceQueryPool(counters, /*query_count=*/1)
+          .status());
+
+  UVKC_RETURN_IF_ERROR(device->AcquireProfilingLock());
+  return absl::WrapUnique(new PerfCounterRecorder(device, std::move(counters)));
+}
+
+PerfCounterRecorder::~PerfCounterRecorder() {
+  {
+    absl::MutexLock lock(&mutex_);
+    recordings_.clear();
+  }
+  device_->ReleaseProfilingLock();
+}
+
+void PerfCounterRecorder::OnBegin(vulkan::CommandBuffer *command_buffer) {
+  if (command_buffer->level() != VK_COMMAND_BUFFER_LEVEL_PRIMARY ||
+      !command_buffer->measured()) {
+    return;
+  }
+
+  absl::MutexLock lock(&mutex_);
+  Recording &recording = recordings_[command_buffer];
+  recording.active = false;
+  if (!recording.query_pool) {
+    auto query_pool =
+        device_->CreatePerformanceQueryPool(counters_, /*query_count=*/1);
+    if (!query_pool.ok()) return;
+    recording.query_pool = std::move(*query_pool);
+  }
+
+  // Any previous submission of this command buffer has been waited on, so
+  // the query is free to reset.
+  recording.query_pool->Reset();
+  command_buffer->BeginQuery(*recording.query_pool, 0);
+  recording.active = true;
+}
+
+void PerfCounterRecorder::OnEnd(vulkan::CommandBuffer *command_buffer) {
+  absl::MutexLock lock(&mutex_);
+  auto it = recordings_.find(command_buffer);
+  if (it == recordings_.end() || !it->second.active) return;
+  command_buffer->EndQuery(*it->second.query_pool, 0);
+}
+
+void PerfCounterRecorder::OnWaitDone(
+    const vulkan::CommandBuffer &command_buffer) {
+  absl::MutexLock lock(&mutex_);
+  auto it = recordings_.find(&command_buffer);
+  if (it == recordings_.end() || !it->second.active) return;
+  it->second.active = false;
+
+  // Losing a sample should not fail the benchmark being measured.
+  if (!it->second.query_pool->GetCounterValues(0, &values_).ok()) return;
+  for (size_t i = 0; i < counters_.size(); ++i) totals_[i] += values_[i];
+  ++num_submits_;
+}
+
+void PerfCounterRecorder::OnDestroy(
+    const vulkan::CommandBuffer &command_buffer) {
+  absl::MutexLock lock(&mutex_);
+  recordings_.erase(&command_buffer);
+}
+
+std::vector<std::pair<std::string, double>>
+PerfCounterRecorder::TakeAverages() {
+  absl::MutexLock lock(&mutex_);
+  std::vector<std::pair<std::string, double>> averages;
+  if (num_submits_ == 0) return averages;
+
+  for (size_t i = 0; i < counters_.size(); ++i) {
+    averages.emplace_back(counters_[i].name, totals_[i] / num_submits_);
+    totals_[i] = 0;
+  }
+  num_submits_ = 0;
+  return averages;
+}
+
+PerfCounterRecorder::PerfCounterRecorder(
+    vulkan::Device *device, std::vector<vulkan::PerformanceCounter> counters)
+    : device_(device),
+      counters_(std::move(counters)),
+      totals_(counters_.size(), 0.0),
+      num_submits_(0) {
+  values_.reserve(counters_.size());
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,100 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_PERF_COUNTERS_H_
+#define UVKC_BENCHMARK_PERF_COUNTERS_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/device.h"
+#include "uvkc/vulkan/performance_query_pool.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Returns a human readable name for the |unit| of a performance counter.
+const char *GetPerformanceCounterUnitName(VkPerformanceCounterUnitKHR unit);
+
+// Samples hardware performance counters over every primary command buffer
+// allocated from one device and marked as measured, using
+// VK_KHR_performance_query. Setup, verification, and overhead sampling
+// command buffers are left out, so counters describe the benchmarked work.
+//
+// Each command buffer is wrapped in a performance query from its first to its
+// last command, so counters cover all the work in it, including setup
+// commands like pipeline binding. Holds the device's profiling lock for its
+// whole lifetime. Collecting counters perturbs timings, so latencies measured
+// at the same time should be taken with a grain of salt.
+class PerfCounterRecorder : public vulkan::CommandTracer {
+ public:
+  // Creates a recorder sampling the counters named |counter_names| on
+  // |device|. Returns a not found error if any counter is not available.
+  static absl::StatusOr<std::unique_ptr<PerfCounterRecorder>> Create(
+      vulkan::Device *device, absl::Span<const std::string> counter_names);
+
+  ~PerfCounterRecorder() override;
+
+  void OnBegin(vulkan::CommandBuffer *command_buffer) override;
+  void OnEnd(vulkan::CommandBuffer *command_buffer) override;
+  void OnBeforeDispatch(vulkan::CommandBuffer *command_buffer) override {}
+  void OnAfterDispatch(vulkan::CommandBuffer *command_buffer) override {}
+  void OnSubmit(const vulkan::CommandBuffer &command_buffer) override {}
+  void OnWait(const vulkan::CommandBuffer &command_buffer) override {}
+  void OnWaitDone(const vulkan::CommandBuffer &command_buffer) override;
+  void OnDestroy(const vulkan::CommandBuffer &command_buffer) override;
+
+  // Returns the average value of each counter per submitted command buffer
+  // since the previous call, as pairs of counter names and values. Returns an
+  // empty list if no command buffer was submitted in between.
+  std::vector<std::pair<std::string, double>> TakeAverages();
+
+ private:
+  // Sampling state of one command buffer.
+  struct Recording {
+    // A single query; may be null if creating it failed.
+    std::unique_ptr<vulkan::PerformanceQueryPool> query_pool;
+    // Whether the query is recorded into the current command buffer.
+    bool active = false;
+  };
+
+  PerfCounterRecorder(vulkan::Device *device,
+                      std::vector<vulkan::PerformanceCounter> counters);
+
+  vulkan::Device *device_;
+  const std::vector<vulkan::PerformanceCounter> counters_;
+
+  absl::Mutex mutex_;
+  std::unordered_map<const vulkan::CommandBuffer *, Recording> recordings_
+      ABSL_GUARDED_BY(mutex_);
+  // Sum of each counter over |num_submits_| command buffers.
+  std::vector<double> totals_ ABSL_GUARDED_BY(mutex_);
+  int64_t num_submits_ ABSL_GUARDED_BY(mutex_);
+  // Scratch space for readback.
+  std::vector<double> values_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_PERF_COUNTERS_H_
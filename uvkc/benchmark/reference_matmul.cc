@@ -0,0 +1,258 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/reference_matmul.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace uvkc {
+namespace benchmark {
+
+namespace {
+
+// Output tiles distributed across threads. A tile row of accumulators stays
+// in L1 while its K loop streams through a panel of the right-hand side.
+constexpr int kTileRows = 16;
+constexpr int kTileColumns = 64;
+
+// Runs |fn|(row_begin, row_end, column_begin, column_end) on the tiles of an
+// MxN output on all hardware threads.
+template <typename TileFn>
+void ParallelForTiles(int M, int N, TileFn fn) {
+  const int row_tiles = (M + kTileRows - 1) / kTileRows;
+  const int column_tiles = (N + kTileColumns - 1) / kTileColumns;
+  const int num_tiles = row_tiles * column_tiles;
+  const int num_threads = std::min<int>(
+      std::max(1u, std::thread::hardware_concurrency()), num_tiles);
+
+  std::atomic<int> next_tile{0};
+  auto worker = [&] {
+    for (int tile = next_tile++; tile < num_tiles; tile = next_tile++) {
+      const int row_begin = (tile / column_tiles) * kTileRows;
+      const int column_begin = (tile % column_tiles) * kTileColumns;
+      fn(row_begin, std::min(M, row_begin + kTileRows), column_begin,
+         std::min(N, column_begin + kTileColumns));
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) threads.emplace_back(worker);
+  worker();
+  for (std::thread &thread : threads) thread.join();
+}
+
+// Multiplies the MxK |lhs| by the KxN |rhs| into |dst|, accumulating each
+// element with Ops::Step() in increasing K order. The inner loop runs over
+// independent columns, so it vectorizes without reordering any sum.
+template <typename Ops, typename Input, typename Accumulator>
+void MultiplyRowMajor(int M, int N, int K, const Input *lhs, const Input *rhs,
+                      Accumulator *dst) {
+  ParallelForTiles(M, N, [&](int row_begin, int row_end, int column_begin,
+                             int column_end) {
+    for (int i = row_begin; i < row_end; ++i) {
+      Accumulator *acc = dst + size_t(i) * N;
+      for (int j = column_begin; j < column_end; ++j) acc[j] = 0;
+      for (int k = 0; k < K; ++k) {
+        const Input a = lhs[size_t(i) * K + k];
+        const Input *b = rhs + size_t(k) * N;
+        for (int j = column_begin; j < column_end; ++j) {
+          acc[j] = Ops::Step(acc[j], a, b[j]);
+        }
+      }
+    }
+  });
+}
+
+// Returns |rhs| as a KxN row-major matrix, transposing it into |storage| if
+// given as NxK.
+template <typename T>
+const T *GetRowMajorRhs(const MatMulShape &shape, absl::Span<const T> rhs,
+                        std::vector<T> *storage) {
+  if (!shape.transposed_rhs) return rhs.data();
+  storage->reserve(rhs.size());
+  for (int k = 0; k < shape.K; ++k) {
+    for (int j = 0; j < shape.N; ++j) {
+      storage->push_back(rhs[size_t(j) * shape.K + k]);
+    }
+  }
+  return storage->data();
+}
+
+// Returns fp16(x).toFloat(), with integer operations that vectorize.
+inline float RoundToFp16(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  const int exp = std::clamp(int((bits >> 23) & 0xff) - 127 + 15, 0, 31);
+  const uint32_t sign = bits & 0x80000000u;
+  bits = exp > 0 ? sign | uint32_t(exp + 127 - 15) << 23 | (bits & 0x7fe000u)
+                 : sign;
+  std::memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+template <typename T>
+struct MultiplyAdd {
+  static T Step(T acc, T a, T b) { return acc + a * b; }
+};
+
+struct MultiplyAddI8 {
+  static int32_t Step(int32_t acc, int8_t a, int8_t b) {
+    return acc + int32_t(a) * int32_t(b);
+  }
+};
+
+// `acc += a * b` on fp16 rounds the product and the sum to fp16. The
+// accumulator holds the sum before its rounding, so that the final conversion
+// to fp16 keeps the exact bits the fp16 class would have.
+struct MultiplyAddFp16 {
+  static float Step(float acc, float a, float b) {
+    return RoundToFp16(acc) + RoundToFp16(a * b);
+  }
+};
+
+// Returns the element (k, j) of the right-hand side.
+template <typename T>
+T GetRhs(const MatMulShape &shape, absl::Span<const T> rhs, int k, int j) {
+  return shape.transposed_rhs ? rhs[size_t(j) * shape.K + k]
+                              : rhs[size_t(k) * shape.N + j];
+}
+
+template <typename T>
+Checksum FloatMatMulChecksum(const MatMulShape &shape, absl::Span<const T> lhs,
+                             absl::Span<const T> rhs) {
+  std::vector<double> lhs_sums(shape.K), lhs_magnitudes(shape.K);
+  for (int i = 0; i < shape.M; ++i) {
+    const int sign = GetChecksumRowSign(i);
+    for (int k = 0; k < shape.K; ++k) {
+      const double value = float(lhs[size_t(i) * shape.K + k]);
+      lhs_sums[k] += sign * value;
+      lhs_magnitudes[k] += std::abs(value);
+    }
+  }
+  std::vector<double> rhs_sums(shape.K), rhs_magnitudes(shape.K);
+  for (int j = 0; j < shape.N; ++j) {
+    const int sign = GetChecksumColumnSign(j);
+    for (int k = 0; k < shape.K; ++k) {
+      const double value = float(GetRhs(shape, rhs, k, j));
+      rhs_sums[k] += sign * value;
+      rhs_magnitudes[k] += std::abs(value);
+    }
+  }
+
+  Checksum checksum;
+  for (int k = 0; k < shape.K; ++k) {
+    checksum.float_sum += lhs_sums[k] * rhs_sums[k];
+    checksum.magnitude += lhs_magnitudes[k] * rhs_magnitudes[k];
+  }
+  return checksum;
+}
+
+template <typename T>
+Checksum IntegerMatMulChecksum(const MatMulShape &shape,
+                               absl::Span<const T> lhs,
+                               absl::Span<const T> rhs) {
+  // Unsigned arithmetic wraps around like the GPU.
+  std::vector<uint32_t> lhs_sums(shape.K), rhs_sums(shape.K);
+  for (int i = 0; i < shape.M; ++i) {
+    const uint32_t sign = GetChecksumRowSign(i);
+    for (int k = 0; k < shape.K; ++k) {
+      lhs_sums[k] += sign * uint32_t(lhs[size_t(i) * shape.K + k]);
+    }
+  }
+  for (int j = 0; j < shape.N; ++j) {
+    const uint32_t sign = GetChecksumColumnSign(j);
+    for (int k = 0; k < shape.K; ++k) {
+      rhs_sums[k] += sign * uint32_t(GetRhs(shape, rhs, k, j));
+    }
+  }
+
+  Checksum checksum;
+  for (int k = 0; k < shape.K; ++k) {
+    checksum.integer_sum += lhs_sums[k] * rhs_sums[k];
+  }
+  return checksum;
+}
+
+}  // namespace
+
+void ReferenceMatMul(const MatMulShape &shape, absl::Span<const float> lhs,
+                     absl::Span<const float> rhs, absl::Span<float> dst) {
+  std::vector<float> storage;
+  MultiplyRowMajor<MultiplyAdd<float>>(shape.M, shape.N, shape.K, lhs.data(),
+                                       GetRowMajorRhs(shape, rhs, &storage),
+                                       dst.data());
+}
+
+void ReferenceMatMul(const MatMulShape &shape, absl::Span<const fp16> lhs,
+                     absl::Span<const fp16> rhs, absl::Span<fp16> dst) {
+  std::vector<float> lhs_values, rhs_values, storage;
+  lhs_values.reserve(lhs.size());
+  for (const fp16 &value : lhs) lhs_values.push_back(value.toFloat());
+  rhs_values.reserve(rhs.size());
+  for (const fp16 &value : rhs) rhs_values.push_back(value.toFloat());
+
+  std::vector<float> sums(dst.size());
+  MultiplyRowMajor<MultiplyAddFp16>(
+      shape.M, shape.N, shape.K, lhs_values.data(),
+      GetRowMajorRhs<float>(shape, rhs_values, &storage), sums.data());
+  for (size_t i = 0; i < sums.size(); ++i) dst[i] = fp16(sums[i]);
+}
+
+void ReferenceMatMul(const MatMulShape &shape, absl::Span<const int8_t> lhs,
+                     absl::Span<const int8_t> rhs, absl::Span<int32_t> dst) {
+  std::vector<int8_t> storage;
+  MultiplyRowMajor<MultiplyAddI8>(shape.M, shape.N, shape.K, lhs.data(),
+                                  GetRowMajorRhs(shape, rhs, &storage),
+                                  dst.data());
+}
+
+void ReferenceMatMul(const MatMulShape &shape, absl::Span<const int32_t> lhs,
+                     absl::Span<const int32_t> rhs, absl::Span<int32_t> dst) {
+  std::vector<int32_t> storage;
+  MultiplyRowMajor<MultiplyAdd<int32_t>>(shape.M, shape.N, shape.K,
+                                         lhs.data(),
+                                         GetRowMajorRhs(shape, rhs, &storage),
+                                         dst.data());
+}
+
+Checksum ReferenceMatMulChecksum(const MatMulShape &shape,
+                                 absl::Span<const float> lhs,
+                                 absl::Span<const float> rhs) {
+  return FloatMatMulChecksum(shape, lhs, rhs);
+}
+
+Checksum ReferenceMatMulChecksum(const MatMulShape &shape,
+                                 absl::Span<const fp16> lhs,
+                                 absl::Span<const fp16> rhs) {
+  return FloatMatMulChecksum(shape, lhs, rhs);
+}
+
+Checksum ReferenceMatMulChecksum(const MatMulShape &shape,
+                                 absl::Span<const int8_t> lhs,
+                                 absl::Span<const int8_t> rhs) {
+  return IntegerMatMulChecksum(shape, lhs, rhs);
+}
+
+Checksum ReferenceMatMulChecksum(const MatMulShape &shape,
+                                 absl::Span<const int32_t> lhs,
+                                 absl::Span<const int32_t> rhs) {
+  return IntegerMatMulChecksum(shape, lhs, rhs);
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
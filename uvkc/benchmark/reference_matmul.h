@@ -0,0 +1,90 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_REFERENCE_MATMUL_H_
+#define UVKC_BENCHMARK_REFERENCE_MATMUL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "uvkc/benchmark/data_type_util.h"
+#include "uvkc/benchmark/verification.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// The shape of a matrix multiplication C = A * B, where A is MxK, B is KxN,
+// and C is MxN, all in row-major order. If |transposed_rhs|, B is given as
+// its NxK transpose instead, as mmt and vmt take it.
+struct MatMulShape {
+  int M;
+  int N;
+  int K;
+  bool transposed_rhs;
+};
+
+// Computes the matrix multiplication |shape| of |lhs| and |rhs| into |dst| on
+// the CPU, as a reference for verifying GPU kernels.
+//
+// Each element accumulates the products in increasing K order with the
+// arithmetic of its runtime type, exactly as a naive triple loop does, so
+// results are bit exact: fp16 rounds every multiply and add to fp16 the way
+// the fp16 class does, and i8 accumulates into i32. The output is split into
+// tiles computed on all hardware threads, and inner loops run over contiguous
+// columns so that compilers vectorize them.
+void ReferenceMatMul(const MatMulShape &shape, absl::Span<const float> lhs,
+                     absl::Span<const float> rhs, absl::Span<float> dst);
+void ReferenceMatMul(const MatMulShape &shape, absl::Span<const fp16> lhs,
+                     absl::Span<const fp16> rhs, absl::Span<fp16> dst);
+void ReferenceMatMul(const MatMulShape &shape, absl::Span<const int8_t> lhs,
+                     absl::Span<const int8_t> rhs, absl::Span<int32_t> dst);
+void ReferenceMatMul(const MatMulShape &shape, absl::Span<const int32_t> lhs,
+                     absl::Span<const int32_t> rhs, absl::Span<int32_t> dst);
+
+// Returns the checksum of the product of |lhs| and |rhs| without computing
+// the product, as the sum over k of (sum_i u_i * lhs[i][k]) *
+// (sum_j v_j * rhs[k][j]) for the row and column signs u and v of checksums.
+// This takes O((M + N) * K) operations. Integers sum modulo 2^32, as i32
+// kernels do.
+Checksum ReferenceMatMulChecksum(const MatMulShape &shape,
+                                 absl::Span<const float> lhs,
+                                 absl::Span<const float> rhs);
+Checksum ReferenceMatMulChecksum(const MatMulShape &shape,
+                                 absl::Span<const fp16> lhs,
+                                 absl::Span<const fp16> rhs);
+Checksum ReferenceMatMulChecksum(const MatMulShape &shape,
+                                 absl::Span<const int8_t> lhs,
+                                 absl::Span<const int8_t> rhs);
+Checksum ReferenceMatMulChecksum(const MatMulShape &shape,
+                                 absl::Span<const int32_t> lhs,
+                                 absl::Span<const int32_t> rhs);
+
+// Returns the |rows|x|columns| row-major matrix whose element (i, j) is
+// |generator|(i, j) converted to T.
+template <typename T, typename GeneratorFn>
+std::vector<T> GenerateMatrix(int rows, int columns, GeneratorFn generator) {
+  std::vector<T> matrix;
+  matrix.reserve(size_t(rows) * columns);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < columns; ++j) matrix.push_back(T(generator(i, j)));
+  }
+  return matrix;
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_REFERENCE_MATMUL_H_
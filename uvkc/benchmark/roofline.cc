@@ -0,0 +1,273 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/roofline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "uvkc/benchmark/device_benchmark.h"
+#include "uvkc/benchmark/latency_samples.h"
+#include "uvkc/benchmark/overhead_sampler.h"
+#include "uvkc/benchmark/status_util.h"
+#include "uvkc/vulkan/pipeline.h"
+
+static uint32_t kMadShaderCode[] = {
+#include "roofline_mad_shader_spirv_instance.inc"
+};
+
+static uint32_t kCopyShaderCode[] = {
+#include "roofline_copy_shader_spirv_instance.inc"
+};
+
+// Workgroup size of both probe shaders.
+static constexpr uint32_t kWorkgroupSize = 64;
+
+// Number of vec4 elements processed by the ALU probe, and loop iterations of
+// 10 multiply-adds each over them.
+static constexpr size_t kMadNumElements = 1 << 18;
+static constexpr int kMadLoopCount = 4096;
+
+// Number of vec4 elements copied by the bandwidth probe, large enough to
+// spill any cache, and how many of them each invocation copies.
+static constexpr size_t kCopyNumElements = 1 << 22;
+static constexpr int kCopyElementsPerThread = 4;
+
+using ::uvkc::benchmark::LatencyMeasure;
+using ::uvkc::benchmark::LatencyMeasureMode;
+
+// Benchmarks dispatching |group_count_x| workgroups of the |spirv| shader with
+// |spec_constant| as constant 0 and |num_buffers| buffers of |buffer_size|
+// bytes bound to bindings 0, 1, ... Returns the median iteration latency.
+static double BenchmarkProbe(::benchmark::State &state,
+                             ::uvkc::vulkan::Device *device,
+                             const LatencyMeasure *latency_measure,
+                             absl::Span<const uint32_t> spirv,
+                             int32_t spec_constant, int num_buffers,
+                             size_t buffer_size, uint32_t group_count_x) {
+  //===-------------------------------------------------------------------===/
+  // Create shader module, pipeline, and descriptor sets
+  //===-------------------------------------------------------------------===/
+
+  BM_CHECK_OK_AND_ASSIGN(
+      auto shader_module,
+      device->CreateShaderModule(spirv.data(), spirv.size()));
+  ::uvkc::vulkan::Pipeline::SpecConstant spec_constants = {};
+  spec_constants.id = 0;
+  spec_constants.type = ::uvkc::vulkan::Pipeline::SpecConstant::Type::s32;
+  spec_constants.value.s32 = spec_constant;
+  BM_CHECK_OK_AND_ASSIGN(
+      auto pipeline,
+      device->CreatePipeline(*shader_module, "main",
+                             absl::MakeSpan(&spec_constants, 1)));
+
+  BM_CHECK_OK_AND_ASSIGN(auto descriptor_pool,
+                         device->CreateDescriptorPool(*shader_module));
+  BM_CHECK_OK_AND_ASSIGN(auto layout_set_map,
+                         descriptor_pool->AllocateDescriptorSets(
+                             shader_module->descriptor_set_layouts()));
+
+  //===-------------------------------------------------------------------===/
+  // Create buffers
+  //===-------------------------------------------------------------------===/
+
+  std::vector<std::unique_ptr<::uvkc::vulkan::Buffer>> buffers;
+  std::vector<::uvkc::vulkan::Device::BoundBuffer> bound_buffers;
+  for (int i = 0; i < num_buffers; ++i) {
+    BM_CHECK_OK_AND_ASSIGN(
+        auto buffer,
+        device->CreateBuffer(VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer_size));
+    bound_buffers.push_back(
+        {buffer.get(), /*set=*/0, /*binding=*/static_cast<uint32_t>(i)});
+    buffers.push_back(std::move(buffer));
+  }
+  BM_CHECK_OK(device->AttachBufferToDescriptor(
+      *shader_module, layout_set_map,
+      {bound_buffers.data(), bound_buffers.size()}));
+
+  BM_CHECK_EQ(shader_module->descriptor_set_layouts().size(), 1)
+      << "unexpected number of descriptor sets";
+  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
+
+  std::vector<::uvkc::vulkan::CommandBuffer::BoundDescriptorSet>
+      bound_descriptor_sets(1);
+  bound_descriptor_sets[0].index = 0;
+  bound_descriptor_sets[0].set = layout_set_map.at(descriptor_set_layout);
+
+  // Fill all buffers with 0.5f so the multiply-add chains converge instead of
+  // running into infinities or denormals, which may be slower on some GPUs.
+  BM_CHECK_OK_AND_ASSIGN(auto fill_cmdbuf, device->AllocateCommandBuffer());
+  BM_CHECK_OK(fill_cmdbuf->Begin());
+  for (const auto &buffer : buffers) {
+    fill_cmdbuf->FillBuffer(*buffer, /*dst_offset=*/0, VK_WHOLE_SIZE,
+                            /*data=*/0x3f000000u);
+  }
+  BM_CHECK_OK(fill_cmdbuf->End());
+  BM_CHECK_OK(device->QueueSubmitAndWait(*fill_cmdbuf));
+
+  //===-------------------------------------------------------------------===/
+  // Benchmarking
+  //===-------------------------------------------------------------------===/
+
+  std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> query_pool;
+  bool use_timestamp =
+      latency_measure->mode == LatencyMeasureMode::kGpuTimestamp;
+  if (use_timestamp) {
+    BM_CHECK_OK_AND_ASSIGN(query_pool, device->CreateTimestampQueryPool(2));
+  }
+
+  BM_CHECK_OK_AND_ASSIGN(auto cmdbuf, device->AllocateCommandBuffer());
+  cmdbuf->set_measured(true);
+  BM_CHECK_OK_AND_ASSIGN(
+      auto overhead_sampler,
+      ::uvkc::benchmark::OverheadSampler::Create(device, state));
+  ::uvkc::benchmark::LatencySamples latency_samples(state);
+  for (auto _ : state) {
+    BM_CHECK_OK(cmdbuf->Begin());
+    if (use_timestamp) cmdbuf->ResetQueryPool(*query_pool);
+
+    cmdbuf->BindPipelineAndDescriptorSets(
+        *pipeline,
+        {bound_descriptor_sets.data(), bound_descriptor_sets.size()});
+
+    if (use_timestamp) {
+      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+    }
+
+    cmdbuf->Dispatch(group_count_x, 1, 1);
+
+    if (use_timestamp) {
+      cmdbuf->WriteTimestamp(*query_pool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             1);
+    }
+
+    BM_CHECK_OK(cmdbuf->End());
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    BM_CHECK_OK(device->QueueSubmitAndWait(*cmdbuf));
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto elapsed_seconds =
+        std::chrono::duration_cast<std::chrono::duration<double>>(end_time -
+                                                                  start_time);
+
+    switch (latency_measure->mode) {
+      case LatencyMeasureMode::kSystemDispatch: {
+        BM_CHECK_OK_AND_ASSIGN(
+            double overhead_seconds,
+            overhead_sampler->Sample(
+                *pipeline, absl::MakeConstSpan(bound_descriptor_sets)));
+        latency_samples.SetIterationTime(
+            state, elapsed_seconds.count() - overhead_seconds);
+      } break;
+      case LatencyMeasureMode::kSystemSubmit: {
+        latency_samples.SetIterationTime(state, elapsed_seconds.count());
+      } break;
+      case LatencyMeasureMode::kGpuTimestamp: {
+        BM_CHECK_OK_AND_ASSIGN(
+            double timestamp_seconds,
+            query_pool->CalculateElapsedSecondsBetween(0, 1));
+        latency_samples.SetIterationTime(state, timestamp_seconds);
+      } break;
+    }
+
+    BM_CHECK_OK(cmdbuf->Reset());
+  }
+  latency_samples.ReportCounters(state);
+  overhead_sampler->ReportCounters(state);
+
+  // Reset the command pool to release all command buffers in the benchmarking
+  // loop to avoid draining GPU resources.
+  BM_CHECK_OK(device->ResetCommandPool());
+
+  return latency_samples.Summarize().p50_seconds;
+}
+
+static void PeakFlops(::benchmark::State &state,
+                      ::uvkc::vulkan::Device *device,
+                      LatencyMeasure *latency_measure) {
+  double seconds = BenchmarkProbe(
+      state, device, latency_measure, kMadShaderCode, kMadLoopCount,
+      /*num_buffers=*/3, kMadNumElements * 4 * sizeof(float),
+      kMadNumElements / kWorkgroupSize);
+
+  // Each of the 4 lanes does 10 multiply-adds per loop iteration.
+  double flops = double(kMadNumElements) * 4 * 10 * 2 * kMadLoopCount;
+  state.counters["FLOps"] =
+      ::benchmark::Counter(flops,
+                           ::benchmark::Counter::kIsIterationInvariant |
+                               ::benchmark::Counter::kIsRate,
+                           ::benchmark::Counter::kIs1000);
+  latency_measure->roofline_peaks.flops_per_second = flops / seconds;
+}
+
+static void PeakBandwidth(::benchmark::State &state,
+                          ::uvkc::vulkan::Device *device,
+                          LatencyMeasure *latency_measure) {
+  const size_t buffer_size = kCopyNumElements * 4 * sizeof(float);
+  double seconds = BenchmarkProbe(
+      state, device, latency_measure, kCopyShaderCode, kCopyElementsPerThread,
+      /*num_buffers=*/2, buffer_size,
+      kCopyNumElements / (kCopyElementsPerThread * kWorkgroupSize));
+
+  // Read the source buffer and write the destination buffer once.
+  double bytes = 2. * buffer_size;
+  state.counters["Bytes"] =
+      ::benchmark::Counter(bytes,
+                           ::benchmark::Counter::kIsIterationInvariant |
+                               ::benchmark::Counter::kIsRate,
+                           ::benchmark::Counter::kIs1024);
+  latency_measure->roofline_peaks.bytes_per_second = bytes / seconds;
+}
+
+namespace uvkc {
+namespace benchmark {
+
+void RegisterRooflinePeakBenchmarks(const char *gpu_name,
+                                    LazyDevice *device,
+                                    LatencyMeasure *latency_measure) {
+  std::string flops_name = absl::StrCat(gpu_name, "/roofline_peak/flops");
+  RegisterDeviceBenchmark(flops_name, PeakFlops, device, latency_measure)
+      ->UseManualTime()
+      ->Unit(::benchmark::kMicrosecond);
+
+  std::string bandwidth_name =
+      absl::StrCat(gpu_name, "/roofline_peak/bandwidth");
+  RegisterDeviceBenchmark(bandwidth_name, PeakBandwidth, device,
+                          latency_measure)
+      ->UseManualTime()
+      ->Unit(::benchmark::kMicrosecond);
+}
+
+void ReportRoofline(::benchmark::State &state, double flops, double bytes,
+                    double seconds, const RooflinePeaks &peaks) {
+  if (peaks.flops_per_second <= 0 || peaks.bytes_per_second <= 0) return;
+  if (bytes <= 0 || seconds <= 0) return;
+
+  const double intensity = flops / bytes;
+  const double attainable_flops_per_second =
+      std::min(peaks.flops_per_second, intensity * peaks.bytes_per_second);
+  state.counters["Intensity(FLOp/B)"] = intensity;
+  state.counters["Attainable(GFLOps)"] = attainable_flops_per_second * 1e-9;
+  state.counters["Roofline(%)"] =
+      flops / seconds / attainable_flops_per_second * 100;
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,51 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_ROOFLINE_H_
+#define UVKC_BENCHMARK_ROOFLINE_H_
+
+#include "benchmark/benchmark.h"
+#include "uvkc/benchmark/vulkan_context.h"
+#include "uvkc/vulkan/device.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Registers benchmarks that measure the peak ALU throughput and memory
+// bandwidth of |device| with the given |gpu_name|, in the same way as the
+// mad_throughput and copy_storage_buffer benchmarks. Writes the peaks to
+// |latency_measure| after benchmarking, for kernels benchmarked afterwards to
+// report against.
+void RegisterRooflinePeakBenchmarks(const char *gpu_name,
+                                    LazyDevice *device,
+                                    LatencyMeasure *latency_measure);
+
+// Reports where a kernel doing |flops| floating point operations and moving
+// |bytes| bytes of memory per iteration, taking |seconds| per iteration, sits
+// against the roofline of |peaks|:
+//
+// * Intensity(FLOp/B): arithmetic intensity, |flops| / |bytes|.
+// * Attainable(GFLOps): the roofline bound at that intensity, i.e., the lower
+//   of peak ALU throughput and intensity times peak bandwidth.
+// * Roofline(%): the achieved throughput as a percentage of the bound.
+//
+// |bytes| should count the compulsory traffic, e.g., reading each input and
+// writing each output once. Reports nothing if |peaks| are not measured.
+void ReportRoofline(::benchmark::State &state, double flops, double bytes,
+                    double seconds, const RooflinePeaks &peaks);
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_ROOFLINE_H_
@@ -0,0 +1,34 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#version 450 core
+
+// Peak memory bandwidth probe for roofline reporting: each invocation copies
+// kElementsPerThread vec4 elements, strided so that adjacent invocations
+// access adjacent memory.
+
+layout(binding=0) buffer InputBuffer { vec4 x[]; } inputI;
+layout(binding=1) buffer OutputBuffer { vec4 x[]; } outputO;
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+layout(constant_id = 0) const uint kElementsPerThread = 1;
+
+void main()
+{
+    const uint stride = gl_NumWorkGroups.x * gl_WorkGroupSize.x;
+    uint index = gl_GlobalInvocationID.x;
+    for (uint i = 0; i < kElementsPerThread; ++i, index += stride) {
+      outputO.x[index] = inputI.x[index];
+    }
+}
@@ -0,0 +1,45 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#version 450 core
+
+// Peak ALU throughput probe for roofline reporting: chains of dependent
+// multiply-adds on vec4, with enough invocations to hide the latency.
+
+layout(binding=0) buffer InputA { vec4 x[]; } inputA;
+layout(binding=1) buffer InputB { vec4 x[]; } inputB;
+layout(binding=2) buffer Output { vec4 x[]; } outputO;
+layout(local_size_x = 64, local_size_y = 1, local_size_z = 1) in;
+
+layout(constant_id = 0) const uint kLoopSize = 1;
+
+void main()
+{
+    vec4 a = inputA.x[gl_GlobalInvocationID.x];
+    vec4 b = inputB.x[gl_GlobalInvocationID.x];
+    vec4 c = vec4(1.f, 1.f, 1.f, 1.f);
+    for(int i = 0; i < kLoopSize; i++) {
+      c = a * c + b;
+      c = a * c + b;
+      c = a * c + b;
+      c = a * c + b;
+      c = a * c + b;
+      c = a * c + b;
+      c = a * c + b;
+      c = a * c + b;
+      c = a * c + b;
+      c = a * c + b;
+    }
+    outputO.x[gl_GlobalInvocationID.x] = c;
+}
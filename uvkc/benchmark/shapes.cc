@@ -0,0 +1,105 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/shapes.h"
+
+#include <utility>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+#include "uvkc/base/log.h"
+#include "uvkc/base/status.h"
+
+namespace uvkc {
+namespace benchmark {
+
+namespace {
+
+std::vector<Shape> &GetRequestedShapes() {
+  static std::vector<Shape> *shapes = new std::vector<Shape>();
+  return *shapes;
+}
+
+}  // namespace
+
+absl::StatusOr<Shape> ParseShape(absl::string_view text) {
+  Shape shape;
+  for (absl::string_view size_text : absl::StrSplit(text, 'x')) {
+    int size = 0;
+    if (!absl::SimpleAtoi(size_text, &size) || size <= 0) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("invalid shape '", text,
+                       "'; expected positive sizes separated by 'x'"));
+    }
+    shape.push_back(size);
+  }
+  return shape;
+}
+
+absl::StatusOr<std::vector<Shape>> ParseShapeList(absl::string_view text) {
+  std::vector<Shape> shapes;
+  for (absl::string_view line : absl::StrSplit(text, '\n')) {
+    line = line.substr(0, line.find('#'));
+    for (absl::string_view entry : absl::StrSplit(line, ',')) {
+      entry = absl::StripAsciiWhitespace(entry);
+      if (entry.empty()) continue;
+      UVKC_ASSIGN_OR_RETURN(Shape shape, ParseShape(entry));
+      shapes.push_back(std::move(shape));
+    }
+  }
+  return shapes;
+}
+
+std::string FormatShape(const Shape &shape) {
+  return absl::StrJoin(shape, "x");
+}
+
+void SetRequestedShapes(std::vector<Shape> shapes) {
+  GetRequestedShapes() = std::move(shapes);
+}
+
+std::vector<Shape> GetShapes(absl::string_view layout,
+                             absl::Span<const Shape> default_shapes) {
+  const std::vector<Shape> &requested_shapes = GetRequestedShapes();
+  if (requested_shapes.empty()) {
+    return std::vector<Shape>(default_shapes.begin(), default_shapes.end());
+  }
+
+  // All suites linked together see the same requested shapes, so each one
+  // takes those of its rank and skips the others.
+  const size_t rank = std::vector<absl::string_view>(
+                          absl::StrSplit(layout, 'x'))
+                          .size();
+  std::vector<Shape> shapes;
+  std::vector<std::string> skipped_shapes;
+  for (const Shape &shape : requested_shapes) {
+    if (shape.size() == rank) {
+      shapes.push_back(shape);
+    } else {
+      skipped_shapes.push_back(FormatShape(shape));
+    }
+  }
+  if (!skipped_shapes.empty()) {
+    GetErrorLogger() << "note: skipping shapes "
+                     << absl::StrJoin(skipped_shapes, ",")
+                     << " not matching the " << layout << " layout\n";
+  }
+  return shapes;
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,56 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_SHAPES_H_
+#define UVKC_BENCHMARK_SHAPES_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// The sizes of the dimensions of a benchmark problem, e.g., {M, N, K} for a
+// matmul.
+using Shape = std::vector<int>;
+
+// Parses a shape written as positive sizes separated by 'x', e.g., "64x32x16".
+absl::StatusOr<Shape> ParseShape(absl::string_view text);
+
+// Parses a list of shapes separated by commas or newlines. Whitespace, empty
+// entries, and '#' comments running to the end of a line are ignored.
+absl::StatusOr<std::vector<Shape>> ParseShapeList(absl::string_view text);
+
+// Formats |shape| the way ParseShape() accepts it.
+std::string FormatShape(const Shape &shape);
+
+// Sets the shapes requested on the command line for the benchmarks about to
+// be registered.
+void SetRequestedShapes(std::vector<Shape> shapes);
+
+// Returns the shapes to register benchmarks for: the requested ones if any,
+// or |default_shapes|. |layout| names the dimensions, e.g., "MxNxK"; requested
+// shapes with a different number of dimensions are meant for other suites and
+// skipped with a note, so a suite may get no shapes at all.
+std::vector<Shape> GetShapes(absl::string_view layout,
+                             absl::Span<const Shape> default_shapes);
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_SHAPES_H_
@@ -0,0 +1,58 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/suite.h"
+
+#include "absl/strings/str_cat.h"
+
+namespace uvkc {
+namespace benchmark {
+
+namespace {
+
+std::vector<BenchmarkSuite> &GetMutableBenchmarkSuites() {
+  // Suites are added by static initializers, so construct on first use.
+  static std::vector<BenchmarkSuite> *suites =
+      new std::vector<BenchmarkSuite>();
+  return *suites;
+}
+
+const BenchmarkSuite *registering_suite = nullptr;
+
+}  // namespace
+
+bool AddBenchmarkSuite(const BenchmarkSuite &suite) {
+  GetMutableBenchmarkSuites().push_back(suite);
+  return true;
+}
+
+const std::vector<BenchmarkSuite> &GetBenchmarkSuites() {
+  return GetMutableBenchmarkSuites();
+}
+
+void SetRegisteringBenchmarkSuite(const BenchmarkSuite *suite) {
+  registering_suite = suite;
+}
+
+std::string GetBenchmarkNamePrefix(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device) {
+  const char *device_name = physical_device.v10_properties.deviceName;
+  if (!registering_suite || GetBenchmarkSuites().size() == 1) {
+    return device_name;
+  }
+  return absl::StrCat(registering_suite->name, "/", device_name);
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,92 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_SUITE_H_
+#define UVKC_BENCHMARK_SUITE_H_
+
+#include <string>
+#include <vector>
+
+#include "uvkc/benchmark/vulkan_context.h"
+#include "uvkc/vulkan/device.h"
+#include "uvkc/vulkan/driver.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// A suite of Vulkan benchmarks, e.g., all the benchmarks of one directory
+// under benchmarks/.
+//
+// Each suite adds itself with UVKC_BENCHMARK_SUITE() when its file is linked
+// in. A benchmark binary runs the benchmarks of all the suites linked into it:
+// its own for a per-suite binary, or all of them for uvkc_bench_all. The
+// Vulkan context is created once and shared among all suites.
+struct BenchmarkSuite {
+  // Names the suite; also used to qualify benchmark names when a binary runs
+  // several suites.
+  const char *name;
+
+  // Registers a benchmark for evaluating the overhead that should be
+  // subtracted from the normal benchmark latency. Returns true if a benchmark
+  // is registered; returns false if to use the default overhead latency
+  // benchmark (that is, void shader dispatch).
+  //
+  // This is only used for LatencyMesaureMode::kSystemDispatch.
+  bool (*register_overhead_benchmark)(
+      const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+      LazyDevice *device, double *overhead_seconds);
+
+  // Registers all Vulkan benchmarks of the suite on |device|. Its logical
+  // device is not created until its first benchmark runs, so decide what to
+  // register from |physical_device| and its optional features.
+  //
+  // For LatencyMeasureMode::kSystemDispatch, the registered benchmarks should
+  // subtract the submission overhead sampled with an OverheadSampler from
+  // their latencies, or the |overhead_seconds| field in |latency_measure| if
+  // they registered their own overhead benchmark. |latency_measure| is a
+  // pointer to avoid copying the value at benchmark registration time.
+  void (*register_benchmarks)(
+      const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+      LazyDevice *device, const LatencyMeasure *latency_measure);
+};
+
+// Adds |suite| to the suites whose benchmarks the benchmark main() registers.
+// Returns true, to initialize a static variable with.
+bool AddBenchmarkSuite(const BenchmarkSuite &suite);
+
+// Returns the suites added so far, in the order they were added.
+const std::vector<BenchmarkSuite> &GetBenchmarkSuites();
+
+// Sets the suite whose benchmarks are being registered, or nullptr.
+void SetRegisteringBenchmarkSuite(const BenchmarkSuite *suite);
+
+// Returns the prefix for the names of benchmarks on |physical_device|: the
+// device name, preceded by the name of the suite being registered if the
+// binary runs several suites, e.g., "tree_reduce/Adreno (TM) 740". This keeps
+// names unique and lets --benchmark_filter select suites.
+std::string GetBenchmarkNamePrefix(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device);
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+// Adds the suite named |name| with the given registration functions, which
+// should be in an anonymous namespace so that suites can link together.
+#define UVKC_BENCHMARK_SUITE(name, register_overhead_benchmark,         \
+                             register_benchmarks)                       \
+  [[maybe_unused]] static const bool uvkc_benchmark_suite_added =       \
+      ::uvkc::benchmark::AddBenchmarkSuite(                             \
+          {name, register_overhead_benchmark, register_benchmarks})
+
+#endif  // UVKC_BENCHMARK_SUITE_H_
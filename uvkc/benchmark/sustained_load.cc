@@ -0,0 +1,101 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/sustained_load.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace uvkc {
+namespace benchmark {
+
+namespace {
+
+std::atomic<SustainedLoadMonitor *> global_monitor{nullptr};
+
+}  // namespace
+
+SustainedLoadMonitor::SustainedLoadMonitor(double throttle_threshold)
+    : throttle_threshold_(throttle_threshold) {}
+
+// static
+SustainedLoadMonitor *SustainedLoadMonitor::GetGlobal() {
+  return global_monitor.load(std::memory_order_acquire);
+}
+
+// static
+void SustainedLoadMonitor::SetGlobal(SustainedLoadMonitor *monitor) {
+  global_monitor.store(monitor, std::memory_order_release);
+}
+
+void SustainedLoadMonitor::AddIteration(double seconds) {
+  auto now = std::chrono::steady_clock::now();
+  absl::MutexLock lock(&mutex_);
+  if (windows_.empty()) start_time_ = now;
+
+  size_t index =
+      std::chrono::duration_cast<std::chrono::seconds>(now - start_time_)
+          .count();
+  if (index >= windows_.size()) windows_.resize(index + 1);
+  ++windows_[index].num_iterations;
+  windows_[index].total_seconds += seconds;
+}
+
+SustainedLoadMonitor::Summary SustainedLoadMonitor::TakeSummary() {
+  std::vector<Window> windows;
+  {
+    absl::MutexLock lock(&mutex_);
+    windows.swap(windows_);
+  }
+
+  Summary summary = {};
+  summary.throttled_at_seconds = -1;
+  if (windows.empty()) return summary;
+
+  for (const Window &window : windows) {
+    summary.throughputs.push_back(
+        window.total_seconds > 0 ? window.num_iterations / window.total_seconds
+                                 : 0);
+  }
+  const std::vector<double> &throughputs = summary.throughputs;
+  summary.burst_throughput =
+      *std::max_element(throughputs.begin(), throughputs.end());
+
+  double total_throughput = 0;
+  int num_sustained_windows = 0;
+  for (size_t i = throughputs.size() / 2; i < throughputs.size(); ++i) {
+    if (throughputs[i] == 0) continue;
+    total_throughput += throughputs[i];
+    ++num_sustained_windows;
+  }
+  if (num_sustained_windows != 0) {
+    summary.sustained_throughput = total_throughput / num_sustained_windows;
+  }
+
+  const double degraded_throughput =
+      (1 - throttle_threshold_) * summary.burst_throughput;
+  size_t ramped_up = 0;
+  while (throughputs[ramped_up] < degraded_throughput) ++ramped_up;
+  summary.ramp_up_seconds = ramped_up;
+  for (size_t i = ramped_up + 1; i < throughputs.size(); ++i) {
+    if (throughputs[i] != 0 && throughputs[i] < degraded_throughput) {
+      summary.throttled_at_seconds = i;
+      break;
+    }
+  }
+  return summary;
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
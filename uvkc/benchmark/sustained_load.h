@@ -0,0 +1,90 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_SUSTAINED_LOAD_H_
+#define UVKC_BENCHMARK_SUSTAINED_LOAD_H_
+
+#include <chrono>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Tracks the throughput of a benchmark over wall time while it runs under
+// sustained load, to tell the burst performance of a GPU at ramped-up clocks
+// from what it sustains once thermal throttling kicks in.
+//
+// Iterations are grouped by the wall-clock second they finish in, counting
+// from the first one. The throughput of each second is the number of
+// iterations divided by their total measured latency, so time not measured,
+// like setting up each run of the benchmark, does not dilute it.
+class SustainedLoadMonitor {
+ public:
+  struct Summary {
+    // Iterations per second of measured time in each wall-clock second; zero
+    // for seconds without any iteration.
+    std::vector<double> throughputs;
+    // The highest throughput of any second.
+    double burst_throughput;
+    // The mean throughput over the second half of the seconds.
+    double sustained_throughput;
+    // Seconds until the throughput first came within the threshold of the
+    // burst throughput, when clocks have ramped up.
+    double ramp_up_seconds;
+    // Seconds until the throughput first fell beyond the threshold below the
+    // burst throughput after reaching it, or a negative value if it never
+    // did.
+    double throttled_at_seconds;
+  };
+
+  // Creates a monitor considering throughput degraded when it falls by more
+  // than |throttle_threshold|, a fraction of the burst throughput.
+  explicit SustainedLoadMonitor(double throttle_threshold);
+
+  // Returns the monitor that LatencySamples feeds all recorded iterations to,
+  // or nullptr if there is none.
+  static SustainedLoadMonitor *GetGlobal();
+
+  // Sets the monitor returned by GetGlobal(); may be nullptr to stop
+  // monitoring. |monitor| must outlive all benchmarks run while it is set.
+  static void SetGlobal(SustainedLoadMonitor *monitor);
+
+  // Records one iteration with a latency of |seconds| finishing now.
+  void AddIteration(double seconds);
+
+  // Returns the summary of iterations recorded since the previous call, and
+  // starts over.
+  Summary TakeSummary();
+
+ private:
+  // Iterations finished in one wall-clock second.
+  struct Window {
+    int num_iterations = 0;
+    double total_seconds = 0;
+  };
+
+  const double throttle_threshold_;
+
+  absl::Mutex mutex_;
+  std::chrono::steady_clock::time_point start_time_ ABSL_GUARDED_BY(mutex_);
+  std::vector<Window> windows_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_SUSTAINED_LOAD_H_
@@ -0,0 +1,258 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/trace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "uvkc/base/log.h"
+#include "uvkc/base/status.h"
+#include "uvkc/benchmark/json_util.h"
+#include "uvkc/benchmark/latency_breakdown.h"
+
+namespace uvkc {
+namespace benchmark {
+
+//===----------------------------------------------------------------------===/
+// TraceWriter
+//===----------------------------------------------------------------------===/
+
+TraceWriter::TraceWriter(size_t max_spans)
+    : max_spans_(max_spans), first_pending_span_(0), num_dropped_spans_(0) {}
+
+int TraceWriter::AddProcess(const std::string &name) {
+  absl::MutexLock lock(&mutex_);
+  process_names_.push_back(name);
+  return process_names_.size() - 1;
+}
+
+void TraceWriter::AddSpan(int pid, int tid, const char *name, int64_t start_ns,
+                          int64_t end_ns) {
+  absl::MutexLock lock(&mutex_);
+  if (spans_.size() >= max_spans_) {
+    ++num_dropped_spans_;
+    return;
+  }
+  spans_.push_back({name, pid, tid, start_ns, end_ns, /*benchmark=*/-1});
+}
+
+void TraceWriter::SetBenchmarkForPendingSpans(
+    const std::string &benchmark_name) {
+  absl::MutexLock lock(&mutex_);
+  if (first_pending_span_ == spans_.size()) return;
+
+  int index = benchmark_names_.size();
+  benchmark_names_.push_back(benchmark_name);
+  for (size_t i = first_pending_span_; i < spans_.size(); ++i) {
+    spans_[i].benchmark = index;
+  }
+  first_pending_span_ = spans_.size();
+}
+
+absl::Status TraceWriter::WriteJson(const std::string &path) const {
+  absl::MutexLock lock(&mutex_);
+
+  std::ofstream file(path, std::ios::out | std::ios::trunc);
+  if (!file) {
+    return absl::UnavailableError(absl::StrCat("cannot open ", path));
+  }
+
+  // Make timestamps relative to the first span to keep them short.
+  int64_t origin_ns = std::numeric_limits<int64_t>::max();
+  for (const Span &span : spans_) {
+    origin_ns = std::min(origin_ns, span.start_ns);
+  }
+
+  file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  bool first_event = true;
+  auto begin_event = [&]() {
+    if (!first_event) file << ",\n";
+    first_event = false;
+  };
+
+  for (size_t pid = 0; pid < process_names_.size(); ++pid) {
+    begin_event();
+    file << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << pid
+         << ",\"args\":{\"name\":" << JsonString(process_names_[pid]) << "}}";
+    for (int tid : {kHostThread, kGpuThread}) {
+      begin_event();
+      file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << pid
+           << ",\"tid\":" << tid << ",\"args\":{\"name\":\""
+           << (tid == kHostThread ? "Host" : "GPU") << "\"}}";
+    }
+  }
+
+  for (const Span &span : spans_) {
+    begin_event();
+    file << absl::StrFormat(
+        "{\"ph\":\"X\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,"
+        "\"ts\":%.3f,\"dur\":%.3f",
+        span.name, span.pid, span.tid, (span.start_ns - origin_ns) * 1e-3,
+        (span.end_ns - span.start_ns) * 1e-3);
+    if (span.benchmark >= 0) {
+      file << ",\"args\":{\"benchmark\":"
+           << JsonString(benchmark_names_[span.benchmark]) << "}";
+    }
+    file << "}";
+  }
+  file << "\n]}\n";
+
+  if (num_dropped_spans_ != 0) {
+    GetErrorLogger() << "trace: dropped " << num_dropped_spans_
+                     << " spans beyond the limit of " << max_spans_ << "\n";
+  }
+
+  file.close();
+  if (!file) {
+    return absl::InternalError(absl::StrCat("failed to write ", path));
+  }
+  return absl::OkStatus();
+}
+
+//===----------------------------------------------------------------------===/
+// TraceRecorder
+//===----------------------------------------------------------------------===/
+
+TraceRecorder::TraceRecorder(vulkan::Device *device, TraceWriter *writer,
+                             int pid)
+    : device_(device), writer_(writer), pid_(pid) {}
+
+TraceRecorder::~TraceRecorder() = default;
+
+void TraceRecorder::OnBegin(vulkan::CommandBuffer *command_buffer) {
+  absl::MutexLock lock(&mutex_);
+  Recording &recording = recordings_[command_buffer];
+  recording.begin_ns = LatencyBreakdown::HostNanoseconds();
+  recording.num_dispatches = 0;
+
+  // Timestamps are best effort: without them only host spans are traced.
+  if (!recording.query_pool) {
+    auto query_pool = device_->CreateTimestampQueryPool(2 * kMaxDispatches);
+    if (query_pool.ok()) recording.query_pool = std::move(*query_pool);
+  }
+  if (recording.query_pool) {
+    command_buffer->ResetQueryPool(*recording.query_pool);
+  }
+}
+
+void TraceRecorder::OnEnd(vulkan::CommandBuffer *command_buffer) {
+  int64_t end_ns = LatencyBreakdown::HostNanoseconds();
+  absl::MutexLock lock(&mutex_);
+  writer_->AddSpan(pid_, TraceWriter::kHostThread, "record",
+                   recordings_[command_buffer].begin_ns, end_ns);
+}
+
+void TraceRecorder::OnBeforeDispatch(vulkan::CommandBuffer *command_buffer) {
+  absl::MutexLock lock(&mutex_);
+  Recording &recording = recordings_[command_buffer];
+  if (!recording.query_pool || recording.num_dispatches >= kMaxDispatches) {
+    return;
+  }
+  command_buffer->WriteTimestamp(*recording.query_pool,
+                                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                 2 * recording.num_dispatches);
+}
+
+void TraceRecorder::OnAfterDispatch(vulkan::CommandBuffer *command_buffer) {
+  absl::MutexLock lock(&mutex_);
+  Recording &recording = recordings_[command_buffer];
+  if (!recording.query_pool || recording.num_dispatches >= kMaxDispatches) {
+    return;
+  }
+  command_buffer->WriteTimestamp(*recording.query_pool,
+                                 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                 2 * recording.num_dispatches + 1);
+  ++recording.num_dispatches;
+}
+
+void TraceRecorder::OnSubmit(const vulkan::CommandBuffer &command_buffer) {
+  int64_t now_ns = LatencyBreakdown::HostNanoseconds();
+  absl::MutexLock lock(&mutex_);
+  recordings_[&command_buffer].submit_ns = now_ns;
+}
+
+void TraceRecorder::OnWait(const vulkan::CommandBuffer &command_buffer) {
+  int64_t now_ns = LatencyBreakdown::HostNanoseconds();
+  absl::MutexLock lock(&mutex_);
+  Recording &recording = recordings_[&command_buffer];
+  writer_->AddSpan(pid_, TraceWriter::kHostThread, "submit",
+                   recording.submit_ns, now_ns);
+  recording.wait_ns = now_ns;
+}
+
+void TraceRecorder::OnWaitDone(const vulkan::CommandBuffer &command_buffer) {
+  int64_t now_ns = LatencyBreakdown::HostNanoseconds();
+  absl::MutexLock lock(&mutex_);
+  const Recording &recording = recordings_[&command_buffer];
+  writer_->AddSpan(pid_, TraceWriter::kHostThread, "wait", recording.wait_ns,
+                   now_ns);
+  // Losing GPU spans should not fail the benchmark being traced.
+  AddGpuSpans(recording, now_ns).IgnoreError();
+}
+
+void TraceRecorder::OnDestroy(const vulkan::CommandBuffer &command_buffer) {
+  // Command buffers come and go with benchmarks, so do not keep their
+  // timestamp pools around.
+  absl::MutexLock lock(&mutex_);
+  recordings_.erase(&command_buffer);
+}
+
+absl::Status TraceRecorder::AddGpuSpans(const Recording &recording,
+                                        int64_t wakeup_ns) {
+  if (recording.num_dispatches == 0) return absl::OkStatus();
+  vulkan::TimestampQueryPool *query_pool = recording.query_pool.get();
+  const uint32_t num_queries = 2 * recording.num_dispatches;
+
+  if (device_->optional_features().calibrated_timestamps) {
+    UVKC_ASSIGN_OR_RETURN(vulkan::CalibratedTimestamps calibration,
+                          device_->SampleCalibratedTimestamps());
+    for (uint32_t query = 0; query < num_queries; query += 2) {
+      UVKC_ASSIGN_OR_RETURN(
+          int64_t start_ns,
+          query_pool->ConvertToHostNanoseconds(query, calibration));
+      UVKC_ASSIGN_OR_RETURN(
+          int64_t end_ns,
+          query_pool->ConvertToHostNanoseconds(query + 1, calibration));
+      writer_->AddSpan(pid_, TraceWriter::kGpuThread, "dispatch", start_ns,
+                       end_ns);
+    }
+    return absl::OkStatus();
+  }
+
+  // Without calibration, place the last timestamp at the host wakeup and the
+  // others relative to it.
+  const int last_query = num_queries - 1;
+  auto to_host_ns = [&](int query) -> absl::StatusOr<int64_t> {
+    if (query == last_query) return wakeup_ns;
+    UVKC_ASSIGN_OR_RETURN(
+        double seconds,
+        query_pool->CalculateElapsedSecondsBetween(query, last_query));
+    return wakeup_ns - static_cast<int64_t>(seconds * 1e9);
+  };
+  for (int query = 0; query < last_query; query += 2) {
+    UVKC_ASSIGN_OR_RETURN(int64_t start_ns, to_host_ns(query));
+    UVKC_ASSIGN_OR_RETURN(int64_t end_ns, to_host_ns(query + 1));
+    writer_->AddSpan(pid_, TraceWriter::kGpuThread, "dispatch", start_ns,
+                     end_ns);
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
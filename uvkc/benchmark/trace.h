@@ -0,0 +1,141 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_TRACE_H_
+#define UVKC_BENCHMARK_TRACE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/device.h"
+#include "uvkc/vulkan/timestamp_query_pool.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// Collects timeline spans and writes them out in the Chrome trace event JSON
+// format, which can be loaded into Perfetto or chrome://tracing.
+//
+// Each device is a process in the trace, with host activities on one thread
+// and GPU work on another.
+class TraceWriter {
+ public:
+  // Thread IDs of the tracks within each process.
+  static constexpr int kHostThread = 0;
+  static constexpr int kGpuThread = 1;
+
+  // Creates a writer keeping at most |max_spans|; spans beyond that are
+  // dropped to bound memory usage on long runs.
+  explicit TraceWriter(size_t max_spans);
+
+  // Adds a process named |name| to the trace and returns its ID.
+  int AddProcess(const std::string &name);
+
+  // Adds a span named |name| from |start_ns| to |end_ns| in the steady clock
+  // domain. |name| must be a string literal.
+  void AddSpan(int pid, int tid, const char *name, int64_t start_ns,
+               int64_t end_ns);
+
+  // Attributes all spans added since the previous call to the benchmark
+  // named |benchmark_name|.
+  void SetBenchmarkForPendingSpans(const std::string &benchmark_name);
+
+  // Writes all spans to the file at |path|.
+  absl::Status WriteJson(const std::string &path) const;
+
+ private:
+  struct Span {
+    const char *name;
+    int pid;
+    int tid;
+    int64_t start_ns;
+    int64_t end_ns;
+    // Index into |benchmark_names_|, or -1 if not attributed yet.
+    int benchmark;
+  };
+
+  const size_t max_spans_;
+
+  mutable absl::Mutex mutex_;
+  std::vector<std::string> process_names_ ABSL_GUARDED_BY(mutex_);
+  std::vector<std::string> benchmark_names_ ABSL_GUARDED_BY(mutex_);
+  std::vector<Span> spans_ ABSL_GUARDED_BY(mutex_);
+  // Index of the first span not attributed to a benchmark yet.
+  size_t first_pending_span_ ABSL_GUARDED_BY(mutex_);
+  size_t num_dropped_spans_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Traces command buffers allocated from one device into a TraceWriter.
+//
+// Records host spans for command buffer recording, queue submission, and
+// waiting, and GPU spans for each dispatch using timestamp queries written
+// around it. GPU timestamps are mapped into the host clock domain with
+// calibrated timestamps if the device supports them; otherwise the end of the
+// last dispatch is aligned to when the host wakes up, which overestimates how
+// late the GPU work runs by the wakeup latency.
+class TraceRecorder : public vulkan::CommandTracer {
+ public:
+  // Creates a recorder for |device| adding spans to |writer| as process
+  // |pid|.
+  TraceRecorder(vulkan::Device *device, TraceWriter *writer, int pid);
+  ~TraceRecorder() override;
+
+  void OnBegin(vulkan::CommandBuffer *command_buffer) override;
+  void OnEnd(vulkan::CommandBuffer *command_buffer) override;
+  void OnBeforeDispatch(vulkan::CommandBuffer *command_buffer) override;
+  void OnAfterDispatch(vulkan::CommandBuffer *command_buffer) override;
+  void OnSubmit(const vulkan::CommandBuffer &command_buffer) override;
+  void OnWait(const vulkan::CommandBuffer &command_buffer) override;
+  void OnWaitDone(const vulkan::CommandBuffer &command_buffer) override;
+  void OnDestroy(const vulkan::CommandBuffer &command_buffer) override;
+
+ private:
+  // The maximal number of dispatches traced per command buffer recording.
+  static constexpr uint32_t kMaxDispatches = 256;
+
+  // Tracing state of one command buffer.
+  struct Recording {
+    // Two queries per dispatch: before and after it. May be null if the
+    // device does not support timestamps.
+    std::unique_ptr<vulkan::TimestampQueryPool> query_pool;
+    uint32_t num_dispatches = 0;
+    int64_t begin_ns = 0;
+    int64_t submit_ns = 0;
+    int64_t wait_ns = 0;
+  };
+
+  // Adds a GPU span for each dispatch in |recording|, which the host finished
+  // waiting for at |wakeup_ns|.
+  absl::Status AddGpuSpans(const Recording &recording, int64_t wakeup_ns);
+
+  vulkan::Device *device_;
+  TraceWriter *writer_;
+  int pid_;
+
+  absl::Mutex mutex_;
+  std::unordered_map<const vulkan::CommandBuffer *, Recording> recordings_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_TRACE_H_
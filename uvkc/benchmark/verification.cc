@@ -0,0 +1,221 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/benchmark/verification.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+#include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
+#include "uvkc/base/status.h"
+#include "uvkc/benchmark/vulkan_buffer_util.h"
+#include "uvkc/vulkan/pipeline.h"
+
+static uint32_t kShaderCode[] = {
+#include "output_checksum_shader_spirv_instance.inc"
+};
+
+namespace uvkc {
+namespace benchmark {
+
+namespace {
+
+// Must match the workgroup size in output_checksum.glsl.
+constexpr uint32_t kWorkgroupSize = 256;
+// Enough workgroups to fill small GPUs while keeping the partial sums few.
+constexpr uint32_t kMaxWorkgroups = 64;
+
+// The size of the tiles checked by kSampled, and how many are random.
+constexpr int kSampledTileSize = 16;
+constexpr int kNumRandomTiles = 6;
+
+VerifyMode &GetMutableVerifyMode() {
+  static VerifyMode mode = VerifyMode::kFull;
+  return mode;
+}
+
+uint32_t PcgHash(uint32_t v) {
+  uint32_t state = v * 747796405u + 2891336453u;
+  uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+// Returns the element type constant expected by output_checksum.glsl.
+int32_t GetShaderElementType(DataType data_type) {
+  switch (data_type) {
+    case DataType::fp32:
+      return 0;
+    case DataType::i32:
+      return 1;
+    case DataType::fp16:
+      return 2;
+    case DataType::i8:
+      break;
+  }
+  return -1;
+}
+
+}  // namespace
+
+void SetVerifyMode(VerifyMode mode) { GetMutableVerifyMode() = mode; }
+
+VerifyMode GetVerifyMode() { return GetMutableVerifyMode(); }
+
+std::vector<OutputTile> GetTilesToVerify(int M, int N) {
+  switch (GetVerifyMode()) {
+    case VerifyMode::kFull:
+      return {{0, 0, M, N}};
+    case VerifyMode::kSampled:
+      break;
+    case VerifyMode::kChecksum:
+    case VerifyMode::kNone:
+      return {};
+  }
+
+  const int rows = std::min(M, kSampledTileSize);
+  const int columns = std::min(N, kSampledTileSize);
+  std::vector<OutputTile> tiles = {{0, 0, rows, columns},
+                                   {M - rows, N - columns, rows, columns}};
+  std::mt19937 generator(/*seed=*/0);
+  std::uniform_int_distribution<int> row_distribution(0, M - rows);
+  std::uniform_int_distribution<int> column_distribution(0, N - columns);
+  for (int i = 0; i < kNumRandomTiles; ++i) {
+    const int row = row_distribution(generator);
+    tiles.push_back({row, column_distribution(generator), rows, columns});
+  }
+  return tiles;
+}
+
+int GetChecksumRowSign(uint32_t row) {
+  return (PcgHash(2 * row) & 1) ? -1 : 1;
+}
+
+int GetChecksumColumnSign(uint32_t column) {
+  return (PcgHash(2 * column + 1) & 1) ? -1 : 1;
+}
+
+bool ChecksumsMatch(DataType data_type, const Checksum &expected,
+                    const Checksum &actual) {
+  // Rounding errors of kernels mostly cancel out under the random signs, so
+  // the tolerance can be a small fraction of the magnitude, while a wrong
+  // element usually shifts the sum by more. fp16 kernels accumulate in fp16.
+  double relative_tolerance = 0;
+  switch (data_type) {
+    case DataType::i8:
+    case DataType::i32:
+      return expected.integer_sum == actual.integer_sum;
+    case DataType::fp32:
+      relative_tolerance = 1e-5;
+      break;
+    case DataType::fp16:
+      relative_tolerance = 1e-3;
+      break;
+  }
+  return std::abs(actual.float_sum - expected.float_sum) <=
+         relative_tolerance * expected.magnitude;
+}
+
+std::ostream &operator<<(std::ostream &os, const Checksum &checksum) {
+  return os << "{integer_sum=" << checksum.integer_sum
+            << ", float_sum=" << checksum.float_sum
+            << ", magnitude=" << checksum.magnitude << "}";
+}
+
+absl::StatusOr<Checksum> ComputeChecksumOnDevice(vulkan::Device *device,
+                                                 vulkan::Buffer *device_buffer,
+                                                 DataType data_type, int M,
+                                                 int N) {
+  const int32_t element_type = GetShaderElementType(data_type);
+  if (element_type < 0) {
+    return absl::UnimplementedError(
+        absl::StrCat("checksums of ", GetName(data_type),
+                     " elements are not supported"));
+  }
+  const uint32_t num_elements = uint32_t(M) * uint32_t(N);
+  const uint32_t num_workgroups = std::max(
+      1u, std::min(kMaxWorkgroups,
+                   (num_elements + kWorkgroupSize - 1) / kWorkgroupSize));
+  const size_t partial_sums_size = num_workgroups * sizeof(uint32_t);
+
+  UVKC_ASSIGN_OR_RETURN(
+      auto partial_sums_buffer,
+      device->CreateBuffer(
+          VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, partial_sums_size));
+
+  UVKC_ASSIGN_OR_RETURN(
+      auto shader_module,
+      device->CreateShaderModule(kShaderCode,
+                                 sizeof(kShaderCode) / sizeof(uint32_t)));
+
+  vulkan::Pipeline::SpecConstant spec_constants[3] = {};
+  for (uint32_t i = 0; i < 3; ++i) spec_constants[i].id = i;
+  spec_constants[0].type = vulkan::Pipeline::SpecConstant::Type::s32;
+  spec_constants[0].value.s32 = element_type;
+  spec_constants[1].type = vulkan::Pipeline::SpecConstant::Type::u32;
+  spec_constants[1].value.u32 = M;
+  spec_constants[2].type = vulkan::Pipeline::SpecConstant::Type::u32;
+  spec_constants[2].value.u32 = N;
+  UVKC_ASSIGN_OR_RETURN(
+      auto pipeline, device->CreatePipeline(*shader_module, "main",
+                                            absl::MakeSpan(spec_constants)));
+
+  UVKC_ASSIGN_OR_RETURN(auto descriptor_pool,
+                        device->CreateDescriptorPool(*shader_module));
+  UVKC_ASSIGN_OR_RETURN(auto layout_set_map,
+                        descriptor_pool->AllocateDescriptorSets(
+                            shader_module->descriptor_set_layouts()));
+
+  vulkan::Device::BoundBuffer bound_buffers[2] = {
+      {device_buffer, /*set=*/0, /*binding=*/0},
+      {partial_sums_buffer.get(), /*set=*/0, /*binding=*/1},
+  };
+  UVKC_RETURN_IF_ERROR(device->AttachBufferToDescriptor(
+      *shader_module, layout_set_map, absl::MakeConstSpan(bound_buffers)));
+
+  auto descriptor_set_layout = shader_module->descriptor_set_layouts().front();
+  vulkan::CommandBuffer::BoundDescriptorSet bound_descriptor_set = {
+      /*index=*/0, layout_set_map.at(descriptor_set_layout)};
+
+  UVKC_ASSIGN_OR_RETURN(auto cmdbuffer, device->AllocateCommandBuffer());
+  UVKC_RETURN_IF_ERROR(cmdbuffer->Begin());
+  cmdbuffer->BindPipelineAndDescriptorSets(
+      *pipeline, absl::MakeConstSpan(&bound_descriptor_set, 1));
+  cmdbuffer->Dispatch(num_workgroups, 1, 1);
+  UVKC_RETURN_IF_ERROR(cmdbuffer->End());
+  UVKC_RETURN_IF_ERROR(device->QueueSubmitAndWait(*cmdbuffer));
+
+  Checksum checksum;
+  UVKC_RETURN_IF_ERROR(GetDeviceBufferViaStagingBuffer(
+      device, partial_sums_buffer.get(), partial_sums_size,
+      [&](void *ptr, size_t num_bytes) {
+        for (uint32_t partial_sum : absl::MakeConstSpan(
+                 static_cast<const uint32_t *>(ptr), num_workgroups)) {
+          if (data_type == DataType::i32) {
+            checksum.integer_sum += partial_sum;
+          } else {
+            float value;
+            std::memcpy(&value, &partial_sum, sizeof(value));
+            checksum.float_sum += value;
+          }
+        }
+      }));
+  return checksum;
+}
+
+}  // namespace benchmark
+}  // namespace uvkc
@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_BENCHMARK_VERIFICATION_H_
+#define UVKC_BENCHMARK_VERIFICATION_H_
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "uvkc/benchmark/data_type_util.h"
+#include "uvkc/vulkan/buffer.h"
+#include "uvkc/vulkan/device.h"
+
+namespace uvkc {
+namespace benchmark {
+
+// How benchmarks verify the results of kernels before measuring them.
+enum class VerifyMode {
+  // Reads back the whole output and checks every element on the host.
+  kFull,
+  // Reads back the whole output but only checks a few tiles of it.
+  kSampled,
+  // Reduces the output into a checksum on the GPU and compares it with one
+  // computed on the host without computing the output.
+  kChecksum,
+  // Skips verification.
+  kNone,
+};
+
+// Sets the verify mode requested on the command line; kFull by default.
+void SetVerifyMode(VerifyMode mode);
+VerifyMode GetVerifyMode();
+
+// A rectangle of elements of an output matrix.
+struct OutputTile {
+  int row;
+  int column;
+  int rows;
+  int columns;
+};
+
+// Returns the tiles of an MxN output matrix to check under the verify mode:
+// the whole matrix for kFull; the first, the last, and a few random tiles in
+// between for kSampled; and none otherwise. Sampled tiles are the same on
+// every run.
+std::vector<OutputTile> GetTilesToVerify(int M, int N);
+
+// A checksum of a matrix: the sum of its elements, each multiplied by the
+// pseudo-random signs of its row and column. The signs keep errors in
+// different elements from cancelling each other out, e.g., when elements are
+// swapped.
+struct Checksum {
+  // The sum for integer elements, modulo 2^32.
+  uint32_t integer_sum = 0;
+  // The sum for floating point elements, and an upper bound of the sum of
+  // their absolute values, which scales the tolerance of comparisons.
+  double float_sum = 0;
+  double magnitude = 0;
+};
+
+// Returns the signs, 1 or -1, that checksums multiply elements in row |row|
+// and column |column| by.
+int GetChecksumRowSign(uint32_t row);
+int GetChecksumColumnSign(uint32_t column);
+
+// Returns whether the checksums of two matrices of |data_type| elements
+// match: exactly for integers, and up to rounding relative to the magnitude
+// of |expected| for floating point numbers.
+bool ChecksumsMatch(DataType data_type, const Checksum &expected,
+                    const Checksum &actual);
+
+std::ostream &operator<<(std::ostream &os, const Checksum &checksum);
+
+// Computes the checksum of the MxN row-major matrix of |data_type| elements
+// in |device_buffer| by dispatching a compute shader; only per-workgroup
+// partial sums go through the host. |device_buffer| is expected to have
+// VK_BUFFER_USAGE_STORAGE_BUFFER_BIT bit. i8 elements are not supported.
+absl::StatusOr<Checksum> ComputeChecksumOnDevice(vulkan::Device *device,
+                                                 vulkan::Buffer *device_buffer,
+                                                 DataType data_type, int M,
+                                                 int N);
+
+}  // namespace benchmark
+}  // namespace uvkc
+
+#endif  // UVKC_BENCHMARK_VERIFICATION_H_
@@ -46,6 +46,17 @@ absl::Status SetDeviceBufferViaStagingBuffer(
   return absl::OkStatus();
 }
 
+absl::Status FillDeviceBuffer(vulkan::Device *device,
+                              vulkan::Buffer *device_buffer, uint32_t value) {
+  UVKC_ASSIGN_OR_RETURN(auto cmdbuffer, device->AllocateCommandBuffer());
+  UVKC_RETURN_IF_ERROR(cmdbuffer->Begin());
+  cmdbuffer->FillBuffer(*device_buffer, /*dst_offset=*/0, VK_WHOLE_SIZE, value);
+  UVKC_RETURN_IF_ERROR(cmdbuffer->End());
+  UVKC_RETURN_IF_ERROR(device->QueueSubmitAndWait(*cmdbuffer));
+
+  return absl::OkStatus();
+}
+
 absl::Status GetDeviceBufferViaStagingBuffer(
     vulkan::Device *device, vulkan::Buffer *device_buffer,
     size_t buffer_size_in_bytes,
@@ -47,6 +47,13 @@ absl::Status SetDeviceBufferViaStagingBuffer(
       });
 }
 
+// Fills the whole |device_buffer| with the 32-bit |value| pattern using a
+// transfer command on the device, without going through a staging buffer. If
+// the buffer size is not a multiple of 4, the trailing bytes are untouched.
+// |device_buffer| is expected to have VK_BUFFER_USAGE_TRANSFER_DST_BIT bit.
+absl::Status FillDeviceBuffer(vulkan::Device *device,
+                              vulkan::Buffer *device_buffer, uint32_t value);
+
 // Get data from a |device_buffer| via a CPU staging buffer by invoking
 // |staging_buffer_getter| on the pointer pointing to the start of the CPU
 // staging buffer. |device_buffer| is expected to have
@@ -14,41 +14,178 @@
 
 #include "uvkc/benchmark/vulkan_context.h"
 
+#include <regex>
+#include <string>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_replace.h"
 #include "uvkc/base/status.h"
 
 namespace uvkc {
 namespace benchmark {
 
+namespace {
+
+// Formats |uuid| as 32 lowercase hexadecimal digits.
+std::string FormatUuid(const uint8_t (&uuid)[VK_UUID_SIZE]) {
+  std::string text;
+  for (uint8_t byte : uuid) {
+    absl::StrAppend(&text, absl::Hex(byte, absl::kZeroPad2));
+  }
+  return text;
+}
+
+// Returns |selector| as 32 lowercase hexadecimal digits if it is a UUID, or
+// an empty string otherwise.
+std::string ParseUuid(absl::string_view selector) {
+  std::string uuid =
+      absl::AsciiStrToLower(absl::StrReplaceAll(selector, {{"-", ""}}));
+  if (uuid.size() != 2 * VK_UUID_SIZE) return "";
+  for (char c : uuid) {
+    if (!absl::ascii_isxdigit(c)) return "";
+  }
+  return uuid;
+}
+
+}  // namespace
+
+LazyDevice::LazyDevice(VulkanContext *context, int index)
+    : context_(context), index_(index) {}
+
+const vulkan::Driver::PhysicalDeviceInfo &LazyDevice::physical_device() const {
+  return context_->physical_devices[index_];
+}
+
+const vulkan::Device::OptionalFeatures &LazyDevice::optional_features() const {
+  return context_->optional_features[index_];
+}
+
+std::vector<uint32_t> LazyDevice::GetRequirableSubgroupSizes() const {
+  return optional_features().GetRequirableSubgroupSizes();
+}
+
+absl::StatusOr<vulkan::Device *> LazyDevice::Get() {
+  return context_->GetDevice(index_);
+}
+
 VulkanContext::VulkanContext(
     std::unique_ptr<vulkan::DynamicSymbols> symbols,
     std::unique_ptr<vulkan::Driver> driver,
     std::vector<vulkan::Driver::PhysicalDeviceInfo> physical_devices,
-    std::vector<std::unique_ptr<vulkan::Device>> devices)
+    std::vector<vulkan::Device::OptionalFeatures> optional_features)
     : symbols(std::move(symbols)),
       driver(std::move(driver)),
       physical_devices(std::move(physical_devices)),
-      devices(std::move(devices)),
-      latency_measure({LatencyMeasureMode::kSystemSubmit, 0.}) {}
+      optional_features(std::move(optional_features)),
+      devices(this->physical_devices.size()),
+      latency_measures(
+          this->physical_devices.size(),
+          {LatencyMeasureMode::kSystemSubmit, 0., {0., 0.}, false}),
+      input_buffers(std::make_unique<InputBufferCache>()) {
+  for (int i = 0; i < this->physical_devices.size(); ++i) {
+    lazy_devices.emplace_back(this, i);
+  }
+}
+
+absl::StatusOr<vulkan::Device *> VulkanContext::GetDevice(int index) {
+  absl::MutexLock lock(&devices_mutex);
+  if (!devices[index]) {
+    UVKC_ASSIGN_OR_RETURN(
+        auto device,
+        driver->CreateDevice(physical_devices[index], VK_QUEUE_COMPUTE_BIT));
+    if (on_device_created) {
+      UVKC_RETURN_IF_ERROR(on_device_created(index, device.get()));
+    }
+    devices[index] = std::move(device);
+  }
+  return devices[index].get();
+}
+
+std::vector<vulkan::Device *> VulkanContext::GetCreatedDevices() {
+  absl::MutexLock lock(&devices_mutex);
+  std::vector<vulkan::Device *> created;
+  for (auto &device : devices) {
+    if (device) created.push_back(device.get());
+  }
+  return created;
+}
+
+absl::StatusOr<std::vector<vulkan::Driver::PhysicalDeviceInfo>>
+SelectPhysicalDevices(
+    std::vector<vulkan::Driver::PhysicalDeviceInfo> physical_devices,
+    absl::string_view selector) {
+  if (selector.empty()) return physical_devices;
+
+  std::vector<vulkan::Driver::PhysicalDeviceInfo> selected;
+  int index = 0;
+  const std::string uuid = ParseUuid(selector);
+  if (absl::SimpleAtoi(selector, &index)) {
+    if (index >= 0 && index < physical_devices.size()) {
+      selected.push_back(physical_devices[index]);
+    }
+  } else if (!uuid.empty()) {
+    for (const auto &physical_device : physical_devices) {
+      if (FormatUuid(physical_device.id_properties.deviceUUID) == uuid) {
+        selected.push_back(physical_device);
+      }
+    }
+  } else {
+    std::regex name_regex;
+    try {
+      name_regex = std::regex(selector.begin(), selector.end());
+    } catch (const std::regex_error &error) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "invalid device name regex '", selector, "': ", error.what()));
+    }
+    for (const auto &physical_device : physical_devices) {
+      if (std::regex_search(physical_device.v10_properties.deviceName,
+                            name_regex)) {
+        selected.push_back(physical_device);
+      }
+    }
+  }
+
+  if (selected.empty()) {
+    std::string available;
+    for (int i = 0; i < physical_devices.size(); ++i) {
+      absl::StrAppend(&available, "\n  ", i, ": ",
+                      physical_devices[i].v10_properties.deviceName, " (",
+                      FormatUuid(physical_devices[i].id_properties.deviceUUID),
+                      ")");
+    }
+    return absl::NotFoundError(absl::StrCat(
+        "no device matches '", selector, "'; available devices:", available));
+  }
+  return selected;
+}
 
 absl::StatusOr<std::unique_ptr<VulkanContext>> CreateDefaultVulkanContext(
-    const char *app_name) {
+    const char *app_name, absl::string_view device_selector) {
   UVKC_ASSIGN_OR_RETURN(auto symbols,
                         vulkan::DynamicSymbols::CreateFromSystemLoader());
   UVKC_ASSIGN_OR_RETURN(auto driver,
                         vulkan::Driver::Create(app_name, symbols.get()));
   UVKC_ASSIGN_OR_RETURN(auto physical_devices,
                         driver->EnumeratePhysicalDevices());
+  UVKC_ASSIGN_OR_RETURN(
+      physical_devices,
+      SelectPhysicalDevices(std::move(physical_devices), device_selector));
 
-  std::vector<std::unique_ptr<vulkan::Device>> devices;
+  // Suites decide what to register from the features, so query them upfront
+  // without creating the logical devices.
+  std::vector<vulkan::Device::OptionalFeatures> optional_features;
   for (const auto &physical_device : physical_devices) {
-    UVKC_ASSIGN_OR_RETURN(
-        auto device,
-        driver->CreateDevice(physical_device, VK_QUEUE_COMPUTE_BIT));
-    devices.push_back(std::move(device));
+    UVKC_ASSIGN_OR_RETURN(auto features,
+                          driver->QueryOptionalFeatures(physical_device,
+                                                        VK_QUEUE_COMPUTE_BIT));
+    optional_features.push_back(features);
   }
-  return std::make_unique<VulkanContext>(std::move(symbols), std::move(driver),
-                                         std::move(physical_devices),
-                                         std::move(devices));
+
+  return std::make_unique<VulkanContext>(
+      std::move(symbols), std::move(driver), std::move(physical_devices),
+      std::move(optional_features));
 }
 
 }  // namespace benchmark
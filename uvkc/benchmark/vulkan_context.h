@@ -15,9 +15,17 @@
 #ifndef UVKC_BENCHMARK_VULKAN_CONTEXT_H_
 #define UVKC_BENCHMARK_VULKAN_CONTEXT_H_
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "uvkc/benchmark/input_buffer_cache.h"
 #include "uvkc/vulkan/device.h"
 #include "uvkc/vulkan/driver.h"
 #include "uvkc/vulkan/dynamic_symbols.h"
@@ -28,15 +36,57 @@ namespace benchmark {
 enum class LatencyMeasureMode {
   // time spent from queue submit to returning from queue wait
   kSystemSubmit,
-  // system_submit subtracted by time for void dispatch
+  // system_submit subtracted by time for dispatching no work, sampled
+  // alongside each iteration
   kSystemDispatch,
   // Timestamp difference measured on GPU
   kGpuTimestamp,
 };
 
+// Peak throughput of a device, measured for roofline reporting.
+struct RooflinePeaks {
+  double flops_per_second;
+  double bytes_per_second;
+};
+
 struct LatencyMeasure {
   LatencyMeasureMode mode;
+  // Latency of the overhead benchmark run before the device's benchmarks.
   double overhead_seconds;
+  // Peaks of the device whose benchmarks are running; all zeros unless
+  // roofline reporting is enabled.
+  RooflinePeaks roofline_peaks;
+  // Whether to break the latency of each iteration down into host and GPU
+  // phases, on devices supporting calibrated timestamps.
+  bool breakdown;
+};
+
+struct VulkanContext;
+
+// A device of a VulkanContext that benchmarks are registered with.
+//
+// Its properties and optional features are known without creating the logical
+// device, which is only created when a benchmark first runs on it, so that
+// devices whose benchmarks are all filtered out are never created.
+class LazyDevice {
+ public:
+  LazyDevice(VulkanContext *context, int index);
+
+  const vulkan::Driver::PhysicalDeviceInfo &physical_device() const;
+
+  // Returns the optional features the logical device enables.
+  const vulkan::Device::OptionalFeatures &optional_features() const;
+
+  // Returns all subgroup sizes that pipelines can require on the device, in
+  // increasing order.
+  std::vector<uint32_t> GetRequirableSubgroupSizes() const;
+
+  // Returns the logical device, creating it on first use.
+  absl::StatusOr<vulkan::Device *> Get();
+
+ private:
+  VulkanContext *context_;
+  int index_;
 };
 
 // A struct for holding the Vulkan application context for benchmarks.
@@ -49,22 +99,62 @@ struct VulkanContext {
   std::unique_ptr<vulkan::DynamicSymbols> symbols;
   std::unique_ptr<vulkan::Driver> driver;
 
+  // The physical devices selected for benchmarking.
   std::vector<vulkan::Driver::PhysicalDeviceInfo> physical_devices;
-  std::vector<std::unique_ptr<vulkan::Device>> devices;
+  // The optional features the logical device of each physical device enables.
+  std::vector<vulkan::Device::OptionalFeatures> optional_features;
+  // The device of each physical device that benchmarks are registered with.
+  std::vector<LazyDevice> lazy_devices;
+
+  // Called with the index of each logical device and the device right after
+  // creating it, e.g., to attach tracers. An error fails GetDevice().
+  std::function<absl::Status(int index, vulkan::Device *device)>
+      on_device_created;
+
+  absl::Mutex devices_mutex;
+  // The logical device for each physical device, or nullptr if not created
+  // yet. Use GetDevice() to create them.
+  std::vector<std::unique_ptr<vulkan::Device>> devices
+      ABSL_GUARDED_BY(devices_mutex);
 
-  LatencyMeasure latency_measure;
+  // How to measure latency on each physical device. Each device has its own
+  // so that devices can run their benchmarks at the same time.
+  std::vector<LatencyMeasure> latency_measures;
+
+  // Input buffers shared among the benchmarks on all devices. Declared after
+  // the devices so that it releases the buffers before they are destroyed.
+  std::unique_ptr<InputBufferCache> input_buffers;
 
   VulkanContext(
       std::unique_ptr<vulkan::DynamicSymbols> symbols,
       std::unique_ptr<vulkan::Driver> driver,
       std::vector<vulkan::Driver::PhysicalDeviceInfo> physical_devices,
-      std::vector<std::unique_ptr<vulkan::Device>> devices);
+      std::vector<vulkan::Device::OptionalFeatures> optional_features);
+
+  // Returns the logical device with one compute queue for the physical device
+  // at |index|, creating it on first use. Thread-safe.
+  absl::StatusOr<vulkan::Device *> GetDevice(int index);
+
+  // Returns the logical devices created so far.
+  std::vector<vulkan::Device *> GetCreatedDevices();
 };
 
-// Creates the default Vulkan application context where we create a logical
-// device with one compute queue for each available physical device.
+// Returns the physical devices in |physical_devices| that |selector| selects:
+// all of them if it is empty, the one at the index if it is a number, the one
+// with the UUID if it is 32 hexadecimal digits optionally separated by
+// dashes, or otherwise those with names matching it as an ECMAScript regular
+// expression. It is an error if none is selected.
+absl::StatusOr<std::vector<vulkan::Driver::PhysicalDeviceInfo>>
+SelectPhysicalDevices(
+    std::vector<vulkan::Driver::PhysicalDeviceInfo> physical_devices,
+    absl::string_view selector);
+
+// Creates the default Vulkan application context for the physical devices
+// that |device_selector| selects, as described in SelectPhysicalDevices().
+// Logical devices are created when first requested from the context, so
+// unused devices cost nothing.
 absl::StatusOr<std::unique_ptr<VulkanContext>> CreateDefaultVulkanContext(
-    const char *app_name);
+    const char *app_name, absl::string_view device_selector = "");
 
 }  // namespace benchmark
 }  // namespace uvkc
@@ -0,0 +1,593 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/kernels/kernels.h"
+
+#include <tuple>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "uvkc/base/status.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/descriptor_pool.h"
+
+namespace uvkc {
+namespace kernels {
+
+namespace {
+
+namespace matmul_f32 {
+#include "matmul_f32_shader_spirv_permutation.inc"
+}
+
+namespace conv2d_f32 {
+#include "conv2d_f32_shader_spirv_permutation.inc"
+}
+
+namespace reduce_loop {
+#include "reduce_loop_shader_spirv_permutation.inc"
+}
+
+namespace reduce_subgroup {
+#include "reduce_subgroup_shader_spirv_permutation.inc"
+}
+
+const uint32_t kArgmaxLoopShader[] = {
+#include "argmax_loop_shader_spirv_instance.inc"
+};
+
+const uint32_t kArgmaxSubgroupShader[] = {
+#include "argmax_subgroup_shader_spirv_instance.inc"
+};
+
+// The number of workgroups below which a grid is unlikely to fill a GPU.
+constexpr int64_t kMinWorkgroups = 64;
+
+//===----------------------------------------------------------------------===/
+// Variants
+//===----------------------------------------------------------------------===/
+
+struct MatmulVariant {
+  absl::Span<const uint32_t> code;
+  int tile_m;
+  int tile_n;
+  int tile_k;
+  int wg_size_x;
+  int wg_size_y;
+};
+
+#define MATMUL_VARIANT(M, N, K, X, Y)                                          \
+  MatmulVariant {                                                              \
+    matmul_f32::TILE_M_##M##_TILE_N_##N##_TILE_K_##K##_WG_X_##X##_WG_Y_##Y, M, \
+        N, K, X, Y                                                             \
+  }
+#define MATMUL_TILE_M_VARIANTS(N, K, X, Y)                             \
+  MATMUL_VARIANT(2, N, K, X, Y), MATMUL_VARIANT(4, N, K, X, Y),        \
+      MATMUL_VARIANT(8, N, K, X, Y), MATMUL_VARIANT(16, N, K, X, Y),   \
+      MATMUL_VARIANT(32, N, K, X, Y)
+#define MATMUL_WORKGROUP_VARIANTS(X, Y)                                \
+  MATMUL_TILE_M_VARIANTS(128, 4, X, Y),                                \
+      MATMUL_TILE_M_VARIANTS(128, 8, X, Y),                            \
+      MATMUL_TILE_M_VARIANTS(256, 4, X, Y),                            \
+      MATMUL_TILE_M_VARIANTS(256, 8, X, Y)
+
+const MatmulVariant kMatmulVariants[] = {
+    MATMUL_WORKGROUP_VARIANTS(16, 1),
+    MATMUL_WORKGROUP_VARIANTS(32, 2),
+};
+
+#undef MATMUL_WORKGROUP_VARIANTS
+#undef MATMUL_TILE_M_VARIANTS
+#undef MATMUL_VARIANT
+
+// Named like the variants of benchmarks/matmul.
+std::string GetName(const MatmulVariant &variant) {
+  return absl::StrCat("Tile[", variant.tile_m, "x", variant.tile_n, "x",
+                      variant.tile_k, "]/Workgroup[", variant.wg_size_x, "x",
+                      variant.wg_size_y, "x1]");
+}
+
+struct Conv2DVariant {
+  absl::Span<const uint32_t> code;
+  int invocation_oh;
+  int invocation_ow;
+  int wg_size_x;
+  int wg_size_y;
+  int wg_size_z;
+
+  int tile_oh() const { return invocation_oh * wg_size_z; }
+  int tile_ow() const { return invocation_ow * wg_size_y; }
+  int tile_oc() const { return wg_size_x * 4; }
+};
+
+#define CONV2D_VARIANT(X, Y, Z, OH, OW)                                  \
+  Conv2DVariant {                                                        \
+    conv2d_f32::                                                         \
+        WG_X_##X##_WG_Y_##Y##_WG_Z_##Z##_IVC_OH_##OH##_IVC_OW_##OW##_IVC_OC_1_VEC4TYPE_vec4, \
+        OH, OW, X, Y, Z                                                  \
+  }
+#define CONV2D_WORKGROUP_VARIANTS(X, Y, Z)                                  \
+  CONV2D_VARIANT(X, Y, Z, 1, 1), CONV2D_VARIANT(X, Y, Z, 1, 2),             \
+      CONV2D_VARIANT(X, Y, Z, 1, 4), CONV2D_VARIANT(X, Y, Z, 2, 1),         \
+      CONV2D_VARIANT(X, Y, Z, 2, 2), CONV2D_VARIANT(X, Y, Z, 2, 4),         \
+      CONV2D_VARIANT(X, Y, Z, 4, 1), CONV2D_VARIANT(X, Y, Z, 4, 2),         \
+      CONV2D_VARIANT(X, Y, Z, 4, 4)
+
+const Conv2DVariant kConv2DVariants[] = {
+    CONV2D_WORKGROUP_VARIANTS(16, 1, 1), CONV2D_WORKGROUP_VARIANTS(8, 2, 1),
+    CONV2D_WORKGROUP_VARIANTS(4, 4, 1),  CONV2D_WORKGROUP_VARIANTS(64, 1, 1),
+    CONV2D_WORKGROUP_VARIANTS(32, 2, 1), CONV2D_WORKGROUP_VARIANTS(16, 4, 1),
+};
+
+#undef CONV2D_WORKGROUP_VARIANTS
+#undef CONV2D_VARIANT
+
+// Named like the fp32 variants of benchmarks/convolution.
+std::string GetName(const Conv2DVariant &variant) {
+  return absl::StrCat("Tile[", variant.tile_oh(), "x", variant.tile_ow(), "x",
+                      variant.tile_oc(), "]/WGSize[", variant.wg_size_x, "x",
+                      variant.wg_size_y, "x", variant.wg_size_z, "]/f32");
+}
+
+struct ReduceVariant {
+  absl::Span<const uint32_t> code;
+  bool subgroup;
+  int batch_elements;
+  ElementType type;
+};
+
+#define REDUCE_VARIANT(kind, subgroup, size, type, element_type) \
+  ReduceVariant {                                                 \
+    reduce_##kind::BATCH_SIZE_##size##_TYPE_##type, subgroup, size, \
+        element_type                                              \
+  }
+#define REDUCE_BATCH_VARIANTS(kind, subgroup, size)                   \
+  REDUCE_VARIANT(kind, subgroup, size, float, ElementType::fp32),     \
+      REDUCE_VARIANT(kind, subgroup, size, int, ElementType::i32)
+
+const ReduceVariant kReduceVariants[] = {
+    REDUCE_BATCH_VARIANTS(loop, false, 16),
+    REDUCE_BATCH_VARIANTS(loop, false, 32),
+    REDUCE_BATCH_VARIANTS(loop, false, 64),
+    REDUCE_BATCH_VARIANTS(loop, false, 128),
+    REDUCE_BATCH_VARIANTS(subgroup, true, 16),
+    REDUCE_BATCH_VARIANTS(subgroup, true, 32),
+    REDUCE_BATCH_VARIANTS(subgroup, true, 64),
+    REDUCE_BATCH_VARIANTS(subgroup, true, 128),
+};
+
+#undef REDUCE_BATCH_VARIANTS
+#undef REDUCE_VARIANT
+
+// The workgroup size of reduce and argmax variants when not requiring a
+// subgroup size, as in the benchmarks.
+constexpr uint32_t kReduceWorkgroupSize = 16;
+constexpr uint32_t kArgmaxWorkgroupSize = 32;
+
+// Named like the variants of benchmarks/reduction/tree_reduce and
+// benchmarks/argmax, where |subgroup_size| is 0 if not required.
+std::string GetName(const ReduceVariant &variant, uint32_t subgroup_size) {
+  std::string name = absl::StrCat(variant.subgroup ? "subgroup" : "loop",
+                                  "/batch=", variant.batch_elements);
+  if (subgroup_size != 0) {
+    absl::StrAppend(&name, "/subgroup_size=", subgroup_size);
+  }
+  return name;
+}
+
+std::string GetArgmaxName(bool subgroup, uint32_t subgroup_size) {
+  std::string name = subgroup ? "subgroup" : "loop";
+  if (subgroup_size != 0) {
+    absl::StrAppend(&name, "/subgroup_size=", subgroup_size);
+  }
+  return name;
+}
+
+const char *GetName(ElementType type) {
+  switch (type) {
+    case ElementType::fp32:
+      return "fp32";
+    case ElementType::i32:
+      return "i32";
+  }
+  return "";
+}
+
+}  // namespace
+
+//===----------------------------------------------------------------------===/
+// Kernels
+//===----------------------------------------------------------------------===/
+
+// static
+absl::StatusOr<std::unique_ptr<Kernels>> Kernels::Create(
+    const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+    vulkan::Device *device, const TuningTable *tuning_table) {
+  UVKC_ASSIGN_OR_RETURN(auto command_pool, device->CreateCommandPool());
+  return absl::WrapUnique(new Kernels(physical_device, device, tuning_table,
+                                      std::move(command_pool)));
+}
+
+Kernels::Kernels(const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+                 vulkan::Device *device, const TuningTable *tuning_table,
+                 std::unique_ptr<vulkan::CommandPool> command_pool)
+    : physical_device_(physical_device),
+      device_(device),
+      tuning_table_(tuning_table),
+      command_pool_(std::move(command_pool)) {}
+
+absl::Status Kernels::Matmul(const vulkan::Buffer &lhs,
+                             const vulkan::Buffer &rhs,
+                             const vulkan::Buffer &result, int m, int n,
+                             int k) {
+  const std::string *tuned =
+      FindTunedVariant("matmul", absl::StrCat(m, "x", n, "x", k), "fp32->fp32");
+  const int preferred_workgroup_size = GetPreferredWorkgroupSize();
+
+  // Prefer workgroups matching the subgroup size, then the largest tiles that
+  // still yield enough workgroups, or the smallest ones if none does.
+  auto rank = [&](const MatmulVariant &variant) {
+    int64_t num_workgroups =
+        int64_t(m / variant.tile_m) * (n / variant.tile_n);
+    bool enough_workgroups = num_workgroups >= kMinWorkgroups;
+    int tile_size = variant.tile_m * variant.tile_n;
+    return std::make_tuple(
+        variant.wg_size_x * variant.wg_size_y == preferred_workgroup_size,
+        enough_workgroups, enough_workgroups ? tile_size : -tile_size,
+        -variant.tile_k);
+  };
+
+  const MatmulVariant *selected = nullptr;
+  for (const MatmulVariant &variant : kMatmulVariants) {
+    if (m % variant.tile_m != 0 || n % variant.tile_n != 0 ||
+        k % variant.tile_k != 0) {
+      continue;
+    }
+    if (tuned && *tuned == GetName(variant)) {
+      selected = &variant;
+      break;
+    }
+    if (!selected || rank(variant) > rank(*selected)) selected = &variant;
+  }
+  if (!selected) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "no matmul variant supports ", m, "x", n, "x", k,
+        "; M must be a multiple of 2, N of 128, and K of 4"));
+  }
+
+  Dispatch dispatch;
+  dispatch.spec_constants = {static_cast<uint32_t>(m), static_cast<uint32_t>(n),
+                             static_cast<uint32_t>(k)};
+  dispatch.group_count_x = n / selected->tile_n;
+  dispatch.group_count_y = m / selected->tile_m;
+  const vulkan::Device::BoundBuffer buffers[] = {
+      {&lhs, /*set=*/0, /*binding=*/0},
+      {&rhs, /*set=*/0, /*binding=*/1},
+      {&result, /*set=*/0, /*binding=*/2},
+  };
+  UVKC_RETURN_IF_ERROR(Run(selected->code, buffers,
+                           /*required_subgroup_size=*/0, {dispatch}));
+  last_variant_ = GetName(*selected);
+  return absl::OkStatus();
+}
+
+absl::Status Kernels::Conv2D(const vulkan::Buffer &input,
+                             const vulkan::Buffer &filter,
+                             const vulkan::Buffer &output,
+                             const Conv2DShape &shape) {
+  if (shape.input_h < shape.filter_h || shape.input_w < shape.filter_w ||
+      shape.input_c % 4 != 0) {
+    return absl::InvalidArgumentError(
+        "conv2d input must be at least as large as the filter, with a "
+        "multiple of 4 channels");
+  }
+  const int output_h = (shape.input_h - shape.filter_h) / shape.stride_h + 1;
+  const int output_w = (shape.input_w - shape.filter_w) / shape.stride_w + 1;
+  const int output_c = shape.output_c;
+
+  const std::string shape_name = absl::StrJoin(
+      {shape.input_h, shape.input_w, shape.input_c, shape.filter_h,
+       shape.filter_w, shape.output_c, shape.stride_h, shape.stride_w},
+      "x");
+  const std::string *tuned = FindTunedVariant("conv2d", shape_name, "fp32");
+  const int preferred_workgroup_size = GetPreferredWorkgroupSize();
+
+  // Same preferences as for matmul.
+  auto num_workgroups = [&](const Conv2DVariant &variant) {
+    return int64_t(output_c / variant.tile_oc()) *
+           (output_w / variant.tile_ow()) * (output_h / variant.tile_oh());
+  };
+  auto rank = [&](const Conv2DVariant &variant) {
+    bool enough_workgroups = num_workgroups(variant) >= kMinWorkgroups;
+    int tile_size = variant.tile_oh() * variant.tile_ow() * variant.tile_oc();
+    return std::make_tuple(
+        variant.wg_size_x * variant.wg_size_y * variant.wg_size_z ==
+            preferred_workgroup_size,
+        enough_workgroups, enough_workgroups ? tile_size : -tile_size);
+  };
+
+  const Conv2DVariant *selected = nullptr;
+  for (const Conv2DVariant &variant : kConv2DVariants) {
+    if (output_c % variant.tile_oc() != 0 ||
+        output_w % variant.tile_ow() != 0 ||
+        output_h % variant.tile_oh() != 0) {
+      continue;
+    }
+    if (tuned && *tuned == GetName(variant)) {
+      selected = &variant;
+      break;
+    }
+    if (!selected || rank(variant) > rank(*selected)) selected = &variant;
+  }
+  if (!selected) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "no conv2d variant tiles the ", output_h, "x", output_w, "x",
+        output_c, " output; output channels must be a multiple of 16"));
+  }
+
+  Dispatch dispatch;
+  for (int value : {output_h, output_w, output_c, shape.input_h, shape.input_w,
+                    shape.input_c, shape.filter_h, shape.filter_w,
+                    shape.stride_h, shape.stride_w}) {
+    dispatch.spec_constants.push_back(static_cast<uint32_t>(value));
+  }
+  dispatch.group_count_x = output_c / selected->tile_oc();
+  dispatch.group_count_y = output_w / selected->tile_ow();
+  dispatch.group_count_z = output_h / selected->tile_oh();
+  const vulkan::Device::BoundBuffer buffers[] = {
+      {&input, /*set=*/0, /*binding=*/0},
+      {&filter, /*set=*/0, /*binding=*/1},
+      {&output, /*set=*/0, /*binding=*/2},
+  };
+  UVKC_RETURN_IF_ERROR(Run(selected->code, buffers,
+                           /*required_subgroup_size=*/0, {dispatch}));
+  last_variant_ = GetName(*selected);
+  return absl::OkStatus();
+}
+
+absl::Status Kernels::Reduce(const vulkan::Buffer &buffer, int num_elements,
+                             ElementType type) {
+  const std::string *tuned =
+      FindTunedVariant("reduce", absl::StrCat(num_elements), GetName(type));
+  const std::vector<uint32_t> subgroup_sizes =
+      GetSubgroupSizes(VK_SUBGROUP_FEATURE_ARITHMETIC_BIT);
+
+  // Workgroups of subgroup variants must form exactly one subgroup, which is
+  // only guaranteed when requiring the subgroup size, unless tuning verified
+  // that the default size works. Prefer subgroup variants, then the fewest
+  // passes, then the largest subgroups.
+  auto rank = [](const ReduceVariant &variant, uint32_t subgroup_size) {
+    return std::make_tuple(subgroup_size != 0, variant.batch_elements,
+                           subgroup_size);
+  };
+  const ReduceVariant *selected = nullptr;
+  uint32_t selected_subgroup_size = 0;
+  bool selected_tuned = false;
+  for (const ReduceVariant &variant : kReduceVariants) {
+    if (variant.type != type || num_elements <= 1) continue;
+    int remaining = num_elements;
+    while (remaining % variant.batch_elements == 0) {
+      remaining /= variant.batch_elements;
+    }
+    if (remaining != 1) continue;
+
+    std::vector<uint32_t> sizes = {0};
+    if (variant.subgroup) {
+      for (uint32_t size : subgroup_sizes) {
+        if (variant.batch_elements % size == 0) sizes.push_back(size);
+      }
+    }
+    for (uint32_t size : sizes) {
+      bool tuned_variant = tuned && *tuned == GetName(variant, size);
+      if (selected_tuned ||
+          (!tuned_variant && variant.subgroup && size == 0)) {
+        continue;
+      }
+      if (tuned_variant || !selected ||
+          rank(variant, size) > rank(*selected, selected_subgroup_size)) {
+        selected = &variant;
+        selected_subgroup_size = size;
+        selected_tuned = tuned_variant;
+      }
+    }
+  }
+  if (!selected) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("cannot reduce ", num_elements,
+                     " elements; it must be a power of 16, 32, 64, or 128"));
+  }
+
+  // Each pass reduces each batch of elements, strided by the number of
+  // batches, into the first element of the batch.
+  const uint32_t workgroup_size = selected_subgroup_size != 0
+                                      ? selected_subgroup_size
+                                      : kReduceWorkgroupSize;
+  std::vector<Dispatch> dispatches;
+  for (int batch = num_elements / selected->batch_elements; batch > 0;
+       batch /= selected->batch_elements) {
+    Dispatch dispatch;
+    dispatch.spec_constants = {static_cast<uint32_t>(batch), workgroup_size};
+    dispatch.group_count_x = batch;
+    dispatches.push_back(std::move(dispatch));
+  }
+  const vulkan::Device::BoundBuffer buffers[] = {
+      {&buffer, /*set=*/0, /*binding=*/0},
+  };
+  UVKC_RETURN_IF_ERROR(
+      Run(selected->code, buffers, selected_subgroup_size, dispatches));
+  last_variant_ = GetName(*selected, selected_subgroup_size);
+  return absl::OkStatus();
+}
+
+absl::Status Kernels::Argmax(const vulkan::Buffer &input,
+                             const vulkan::Buffer &output, int num_elements) {
+  if (num_elements <= 0) {
+    return absl::InvalidArgumentError("argmax needs at least one element");
+  }
+  const std::string *tuned =
+      FindTunedVariant("argmax", absl::StrCat(num_elements), "fp32");
+
+  // As for reduce, only use subgroup variants with a required subgroup size
+  // unless tuned, preferring the largest subgroups. The subgroup variant needs
+  // the elements to split evenly among the invocations.
+  bool subgroup = false;
+  uint32_t subgroup_size = 0;
+  std::vector<uint32_t> sizes = GetSubgroupSizes(
+      VK_SUBGROUP_FEATURE_ARITHMETIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT);
+  if (tuned && *tuned == GetArgmaxName(/*subgroup=*/true, 0) &&
+      num_elements % kArgmaxWorkgroupSize == 0) {
+    subgroup = true;
+  } else if (!(tuned && *tuned == GetArgmaxName(/*subgroup=*/false, 0))) {
+    for (uint32_t size : sizes) {
+      if (num_elements % size != 0) continue;
+      bool tuned_size = tuned && *tuned == GetArgmaxName(true, size);
+      if (tuned_size || size > subgroup_size) {
+        subgroup = true;
+        subgroup_size = size;
+      }
+      if (tuned_size) break;
+    }
+  }
+
+  const uint32_t workgroup_size =
+      subgroup_size != 0 ? subgroup_size : kArgmaxWorkgroupSize;
+  Dispatch dispatch;
+  dispatch.spec_constants = {static_cast<uint32_t>(num_elements),
+                             workgroup_size};
+  const vulkan::Device::BoundBuffer buffers[] = {
+      {&input, /*set=*/0, /*binding=*/0},
+      {&output, /*set=*/0, /*binding=*/1},
+  };
+  if (subgroup) {
+    UVKC_RETURN_IF_ERROR(
+        Run(kArgmaxSubgroupShader, buffers, subgroup_size, {dispatch}));
+  } else {
+    UVKC_RETURN_IF_ERROR(Run(kArgmaxLoopShader, buffers,
+                             /*required_subgroup_size=*/0, {dispatch}));
+  }
+  last_variant_ = GetArgmaxName(subgroup, subgroup_size);
+  return absl::OkStatus();
+}
+
+const std::string *Kernels::FindTunedVariant(
+    absl::string_view kernel, absl::string_view shape,
+    absl::string_view data_type) const {
+  if (!tuning_table_) return nullptr;
+  const VkPhysicalDeviceProperties &properties =
+      physical_device_.v10_properties;
+  return tuning_table_->Find(properties.deviceName, properties.driverVersion,
+                             kernel, shape, data_type);
+}
+
+int Kernels::GetPreferredWorkgroupSize() const {
+  // Matches the workgroup sizes the benchmarks use on Mali GPUs with 16-wide
+  // subgroups and on Adreno GPUs with wider ones.
+  return physical_device_.subgroup_properties.subgroupSize >= 32 ? 64 : 16;
+}
+
+std::vector<uint32_t> Kernels::GetSubgroupSizes(
+    VkSubgroupFeatureFlags operations) const {
+  const VkPhysicalDeviceSubgroupProperties &properties =
+      physical_device_.subgroup_properties;
+  if ((properties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) == 0 ||
+      (properties.supportedOperations & operations) != operations) {
+    return {};
+  }
+  return device_->GetRequirableSubgroupSizes();
+}
+
+absl::Status Kernels::Run(
+    absl::Span<const uint32_t> code,
+    absl::Span<const vulkan::Device::BoundBuffer> buffers,
+    uint32_t required_subgroup_size, absl::Span<const Dispatch> dispatches) {
+  std::unique_ptr<vulkan::ShaderModule> &shader_module =
+      shader_modules_[code.data()];
+  if (!shader_module) {
+    UVKC_ASSIGN_OR_RETURN(shader_module, device_->CreateShaderModule(
+                                             code.data(), code.size()));
+  }
+
+  std::vector<const vulkan::Pipeline *> pipelines;
+  for (const Dispatch &dispatch : dispatches) {
+    UVKC_ASSIGN_OR_RETURN(const vulkan::Pipeline *pipeline,
+                          GetPipeline(*shader_module, code, dispatch,
+                                      required_subgroup_size));
+    pipelines.push_back(pipeline);
+  }
+
+  // Descriptor sets only live as long as this call.
+  UVKC_ASSIGN_OR_RETURN(auto descriptor_pool,
+                        device_->CreateDescriptorPool(*shader_module));
+  UVKC_ASSIGN_OR_RETURN(auto layout_set_map,
+                        descriptor_pool->AllocateDescriptorSets(
+                            shader_module->descriptor_set_layouts()));
+  UVKC_RETURN_IF_ERROR(device_->AttachBufferToDescriptor(
+      *shader_module, layout_set_map, buffers));
+  const vulkan::CommandBuffer::BoundDescriptorSet bound_descriptor_sets[] = {
+      {/*index=*/0,
+       layout_set_map.at(shader_module->descriptor_set_layouts().front())},
+  };
+
+  UVKC_ASSIGN_OR_RETURN(auto cmdbuf, command_pool_->AllocateCommandBuffer(
+                                         VK_COMMAND_BUFFER_LEVEL_PRIMARY));
+  UVKC_RETURN_IF_ERROR(cmdbuf->Begin());
+  for (size_t i = 0; i < dispatches.size(); ++i) {
+    if (i != 0) cmdbuf->DispatchBarrier();
+    cmdbuf->BindPipelineAndDescriptorSets(*pipelines[i],
+                                          bound_descriptor_sets);
+    cmdbuf->Dispatch(dispatches[i].group_count_x, dispatches[i].group_count_y,
+                     dispatches[i].group_count_z);
+  }
+  UVKC_RETURN_IF_ERROR(cmdbuf->End());
+  UVKC_RETURN_IF_ERROR(device_->QueueSubmitAndWait(*cmdbuf));
+  return command_pool_->Reset();
+}
+
+absl::StatusOr<const vulkan::Pipeline *> Kernels::GetPipeline(
+    const vulkan::ShaderModule &shader_module, absl::Span<const uint32_t> code,
+    const Dispatch &dispatch, uint32_t required_subgroup_size) {
+  std::string key =
+      absl::StrCat(reinterpret_cast<uintptr_t>(code.data()), "/",
+                   absl::StrJoin(dispatch.spec_constants, ","), "/",
+                   required_subgroup_size);
+  std::unique_ptr<vulkan::Pipeline> &pipeline = pipelines_[key];
+  if (pipeline) return pipeline.get();
+
+  std::vector<vulkan::Pipeline::SpecConstant> spec_constants;
+  for (size_t i = 0; i < dispatch.spec_constants.size(); ++i) {
+    vulkan::Pipeline::SpecConstant spec_constant;
+    spec_constant.id = i;
+    spec_constant.type = vulkan::Pipeline::SpecConstant::Type::u32;
+    spec_constant.value.u32 = dispatch.spec_constants[i];
+    spec_constants.push_back(spec_constant);
+  }
+  // Without this, a failure would cache a null pipeline.
+  absl::StatusOr<std::unique_ptr<vulkan::Pipeline>> created =
+      device_->CreatePipeline(
+          shader_module, "main", absl::MakeSpan(spec_constants),
+          {required_subgroup_size,
+           required_subgroup_size != 0 &&
+               device_->optional_features().compute_full_subgroups});
+  if (!created.ok()) {
+    pipelines_.erase(key);
+    return created.status();
+  }
+  pipeline = std::move(*created);
+  return pipeline.get();
+}
+
+}  // namespace kernels
+}  // namespace uvkc
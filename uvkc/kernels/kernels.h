@@ -0,0 +1,167 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_KERNELS_KERNELS_H_
+#define UVKC_KERNELS_KERNELS_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "uvkc/kernels/tuning_table.h"
+#include "uvkc/vulkan/buffer.h"
+#include "uvkc/vulkan/command_pool.h"
+#include "uvkc/vulkan/device.h"
+#include "uvkc/vulkan/driver.h"
+#include "uvkc/vulkan/pipeline.h"
+#include "uvkc/vulkan/shader_module.h"
+
+namespace uvkc {
+namespace kernels {
+
+enum class ElementType {
+  fp32,
+  i32,
+};
+
+// The shape of a 2-D convolution: input height, width, and channels, filter
+// height and width, output channels, and strides.
+struct Conv2DShape {
+  int input_h;
+  int input_w;
+  int input_c;
+  int filter_h;
+  int filter_w;
+  int output_c;
+  int stride_h;
+  int stride_w;
+};
+
+// Runs the kernels benchmarked under benchmarks/ on a device.
+//
+// Each kernel comes precompiled in several variants, e.g., with different tile
+// and workgroup sizes. For each problem, the variant that the tuning table
+// lists for the device is used if it supports the problem; otherwise one is
+// picked by heuristics based on the device's subgroup properties and the
+// number of workgroups the problem yields. Variants are named the same way as
+// in the benchmarks so tuning databases apply directly.
+//
+// Buffers hold tightly packed row-major data and must be usable as storage
+// buffers. Each call records its dispatches, submits them, and waits for them
+// to complete. Pipelines are cached per variant and problem.
+class Kernels {
+ public:
+  // Creates kernels for |device| created from |physical_device|.
+  // |tuning_table| may be nullptr to always use heuristics; otherwise it must
+  // outlive the returned object.
+  static absl::StatusOr<std::unique_ptr<Kernels>> Create(
+      const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+      vulkan::Device *device, const TuningTable *tuning_table);
+
+  // Computes the fp32 matrix product |result| (MxN) = |lhs| (MxK) x |rhs|
+  // (KxN). A variant must tile the problem: M must be a multiple of 2, N of
+  // 128, and K of 4.
+  absl::Status Matmul(const vulkan::Buffer &lhs, const vulkan::Buffer &rhs,
+                      const vulkan::Buffer &result, int m, int n, int k);
+
+  // Computes the fp32 2-D convolution of |input| (1xHxWxC) with |filter|
+  // (FHxFWxCxOC) into |output| (1xOHxOWxOC), without padding or dilation. C
+  // must be a multiple of 4, and a variant must tile the output: OC must be a
+  // multiple of 16.
+  absl::Status Conv2D(const vulkan::Buffer &input,
+                      const vulkan::Buffer &filter,
+                      const vulkan::Buffer &output, const Conv2DShape &shape);
+
+  // Sums the |num_elements| elements of |buffer| of |type| in place, leaving
+  // the sum in the first element and clobbering the others. |num_elements|
+  // must be a power of 16, 32, 64, or 128.
+  absl::Status Reduce(const vulkan::Buffer &buffer, int num_elements,
+                      ElementType type);
+
+  // Writes the index of the first largest of the |num_elements| fp32 elements
+  // of |input| to |output| as a uint32.
+  absl::Status Argmax(const vulkan::Buffer &input,
+                      const vulkan::Buffer &output, int num_elements);
+
+  // Returns the name of the variant the last successful call ran.
+  const std::string &last_variant() const { return last_variant_; }
+
+ private:
+  // One dispatch of a variant, with its specialization constants, all of type
+  // uint32 with consecutive IDs from 0.
+  struct Dispatch {
+    std::vector<uint32_t> spec_constants;
+    uint32_t group_count_x = 1;
+    uint32_t group_count_y = 1;
+    uint32_t group_count_z = 1;
+  };
+
+  Kernels(const vulkan::Driver::PhysicalDeviceInfo &physical_device,
+          vulkan::Device *device, const TuningTable *tuning_table,
+          std::unique_ptr<vulkan::CommandPool> command_pool);
+
+  // Returns the tuned variant of the given problem on this device, or nullptr
+  // if there is none.
+  const std::string *FindTunedVariant(absl::string_view kernel,
+                                      absl::string_view shape,
+                                      absl::string_view data_type) const;
+
+  // Returns the number of invocations per workgroup that tiled variants
+  // should prefer on this device.
+  int GetPreferredWorkgroupSize() const;
+
+  // Returns the subgroup sizes subgroup variants can require, with one
+  // subgroup per workgroup, if the device supports the given subgroup
+  // operations in compute shaders.
+  std::vector<uint32_t> GetSubgroupSizes(
+      VkSubgroupFeatureFlags operations) const;
+
+  // Runs |dispatches| of |code| in order, separated by barriers, with
+  // |buffers| bound to set 0, and waits for them.
+  absl::Status Run(absl::Span<const uint32_t> code,
+                   absl::Span<const vulkan::Device::BoundBuffer> buffers,
+                   uint32_t required_subgroup_size,
+                   absl::Span<const Dispatch> dispatches);
+
+  // Returns the pipeline of |code| for |dispatch|, creating it if needed.
+  absl::StatusOr<const vulkan::Pipeline *> GetPipeline(
+      const vulkan::ShaderModule &shader_module,
+      absl::Span<const uint32_t> code, const Dispatch &dispatch,
+      uint32_t required_subgroup_size);
+
+  const vulkan::Driver::PhysicalDeviceInfo physical_device_;
+  vulkan::Device *device_;
+  const TuningTable *tuning_table_;
+  std::unique_ptr<vulkan::CommandPool> command_pool_;
+
+  // Shader modules by the start of their code.
+  std::unordered_map<const uint32_t *, std::unique_ptr<vulkan::ShaderModule>>
+      shader_modules_;
+  // Pipelines by their code, specialization constants, and subgroup size.
+  std::unordered_map<std::string, std::unique_ptr<vulkan::Pipeline>>
+      pipelines_;
+
+  std::string last_variant_;
+};
+
+}  // namespace kernels
+}  // namespace uvkc
+
+#endif  // UVKC_KERNELS_KERNELS_H_
@@ -0,0 +1,245 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/kernels/tuning_table.h"
+
+#include <cstdlib>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "uvkc/base/file.h"
+#include "uvkc/base/status.h"
+
+namespace uvkc {
+namespace kernels {
+
+namespace {
+
+// Reads the subset of JSON that tuning databases use: objects, arrays,
+// strings, numbers, and literals. Strings may only escape quotes, backslashes,
+// and control characters.
+class JsonReader {
+ public:
+  explicit JsonReader(absl::string_view text) : text_(text) {}
+
+  // Reads an object, calling |read_member| with each key to read its value.
+  absl::Status ReadObject(
+      const std::function<absl::Status(const std::string &)> &read_member) {
+    UVKC_RETURN_IF_ERROR(Expect('{'));
+    if (Consume('}')) return absl::OkStatus();
+    do {
+      UVKC_ASSIGN_OR_RETURN(std::string key, ReadString());
+      UVKC_RETURN_IF_ERROR(Expect(':'));
+      UVKC_RETURN_IF_ERROR(read_member(key));
+    } while (Consume(','));
+    return Expect('}');
+  }
+
+  // Reads an array, calling |read_element| to read each element.
+  absl::Status ReadArray(const std::function<absl::Status()> &read_element) {
+    UVKC_RETURN_IF_ERROR(Expect('['));
+    if (Consume(']')) return absl::OkStatus();
+    do {
+      UVKC_RETURN_IF_ERROR(read_element());
+    } while (Consume(','));
+    return Expect(']');
+  }
+
+  absl::StatusOr<std::string> ReadString() {
+    UVKC_RETURN_IF_ERROR(Expect('"'));
+    std::string result;
+    while (position_ < text_.size() && text_[position_] != '"') {
+      char c = text_[position_++];
+      if (c != '\\') {
+        result += c;
+        continue;
+      }
+      if (position_ >= text_.size()) break;
+      char escaped = text_[position_++];
+      if (escaped == 'u' && position_ + 4 <= text_.size()) {
+        int code = std::strtol(
+            std::string(text_.substr(position_, 4)).c_str(), nullptr, 16);
+        position_ += 4;
+        result += static_cast<char>(code);
+      } else if (escaped == '"' || escaped == '\\' || escaped == '/') {
+        result += escaped;
+      } else {
+        return Error("unsupported escape sequence");
+      }
+    }
+    UVKC_RETURN_IF_ERROR(Expect('"'));
+    return result;
+  }
+
+  absl::StatusOr<double> ReadNumber() {
+    SkipWhitespace();
+    size_t end = text_.find_first_of(",]} \t\r\n", position_);
+    if (end == absl::string_view::npos) end = text_.size();
+    double value = 0;
+    if (!absl::SimpleAtod(text_.substr(position_, end - position_), &value)) {
+      return Error("expected a number");
+    }
+    position_ = end;
+    return value;
+  }
+
+  // Skips a value of any type.
+  absl::Status SkipValue() {
+    SkipWhitespace();
+    if (position_ >= text_.size()) return Error("expected a value");
+    switch (text_[position_]) {
+      case '{':
+        return ReadObject([this](const std::string &) { return SkipValue(); });
+      case '[':
+        return ReadArray([this]() { return SkipValue(); });
+      case '"':
+        return ReadString().status();
+      default:
+        break;
+    }
+    for (absl::string_view literal : {"true", "false", "null"}) {
+      if (text_.substr(position_, literal.size()) == literal) {
+        position_ += literal.size();
+        return absl::OkStatus();
+      }
+    }
+    return ReadNumber().status();
+  }
+
+  // Returns an error if anything but whitespace is left.
+  absl::Status ExpectEnd() {
+    SkipWhitespace();
+    if (position_ != text_.size()) return Error("unexpected trailing text");
+    return absl::OkStatus();
+  }
+
+ private:
+  void SkipWhitespace() {
+    while (position_ < text_.size() && absl::ascii_isspace(text_[position_])) {
+      ++position_;
+    }
+  }
+
+  // Skips whitespace and |c| if it comes next, returning whether it did.
+  bool Consume(char c) {
+    SkipWhitespace();
+    if (position_ >= text_.size() || text_[position_] != c) return false;
+    ++position_;
+    return true;
+  }
+
+  absl::Status Expect(char c) {
+    if (Consume(c)) return absl::OkStatus();
+    return Error(absl::StrCat("expected '", std::string(1, c), "'"));
+  }
+
+  absl::Status Error(absl::string_view message) const {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "malformed tuning database at offset ", position_, ": ", message));
+  }
+
+  absl::string_view text_;
+  size_t position_ = 0;
+};
+
+}  // namespace
+
+// static
+absl::StatusOr<TuningTable> TuningTable::Parse(absl::string_view json) {
+  TuningTable table;
+  JsonReader reader(json);
+
+  auto read_device = [&]() -> absl::Status {
+    std::string device_name;
+    double driver_version = 0;
+    // Kernels may come before the device name, so collect them first.
+    std::vector<std::tuple<std::string, std::string, std::string, std::string>>
+        problems;
+    auto read_kernel = [&]() -> absl::Status {
+      std::string kernel, shape, data_type, variant;
+      UVKC_RETURN_IF_ERROR(
+          reader.ReadObject([&](const std::string &key) -> absl::Status {
+            std::string *field = key == "kernel"      ? &kernel
+                                 : key == "shape"     ? &shape
+                                 : key == "data_type" ? &data_type
+                                 : key == "variant"   ? &variant
+                                                      : nullptr;
+            if (!field) return reader.SkipValue();
+            UVKC_ASSIGN_OR_RETURN(*field, reader.ReadString());
+            return absl::OkStatus();
+          }));
+      problems.emplace_back(std::move(kernel), std::move(shape),
+                            std::move(data_type), std::move(variant));
+      return absl::OkStatus();
+    };
+    UVKC_RETURN_IF_ERROR(
+        reader.ReadObject([&](const std::string &key) -> absl::Status {
+          if (key == "name") {
+            UVKC_ASSIGN_OR_RETURN(device_name, reader.ReadString());
+          } else if (key == "driver_version") {
+            UVKC_ASSIGN_OR_RETURN(driver_version, reader.ReadNumber());
+          } else if (key == "kernels") {
+            return reader.ReadArray(read_kernel);
+          } else {
+            return reader.SkipValue();
+          }
+          return absl::OkStatus();
+        }));
+    for (const auto &problem : problems) {
+      table.Add(device_name, static_cast<uint32_t>(driver_version),
+                std::get<0>(problem), std::get<1>(problem),
+                std::get<2>(problem), std::get<3>(problem));
+    }
+    return absl::OkStatus();
+  };
+
+  UVKC_RETURN_IF_ERROR(
+      reader.ReadObject([&](const std::string &key) -> absl::Status {
+        if (key == "devices") return reader.ReadArray(read_device);
+        return reader.SkipValue();
+      }));
+  UVKC_RETURN_IF_ERROR(reader.ExpectEnd());
+  return table;
+}
+
+// static
+absl::StatusOr<TuningTable> TuningTable::Load(const std::string &path) {
+  UVKC_ASSIGN_OR_RETURN(std::string json, ReadFile(path));
+  return Parse(json);
+}
+
+void TuningTable::Add(absl::string_view device_name, uint32_t driver_version,
+                      absl::string_view kernel, absl::string_view shape,
+                      absl::string_view data_type, absl::string_view variant) {
+  variants_[Key(device_name, driver_version, kernel, shape, data_type)] =
+      std::string(variant);
+}
+
+const std::string *TuningTable::Find(absl::string_view device_name,
+                                     uint32_t driver_version,
+                                     absl::string_view kernel,
+                                     absl::string_view shape,
+                                     absl::string_view data_type) const {
+  auto it = variants_.find(
+      Key(device_name, driver_version, kernel, shape, data_type));
+  if (it == variants_.end()) return nullptr;
+  return &it->second;
+}
+
+}  // namespace kernels
+}  // namespace uvkc
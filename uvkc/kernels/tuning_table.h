@@ -0,0 +1,67 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_KERNELS_TUNING_TABLE_H_
+#define UVKC_KERNELS_TUNING_TABLE_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace uvkc {
+namespace kernels {
+
+// The fastest kernel variant of each problem on each device, as found by
+// autotuning the benchmarks with --autotune and written to --tuning_db_out.
+//
+// Problems are keyed the same way as in the tuning database: by kernel name,
+// e.g., "matmul", shape, e.g., "1024x1024x1024", and data types, e.g.,
+// "fp32->fp32". Results only apply to the exact device name and driver
+// version they were tuned on.
+class TuningTable {
+ public:
+  // Parses a tuning database.
+  static absl::StatusOr<TuningTable> Parse(absl::string_view json);
+
+  // Reads and parses the tuning database at |path|.
+  static absl::StatusOr<TuningTable> Load(const std::string &path);
+
+  // Records |variant| as the fastest one for the given problem on the given
+  // device, replacing any previous one.
+  void Add(absl::string_view device_name, uint32_t driver_version,
+           absl::string_view kernel, absl::string_view shape,
+           absl::string_view data_type, absl::string_view variant);
+
+  // Returns the fastest variant for the given problem on the given device, or
+  // nullptr if it was not tuned.
+  const std::string *Find(absl::string_view device_name,
+                          uint32_t driver_version, absl::string_view kernel,
+                          absl::string_view shape,
+                          absl::string_view data_type) const;
+
+ private:
+  using Key = std::tuple<std::string, uint32_t, std::string, std::string,
+                         std::string>;
+
+  std::map<Key, std::string> variants_;
+};
+
+}  // namespace kernels
+}  // namespace uvkc
+
+#endif  // UVKC_KERNELS_TUNING_TABLE_H_
@@ -14,6 +14,7 @@
 
 #include "uvkc/vulkan/command_buffer.h"
 
+#include "absl/container/inlined_vector.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "uvkc/vulkan/status_util.h"
@@ -23,26 +24,54 @@ namespace uvkc {
 namespace vulkan {
 
 CommandBuffer::CommandBuffer(VkDevice device, VkCommandBuffer command_buffer,
+                             VkCommandBufferLevel level,
+                             bool use_synchronization2,
                              const DynamicSymbols &symbols)
-    : command_buffer_(command_buffer), device_(device), symbols_(symbols) {}
+    : command_buffer_(command_buffer),
+      level_(level),
+      device_(device),
+      use_synchronization2_(use_synchronization2),
+      tracer_(nullptr),
+      measured_(false),
+      symbols_(symbols) {}
 
-CommandBuffer::~CommandBuffer() = default;
+CommandBuffer::~CommandBuffer() {
+  if (tracer_) tracer_->OnDestroy(*this);
+}
 
 VkCommandBuffer CommandBuffer::command_buffer() const {
   return command_buffer_;
 }
 
+VkCommandBufferLevel CommandBuffer::level() const { return level_; }
+
 absl::Status CommandBuffer::Begin() {
+  // Secondary command buffers must specify inheritance info even if they are
+  // only used for compute outside of render passes.
+  VkCommandBufferInheritanceInfo inheritance_info = {};
+  inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritance_info.pNext = nullptr;
+  inheritance_info.renderPass = VK_NULL_HANDLE;
+  inheritance_info.subpass = 0;
+  inheritance_info.framebuffer = VK_NULL_HANDLE;
+  inheritance_info.occlusionQueryEnable = VK_FALSE;
+  inheritance_info.queryFlags = 0;
+  inheritance_info.pipelineStatistics = 0;
+
   VkCommandBufferBeginInfo begin_info = {};
   begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
   begin_info.pNext = nullptr;
   begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-  begin_info.pInheritanceInfo = nullptr;
-  return VkResultToStatus(
-      symbols_.vkBeginCommandBuffer(command_buffer_, &begin_info));
+  begin_info.pInheritanceInfo =
+      level_ == VK_COMMAND_BUFFER_LEVEL_SECONDARY ? &inheritance_info : nullptr;
+  UVKC_RETURN_IF_ERROR(VkResultToStatus(
+      symbols_.vkBeginCommandBuffer(command_buffer_, &begin_info)));
+  if (tracer_) tracer_->OnBegin(this);
+  return absl::OkStatus();
 }
 
 absl::Status CommandBuffer::End() {
+  if (tracer_) tracer_->OnEnd(this);
   return VkResultToStatus(symbols_.vkEndCommandBuffer(command_buffer_));
 }
 
@@ -67,6 +96,12 @@ void CommandBuffer::CopyBuffer(const Buffer &src_buffer, size_t src_offset,
                            /*regionCount=*/1, &region);
 }
 
+void CommandBuffer::FillBuffer(const Buffer &dst_buffer, size_t dst_offset,
+                               size_t length, uint32_t data) {
+  symbols_.vkCmdFillBuffer(command_buffer_, dst_buffer.buffer(), dst_offset,
+                           length, data);
+}
+
 void CommandBuffer::CopyBufferToImage(const Buffer &src_buffer,
                                       size_t src_offset, const Image &dst_image,
                                       VkExtent3D image_dimensions) {
@@ -183,6 +218,12 @@ void CommandBuffer::ResetQueryPool(const TimestampQueryPool &query_pool) {
                                /*queryCount=*/query_pool.query_count());
 }
 
+void CommandBuffer::ResetQueryPool(const TimestampQueryPool &query_pool,
+                                   uint32_t first_query, uint32_t query_count) {
+  symbols_.vkCmdResetQueryPool(command_buffer_, query_pool.query_pool(),
+                               first_query, query_count);
+}
+
 void CommandBuffer::WriteTimestamp(const TimestampQueryPool &query_pool,
                                    VkPipelineStageFlagBits pipeline_stage,
                                    uint32_t query_index) {
@@ -190,20 +231,177 @@ void CommandBuffer::WriteTimestamp(const TimestampQueryPool &query_pool,
                                query_pool.query_pool(), query_index);
 }
 
+void CommandBuffer::ResetQueryPool(
+    const PipelineStatisticsQueryPool &query_pool) {
+  symbols_.vkCmdResetQueryPool(command_buffer_, query_pool.query_pool(),
+                               /*firstQuery=*/0,
+                               /*queryCount=*/query_pool.query_count());
+}
+
+void CommandBuffer::BeginQuery(const PipelineStatisticsQueryPool &query_pool,
+                               uint32_t query_index) {
+  symbols_.vkCmdBeginQuery(command_buffer_, query_pool.query_pool(),
+                           query_index, /*flags=*/0);
+}
+
+void CommandBuffer::EndQuery(const PipelineStatisticsQueryPool &query_pool,
+                             uint32_t query_index) {
+  symbols_.vkCmdEndQuery(command_buffer_, query_pool.query_pool(),
+                         query_index);
+}
+
+void CommandBuffer::BeginQuery(const PerformanceQueryPool &query_pool,
+                               uint32_t query_index) {
+  symbols_.vkCmdBeginQuery(command_buffer_, query_pool.query_pool(),
+                           query_index, /*flags=*/0);
+}
+
+void CommandBuffer::EndQuery(const PerformanceQueryPool &query_pool,
+                             uint32_t query_index) {
+  symbols_.vkCmdEndQuery(command_buffer_, query_pool.query_pool(),
+                         query_index);
+}
+
 void CommandBuffer::Dispatch(uint32_t x, uint32_t y, uint32_t z) {
+  if (tracer_) tracer_->OnBeforeDispatch(this);
   symbols_.vkCmdDispatch(command_buffer_, x, y, z);
+  if (tracer_) tracer_->OnAfterDispatch(this);
 }
 
-void CommandBuffer::DispatchBarrier() {
+void CommandBuffer::DispatchIndirect(const Buffer &buffer, size_t offset) {
+  if (tracer_) tracer_->OnBeforeDispatch(this);
+  symbols_.vkCmdDispatchIndirect(command_buffer_, buffer.buffer(), offset);
+  if (tracer_) tracer_->OnAfterDispatch(this);
+}
+
+void CommandBuffer::ExecuteCommands(
+    absl::Span<const CommandBuffer *const> secondary_command_buffers) {
+  absl::InlinedVector<VkCommandBuffer, 8> command_buffers;
+  command_buffers.reserve(secondary_command_buffers.size());
+  for (const CommandBuffer *command_buffer : secondary_command_buffers) {
+    command_buffers.push_back(command_buffer->command_buffer());
+  }
+  symbols_.vkCmdExecuteCommands(command_buffer_, command_buffers.size(),
+                                command_buffers.data());
+}
+
+void CommandBuffer::PipelineBarrier(VkPipelineStageFlags src_stage_mask,
+                                    VkAccessFlags src_access_mask,
+                                    VkPipelineStageFlags dst_stage_mask,
+                                    VkAccessFlags dst_access_mask) {
+  // The legacy stage and access bits have the same values in the 64-bit
+  // synchronization2 flags, so they can be passed through as-is.
+  if (use_synchronization2_) {
+    VkMemoryBarrier2KHR barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+    barrier.pNext = nullptr;
+    barrier.srcStageMask = src_stage_mask;
+    barrier.srcAccessMask = src_access_mask;
+    barrier.dstStageMask = dst_stage_mask;
+    barrier.dstAccessMask = dst_access_mask;
+
+    VkDependencyInfoKHR dependency_info = {};
+    dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+    dependency_info.pNext = nullptr;
+    dependency_info.dependencyFlags = 0;
+    dependency_info.memoryBarrierCount = 1;
+    dependency_info.pMemoryBarriers = &barrier;
+    dependency_info.bufferMemoryBarrierCount = 0;
+    dependency_info.pBufferMemoryBarriers = nullptr;
+    dependency_info.imageMemoryBarrierCount = 0;
+    dependency_info.pImageMemoryBarriers = nullptr;
+    symbols_.vkCmdPipelineBarrier2KHR(command_buffer_, &dependency_info);
+    return;
+  }
+
   VkMemoryBarrier barrier = {};
   barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
-  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.srcAccessMask = src_access_mask;
+  barrier.dstAccessMask = dst_access_mask;
+
+  symbols_.vkCmdPipelineBarrier(command_buffer_, src_stage_mask,
+                                dst_stage_mask, 0, 1, &barrier, 0, nullptr, 0,
+                                nullptr);
+}
+
+void CommandBuffer::PipelineBarrier(
+    VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask,
+    absl::Span<const BufferBarrier> buffer_barriers) {
+  if (use_synchronization2_) {
+    absl::InlinedVector<VkBufferMemoryBarrier2KHR, 4> barriers(
+        buffer_barriers.size());
+    for (int i = 0; i < buffer_barriers.size(); ++i) {
+      VkBufferMemoryBarrier2KHR &barrier = barriers[i];
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+      barrier.pNext = nullptr;
+      barrier.srcStageMask = src_stage_mask;
+      barrier.srcAccessMask = buffer_barriers[i].src_access_mask;
+      barrier.dstStageMask = dst_stage_mask;
+      barrier.dstAccessMask = buffer_barriers[i].dst_access_mask;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.buffer = buffer_barriers[i].buffer->buffer();
+      barrier.offset = buffer_barriers[i].offset;
+      barrier.size = buffer_barriers[i].size;
+    }
+
+    VkDependencyInfoKHR dependency_info = {};
+    dependency_info.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+    dependency_info.pNext = nullptr;
+    dependency_info.dependencyFlags = 0;
+    dependency_info.memoryBarrierCount = 0;
+    dependency_info.pMemoryBarriers = nullptr;
+    dependency_info.bufferMemoryBarrierCount = barriers.size();
+    dependency_info.pBufferMemoryBarriers = barriers.data();
+    dependency_info.imageMemoryBarrierCount = 0;
+    dependency_info.pImageMemoryBarriers = nullptr;
+    symbols_.vkCmdPipelineBarrier2KHR(command_buffer_, &dependency_info);
+    return;
+  }
+
+  absl::InlinedVector<VkBufferMemoryBarrier, 4> barriers(
+      buffer_barriers.size());
+  for (int i = 0; i < buffer_barriers.size(); ++i) {
+    VkBufferMemoryBarrier &barrier = barriers[i];
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = buffer_barriers[i].src_access_mask;
+    barrier.dstAccessMask = buffer_barriers[i].dst_access_mask;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer_barriers[i].buffer->buffer();
+    barrier.offset = buffer_barriers[i].offset;
+    barrier.size = buffer_barriers[i].size;
+  }
+
+  symbols_.vkCmdPipelineBarrier(command_buffer_, src_stage_mask,
+                                dst_stage_mask, /*dependencyFlags=*/0,
+                                /*memoryBarrierCount=*/0, nullptr,
+                                barriers.size(), barriers.data(),
+                                /*imageMemoryBarrierCount=*/0, nullptr);
+}
+
+void CommandBuffer::DispatchBarrier() {
+  PipelineBarrier(
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+}
+
+void CommandBuffer::DispatchBarrier(const Buffer &buffer, size_t offset,
+                                    size_t size) {
+  BufferBarrier barrier = {&buffer, offset, size, VK_ACCESS_SHADER_WRITE_BIT,
+                           VK_ACCESS_SHADER_READ_BIT};
+  PipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {barrier});
+}
 
-  symbols_.vkCmdPipelineBarrier(command_buffer_,
-                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
-                                &barrier, 0, nullptr, 0, nullptr);
+void CommandBuffer::DispatchIndirectBarrier() {
+  PipelineBarrier(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_SHADER_WRITE_BIT,
+                  VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_INDIRECT_COMMAND_READ_BIT |
+                      VK_ACCESS_SHADER_READ_BIT);
 }
 
 }  // namespace vulkan
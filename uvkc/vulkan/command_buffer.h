@@ -22,23 +22,59 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "uvkc/vulkan/buffer.h"
 #include "uvkc/vulkan/dynamic_symbols.h"
 #include "uvkc/vulkan/image.h"
+#include "uvkc/vulkan/performance_query_pool.h"
 #include "uvkc/vulkan/pipeline.h"
+#include "uvkc/vulkan/pipeline_statistics_query_pool.h"
 #include "uvkc/vulkan/timestamp_query_pool.h"
 
 namespace uvkc {
 namespace vulkan {
 
+class CommandBuffer;
+
+// An interface for observing how command buffers are recorded and submitted,
+// e.g., to export a timeline. Hooks are called on the thread doing the
+// recording or submission.
+class CommandTracer {
+ public:
+  virtual ~CommandTracer() = default;
+
+  // Called right after |command_buffer| begins recording.
+  virtual void OnBegin(CommandBuffer *command_buffer) = 0;
+  // Called right before |command_buffer| ends recording.
+  virtual void OnEnd(CommandBuffer *command_buffer) = 0;
+
+  // Called right before and after a dispatch command is recorded into
+  // |command_buffer|. Tracers may record extra commands, e.g., timestamps.
+  virtual void OnBeforeDispatch(CommandBuffer *command_buffer) = 0;
+  virtual void OnAfterDispatch(CommandBuffer *command_buffer) = 0;
+
+  // Called right before |command_buffer| is submitted to the queue, right
+  // before waiting for it, and after the wait returns.
+  virtual void OnSubmit(const CommandBuffer &command_buffer) = 0;
+  virtual void OnWait(const CommandBuffer &command_buffer) = 0;
+  virtual void OnWaitDone(const CommandBuffer &command_buffer) = 0;
+
+  // Called when |command_buffer| is destroyed, so that tracers can release
+  // any state kept for it.
+  virtual void OnDestroy(const CommandBuffer &command_buffer) {}
+};
+
 // A class representing a Vulkan command buffer.
 //
 // Objects from this class do not reset the Vulkan command buffers at
 // destruction time; the pool is expected to release them all together.
 class CommandBuffer {
  public:
-  // Wraps a |command_buffer| from |device|.
+  // Wraps a |command_buffer| of the given |level| from |device|. If
+  // |use_synchronization2| is true, barriers are recorded via
+  // VK_KHR_synchronization2, which must be enabled on |device|.
   CommandBuffer(VkDevice device, VkCommandBuffer command_buffer,
+                VkCommandBufferLevel level, bool use_synchronization2,
                 const DynamicSymbols &symbols);
 
   ~CommandBuffer();
@@ -46,7 +82,22 @@ class CommandBuffer {
   // Returns the VkCommandBuffer handle.
   VkCommandBuffer command_buffer() const;
 
-  // Begins command buffer recording.
+  // Returns whether this is a primary or secondary command buffer.
+  VkCommandBufferLevel level() const;
+
+  // Sets the |tracer| notified of commands recorded into this command buffer.
+  // |tracer| may be nullptr to disable tracing.
+  void set_tracer(CommandTracer *tracer) { tracer_ = tracer; }
+  CommandTracer *tracer() const { return tracer_; }
+
+  // Marks whether this command buffer holds the work a benchmark measures,
+  // as opposed to setup, verification, or overhead sampling. Tracers may
+  // only observe measured command buffers.
+  void set_measured(bool measured) { measured_ = measured; }
+  bool measured() const { return measured_; }
+
+  // Begins command buffer recording. Secondary command buffers are begun
+  // outside of any render pass.
   absl::Status Begin();
 
   // Ends command buffer recording.
@@ -59,6 +110,14 @@ class CommandBuffer {
   void CopyBuffer(const Buffer &src_buffer, size_t src_offset,
                   const Buffer &dst_buffer, size_t dst_offset, size_t length);
 
+  // Records a command to fill |length| bytes of |dst_buffer| starting at
+  // |dst_offset| with the 32-bit |data| pattern. Both |dst_offset| and |length|
+  // must be multiples of 4; |length| may also be VK_WHOLE_SIZE to fill till the
+  // end of the buffer. |dst_buffer| is expected to have
+  // VK_BUFFER_USAGE_TRANSFER_DST_BIT bit.
+  void FillBuffer(const Buffer &dst_buffer, size_t dst_offset, size_t length,
+                  uint32_t data);
+
   // Records a command to copy the tightly packed data starting at |src_offset|
   // of the |src_buffer| to |dst_image|. The |dst_image| should be of
   // VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL.
@@ -92,24 +151,102 @@ class CommandBuffer {
   // Records a command to reset the given timestamp |query_pool|.
   void ResetQueryPool(const TimestampQueryPool &query_pool);
 
+  // Records a command to reset |query_count| queries starting from
+  // |first_query| in the given timestamp |query_pool|.
+  void ResetQueryPool(const TimestampQueryPool &query_pool,
+                      uint32_t first_query, uint32_t query_count);
+
   // Records a command to write the timestamp at the given |pipeline_stage| to
   // the query with |query_index| in the |query_pool|.
   void WriteTimestamp(const TimestampQueryPool &query_pool,
                       VkPipelineStageFlagBits pipeline_stage,
                       uint32_t query_index);
 
+  // Records a command to reset the given pipeline statistics |query_pool|.
+  void ResetQueryPool(const PipelineStatisticsQueryPool &query_pool);
+
+  // Records commands to begin and end the query with |query_index| in the
+  // pipeline statistics |query_pool|. The query counts the work of all
+  // commands recorded in between.
+  void BeginQuery(const PipelineStatisticsQueryPool &query_pool,
+                  uint32_t query_index);
+  void EndQuery(const PipelineStatisticsQueryPool &query_pool,
+                uint32_t query_index);
+
+  // Records commands to begin and end the query with |query_index| in the
+  // performance |query_pool|, sampling hardware counters over all commands
+  // recorded in between.
+  void BeginQuery(const PerformanceQueryPool &query_pool, uint32_t query_index);
+  void EndQuery(const PerformanceQueryPool &query_pool, uint32_t query_index);
+
   // Records a dispatch command.
   void Dispatch(uint32_t x, uint32_t y, uint32_t z);
 
+  // Records an indirect dispatch command that reads the workgroup counts from
+  // a VkDispatchIndirectCommand at |offset| in |buffer|. |buffer| is expected
+  // to have VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT bit.
+  void DispatchIndirect(const Buffer &buffer, size_t offset);
+
+  // Records a command to execute the already recorded
+  // |secondary_command_buffers| in order. This must be a primary command
+  // buffer. Pipeline state bound in this command buffer is not inherited by
+  // the secondary command buffers, and is undefined after this command.
+  void ExecuteCommands(
+      absl::Span<const CommandBuffer *const> secondary_command_buffers);
+
+  // Records a pipeline barrier with a global memory barrier that makes
+  // |src_access_mask| accesses from |src_stage_mask| available and visible to
+  // |dst_access_mask| accesses from |dst_stage_mask|.
+  void PipelineBarrier(VkPipelineStageFlags src_stage_mask,
+                       VkAccessFlags src_access_mask,
+                       VkPipelineStageFlags dst_stage_mask,
+                       VkAccessFlags dst_access_mask);
+
+  // A range of |size| bytes starting at |offset| in |buffer| and the accesses
+  // to it that should be synchronized. |size| may be VK_WHOLE_SIZE to cover
+  // till the end of the buffer.
+  struct BufferBarrier {
+    const Buffer *buffer;
+    size_t offset;
+    size_t size;
+    VkAccessFlags src_access_mask;
+    VkAccessFlags dst_access_mask;
+  };
+
+  // Records a pipeline barrier from |src_stage_mask| to |dst_stage_mask| with
+  // one buffer memory barrier per entry in |buffer_barriers|. Unlike the global
+  // barrier above, other buffers are not affected.
+  void PipelineBarrier(VkPipelineStageFlags src_stage_mask,
+                       VkPipelineStageFlags dst_stage_mask,
+                       absl::Span<const BufferBarrier> buffer_barriers);
+
   // Records a pipeline barrier that synchronizes shader read from a compute
   // shader with shader write from a previous compute shader.
   void DispatchBarrier();
 
+  // Records a pipeline barrier that synchronizes shader read from a compute
+  // shader with shader write from a previous compute shader, only for the
+  // |size| bytes starting at |offset| in |buffer|.
+  void DispatchBarrier(const Buffer &buffer, size_t offset = 0,
+                       size_t size = VK_WHOLE_SIZE);
+
+  // Records a pipeline barrier that synchronizes indirect command read and
+  // shader read from a compute shader with shader write from a previous compute
+  // shader.
+  void DispatchIndirectBarrier();
+
  private:
   VkCommandBuffer command_buffer_;
 
+  VkCommandBufferLevel level_;
+
   VkDevice device_;
 
+  bool use_synchronization2_;
+
+  CommandTracer *tracer_;
+  bool measured_;
+
   const DynamicSymbols &symbols_;
 };
 
@@ -0,0 +1,76 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/vulkan/command_pool.h"
+
+#include "absl/memory/memory.h"
+#include "uvkc/vulkan/status_util.h"
+
+namespace uvkc {
+namespace vulkan {
+
+absl::StatusOr<std::unique_ptr<CommandPool>> CommandPool::Create(
+    VkDevice device, uint32_t queue_family_index, bool use_synchronization2,
+    const DynamicSymbols &symbols) {
+  VkCommandPoolCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+  create_info.pNext = nullptr;
+  create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+  create_info.queueFamilyIndex = queue_family_index;
+
+  VkCommandPool pool = VK_NULL_HANDLE;
+  VK_RETURN_IF_ERROR(symbols.vkCreateCommandPool(
+      device, &create_info, /*pAllocator=*/nullptr, &pool));
+
+  return absl::WrapUnique(
+      new CommandPool(pool, device, use_synchronization2, symbols));
+}
+
+CommandPool::~CommandPool() {
+  symbols_.vkDestroyCommandPool(device_, pool_, /*pAllocator=*/nullptr);
+}
+
+VkCommandPool CommandPool::command_pool() const { return pool_; }
+
+absl::StatusOr<std::unique_ptr<CommandBuffer>>
+CommandPool::AllocateCommandBuffer(VkCommandBufferLevel level) {
+  VkCommandBufferAllocateInfo allocate_info = {};
+  allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+  allocate_info.pNext = nullptr;
+  allocate_info.commandPool = pool_;
+  allocate_info.level = level;
+  allocate_info.commandBufferCount = 1;
+
+  VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+  VK_RETURN_IF_ERROR(symbols_.vkAllocateCommandBuffers(device_, &allocate_info,
+                                                       &command_buffer));
+  return std::make_unique<CommandBuffer>(device_, command_buffer, level,
+                                         use_synchronization2_, symbols_);
+}
+
+absl::Status CommandPool::Reset() {
+  return VkResultToStatus(symbols_.vkResetCommandPool(
+      device_, pool_, VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT));
+}
+
+CommandPool::CommandPool(VkCommandPool pool, VkDevice device,
+                         bool use_synchronization2,
+                         const DynamicSymbols &symbols)
+    : pool_(pool),
+      device_(device),
+      use_synchronization2_(use_synchronization2),
+      symbols_(symbols) {}
+
+}  // namespace vulkan
+}  // namespace uvkc
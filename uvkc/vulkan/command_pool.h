@@ -0,0 +1,73 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_VULKAN_COMMAND_POOL_H_
+#define UVKC_VULKAN_COMMAND_POOL_H_
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/dynamic_symbols.h"
+
+namespace uvkc {
+namespace vulkan {
+
+// A class representing a Vulkan command pool.
+//
+// Command pools are externally synchronized in Vulkan: command buffers that are
+// recorded concurrently on different threads must be allocated from different
+// pools.
+class CommandPool {
+ public:
+  // Creates a command pool for queues of |queue_family_index| from |device|.
+  // Command buffers allocated from it record barriers via
+  // VK_KHR_synchronization2 if |use_synchronization2| is true.
+  static absl::StatusOr<std::unique_ptr<CommandPool>> Create(
+      VkDevice device, uint32_t queue_family_index, bool use_synchronization2,
+      const DynamicSymbols &symbols);
+
+  ~CommandPool();
+
+  // Returns the VkCommandPool handle.
+  VkCommandPool command_pool() const;
+
+  // Allocates a command buffer of the given |level|.
+  absl::StatusOr<std::unique_ptr<CommandBuffer>> AllocateCommandBuffer(
+      VkCommandBufferLevel level);
+
+  // Resets the pool and recycles all the sources from all the command buffers
+  // allocated from it thus far.
+  absl::Status Reset();
+
+ private:
+  CommandPool(VkCommandPool pool, VkDevice device, bool use_synchronization2,
+              const DynamicSymbols &symbols);
+
+  VkCommandPool pool_;
+
+  VkDevice device_;
+
+  bool use_synchronization2_;
+
+  const DynamicSymbols &symbols_;
+};
+
+}  // namespace vulkan
+}  // namespace uvkc
+
+#endif  // UVKC_VULKAN_COMMAND_POOL_H_
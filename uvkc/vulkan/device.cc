@@ -16,9 +16,11 @@
 
 #include <cstdint>
 #include <memory>
+#include <utility>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "uvkc/base/status.h"
 #include "uvkc/vulkan/image.h"
 #include "uvkc/vulkan/status_util.h"
@@ -29,26 +31,24 @@ namespace vulkan {
 
 absl::StatusOr<std::unique_ptr<Device>> Device::Create(
     VkPhysicalDevice physical_device, uint32_t queue_family_index,
-    uint32_t valid_timestamp_bits, uint32_t nanoseconds_per_timestamp_value,
-    VkDevice device, const DynamicSymbols &symbols) {
-  VkCommandPoolCreateInfo create_info = {};
-  create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-  create_info.pNext = nullptr;
-  create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-  create_info.queueFamilyIndex = queue_family_index;
-
-  VkCommandPool command_pool = VK_NULL_HANDLE;
-  VK_RETURN_IF_ERROR(symbols.vkCreateCommandPool(
-      device, &create_info, /*pAllocator=*/nullptr, &command_pool));
+    uint32_t valid_timestamp_bits, float nanoseconds_per_timestamp_value,
+    const OptionalFeatures &optional_features, VkDevice device,
+    const DynamicSymbols &symbols) {
+  UVKC_ASSIGN_OR_RETURN(
+      auto command_pool,
+      CommandPool::Create(device, queue_family_index,
+                          optional_features.synchronization2, symbols));
 
   return absl::WrapUnique(new Device(
       device, physical_device, queue_family_index, valid_timestamp_bits,
-      nanoseconds_per_timestamp_value, command_pool, symbols));
+      nanoseconds_per_timestamp_value, optional_features,
+      std::move(command_pool), symbols));
 }
 
 Device::~Device() {
   symbols_.vkDeviceWaitIdle(device_);
-  symbols_.vkDestroyCommandPool(device_, command_pool_, /*pAllocator=*/nullptr);
+  // The command pool must be destroyed before the device.
+  command_pool_.reset();
   symbols_.vkDestroyDevice(device_, /*pAllocator=*/nullptr);
 }
 
@@ -179,7 +179,50 @@ absl::StatusOr<std::unique_ptr<Pipeline>> Device::CreatePipeline(
     const ShaderModule &shader_module, const char *entry_point,
     absl::Span<Pipeline::SpecConstant> spec_constants) {
   return Pipeline::Create(device_, shader_module, entry_point, spec_constants,
-                          symbols_);
+                          /*subgroup_size_control=*/{0, false}, symbols_);
+}
+
+absl::StatusOr<std::unique_ptr<Pipeline>> Device::CreatePipeline(
+    const ShaderModule &shader_module, const char *entry_point,
+    absl::Span<Pipeline::SpecConstant> spec_constants,
+    const Pipeline::SubgroupSizeControl &subgroup_size_control) {
+  const uint32_t required_size = subgroup_size_control.required_size;
+  if ((required_size != 0 || subgroup_size_control.require_full_subgroups) &&
+      !optional_features_.subgroup_size_control) {
+    return absl::UnimplementedError(
+        "subgroup size control is not supported by the device");
+  }
+  if (required_size != 0 &&
+      ((required_size & (required_size - 1)) != 0 ||
+       required_size < optional_features_.min_subgroup_size ||
+       required_size > optional_features_.max_subgroup_size)) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "required subgroup size ", required_size, " is not a power of two in [",
+        optional_features_.min_subgroup_size, ", ",
+        optional_features_.max_subgroup_size, "]"));
+  }
+  if (subgroup_size_control.require_full_subgroups &&
+      !optional_features_.compute_full_subgroups) {
+    return absl::UnimplementedError(
+        "requiring full subgroups is not supported by the device");
+  }
+  return Pipeline::Create(device_, shader_module, entry_point, spec_constants,
+                          subgroup_size_control, symbols_);
+}
+
+std::vector<uint32_t> Device::OptionalFeatures::GetRequirableSubgroupSizes()
+    const {
+  std::vector<uint32_t> sizes;
+  if (!subgroup_size_control) return sizes;
+  for (uint32_t size = min_subgroup_size; size <= max_subgroup_size;
+       size *= 2) {
+    sizes.push_back(size);
+  }
+  return sizes;
+}
+
+std::vector<uint32_t> Device::GetRequirableSubgroupSizes() const {
+  return optional_features_.GetRequirableSubgroupSizes();
 }
 
 absl::StatusOr<std::unique_ptr<DescriptorPool>> Device::CreateDescriptorPool(
@@ -271,22 +314,18 @@ absl::Status Device::AttachImageToDescriptor(
 }
 
 absl::StatusOr<std::unique_ptr<CommandBuffer>> Device::AllocateCommandBuffer() {
-  VkCommandBufferAllocateInfo allocate_info = {};
-  allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  allocate_info.pNext = nullptr;
-  allocate_info.commandPool = command_pool_;
-  allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocate_info.commandBufferCount = 1;
-
-  VkCommandBuffer command_buffer = VK_NULL_HANDLE;
-  VK_RETURN_IF_ERROR(symbols_.vkAllocateCommandBuffers(device_, &allocate_info,
-                                                       &command_buffer));
-  return std::make_unique<CommandBuffer>(device_, command_buffer, symbols_);
+  UVKC_ASSIGN_OR_RETURN(
+      auto command_buffer,
+      command_pool_->AllocateCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY));
+  command_buffer->set_tracer(tracer_);
+  return command_buffer;
 }
 
-absl::Status Device::ResetCommandPool() {
-  return VkResultToStatus(symbols_.vkResetCommandPool(
-      device_, command_pool_, VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT));
+absl::Status Device::ResetCommandPool() { return command_pool_->Reset(); }
+
+absl::StatusOr<std::unique_ptr<CommandPool>> Device::CreateCommandPool() {
+  return CommandPool::Create(device_, queue_family_index_,
+                             optional_features_.synchronization2, symbols_);
 }
 
 absl::StatusOr<std::unique_ptr<TimestampQueryPool>>
@@ -296,6 +335,112 @@ Device::CreateTimestampQueryPool(uint32_t query_count) {
                                     query_count, symbols_);
 }
 
+absl::StatusOr<std::unique_ptr<PipelineStatisticsQueryPool>>
+Device::CreatePipelineStatisticsQueryPool(uint32_t query_count) {
+  if (!optional_features_.pipeline_statistics_query) {
+    return absl::UnimplementedError(
+        "pipeline statistics queries are not supported by the device");
+  }
+  return PipelineStatisticsQueryPool::Create(device_, query_count, symbols_);
+}
+
+absl::StatusOr<std::vector<PerformanceCounter>>
+Device::EnumeratePerformanceCounters() {
+  if (!optional_features_.performance_query) {
+    return absl::UnimplementedError(
+        "performance queries are not supported by the device");
+  }
+
+  uint32_t count = 0;
+  VK_RETURN_IF_ERROR(
+      symbols_.vkEnumeratePhysicalDeviceQueueFamilyPerformanceQueryCountersKHR(
+          physical_device_, queue_family_index_, &count,
+          /*pCounters=*/nullptr, /*pCounterDescriptions=*/nullptr));
+
+  std::vector<VkPerformanceCounterKHR> vk_counters(count);
+  std::vector<VkPerformanceCounterDescriptionKHR> descriptions(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    vk_counters[i].sType = VK_STRUCTURE_TYPE_PERFORMANCE_COUNTER_KHR;
+    vk_counters[i].pNext = nullptr;
+    descriptions[i].sType =
+        VK_STRUCTURE_TYPE_PERFORMANCE_COUNTER_DESCRIPTION_KHR;
+    descriptions[i].pNext = nullptr;
+  }
+  VK_RETURN_IF_ERROR(
+      symbols_.vkEnumeratePhysicalDeviceQueueFamilyPerformanceQueryCountersKHR(
+          physical_device_, queue_family_index_, &count, vk_counters.data(),
+          descriptions.data()));
+
+  std::vector<PerformanceCounter> counters;
+  counters.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    counters.push_back({i, descriptions[i].name, descriptions[i].category,
+                        descriptions[i].description, vk_counters[i].unit,
+                        vk_counters[i].storage});
+  }
+  return counters;
+}
+
+absl::StatusOr<std::unique_ptr<PerformanceQueryPool>>
+Device::CreatePerformanceQueryPool(
+    absl::Span<const PerformanceCounter> counters, uint32_t query_count) {
+  if (!optional_features_.performance_query) {
+    return absl::UnimplementedError(
+        "performance queries are not supported by the device");
+  }
+  return PerformanceQueryPool::Create(device_, physical_device_,
+                                      queue_family_index_, counters,
+                                      query_count, symbols_);
+}
+
+absl::Status Device::AcquireProfilingLock() {
+  if (!optional_features_.performance_query) {
+    return absl::UnimplementedError(
+        "performance queries are not supported by the device");
+  }
+
+  VkAcquireProfilingLockInfoKHR lock_info = {};
+  lock_info.sType = VK_STRUCTURE_TYPE_ACQUIRE_PROFILING_LOCK_INFO_KHR;
+  lock_info.pNext = nullptr;
+  lock_info.flags = 0;
+  lock_info.timeout = UINT64_MAX;
+  VK_RETURN_IF_ERROR(symbols_.vkAcquireProfilingLockKHR(device_, &lock_info));
+  return absl::OkStatus();
+}
+
+void Device::ReleaseProfilingLock() {
+  if (optional_features_.performance_query) {
+    symbols_.vkReleaseProfilingLockKHR(device_);
+  }
+}
+
+absl::StatusOr<CalibratedTimestamps> Device::SampleCalibratedTimestamps() {
+  if (!optional_features_.calibrated_timestamps) {
+    return absl::UnimplementedError(
+        "calibrated timestamps are not supported by the device");
+  }
+
+  VkCalibratedTimestampInfoEXT infos[2] = {};
+  infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+  infos[0].pNext = nullptr;
+  infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+  infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+  infos[1].pNext = nullptr;
+  infos[1].timeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+
+  uint64_t timestamps[2] = {};
+  uint64_t max_deviation = 0;
+  VK_RETURN_IF_ERROR(symbols_.vkGetCalibratedTimestampsEXT(
+      device_, /*timestampCount=*/2, infos, timestamps, &max_deviation));
+
+  CalibratedTimestamps calibration = {};
+  calibration.device_timestamp = timestamps[0];
+  // CLOCK_MONOTONIC values are in nanoseconds.
+  calibration.host_nanoseconds = static_cast<int64_t>(timestamps[1]);
+  calibration.max_deviation_nanoseconds = max_deviation;
+  return calibration;
+}
+
 absl::Status Device::QueueSubmitAndWait(const CommandBuffer &command_buffer) {
   VkFenceCreateInfo fence_create_info = {};
   fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
@@ -312,11 +457,15 @@ absl::Status Device::QueueSubmitAndWait(const CommandBuffer &command_buffer) {
   submit_info.commandBufferCount = 1;
   submit_info.pCommandBuffers = &cmdbuf;
 
+  CommandTracer *tracer = command_buffer.tracer();
+  if (tracer) tracer->OnSubmit(command_buffer);
   VK_RETURN_IF_ERROR(symbols_.vkQueueSubmit(queue_, 1, &submit_info, fence));
 
+  if (tracer) tracer->OnWait(command_buffer);
   VK_RETURN_IF_ERROR(symbols_.vkWaitForFences(device_, /*fenceCount=*/1, &fence,
                                               /*waitAll=*/true,
                                               /*timeout=*/UINT64_MAX));
+  if (tracer) tracer->OnWaitDone(command_buffer);
 
   symbols_.vkDestroyFence(device_, fence, /*pAllocator=*/nullptr);
   return absl::OkStatus();
@@ -324,8 +473,10 @@ absl::Status Device::QueueSubmitAndWait(const CommandBuffer &command_buffer) {
 
 Device::Device(VkDevice device, VkPhysicalDevice physical_device,
                uint32_t queue_family_index, uint32_t valid_timestamp_bits,
-               uint32_t nanoseconds_per_timestamp_value,
-               VkCommandPool command_pool, const DynamicSymbols &symbols)
+               float nanoseconds_per_timestamp_value,
+               const OptionalFeatures &optional_features,
+               std::unique_ptr<CommandPool> command_pool,
+               const DynamicSymbols &symbols)
     : device_(device),
       physical_device_(physical_device),
       memory_properties_(),
@@ -333,7 +484,9 @@ Device::Device(VkDevice device, VkPhysicalDevice physical_device,
       queue_family_index_(queue_family_index),
       valid_timestamp_bits_(valid_timestamp_bits),
       nanoseconds_per_timestamp_value_(nanoseconds_per_timestamp_value),
-      command_pool_(command_pool),
+      optional_features_(optional_features),
+      tracer_(nullptr),
+      command_pool_(std::move(command_pool)),
       symbols_(symbols) {
   symbols_.vkGetPhysicalDeviceMemoryProperties(physical_device_,
                                                &memory_properties_);
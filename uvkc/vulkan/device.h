@@ -19,15 +19,20 @@
 
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "uvkc/vulkan/buffer.h"
 #include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/command_pool.h"
 #include "uvkc/vulkan/descriptor_pool.h"
 #include "uvkc/vulkan/dynamic_symbols.h"
 #include "uvkc/vulkan/image.h"
+#include "uvkc/vulkan/performance_query_pool.h"
 #include "uvkc/vulkan/pipeline.h"
+#include "uvkc/vulkan/pipeline_statistics_query_pool.h"
 #include "uvkc/vulkan/shader_module.h"
 #include "uvkc/vulkan/timestamp_query_pool.h"
 
@@ -43,14 +48,45 @@ namespace vulkan {
 // individually.
 class Device {
  public:
+  // Optional extensions and features that were enabled on the logical device.
+  struct OptionalFeatures {
+    // VK_KHR_synchronization2 with the synchronization2 feature.
+    bool synchronization2 = false;
+    // VK_EXT_subgroup_size_control with the subgroupSizeControl feature for
+    // compute shaders, and the range of subgroup sizes that can be required.
+    bool subgroup_size_control = false;
+    uint32_t min_subgroup_size = 0;
+    uint32_t max_subgroup_size = 0;
+    // The computeFullSubgroups feature of VK_EXT_subgroup_size_control.
+    bool compute_full_subgroups = false;
+    // VK_EXT_calibrated_timestamps with both the device time domain and the
+    // host CLOCK_MONOTONIC time domain, which backs std::chrono::steady_clock.
+    bool calibrated_timestamps = false;
+    // The pipelineStatisticsQuery core feature.
+    bool pipeline_statistics_query = false;
+    // VK_KHR_performance_query with the performanceCounterQueryPools feature,
+    // together with VK_EXT_host_query_reset for resetting its queries.
+    bool performance_query = false;
+
+    // Returns all subgroup sizes that pipelines can require, in increasing
+    // order, or an empty list if subgroup size control is not supported.
+    std::vector<uint32_t> GetRequirableSubgroupSizes() const;
+  };
+
   // Wraps a logical |device| from |physical_device| of |queue_family_index|.
   static absl::StatusOr<std::unique_ptr<Device>> Create(
       VkPhysicalDevice physical_device, uint32_t queue_family_index,
-      uint32_t valid_timestamp_bits, uint32_t nanoseconds_per_timestamp_value,
-      VkDevice device, const DynamicSymbols &symbols);
+      uint32_t valid_timestamp_bits, float nanoseconds_per_timestamp_value,
+      const OptionalFeatures &optional_features, VkDevice device,
+      const DynamicSymbols &symbols);
 
   ~Device();
 
+  // Returns the optional features enabled on this device.
+  const OptionalFeatures &optional_features() const {
+    return optional_features_;
+  }
+
   // Creates a buffer of |size_in_bytes| for the specified usage as indicated by
   // |usage_flags| and memory properties as indicated in |memory_flags|.
   absl::StatusOr<std::unique_ptr<Buffer>> CreateBuffer(
@@ -80,6 +116,19 @@ class Device {
       const ShaderModule &shader_module, const char *entry_point,
       absl::Span<Pipeline::SpecConstant> spec_constants);
 
+  // Creates a compute pipeline like above, additionally with the given
+  // |subgroup_size_control| requirements. Returns an error if the device does
+  // not support them.
+  absl::StatusOr<std::unique_ptr<Pipeline>> CreatePipeline(
+      const ShaderModule &shader_module, const char *entry_point,
+      absl::Span<Pipeline::SpecConstant> spec_constants,
+      const Pipeline::SubgroupSizeControl &subgroup_size_control);
+
+  // Returns all subgroup sizes that pipelines can require on this device, in
+  // increasing order. Returns an empty list if subgroup size control is not
+  // supported.
+  std::vector<uint32_t> GetRequirableSubgroupSizes() const;
+
   // Creates a descriptor pool with enough resources matching the pipeline
   // layout of the given |shader_module|.
   absl::StatusOr<std::unique_ptr<DescriptorPool>> CreateDescriptorPool(
@@ -116,24 +165,65 @@ class Device {
           &layout_set_map,
       absl::Span<const BoundImage> bound_images);
 
-  // Allocates a primary command buffer.
+  // Allocates a primary command buffer. It is traced by the tracer set on this
+  // device at the time of allocation, if any.
   absl::StatusOr<std::unique_ptr<CommandBuffer>> AllocateCommandBuffer();
 
+  // Sets the |tracer| for command buffers allocated from this device and their
+  // submissions. |tracer| may be nullptr to disable tracing, and must outlive
+  // all command buffers it is set on.
+  void set_tracer(CommandTracer *tracer) { tracer_ = tracer; }
+
   // Resets the command pool and recycles all the sources from all the command
   // buffers allocated from this device thus far.
   absl::Status ResetCommandPool();
 
+  // Creates a new command pool, separate from the one used by
+  // AllocateCommandBuffer(). Each thread recording command buffers
+  // concurrently needs its own pool.
+  absl::StatusOr<std::unique_ptr<CommandPool>> CreateCommandPool();
+
   // Creates a query pool for managing |query_count| timestamp queries.
   absl::StatusOr<std::unique_ptr<TimestampQueryPool>> CreateTimestampQueryPool(
       uint32_t query_count);
 
+  // Creates a query pool for managing |query_count| pipeline statistics
+  // queries counting compute shader invocations. Returns an unimplemented
+  // error if pipeline statistics queries are not supported.
+  absl::StatusOr<std::unique_ptr<PipelineStatisticsQueryPool>>
+  CreatePipelineStatisticsQueryPool(uint32_t query_count);
+
+  // Returns the hardware performance counters available on the queue family
+  // of this device. Returns an unimplemented error if performance queries are
+  // not supported.
+  absl::StatusOr<std::vector<PerformanceCounter>>
+  EnumeratePerformanceCounters();
+
+  // Creates a query pool for managing |query_count| performance queries that
+  // sample |counters|, which must come from EnumeratePerformanceCounters().
+  absl::StatusOr<std::unique_ptr<PerformanceQueryPool>>
+  CreatePerformanceQueryPool(absl::Span<const PerformanceCounter> counters,
+                             uint32_t query_count);
+
+  // Acquires and releases the device profiling lock, which must be held while
+  // recording and executing command buffers that use performance queries.
+  absl::Status AcquireProfilingLock();
+  void ReleaseProfilingLock();
+
+  // Samples the device timestamp counter and the host steady clock at the same
+  // moment, for mapping timestamps into the host clock domain. Returns an
+  // unimplemented error if calibrated timestamps are not supported.
+  absl::StatusOr<CalibratedTimestamps> SampleCalibratedTimestamps();
+
   // Submits the given |command_buffer| to the queue.
   absl::Status QueueSubmitAndWait(const CommandBuffer &command_buffer);
 
  private:
   Device(VkDevice device, VkPhysicalDevice physical_device,
          uint32_t queue_family_index, uint32_t valid_timestamp_bits,
-         uint32_t nanoseconds_per_timestamp_value, VkCommandPool command_pool,
+         float nanoseconds_per_timestamp_value,
+         const OptionalFeatures &optional_features,
+         std::unique_ptr<CommandPool> command_pool,
          const DynamicSymbols &symbols);
 
   // Selects a memory type among |supported_memory_types| that statisfies
@@ -157,9 +247,13 @@ class Device {
   VkQueue queue_;
   uint32_t queue_family_index_;
   uint32_t valid_timestamp_bits_;
-  uint32_t nanoseconds_per_timestamp_value_;
+  float nanoseconds_per_timestamp_value_;
+
+  OptionalFeatures optional_features_;
+
+  CommandTracer *tracer_;
 
-  VkCommandPool command_pool_;
+  std::unique_ptr<CommandPool> command_pool_;
 
   const DynamicSymbols &symbols_;
 };
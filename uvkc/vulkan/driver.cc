@@ -14,11 +14,14 @@
 
 #include "uvkc/vulkan/driver.h"
 
+#include <cstring>
 #include <memory>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "uvkc/base/status.h"
 #include "uvkc/base/target_platform.h"
 #include "uvkc/vulkan/dynamic_symbols.h"
@@ -72,6 +75,227 @@ absl::StatusOr<uint32_t> SelectQueueFamily(VkPhysicalDevice physical_device,
   return absl::UnavailableError("cannot find queue family with required bits");
 }
 
+// Returns all device extensions supported by |physical_device|.
+absl::StatusOr<std::vector<VkExtensionProperties>> EnumerateDeviceExtensions(
+    VkPhysicalDevice physical_device, const DynamicSymbols &symbols) {
+  uint32_t count = 0;
+  VK_RETURN_IF_ERROR(symbols.vkEnumerateDeviceExtensionProperties(
+      physical_device, /*pLayerName=*/nullptr, &count, nullptr));
+
+  std::vector<VkExtensionProperties> extensions(count);
+  VK_RETURN_IF_ERROR(symbols.vkEnumerateDeviceExtensionProperties(
+      physical_device, /*pLayerName=*/nullptr, &count, extensions.data()));
+  return extensions;
+}
+
+bool HasExtension(absl::Span<const VkExtensionProperties> extensions,
+                  const char *name) {
+  for (const auto &extension : extensions) {
+    if (std::strcmp(extension.extensionName, name) == 0) return true;
+  }
+  return false;
+}
+
+// Returns true if |physical_device| can sample its timestamps together with
+// CLOCK_MONOTONIC via VK_EXT_calibrated_timestamps.
+bool SupportsMonotonicCalibration(VkPhysicalDevice physical_device,
+                                  const DynamicSymbols &symbols) {
+#if defined(UVKC_PLATFORM_WINDOWS) || defined(UVKC_PLATFORM_APPLE)
+  // CLOCK_MONOTONIC is unavailable there.
+  return false;
+#else
+  if (symbols.vkGetPhysicalDeviceCalibrateableTimeDomainsEXT == nullptr ||
+      symbols.vkGetCalibratedTimestampsEXT == nullptr) {
+    return false;
+  }
+
+  uint32_t count = 0;
+  if (symbols.vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+          physical_device, &count, nullptr) != VK_SUCCESS) {
+    return false;
+  }
+  std::vector<VkTimeDomainEXT> time_domains(count);
+  if (symbols.vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(
+          physical_device, &count, time_domains.data()) != VK_SUCCESS) {
+    return false;
+  }
+
+  bool has_device = false, has_monotonic = false;
+  for (VkTimeDomainEXT time_domain : time_domains) {
+    if (time_domain == VK_TIME_DOMAIN_DEVICE_EXT) has_device = true;
+    if (time_domain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT) has_monotonic = true;
+  }
+  return has_device && has_monotonic;
+#endif
+}
+
+// Optional extensions and features of a physical device that we can take
+// advantage of, together with the queue family to use and the feature structs
+// to chain into creating a logical device. Not copyable, as the chain points
+// into it.
+struct DeviceFeatureQuery {
+  DeviceFeatureQuery() = default;
+  DeviceFeatureQuery(const DeviceFeatureQuery &) = delete;
+  DeviceFeatureQuery &operator=(const DeviceFeatureQuery &) = delete;
+
+  uint32_t queue_family_index = 0;
+  uint32_t valid_timestamp_bits = 0;
+
+  VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2_features = {};
+  VkPhysicalDeviceSubgroupSizeControlFeaturesEXT
+      subgroup_size_control_features = {};
+  VkPhysicalDevicePerformanceQueryFeaturesKHR performance_query_features = {};
+  VkPhysicalDeviceHostQueryResetFeaturesEXT host_query_reset_features = {};
+
+  std::vector<const char *> enabled_extensions;
+  // Feature structs for the enabled extensions, chained into device creation.
+  void *enabled_features_chain = nullptr;
+  // Core features to enable; everything else stays off.
+  VkPhysicalDeviceFeatures enabled_features = {};
+  Device::OptionalFeatures optional_features;
+};
+
+// Selects a queue family with the required |queue_flags| in |physical_device|
+// and the optional extensions and features to enable, writing them to
+// |query|.
+absl::Status QueryDeviceFeatures(VkPhysicalDevice physical_device,
+                                 VkQueueFlags queue_flags,
+                                 const DynamicSymbols &symbols,
+                                 DeviceFeatureQuery *query) {
+  UVKC_ASSIGN_OR_RETURN(
+      query->queue_family_index,
+      SelectQueueFamily(physical_device, queue_flags,
+                        &query->valid_timestamp_bits, symbols));
+
+  // Query optional extensions and features we can take advantage of. Only
+  // structs for supported extensions are chained into the queries.
+  UVKC_ASSIGN_OR_RETURN(
+      std::vector<VkExtensionProperties> supported_extensions,
+      EnumerateDeviceExtensions(physical_device, symbols));
+  const bool has_synchronization2 = HasExtension(
+      supported_extensions, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+  const bool has_subgroup_size_control = HasExtension(
+      supported_extensions, VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME);
+  const bool has_calibrated_timestamps = HasExtension(
+      supported_extensions, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+  const bool has_performance_query =
+      HasExtension(supported_extensions,
+                   VK_KHR_PERFORMANCE_QUERY_EXTENSION_NAME) &&
+      HasExtension(supported_extensions,
+                   VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME);
+
+  query->synchronization2_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+  query->synchronization2_features.pNext = nullptr;
+
+  query->subgroup_size_control_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_FEATURES_EXT;
+  query->subgroup_size_control_features.pNext = nullptr;
+
+  query->performance_query_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PERFORMANCE_QUERY_FEATURES_KHR;
+  query->performance_query_features.pNext = nullptr;
+
+  query->host_query_reset_features.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_QUERY_RESET_FEATURES_EXT;
+  query->host_query_reset_features.pNext = nullptr;
+
+  VkPhysicalDeviceFeatures2 features2 = {};
+  features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features2.pNext = nullptr;
+  if (has_synchronization2) {
+    query->synchronization2_features.pNext = features2.pNext;
+    features2.pNext = &query->synchronization2_features;
+  }
+  if (has_subgroup_size_control) {
+    query->subgroup_size_control_features.pNext = features2.pNext;
+    features2.pNext = &query->subgroup_size_control_features;
+  }
+  if (has_performance_query) {
+    query->performance_query_features.pNext = features2.pNext;
+    features2.pNext = &query->performance_query_features;
+    query->host_query_reset_features.pNext = features2.pNext;
+    features2.pNext = &query->host_query_reset_features;
+  }
+  symbols.vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+
+  VkPhysicalDeviceSubgroupSizeControlPropertiesEXT
+      subgroup_size_control_properties = {};
+  subgroup_size_control_properties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_PROPERTIES_EXT;
+  subgroup_size_control_properties.pNext = nullptr;
+
+  VkPhysicalDeviceProperties2 properties2 = {};
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties2.pNext = nullptr;
+  if (has_subgroup_size_control) {
+    properties2.pNext = &subgroup_size_control_properties;
+  }
+  symbols.vkGetPhysicalDeviceProperties2(physical_device, &properties2);
+
+  if (has_synchronization2 &&
+      query->synchronization2_features.synchronization2 == VK_TRUE &&
+      symbols.vkCmdPipelineBarrier2KHR != nullptr) {
+    query->enabled_extensions.push_back(
+        VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    query->synchronization2_features.pNext = query->enabled_features_chain;
+    query->enabled_features_chain = &query->synchronization2_features;
+    query->optional_features.synchronization2 = true;
+  }
+
+  // Only useful to us if compute shaders can require a subgroup size.
+  if (has_subgroup_size_control &&
+      query->subgroup_size_control_features.subgroupSizeControl == VK_TRUE &&
+      (subgroup_size_control_properties.requiredSubgroupSizeStages &
+       VK_SHADER_STAGE_COMPUTE_BIT)) {
+    query->enabled_extensions.push_back(
+        VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME);
+    query->subgroup_size_control_features.pNext = query->enabled_features_chain;
+    query->enabled_features_chain = &query->subgroup_size_control_features;
+    query->optional_features.subgroup_size_control = true;
+    query->optional_features.compute_full_subgroups =
+        query->subgroup_size_control_features.computeFullSubgroups == VK_TRUE;
+    query->optional_features.min_subgroup_size =
+        subgroup_size_control_properties.minSubgroupSize;
+    query->optional_features.max_subgroup_size =
+        subgroup_size_control_properties.maxSubgroupSize;
+  }
+
+  // Device timestamps are useless to calibrate if the queue has none.
+  if (has_calibrated_timestamps && query->valid_timestamp_bits != 0 &&
+      SupportsMonotonicCalibration(physical_device, symbols)) {
+    query->enabled_extensions.push_back(
+        VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+    query->optional_features.calibrated_timestamps = true;
+  }
+
+  // Performance queries are reset from the host. Counters are only collected
+  // with one query pool per command buffer, so multiple pools are not needed.
+  if (has_performance_query &&
+      query->performance_query_features.performanceCounterQueryPools ==
+          VK_TRUE &&
+      query->host_query_reset_features.hostQueryReset == VK_TRUE &&
+      symbols.vkAcquireProfilingLockKHR != nullptr &&
+      symbols.vkResetQueryPoolEXT != nullptr) {
+    query->enabled_extensions.push_back(
+        VK_KHR_PERFORMANCE_QUERY_EXTENSION_NAME);
+    query->enabled_extensions.push_back(VK_EXT_HOST_QUERY_RESET_EXTENSION_NAME);
+    query->performance_query_features.performanceCounterMultipleQueryPools =
+        VK_FALSE;
+    query->performance_query_features.pNext = query->enabled_features_chain;
+    query->host_query_reset_features.pNext = &query->performance_query_features;
+    query->enabled_features_chain = &query->host_query_reset_features;
+    query->optional_features.performance_query = true;
+  }
+
+  if (features2.features.pipelineStatisticsQuery == VK_TRUE) {
+    query->enabled_features.pipelineStatisticsQuery = VK_TRUE;
+    query->optional_features.pipeline_statistics_query = true;
+  }
+
+  return absl::OkStatus();
+}
+
 }  // namespace
 
 absl::StatusOr<std::unique_ptr<Driver>> Driver::Create(
@@ -113,10 +337,14 @@ Driver::EnumeratePhysicalDevices() {
 
   std::vector<PhysicalDeviceInfo> infos(count);
   for (int i = 0; i < count; ++i) {
+    VkPhysicalDeviceIDProperties id_properties = {};
+    id_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+    id_properties.pNext = nullptr;
+
     VkPhysicalDeviceSubgroupProperties subgroup_properties = {};
     subgroup_properties.sType =
         VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
-    subgroup_properties.pNext = nullptr;
+    subgroup_properties.pNext = &id_properties;
 
     VkPhysicalDeviceProperties2 properties2 = {};
     properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
@@ -127,18 +355,27 @@ Driver::EnumeratePhysicalDevices() {
     infos[i].handle = devices[i];
     infos[i].v10_properties = properties2.properties;
     infos[i].subgroup_properties = subgroup_properties;
+    infos[i].subgroup_properties.pNext = nullptr;
+    infos[i].id_properties = id_properties;
   }
 
   return infos;
 }
 
+absl::StatusOr<Device::OptionalFeatures> Driver::QueryOptionalFeatures(
+    const PhysicalDeviceInfo &physical_device, VkQueueFlags queue_flags) {
+  DeviceFeatureQuery query;
+  UVKC_RETURN_IF_ERROR(QueryDeviceFeatures(physical_device.handle, queue_flags,
+                                           symbols_, &query));
+  return query.optional_features;
+}
+
 absl::StatusOr<std::unique_ptr<Device>> Driver::CreateDevice(
     const Driver::PhysicalDeviceInfo &physical_device,
     VkQueueFlags queue_flags) {
-  uint32_t valid_timestamp_bits = 0;
-  UVKC_ASSIGN_OR_RETURN(uint32_t queue_family_index,
-                        SelectQueueFamily(physical_device.handle, queue_flags,
-                                          &valid_timestamp_bits, symbols_));
+  DeviceFeatureQuery query;
+  UVKC_RETURN_IF_ERROR(QueryDeviceFeatures(physical_device.handle, queue_flags,
+                                           symbols_, &query));
 
   float queue_priority = 1.0;
 
@@ -146,29 +383,31 @@ absl::StatusOr<std::unique_ptr<Device>> Driver::CreateDevice(
   queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
   queue_create_info.pNext = nullptr;
   queue_create_info.flags = 0;
-  queue_create_info.queueFamilyIndex = queue_family_index;
+  queue_create_info.queueFamilyIndex = query.queue_family_index;
   queue_create_info.queueCount = 1;
   queue_create_info.pQueuePriorities = &queue_priority;
 
   VkDeviceCreateInfo device_create_info = {};
   device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-  device_create_info.pNext = nullptr;
+  device_create_info.pNext = query.enabled_features_chain;
   device_create_info.flags = 0;
   device_create_info.queueCreateInfoCount = 1;
   device_create_info.pQueueCreateInfos = &queue_create_info;
   device_create_info.enabledLayerCount = 0;
   device_create_info.ppEnabledLayerNames = nullptr;
-  device_create_info.enabledExtensionCount = 0;
-  device_create_info.ppEnabledExtensionNames = nullptr;
-  device_create_info.pEnabledFeatures = nullptr;
+  device_create_info.enabledExtensionCount = query.enabled_extensions.size();
+  device_create_info.ppEnabledExtensionNames =
+      query.enabled_extensions.data();
+  device_create_info.pEnabledFeatures = &query.enabled_features;
 
   VkDevice device;
   VK_RETURN_IF_ERROR(symbols_.vkCreateDevice(physical_device.handle,
                                              &device_create_info,
                                              /*pAllocator=*/nullptr, &device));
-  return Device::Create(
-      physical_device.handle, queue_family_index, valid_timestamp_bits,
-      physical_device.v10_properties.limits.timestampPeriod, device, symbols_);
+  return Device::Create(physical_device.handle, query.queue_family_index,
+                        query.valid_timestamp_bits,
+                        physical_device.v10_properties.limits.timestampPeriod,
+                        query.optional_features, device, symbols_);
 }
 
 Driver::Driver(VkInstance instance, const DynamicSymbols &symbols)
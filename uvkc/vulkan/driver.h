@@ -44,11 +44,18 @@ class Driver {
     VkPhysicalDevice handle;
     VkPhysicalDeviceProperties v10_properties;
     VkPhysicalDeviceSubgroupProperties subgroup_properties;
+    VkPhysicalDeviceIDProperties id_properties;
   };
 
   // Enumerates all available physical devices on system.
   absl::StatusOr<std::vector<PhysicalDeviceInfo>> EnumeratePhysicalDevices();
 
+  // Returns the optional features that a logical device created from the given
+  // |physical_device| with the given |queue_flags| would enable, without
+  // creating it.
+  absl::StatusOr<Device::OptionalFeatures> QueryOptionalFeatures(
+      const PhysicalDeviceInfo &physical_device, VkQueueFlags queue_flags);
+
   // Creates a logical device from the given |physical_device| with the ability
   // to use a queue of the given |queue_flags|.
   absl::StatusOr<std::unique_ptr<Device>> CreateDevice(
@@ -49,10 +49,11 @@ namespace vulkan {
 // vkGetInstanceProcAddr/vkGetDeviceProcAddr after Vulkan instance/device
 // creation.
 #define UVKC_VULKAN_DYNAMIC_SYMBOL_COMMON_TABLE(INS_PFN, DEV_PFN)       \
+  DEV_PFN(OPTIONAL, vkAcquireProfilingLockKHR)                          \
   DEV_PFN(REQUIRED, vkBeginCommandBuffer)                               \
   DEV_PFN(EXCLUDED, vkCmdBeginConditionalRenderingEXT)                  \
   DEV_PFN(EXCLUDED, vkCmdBeginDebugUtilsLabelEXT)                       \
-  DEV_PFN(EXCLUDED, vkCmdBeginQuery)                                    \
+  DEV_PFN(REQUIRED, vkCmdBeginQuery)                                    \
   DEV_PFN(EXCLUDED, vkCmdBeginQueryIndexedEXT)                          \
   DEV_PFN(EXCLUDED, vkCmdBeginRenderPass)                               \
   DEV_PFN(EXCLUDED, vkCmdBeginRenderPass2KHR)                           \
@@ -80,7 +81,7 @@ namespace vulkan {
   DEV_PFN(REQUIRED, vkCmdDispatch)                                      \
   DEV_PFN(EXCLUDED, vkCmdDispatchBase)                                  \
   DEV_PFN(EXCLUDED, vkCmdDispatchBaseKHR)                               \
-  DEV_PFN(EXCLUDED, vkCmdDispatchIndirect)                              \
+  DEV_PFN(REQUIRED, vkCmdDispatchIndirect)                              \
   DEV_PFN(EXCLUDED, vkCmdDraw)                                          \
   DEV_PFN(EXCLUDED, vkCmdDrawIndexed)                                   \
   DEV_PFN(EXCLUDED, vkCmdDrawIndexedIndirect)                           \
@@ -95,17 +96,18 @@ namespace vulkan {
   DEV_PFN(EXCLUDED, vkCmdDrawMeshTasksNV)                               \
   DEV_PFN(EXCLUDED, vkCmdEndConditionalRenderingEXT)                    \
   DEV_PFN(EXCLUDED, vkCmdEndDebugUtilsLabelEXT)                         \
-  DEV_PFN(EXCLUDED, vkCmdEndQuery)                                      \
+  DEV_PFN(REQUIRED, vkCmdEndQuery)                                      \
   DEV_PFN(EXCLUDED, vkCmdEndQueryIndexedEXT)                            \
   DEV_PFN(EXCLUDED, vkCmdEndRenderPass)                                 \
   DEV_PFN(EXCLUDED, vkCmdEndRenderPass2KHR)                             \
   DEV_PFN(EXCLUDED, vkCmdEndTransformFeedbackEXT)                       \
-  DEV_PFN(EXCLUDED, vkCmdExecuteCommands)                               \
-  DEV_PFN(EXCLUDED, vkCmdFillBuffer)                                    \
+  DEV_PFN(REQUIRED, vkCmdExecuteCommands)                               \
+  DEV_PFN(REQUIRED, vkCmdFillBuffer)                                    \
   DEV_PFN(EXCLUDED, vkCmdInsertDebugUtilsLabelEXT)                      \
   DEV_PFN(EXCLUDED, vkCmdNextSubpass)                                   \
   DEV_PFN(EXCLUDED, vkCmdNextSubpass2KHR)                               \
   DEV_PFN(REQUIRED, vkCmdPipelineBarrier)                               \
+  DEV_PFN(OPTIONAL, vkCmdPipelineBarrier2KHR)                           \
   DEV_PFN(EXCLUDED, vkCmdProcessCommandsNVX)                            \
   DEV_PFN(EXCLUDED, vkCmdPushConstants)                                 \
   DEV_PFN(EXCLUDED, vkCmdPushDescriptorSetKHR)                          \
@@ -227,7 +229,7 @@ namespace vulkan {
   DEV_PFN(REQUIRED, vkGetBufferMemoryRequirements)                      \
   DEV_PFN(EXCLUDED, vkGetBufferMemoryRequirements2)                     \
   DEV_PFN(EXCLUDED, vkGetBufferMemoryRequirements2KHR)                  \
-  DEV_PFN(EXCLUDED, vkGetCalibratedTimestampsEXT)                       \
+  DEV_PFN(OPTIONAL, vkGetCalibratedTimestampsEXT)                       \
   DEV_PFN(EXCLUDED, vkGetDescriptorSetLayoutSupport)                    \
   DEV_PFN(EXCLUDED, vkGetDescriptorSetLayoutSupportKHR)                 \
   DEV_PFN(EXCLUDED, vkGetDeviceGroupPeerMemoryFeatures)                 \
@@ -273,11 +275,12 @@ namespace vulkan {
   DEV_PFN(EXCLUDED, vkRegisterDeviceEventEXT)                           \
   DEV_PFN(EXCLUDED, vkRegisterDisplayEventEXT)                          \
   DEV_PFN(EXCLUDED, vkRegisterObjectsNVX)                               \
+  DEV_PFN(OPTIONAL, vkReleaseProfilingLockKHR)                          \
   DEV_PFN(REQUIRED, vkResetCommandPool)                                 \
   DEV_PFN(EXCLUDED, vkResetDescriptorPool)                              \
   DEV_PFN(EXCLUDED, vkResetEvent)                                       \
   DEV_PFN(EXCLUDED, vkResetFences)                                      \
-  DEV_PFN(EXCLUDED, vkResetQueryPoolEXT)                                \
+  DEV_PFN(OPTIONAL, vkResetQueryPoolEXT)                                \
   DEV_PFN(EXCLUDED, vkSetDebugUtilsObjectNameEXT)                       \
   DEV_PFN(EXCLUDED, vkSetDebugUtilsObjectTagEXT)                        \
   DEV_PFN(EXCLUDED, vkSetEvent)                                         \
@@ -311,17 +314,18 @@ namespace vulkan {
   INS_PFN(EXCLUDED, vkEnumeratePhysicalDeviceGroups)                    \
   INS_PFN(EXCLUDED, vkEnumeratePhysicalDeviceGroupsKHR)                 \
   INS_PFN(REQUIRED, vkEnumeratePhysicalDevices)                         \
+  INS_PFN(OPTIONAL, vkEnumeratePhysicalDeviceQueueFamilyPerformanceQueryCountersKHR) \
   INS_PFN(EXCLUDED, vkSubmitDebugUtilsMessageEXT)                       \
   INS_PFN(REQUIRED, vkCreateDevice)                                     \
   INS_PFN(EXCLUDED, vkCreateDisplayModeKHR)                             \
-  INS_PFN(EXCLUDED, vkEnumerateDeviceExtensionProperties)               \
+  INS_PFN(REQUIRED, vkEnumerateDeviceExtensionProperties)               \
   INS_PFN(EXCLUDED, vkEnumerateDeviceLayerProperties)                   \
   INS_PFN(EXCLUDED, vkGetDisplayModeProperties2KHR)                     \
   INS_PFN(EXCLUDED, vkGetDisplayModePropertiesKHR)                      \
   INS_PFN(EXCLUDED, vkGetDisplayPlaneCapabilities2KHR)                  \
   INS_PFN(EXCLUDED, vkGetDisplayPlaneCapabilitiesKHR)                   \
   INS_PFN(EXCLUDED, vkGetDisplayPlaneSupportedDisplaysKHR)              \
-  INS_PFN(EXCLUDED, vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)     \
+  INS_PFN(OPTIONAL, vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)     \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceCooperativeMatrixPropertiesNV)   \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceDisplayPlaneProperties2KHR)      \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceDisplayPlanePropertiesKHR)       \
@@ -335,7 +339,7 @@ namespace vulkan {
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceExternalSemaphoreProperties)     \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceExternalSemaphorePropertiesKHR)  \
   INS_PFN(REQUIRED, vkGetPhysicalDeviceFeatures)                        \
-  INS_PFN(EXCLUDED, vkGetPhysicalDeviceFeatures2)                       \
+  INS_PFN(REQUIRED, vkGetPhysicalDeviceFeatures2)                       \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceFeatures2KHR)                    \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceFormatProperties)                \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceFormatProperties2)               \
@@ -355,6 +359,7 @@ namespace vulkan {
   INS_PFN(REQUIRED, vkGetPhysicalDeviceQueueFamilyProperties)           \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceQueueFamilyProperties2)          \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceQueueFamilyProperties2KHR)       \
+  INS_PFN(OPTIONAL, vkGetPhysicalDeviceQueueFamilyPerformanceQueryPassesKHR) \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceSparseImageFormatProperties)     \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceSparseImageFormatProperties2)    \
   INS_PFN(EXCLUDED, vkGetPhysicalDeviceSparseImageFormatProperties2KHR) \
@@ -0,0 +1,148 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/vulkan/performance_query_pool.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "uvkc/vulkan/status_util.h"
+
+namespace uvkc {
+namespace vulkan {
+
+namespace {
+
+// Returns the value of |result| stored as |storage| converted to double.
+double ToDouble(const VkPerformanceCounterResultKHR &result,
+                VkPerformanceCounterStorageKHR storage) {
+  switch (storage) {
+    case VK_PERFORMANCE_COUNTER_STORAGE_INT32_KHR:
+      return result.int32;
+    case VK_PERFORMANCE_COUNTER_STORAGE_INT64_KHR:
+      return result.int64;
+    case VK_PERFORMANCE_COUNTER_STORAGE_UINT32_KHR:
+      return result.uint32;
+    case VK_PERFORMANCE_COUNTER_STORAGE_UINT64_KHR:
+      return result.uint64;
+    case VK_PERFORMANCE_COUNTER_STORAGE_FLOAT32_KHR:
+      return result.float32;
+    case VK_PERFORMANCE_COUNTER_STORAGE_FLOAT64_KHR:
+      return result.float64;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace
+
+// static
+absl::StatusOr<std::unique_ptr<PerformanceQueryPool>>
+PerformanceQueryPool::Create(VkDevice device, VkPhysicalDevice physical_device,
+                             uint32_t queue_family_index,
+                             absl::Span<const PerformanceCounter> counters,
+                             uint32_t query_count,
+                             const DynamicSymbols &symbols) {
+  if (counters.empty()) {
+    return absl::InvalidArgumentError("no performance counters to query");
+  }
+
+  std::vector<uint32_t> counter_indices;
+  counter_indices.reserve(counters.size());
+  for (const PerformanceCounter &counter : counters) {
+    counter_indices.push_back(counter.index);
+  }
+
+  VkQueryPoolPerformanceCreateInfoKHR performance_create_info = {};
+  performance_create_info.sType =
+      VK_STRUCTURE_TYPE_QUERY_POOL_PERFORMANCE_CREATE_INFO_KHR;
+  performance_create_info.pNext = nullptr;
+  performance_create_info.queueFamilyIndex = queue_family_index;
+  performance_create_info.counterIndexCount = counter_indices.size();
+  performance_create_info.pCounterIndices = counter_indices.data();
+
+  uint32_t num_passes = 0;
+  symbols.vkGetPhysicalDeviceQueueFamilyPerformanceQueryPassesKHR(
+      physical_device, &performance_create_info, &num_passes);
+  if (num_passes != 1) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("the requested performance counters need ", num_passes,
+                     " passes to collect; only one is supported, so request "
+                     "fewer counters at a time"));
+  }
+
+  VkQueryPoolCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  create_info.pNext = &performance_create_info;
+  create_info.flags = 0;
+  create_info.queryType = VK_QUERY_TYPE_PERFORMANCE_QUERY_KHR;
+  create_info.queryCount = query_count;
+  create_info.pipelineStatistics = 0;
+
+  VkQueryPool query_pool = VK_NULL_HANDLE;
+  VK_RETURN_IF_ERROR(symbols.vkCreateQueryPool(device, &create_info,
+                                               /*pAllocator=*/nullptr,
+                                               &query_pool));
+  return absl::WrapUnique(new PerformanceQueryPool(
+      device, query_pool, {counters.begin(), counters.end()}, query_count,
+      symbols));
+}
+
+PerformanceQueryPool::~PerformanceQueryPool() {
+  symbols_.vkDestroyQueryPool(device_, query_pool_, /*pAllocator=*/nullptr);
+}
+
+void PerformanceQueryPool::Reset() {
+  symbols_.vkResetQueryPoolEXT(device_, query_pool_, /*firstQuery=*/0,
+                               query_count_);
+}
+
+absl::Status PerformanceQueryPool::GetCounterValues(
+    uint32_t index, std::vector<double> *values) {
+  if (index >= query_count_) {
+    return absl::OutOfRangeError("query index out of range");
+  }
+
+  // Performance queries support neither the availability bit nor the 64-bit
+  // flag; results are always VkPerformanceCounterResultKHR values and
+  // VK_NOT_READY tells when they are not available yet.
+  const size_t stride = results_.size() * sizeof(results_[0]);
+  VkResult result = symbols_.vkGetQueryPoolResults(
+      device_, query_pool_, index, /*queryCount=*/1, /*dataSize=*/stride,
+      /*pData=*/results_.data(), stride, /*flags=*/0);
+  VK_RETURN_IF_ERROR(result);
+  if (result == VK_NOT_READY) {
+    return absl::UnavailableError("performance query result not ready");
+  }
+
+  values->clear();
+  for (size_t i = 0; i < counters_.size(); ++i) {
+    values->push_back(ToDouble(results_[i], counters_[i].storage));
+  }
+  return absl::OkStatus();
+}
+
+PerformanceQueryPool::PerformanceQueryPool(
+    VkDevice device, VkQueryPool pool, std::vector<PerformanceCounter> counters,
+    uint32_t query_count, const DynamicSymbols &symbols)
+    : query_pool_(pool),
+      device_(device),
+      counters_(std::move(counters)),
+      query_count_(query_count),
+      results_(counters_.size()),
+      symbols_(symbols) {}
+
+}  // namespace vulkan
+}  // namespace uvkc
@@ -0,0 +1,101 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_VULKAN_PERFORMANCE_QUERY_POOL_H_
+#define UVKC_VULKAN_PERFORMANCE_QUERY_POOL_H_
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "uvkc/vulkan/dynamic_symbols.h"
+
+namespace uvkc {
+namespace vulkan {
+
+// A hardware performance counter exposed via VK_KHR_performance_query.
+struct PerformanceCounter {
+  // Index of the counter among those of the queue family.
+  uint32_t index;
+  std::string name;
+  std::string category;
+  std::string description;
+  VkPerformanceCounterUnitKHR unit;
+  VkPerformanceCounterStorageKHR storage;
+};
+
+// A class representing a Vulkan query pool for hardware performance counters.
+//
+// Each query samples all the counters of the pool over the commands recorded
+// between CommandBuffer::BeginQuery() and CommandBuffer::EndQuery() on it.
+// The device's profiling lock must be held while recording and executing
+// such command buffers. Queries are reset from the host with Reset(), since
+// counters scoped to a whole command buffer require the query to begin with
+// its very first command, leaving no room for a reset command in it.
+//
+// Only counter sets that can be collected in a single pass are supported, so
+// that command buffers need no resubmission.
+class PerformanceQueryPool {
+ public:
+  // Creates a pool of |query_count| queries sampling |counters| on the queue
+  // family with |queue_family_index|. Returns an invalid argument error if the
+  // counters need more than one pass to collect.
+  static absl::StatusOr<std::unique_ptr<PerformanceQueryPool>> Create(
+      VkDevice device, VkPhysicalDevice physical_device,
+      uint32_t queue_family_index,
+      absl::Span<const PerformanceCounter> counters, uint32_t query_count,
+      const DynamicSymbols &symbols);
+
+  ~PerformanceQueryPool();
+
+  VkQueryPool query_pool() const { return query_pool_; }
+  uint32_t query_count() const { return query_count_; }
+  const std::vector<PerformanceCounter> &counters() const { return counters_; }
+
+  // Resets all queries from the host. The queries must not be in use by the
+  // GPU.
+  void Reset();
+
+  // Reads back the counter values of the query with |index| into |values|, in
+  // the order of counters(). Does not wait for the GPU; returns an unavailable
+  // error if the query has not finished yet.
+  absl::Status GetCounterValues(uint32_t index, std::vector<double> *values);
+
+ private:
+  PerformanceQueryPool(VkDevice device, VkQueryPool pool,
+                       std::vector<PerformanceCounter> counters,
+                       uint32_t query_count, const DynamicSymbols &symbols);
+
+  VkQueryPool query_pool_;
+
+  VkDevice device_;
+
+  std::vector<PerformanceCounter> counters_;
+  uint32_t query_count_;
+
+  // Scratch space for readback of one query.
+  std::vector<VkPerformanceCounterResultKHR> results_;
+
+  const DynamicSymbols &symbols_;
+};
+
+}  // namespace vulkan
+}  // namespace uvkc
+
+#endif  // UVKC_VULKAN_PERFORMANCE_QUERY_POOL_H_
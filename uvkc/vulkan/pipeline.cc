@@ -83,6 +83,7 @@ size_t Pipeline::SpecConstant::size() const {
 absl::StatusOr<std::unique_ptr<Pipeline>> Pipeline::Create(
     VkDevice device, const ShaderModule &shader_module, const char *entry_point,
     absl::Span<Pipeline::SpecConstant> spec_constants,
+    const SubgroupSizeControl &subgroup_size_control,
     const DynamicSymbols &symbols) {
   // Pack the specialization constant into an byte buffer
   SpecConstantData spec_constant_data = PackSpecConstantData(spec_constants);
@@ -97,6 +98,21 @@ absl::StatusOr<std::unique_ptr<Pipeline>> Pipeline::Create(
   shader_stage_create_info.module = shader_module.shader_module();
   shader_stage_create_info.pName = entry_point;
 
+  // Update subgroup size requirements
+  VkPipelineShaderStageRequiredSubgroupSizeCreateInfoEXT required_size_info =
+      {};
+  required_size_info.sType =
+      VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_REQUIRED_SUBGROUP_SIZE_CREATE_INFO_EXT;
+  required_size_info.pNext = nullptr;
+  required_size_info.requiredSubgroupSize = subgroup_size_control.required_size;
+  if (subgroup_size_control.required_size != 0) {
+    shader_stage_create_info.pNext = &required_size_info;
+  }
+  if (subgroup_size_control.require_full_subgroups) {
+    shader_stage_create_info.flags |=
+        VK_PIPELINE_SHADER_STAGE_CREATE_REQUIRE_FULL_SUBGROUPS_BIT_EXT;
+  }
+
   // Update specialization information
   if (!spec_constants.empty()) {
     spec_constant_info.mapEntryCount = spec_constant_data.entries.size();
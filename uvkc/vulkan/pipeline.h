@@ -47,11 +47,25 @@ class Pipeline {
     size_t size() const;
   };
 
+  // A struct representing subgroup size requirements. Non-default values need
+  // VK_EXT_subgroup_size_control.
+  struct SubgroupSizeControl {
+    // The subgroup size to compile the pipeline with, or 0 to let the
+    // implementation choose.
+    uint32_t required_size;
+    // Whether all subgroups must be fully populated. The workgroup size along X
+    // must then be a multiple of the required subgroup size, or the maximal
+    // subgroup size if none is required.
+    bool require_full_subgroups;
+  };
+
   // Creates a Vulkan compute pipeline using the given |entry_point| in the
-  // |shader_module|, with the provided |spec_constants|.
+  // |shader_module|, with the provided |spec_constants| and
+  // |subgroup_size_control| requirements.
   static absl::StatusOr<std::unique_ptr<Pipeline>> Create(
       VkDevice device, const ShaderModule &shader_module,
       const char *entry_point, absl::Span<SpecConstant> spec_constants,
+      const SubgroupSizeControl &subgroup_size_control,
       const DynamicSymbols &symbols);
 
   ~Pipeline();
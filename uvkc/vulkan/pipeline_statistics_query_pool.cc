@@ -0,0 +1,79 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "uvkc/vulkan/pipeline_statistics_query_pool.h"
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "uvkc/vulkan/status_util.h"
+
+namespace uvkc {
+namespace vulkan {
+
+// static
+absl::StatusOr<std::unique_ptr<PipelineStatisticsQueryPool>>
+PipelineStatisticsQueryPool::Create(VkDevice device, uint32_t query_count,
+                                    const DynamicSymbols &symbols) {
+  VkQueryPoolCreateInfo create_info = {};
+  create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  create_info.pNext = nullptr;
+  create_info.flags = 0;
+  create_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+  create_info.queryCount = query_count;
+  create_info.pipelineStatistics =
+      VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+  VkQueryPool query_pool = VK_NULL_HANDLE;
+  VK_RETURN_IF_ERROR(symbols.vkCreateQueryPool(device, &create_info,
+                                               /*pAllocator=*/nullptr,
+                                               &query_pool));
+  return absl::WrapUnique(
+      new PipelineStatisticsQueryPool(device, query_pool, query_count, symbols));
+}
+
+PipelineStatisticsQueryPool::~PipelineStatisticsQueryPool() {
+  symbols_.vkDestroyQueryPool(device_, query_pool_, /*pAllocator=*/nullptr);
+}
+
+absl::StatusOr<uint64_t>
+PipelineStatisticsQueryPool::GetComputeShaderInvocations(uint32_t index) {
+  if (index >= query_count_) {
+    return absl::OutOfRangeError("query index out of range");
+  }
+
+  // With a single statistic enabled, the result is the counter followed by the
+  // availability word.
+  uint64_t results[2] = {0, 0};
+  VkResult result = symbols_.vkGetQueryPoolResults(
+      device_, query_pool_, index, /*queryCount=*/1,
+      /*dataSize=*/sizeof(results), /*pData=*/results,
+      /*stride=*/sizeof(results),
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+  VK_RETURN_IF_ERROR(result);
+  if (result == VK_NOT_READY || results[1] == 0) {
+    return absl::UnavailableError("pipeline statistics query result not ready");
+  }
+  return results[0];
+}
+
+PipelineStatisticsQueryPool::PipelineStatisticsQueryPool(
+    VkDevice device, VkQueryPool pool, uint32_t query_count,
+    const DynamicSymbols &symbols)
+    : query_pool_(pool),
+      device_(device),
+      query_count_(query_count),
+      symbols_(symbols) {}
+
+}  // namespace vulkan
+}  // namespace uvkc
@@ -0,0 +1,69 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef UVKC_VULKAN_PIPELINE_STATISTICS_QUERY_POOL_H_
+#define UVKC_VULKAN_PIPELINE_STATISTICS_QUERY_POOL_H_
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+
+#include "absl/status/statusor.h"
+#include "uvkc/vulkan/dynamic_symbols.h"
+
+namespace uvkc {
+namespace vulkan {
+
+// A class representing a Vulkan query pool for pipeline statistics.
+//
+// Each query counts the compute shader invocations executed by the dispatches
+// recorded between CommandBuffer::BeginQuery() and CommandBuffer::EndQuery()
+// on it.
+class PipelineStatisticsQueryPool {
+ public:
+  static absl::StatusOr<std::unique_ptr<PipelineStatisticsQueryPool>> Create(
+      VkDevice device, uint32_t query_count, const DynamicSymbols &symbols);
+
+  ~PipelineStatisticsQueryPool();
+
+  VkQueryPool query_pool() const { return query_pool_; }
+  uint32_t query_count() const { return query_count_; }
+
+  // Returns the number of compute shader invocations counted by the query with
+  // |index|. Does not wait for the GPU; returns an unavailable error if the
+  // query has not finished yet.
+  //
+  // Note that implementations may execute more or fewer invocations than the
+  // dispatch sizes imply, e.g., to fill hardware waves or to skip invocations
+  // without side effects; the count is what the hardware actually ran.
+  absl::StatusOr<uint64_t> GetComputeShaderInvocations(uint32_t index);
+
+ private:
+  PipelineStatisticsQueryPool(VkDevice device, VkQueryPool pool,
+                              uint32_t query_count,
+                              const DynamicSymbols &symbols);
+
+  VkQueryPool query_pool_;
+
+  VkDevice device_;
+
+  uint32_t query_count_;
+
+  const DynamicSymbols &symbols_;
+};
+
+}  // namespace vulkan
+}  // namespace uvkc
+
+#endif  // UVKC_VULKAN_PIPELINE_STATISTICS_QUERY_POOL_H_
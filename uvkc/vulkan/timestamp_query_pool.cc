@@ -14,10 +14,12 @@
 
 #include "uvkc/vulkan/timestamp_query_pool.h"
 
+#include <cmath>
 #include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "uvkc/base/status.h"
 #include "uvkc/vulkan/status_util.h"
 
 namespace uvkc {
@@ -26,7 +28,7 @@ namespace vulkan {
 // static
 absl::StatusOr<std::unique_ptr<TimestampQueryPool>> TimestampQueryPool::Create(
     VkDevice device, uint32_t valid_timestamp_bits,
-    uint32_t nanoseconds_per_timestamp_value, uint32_t query_count,
+    float nanoseconds_per_timestamp_value, uint32_t query_count,
     const DynamicSymbols &symbols) {
   if (valid_timestamp_bits == 0) {
     return absl::UnavailableError("the device does not support timestamp");
@@ -46,8 +48,8 @@ absl::StatusOr<std::unique_ptr<TimestampQueryPool>> TimestampQueryPool::Create(
                                                /*pAllocator=*/nullptr,
                                                &query_pool));
   return absl::WrapUnique(new TimestampQueryPool(
-      device, query_pool, nanoseconds_per_timestamp_value, query_count,
-      symbols));
+      device, query_pool, valid_timestamp_bits, nanoseconds_per_timestamp_value,
+      query_count, symbols));
 }
 
 TimestampQueryPool::~TimestampQueryPool() {
@@ -60,28 +62,139 @@ absl::StatusOr<double> TimestampQueryPool::CalculateElapsedSecondsBetween(
     return absl::InvalidArgumentError(
         "end index must be greater than start index");
   }
+  if (start < 0 || static_cast<uint32_t>(end) >= query_count_) {
+    return absl::OutOfRangeError("query index out of range");
+  }
+
+  // Only the two end points are needed; read them one at a time so that
+  // queries in between may be unused.
+  uint64_t timestamps[2];
+  for (int i = 0; i < 2; ++i) {
+    UVKC_ASSIGN_OR_RETURN(
+        bool available,
+        ReadTimestamps({static_cast<uint32_t>(i == 0 ? start : end), 1}));
+    if (!available) {
+      return absl::UnavailableError("timestamp query result not ready");
+    }
+    timestamps[i] = results_[0];
+  }
+
+  return TicksBetween(timestamps[0], timestamps[1]) *
+         nanoseconds_per_timestamp_value_ * 1e-9;
+}
+
+absl::StatusOr<int64_t> TimestampQueryPool::ConvertToHostNanoseconds(
+    uint32_t index, const CalibratedTimestamps &calibration) {
+  if (index >= query_count_) {
+    return absl::OutOfRangeError("query index out of range");
+  }
+  UVKC_ASSIGN_OR_RETURN(bool available, ReadTimestamps({index, 1}));
+  if (!available) {
+    return absl::UnavailableError("timestamp query result not ready");
+  }
+
+  // Count backwards from the calibration point so that the difference stays
+  // non-negative under the valid bits mask.
+  uint64_t ticks = TicksBetween(results_[0], calibration.device_timestamp);
+  return calibration.host_nanoseconds -
+         std::llround(ticks * static_cast<double>(
+                                    nanoseconds_per_timestamp_value_));
+}
+
+absl::StatusOr<uint32_t> TimestampQueryPool::AcquireQueries(uint32_t count) {
+  if (count == 0 || count > query_count_) {
+    return absl::InvalidArgumentError(
+        "query count must be positive and no larger than the pool");
+  }
+
+  if (pending_ranges_.empty()) next_query_ = 0;
+
+  // Queries from the oldest pending range up to |next_query_| are in use; the
+  // rest of the ring, possibly split into a tail and a head part, is free.
+  uint32_t first = next_query_;
+  uint32_t free_end = query_count_;
+  if (!pending_ranges_.empty()) {
+    uint32_t oldest = pending_ranges_.front().first;
+    if (next_query_ <= oldest) {
+      // Already wrapped around: only the gap before the oldest range is free.
+      free_end = oldest;
+    } else if (next_query_ + count > query_count_) {
+      // The tail is too short; wrap around to the head.
+      first = 0;
+      free_end = oldest;
+    }
+  } else if (next_query_ + count > query_count_) {
+    first = 0;
+  }
+
+  if (first + count > free_end) {
+    return absl::ResourceExhaustedError(
+        "not enough free timestamp queries; collect pending ones first");
+  }
+
+  pending_ranges_.push_back({first, count});
+  next_query_ = first + count;
+  return first;
+}
+
+absl::StatusOr<int> TimestampQueryPool::CollectElapsedSeconds(
+    std::vector<double> *elapsed_seconds) {
+  int num_collected = 0;
+  while (!pending_ranges_.empty()) {
+    QueryRange range = pending_ranges_.front();
+    UVKC_ASSIGN_OR_RETURN(bool available, ReadTimestamps(range));
+    if (!available) break;
+
+    for (uint32_t i = 1; i < range.count; ++i) {
+      uint64_t ticks = TicksBetween(results_[2 * (i - 1)], results_[2 * i]);
+      elapsed_seconds->push_back(ticks * nanoseconds_per_timestamp_value_ *
+                                 1e-9);
+    }
+    pending_ranges_.pop_front();
+    ++num_collected;
+  }
+  return num_collected;
+}
+
+absl::StatusOr<bool> TimestampQueryPool::ReadTimestamps(QueryRange range) {
+  // Without VK_QUERY_RESULT_WAIT_BIT this returns VK_NOT_READY instead of
+  // blocking if any query is unavailable; the per-query availability words
+  // tell exactly which.
+  const size_t stride = 2 * sizeof(uint64_t);
+  VkResult result = symbols_.vkGetQueryPoolResults(
+      device_, query_pool_, range.first, range.count,
+      /*dataSize=*/range.count * stride,
+      /*pData=*/reinterpret_cast<void *>(results_.data()), stride,
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+  VK_RETURN_IF_ERROR(result);
+  if (result == VK_NOT_READY) return false;
+
+  for (uint32_t i = 0; i < range.count; ++i) {
+    if (results_[2 * i + 1] == 0) return false;
+  }
+  return true;
+}
 
-  uint32_t count = end - start + 1;
-  std::vector<uint64_t> timestamps(count);
-  VK_RETURN_IF_ERROR(symbols_.vkGetQueryPoolResults(
-      device_, query_pool_, start, count, /*dataSize=*/count * sizeof(uint64_t),
-      /*pData=*/reinterpret_cast<void *>(timestamps.data()),
-      /*stride=*/sizeof(uint64_t),
-      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
-
-  double seconds = (timestamps.back() - timestamps.front()) *
-                   nanoseconds_per_timestamp_value_ * 1e-9;
-  return seconds;
+uint64_t TimestampQueryPool::TicksBetween(uint64_t start, uint64_t end) const {
+  // Bits beyond the valid ones are unspecified. Masking the difference also
+  // gives the right result if the counter wrapped around once in between.
+  return (end - start) & timestamp_mask_;
 }
 
 TimestampQueryPool::TimestampQueryPool(VkDevice device, VkQueryPool pool,
-                                       uint32_t nanoseconds_per_timestamp_value,
+                                       uint32_t valid_timestamp_bits,
+                                       float nanoseconds_per_timestamp_value,
                                        uint32_t query_count,
                                        const DynamicSymbols &symbols)
-    : device_(device),
-      query_pool_(pool),
+    : query_pool_(pool),
+      device_(device),
+      timestamp_mask_(valid_timestamp_bits >= 64
+                          ? ~uint64_t(0)
+                          : (uint64_t(1) << valid_timestamp_bits) - 1),
       nanoseconds_per_timestamp_value_(nanoseconds_per_timestamp_value),
       query_count_(query_count),
+      next_query_(0),
+      results_(2 * query_count),
       symbols_(symbols) {}
 
 }  // namespace vulkan
@@ -17,7 +17,9 @@
 
 #include <vulkan/vulkan.h>
 
+#include <deque>
 #include <memory>
+#include <vector>
 
 #include "absl/status/statusor.h"
 #include "uvkc/vulkan/dynamic_symbols.h"
@@ -25,12 +27,27 @@
 namespace uvkc {
 namespace vulkan {
 
+// A device timestamp and a host clock time sampled at the same moment via
+// VK_EXT_calibrated_timestamps.
+struct CalibratedTimestamps {
+  uint64_t device_timestamp;
+  // Nanoseconds in the domain of std::chrono::steady_clock.
+  int64_t host_nanoseconds;
+  // Maximum deviation in nanoseconds between the two samples.
+  uint64_t max_deviation_nanoseconds;
+};
+
 // A class representing a Vulkan query pool for timestamps.
+//
+// Besides addressing queries by index directly, the pool can be used as a
+// ring: callers acquire ranges of consecutive queries, record timestamps into
+// them across as many submits as they like, and later collect the elapsed
+// times of all ranges the GPU has finished, without waiting on the GPU.
 class TimestampQueryPool {
  public:
   static absl::StatusOr<std::unique_ptr<TimestampQueryPool>> Create(
       VkDevice device, uint32_t valid_timestamp_bits,
-      uint32_t nanoseconds_per_timestamp_value, uint32_t query_count,
+      float nanoseconds_per_timestamp_value, uint32_t query_count,
       const DynamicSymbols &symbols);
 
   ~TimestampQueryPool();
@@ -39,21 +56,73 @@ class TimestampQueryPool {
   uint32_t query_count() const { return query_count_; }
 
   // Calculates the number of seconds elapsed between the query with index
-  // |start| and |end|.
+  // |start| and |end|. Does not wait for the GPU; returns an unavailable error
+  // if either timestamp has not been written yet.
   absl::StatusOr<double> CalculateElapsedSecondsBetween(int start, int end);
 
+  // Converts the timestamp of the query with |index| into nanoseconds in the
+  // host clock domain of |calibration|. The timestamp must have been written
+  // before |calibration| was sampled. Does not wait for the GPU; returns an
+  // unavailable error if the timestamp has not been written yet.
+  absl::StatusOr<int64_t> ConvertToHostNanoseconds(
+      uint32_t index, const CalibratedTimestamps &calibration);
+
+  // Acquires |count| consecutive queries from the ring and returns the index
+  // of the first one. A range never straddles the end of the pool; if the
+  // remaining tail is too short, the range wraps around to start at index 0.
+  // Returns a resource exhausted error if the queries needed are still held by
+  // ranges that have not been collected yet.
+  //
+  // The queries must be reset with CommandBuffer::ResetQueryPool() before
+  // timestamps are written to them.
+  absl::StatusOr<uint32_t> AcquireQueries(uint32_t count);
+
+  // Returns the number of acquired query ranges not collected yet.
+  size_t num_pending_ranges() const { return pending_ranges_.size(); }
+
+  // Collects acquired query ranges in acquisition order, stopping at the first
+  // range whose timestamps are not all written yet. For each collected range
+  // of N queries, appends the N - 1 elapsed seconds between adjacent queries to
+  // |elapsed_seconds| and releases the range back to the ring. Returns the
+  // number of ranges collected.
+  absl::StatusOr<int> CollectElapsedSeconds(
+      std::vector<double> *elapsed_seconds);
+
  private:
+  // A range of |count| consecutive queries starting from |first|.
+  struct QueryRange {
+    uint32_t first;
+    uint32_t count;
+  };
+
   TimestampQueryPool(VkDevice device, VkQueryPool pool,
-                     uint32_t nanoseconds_per_timestamp_value,
+                     uint32_t valid_timestamp_bits,
+                     float nanoseconds_per_timestamp_value,
                      uint32_t query_count, const DynamicSymbols &symbols);
 
+  // Reads back the timestamps of |range| into |results_| without waiting.
+  // Returns false if any of them is not available yet.
+  absl::StatusOr<bool> ReadTimestamps(QueryRange range);
+
+  // Returns the number of timestamp ticks from |start| to |end|, accounting
+  // for the counter wrapping around within its valid bits.
+  uint64_t TicksBetween(uint64_t start, uint64_t end) const;
+
   VkQueryPool query_pool_;
 
   VkDevice device_;
 
-  uint32_t nanoseconds_per_timestamp_value_;
+  uint64_t timestamp_mask_;
+  float nanoseconds_per_timestamp_value_;
   uint32_t query_count_;
 
+  // Index of the query where the next range starts, if it fits.
+  uint32_t next_query_;
+  // Acquired ranges not collected yet, oldest first.
+  std::deque<QueryRange> pending_ranges_;
+  // Scratch space for readback: a value and availability pair per query.
+  std::vector<uint64_t> results_;
+
   const DynamicSymbols &symbols_;
 };
 